@@ -85,6 +85,7 @@
 #include "fx25.h"
 #include "il2p.h"
 #include "hdlc_rec.h"
+#include "rxprof.h"
 
 
 #if 0	/* Typical but not flexible enough. */
@@ -111,37 +112,64 @@ struct wav_header {             /* .WAV file header. */
  					/* 16 bit samples are little endian signed short */
 					/* in range of -32768 .. +32767. */
 
-static struct {
+struct riff_header_s {
         char riff[4];          /* "RIFF" */
         int filesize;          /* file length - 8 */
         char wave[4];          /* "WAVE" */
-} header;
+};
 
-static struct {
-	char id[4];		/* "LIST" or "fmt " */
+struct riff_chunk_s {
+	char id[4];		/* "LIST", "fmt ", or "data" */
 	int datasize;
-} chunk;
+};
 
-static struct {
+struct wav_format_s {
         short wformattag;       /* 1 for PCM. */
         short nchannels;        /* 1 for mono, 2 for stereo. */
         int nsamplespersec;    /* sampling freq, Hz. */
         int navgbytespersec;   /* = nblockalign*nsamplespersec. */
         short nblockalign;      /* = wbitspersample/8 * nchannels. */
-        short wbitspersample;   /* 16 or 8. */
-	char extras[4];
-} format;
+        short wbitspersample;   /* 8, 16, 24, or 32. */
+	short cbsize;		/* Remaining fields only for WAVE_FORMAT_EXTENSIBLE. */
+	short wvalidbitspersample;
+	int dwchannelmask;
+	unsigned char subformat[16];	/* First two bytes are the real format tag. */
+};
 
-static struct {
-	char data[4];		/* "data" */
-	int datasize;
-} wav_data;
+
+/*
+ * Everything about decoding one file.  Nothing here is shared
+ * so run_matrix can have several threads decoding at once.
+ */
+
+struct decode_s {
+	struct audio_s config;		/* Modem configuration for this file. */
+
+	int own_chains;			/* Use chain[] below, from rx_chain_create, */
+	struct rx_chain_s *chain[2];	/* rather than the ones in rx_chain[]. */
+					/* Left and right audio channels. */
+
+	int quiet;			/* Don't print anything.  Output from */
+					/* different jobs would be mixed together. */
+
+	FILE *fp;
+	int e_o_f;
+	int datasize;			/* Audio bytes remaining in file. */
+
+	int packets_decoded;		/* For the current file. */
+
+	int sample_number;		/* Sample number from the file. */
+					/* Incremented only for channel 0. */
+					/* Use to print timestamp, relative to beginning */
+					/* of file, when frame was decoded. */
+
+	int dcd_count;			/* For -d o option. */
+	int dcd_missing_errors;
+};
+
+static __thread struct decode_s *this_decode;	/* For audio_get, dlq_rec_frame, and ptt_set. */
 
 
-static FILE *fp;
-static int e_o_f;
-static int packets_decoded_one = 0;
-static int packets_decoded_total = 0;
 static int decimate = 0;		/* Reduce that sampling rate if set. */
 					/* 1 = normal, 2 = half, 3 = 1/3, etc. */
 
@@ -165,22 +193,17 @@ static int error_if_greater_than = -1;	/* Exit with error status if this maximum
 
 static 	int count[MAX_SUBCHANS];
 
-#if EXPERIMENT_H
-extern float space_gain[MAX_SUBCHANS];
-#endif
-
 #endif
 
 static void usage (void);
+static void set_modem_config (struct audio_s *pa, char *profile);
+static struct decode_s *decode_new (struct audio_s *pa);
+static int decode_wav_file (struct decode_s *D, char *fname, double *duration);
+static int run_matrix (int num_files, char *files[]);
 
 
 static int decode_only = 0;		/* Set to 0 or 1 to decode only one channel.  2 for both.  */
 
-static int sample_number = -1;		/* Sample number from the file. */
-					/* Incremented only for channel 0. */
-					/* Use to print timestamp, relative to beginning */
-					/* of file, when frame was decoded. */
-
 // command line options.
 
 static int B_opt = DEFAULT_BAUD;	// Bits per second.  Need to change all baud references to bps.
@@ -192,14 +215,16 @@ static char P_opt[16] = "";		// Demodulator profiles.
 static int d_x_opt = 1;			// FX.25 debug.
 static int d_o_opt = 0;			// "-d o" option for DCD output control. */	
 static int d_2_opt = 0;			// "-d 2" option for IL2P details. */
-static int dcd_count = 0;
-static int dcd_missing_errors = 0;
+static int T_opt = 0;			// Print machine readable timing summary.
+static int q_opt = 0;			// Quiet.  Don't display each decoded frame.
+static int t_opt = -1;			// Number of jobs at once for a matrix of tests.  0 for one per processor.
+static char P_list[80] = "";		// Comma separated list of profiles for matrix.
+static char F_list[40] = "";		// Comma separated list of fix bits levels for matrix.
 
 
 int main (int argc, char *argv[])
 {
 
-	int err;
 	int c;
 	int channel;
 
@@ -267,7 +292,7 @@ int main (int argc, char *argv[])
 
 	  /* ':' following option character means arg is required. */
 
-          c = getopt_long(argc, argv, "B:P:D:U:gjJF:L:G:012he:d:",
+          c = getopt_long(argc, argv, "B:P:D:U:gjJF:L:G:012he:d:Tqt:",
                         long_options, &option_index);
           if (c == -1)
             break;
@@ -306,7 +331,13 @@ int main (int argc, char *argv[])
 	    case 'P':				/* -P for modem profile. */
 
 	      // Wait until after other options processed.
-	      strlcpy (P_opt, optarg, sizeof(P_opt));
+	      // A comma separated list means try each one.  See run_matrix.
+	      if (strchr(optarg, ',') != NULL) {
+	        strlcpy (P_list, optarg, sizeof(P_list));
+	      }
+	      else {
+	        strlcpy (P_opt, optarg, sizeof(P_opt));
+	      }
 	      break;	
 
 	    case 'D':				/* -D reduce sampling rate for lower CPU usage. */
@@ -342,6 +373,10 @@ int main (int argc, char *argv[])
 
 	    case 'F':				/* -F set "fix bits" level. */
 
+	      if (strchr(optarg, ',') != NULL) {
+	        strlcpy (F_list, optarg, sizeof(F_list));
+	        break;
+	      }
 	      my_audio_config.achan[0].fix_bits = atoi(optarg);
 
 	      if (my_audio_config.achan[0].fix_bits < RETRY_NONE || my_audio_config.achan[0].fix_bits >= RETRY_MAX) {
@@ -386,6 +421,21 @@ int main (int argc, char *argv[])
 	       my_audio_config.recv_ber = atof(optarg);
 	       break;
 
+	     case 'T':				/* Timing of receive stages. */
+
+	       T_opt = 1;
+	       break;
+
+	     case 'q':				/* Quiet. */
+
+	       q_opt = 1;
+	       break;
+
+	     case 't':				/* Number of jobs for matrix of tests. */
+
+	       t_opt = atoi(optarg);
+	       break;
+
 	     case 'd':				/* Debug message options. */
 
 	       for (char *p=optarg; *p!='\0'; p++) {
@@ -413,6 +463,131 @@ int main (int argc, char *argv[])
 	    }
         }
     
+	if (optind >= argc) {
+	  text_color_set(DW_COLOR_ERROR);
+	  dw_printf ("Specify .WAV file name on command line.\n");
+	  usage ();
+	}
+
+/*
+ * Try every combination of file, profile, and fix bits level,
+ * as separate jobs, rather than adding up the results.
+ */
+	if (t_opt >= 0 || strlen(P_list) > 0 || strlen(F_list) > 0) {
+
+	  fx25_init (d_x_opt);
+	  il2p_init (d_2_opt);
+
+	  int failed = run_matrix (argc - optind, argv + optind);
+	  exit (failed ? EXIT_FAILURE : EXIT_SUCCESS);
+	}
+
+	set_modem_config (&my_audio_config, P_opt);
+
+	fx25_init (d_x_opt);
+	il2p_init (d_2_opt);
+	rxprof_init (T_opt);
+
+	struct decode_s *D = decode_new (&my_audio_config);
+	int packets_decoded_total = 0;
+
+	start_time = dtime_now();
+
+	while (optind < argc) {
+
+	int packets_decoded_one = decode_wav_file (D, argv[optind], &one_filetime);
+	if (packets_decoded_one < 0) {
+	  exit (EXIT_FAILURE);
+	}
+	total_filetime += one_filetime;
+	packets_decoded_total += packets_decoded_one;
+
+	optind++;
+	}
+
+	elapsed = dtime_now() - start_time;
+
+	dw_printf ("%d packets decoded in %.3f seconds.  %.1f x realtime\n", packets_decoded_total, elapsed, total_filetime/elapsed);
+	if (d_o_opt) {
+	  dw_printf ("DCD count = %d\n", D->dcd_count);
+	  dw_printf ("DCD missing errors = %d\n", D->dcd_missing_errors);
+	}
+
+/*
+ * -T option.  One line, easy for scripts to pick out, so changes in
+ * processor usage can be tracked along with the number decoded.
+ * Time not accounted for by the receive stages is file reading,
+ * picking the best candidate, and printing.
+ */
+	if (T_opt) {
+	  char profile[sizeof(D->config.achan[0].profiles)];
+	  int64_t samples = 0;
+	  double stage_sec[RXPROF_NUM_STAGES];
+	  double accounted = 0;
+
+	  int k = 0;
+	  for (char *p = D->config.achan[0].profiles; *p != '\0'; p++) {
+	    if (*p != ' ') profile[k++] = *p;
+	  }
+	  profile[k] = '\0';
+
+	  for (int s = 0; s < RXPROF_NUM_STAGES; s++) {
+	    stage_sec[s] = 0;
+	    for (int ch = 0; ch < MAX_RADIO_CHANS; ch++) {
+	      stage_sec[s] += rxprof_get_seconds (ch, s);
+	    }
+	    accounted += stage_sec[s];
+	  }
+	  for (int ch = 0; ch < MAX_RADIO_CHANS; ch++) {
+	    samples += rxprof_get_samples (ch);
+	  }
+
+	  int paths = D->config.achan[0].num_subchan * D->config.achan[0].num_slicers;
+
+	  dw_printf ("BENCH wav=%s baud=%d profile=%s subchan=%d slicers=%d fix_bits=%d audio_sec=%.3f elapsed_sec=%.3f realtime=%.1f"
+			" samples=%lld path_samples_per_sec=%.0f decoded=%d",
+		argv[optind-1], D->config.achan[0].baud, k > 0 ? profile : "-",
+		D->config.achan[0].num_subchan, D->config.achan[0].num_slicers,
+		D->config.achan[0].fix_bits,
+		total_filetime, elapsed, total_filetime/elapsed,
+		(long long)samples, (double)samples * paths / elapsed, packets_decoded_total);
+	  for (int s = 0; s < RXPROF_NUM_STAGES; s++) {
+	    dw_printf (" %s_sec=%.3f", rxprof_stage_name(s), stage_sec[s]);
+	  }
+	  dw_printf (" other_sec=%.3f\n", elapsed > accounted ? elapsed - accounted : 0);
+	}
+
+	if (error_if_less_than != -1 && packets_decoded_total < error_if_less_than) {
+	  text_color_set(DW_COLOR_ERROR);
+	  dw_printf ("\n * * * TEST FAILED: number decoded is less than %d * * * \n", error_if_less_than);
+	  exit (EXIT_FAILURE);
+	}
+	if (error_if_greater_than != -1 && packets_decoded_total > error_if_greater_than) {
+	  text_color_set(DW_COLOR_ERROR);
+	  dw_printf ("\n * * * TEST FAILED: number decoded is greater than %d * * * \n", error_if_greater_than);
+	  exit (EXIT_FAILURE);
+	}
+
+	exit (EXIT_SUCCESS);
+}
+
+
+/*------------------------------------------------------------------
+ *
+ * Name:        set_modem_config
+ *
+ * Purpose:     Fill in the modem configuration for channel 0, and copy
+ *		to channel 1, from the -B, -g, -j, and -J options.
+ *
+ * Inputs:	pa	- Configuration to fill in.
+ *
+ *		profile	- Demodulator profile(s) from -P, or empty string
+ *			  for the default.
+ *
+ *------------------------------------------------------------------*/
+
+static void set_modem_config (struct audio_s *pa, char *profile)
+{
 /*
  * Set modem type based on data rate.
  * (Could be overridden by -g, -j, or -J later.)
@@ -423,64 +598,64 @@ int main (int argc, char *argv[])
 	/*    4800 implies V.27 8PSK. */
 	/*    9600 implies G3RUH baseband scrambled. */
 
-        my_audio_config.achan[0].baud = B_opt;
+        pa->achan[0].baud = B_opt;
 
 
 	/* We have similar logic in direwolf.c, config.c, gen_packets.c, and atest.c, */
 	/* that need to be kept in sync.  Maybe it could be a common function someday. */
 
-	if (my_audio_config.achan[0].baud == 100) {		// What was this for?
-	  my_audio_config.achan[0].modem_type = MODEM_AFSK;
-	  my_audio_config.achan[0].mark_freq = 1615;
-	  my_audio_config.achan[0].space_freq = 1785;
+	if (pa->achan[0].baud == 100) {		// What was this for?
+	  pa->achan[0].modem_type = MODEM_AFSK;
+	  pa->achan[0].mark_freq = 1615;
+	  pa->achan[0].space_freq = 1785;
 	}
-	else if (my_audio_config.achan[0].baud < 600) {		// e.g. HF SSB packet
-	  my_audio_config.achan[0].modem_type = MODEM_AFSK;
-	  my_audio_config.achan[0].mark_freq = 1600;
-	  my_audio_config.achan[0].space_freq = 1800;
+	else if (pa->achan[0].baud < 600) {		// e.g. HF SSB packet
+	  pa->achan[0].modem_type = MODEM_AFSK;
+	  pa->achan[0].mark_freq = 1600;
+	  pa->achan[0].space_freq = 1800;
 	  // Previously we had a "D" which was fine tuned for 300 bps.
 	  // In v1.7, it's not clear if we should use "B" or just stick with "A".
 	}
-	else if (my_audio_config.achan[0].baud < 1800) {	// common 1200
-	  my_audio_config.achan[0].modem_type = MODEM_AFSK;
-	  my_audio_config.achan[0].mark_freq = DEFAULT_MARK_FREQ;
-	  my_audio_config.achan[0].space_freq = DEFAULT_SPACE_FREQ;
-	}
-	else if (my_audio_config.achan[0].baud < 3600) {
-	  my_audio_config.achan[0].modem_type = MODEM_QPSK;
-	  my_audio_config.achan[0].mark_freq = 0;
-	  my_audio_config.achan[0].space_freq = 0;
-	  strlcpy (my_audio_config.achan[0].profiles, "", sizeof(my_audio_config.achan[0].profiles));
-	}
-	else if (my_audio_config.achan[0].baud < 7200) {
-	  my_audio_config.achan[0].modem_type = MODEM_8PSK;
-	  my_audio_config.achan[0].mark_freq = 0;
-	  my_audio_config.achan[0].space_freq = 0;
-	  strlcpy (my_audio_config.achan[0].profiles, "", sizeof(my_audio_config.achan[0].profiles));
-	}
-	else if (my_audio_config.achan[0].baud == BAUD_SENTINEL_AIS) {	// Hack for different use of 9600
-	  my_audio_config.achan[0].modem_type = MODEM_AIS;
-	  my_audio_config.achan[0].baud = 9600;
-	  my_audio_config.achan[0].mark_freq = 0;
-	  my_audio_config.achan[0].space_freq = 0;
-	  strlcpy (my_audio_config.achan[0].profiles, " ", sizeof(my_audio_config.achan[0].profiles));	// avoid getting default later.
-	}
-	else if (my_audio_config.achan[0].baud == BAUD_SENTINEL_EAS) {
-	  my_audio_config.achan[0].modem_type = MODEM_EAS;
-	  my_audio_config.achan[0].baud = 521;	// Actually 520.83 but we have an integer field here.
+	else if (pa->achan[0].baud < 1800) {	// common 1200
+	  pa->achan[0].modem_type = MODEM_AFSK;
+	  pa->achan[0].mark_freq = DEFAULT_MARK_FREQ;
+	  pa->achan[0].space_freq = DEFAULT_SPACE_FREQ;
+	}
+	else if (pa->achan[0].baud < 3600) {
+	  pa->achan[0].modem_type = MODEM_QPSK;
+	  pa->achan[0].mark_freq = 0;
+	  pa->achan[0].space_freq = 0;
+	  strlcpy (pa->achan[0].profiles, "", sizeof(pa->achan[0].profiles));
+	}
+	else if (pa->achan[0].baud < 7200) {
+	  pa->achan[0].modem_type = MODEM_8PSK;
+	  pa->achan[0].mark_freq = 0;
+	  pa->achan[0].space_freq = 0;
+	  strlcpy (pa->achan[0].profiles, "", sizeof(pa->achan[0].profiles));
+	}
+	else if (pa->achan[0].baud == BAUD_SENTINEL_AIS) {	// Hack for different use of 9600
+	  pa->achan[0].modem_type = MODEM_AIS;
+	  pa->achan[0].baud = 9600;
+	  pa->achan[0].mark_freq = 0;
+	  pa->achan[0].space_freq = 0;
+	  strlcpy (pa->achan[0].profiles, " ", sizeof(pa->achan[0].profiles));	// avoid getting default later.
+	}
+	else if (pa->achan[0].baud == BAUD_SENTINEL_EAS) {
+	  pa->achan[0].modem_type = MODEM_EAS;
+	  pa->achan[0].baud = 521;	// Actually 520.83 but we have an integer field here.
 						// Will make more precise in afsk demod init.
-	  my_audio_config.achan[0].mark_freq = 2083;	// Actually 2083.3 - logic 1.
-	  my_audio_config.achan[0].space_freq = 1563;	// Actually 1562.5 - logic 0.
-	  strlcpy (my_audio_config.achan[0].profiles, "A", sizeof(my_audio_config.achan[0].profiles));
+	  pa->achan[0].mark_freq = 2083;	// Actually 2083.3 - logic 1.
+	  pa->achan[0].space_freq = 1563;	// Actually 1562.5 - logic 0.
+	  strlcpy (pa->achan[0].profiles, "A", sizeof(pa->achan[0].profiles));
 	}
 	else {
-	  my_audio_config.achan[0].modem_type = MODEM_SCRAMBLE;
-	  my_audio_config.achan[0].mark_freq = 0;
-	  my_audio_config.achan[0].space_freq = 0;
-	  strlcpy (my_audio_config.achan[0].profiles, " ", sizeof(my_audio_config.achan[0].profiles));	// avoid getting default later.
+	  pa->achan[0].modem_type = MODEM_SCRAMBLE;
+	  pa->achan[0].mark_freq = 0;
+	  pa->achan[0].space_freq = 0;
+	  strlcpy (pa->achan[0].profiles, " ", sizeof(pa->achan[0].profiles));	// avoid getting default later.
 	}
 
-        if (my_audio_config.achan[0].baud < MIN_BAUD || my_audio_config.achan[0].baud > MAX_BAUD) {
+        if (pa->achan[0].baud < MIN_BAUD || pa->achan[0].baud > MAX_BAUD) {
 	  text_color_set(DW_COLOR_ERROR);
           dw_printf ("Use a more reasonable bit rate in range of %d - %d.\n", MIN_BAUD, MAX_BAUD);
           exit (EXIT_FAILURE);
@@ -491,10 +666,10 @@ int main (int argc, char *argv[])
  */
 
 	if (g_opt) {
-          my_audio_config.achan[0].modem_type = MODEM_SCRAMBLE;
-          my_audio_config.achan[0].mark_freq = 0;
-          my_audio_config.achan[0].space_freq = 0;
-	  strlcpy (my_audio_config.achan[0].profiles, " ", sizeof(my_audio_config.achan[0].profiles));	// avoid getting default later.
+          pa->achan[0].modem_type = MODEM_SCRAMBLE;
+          pa->achan[0].mark_freq = 0;
+          pa->achan[0].space_freq = 0;
+	  strlcpy (pa->achan[0].profiles, " ", sizeof(pa->achan[0].profiles));	// avoid getting default later.
 	}
 
 /*
@@ -505,54 +680,104 @@ int main (int argc, char *argv[])
 	  // V.26 compatible with earlier versions of direwolf.
 	  //   Example:   -B 2400 -j    or simply   -j
 
-	  my_audio_config.achan[0].v26_alternative = V26_A;
-          my_audio_config.achan[0].modem_type = MODEM_QPSK;
-          my_audio_config.achan[0].mark_freq = 0;
-          my_audio_config.achan[0].space_freq = 0;
-	  my_audio_config.achan[0].baud = 2400;
-	  strlcpy (my_audio_config.achan[0].profiles, "", sizeof(my_audio_config.achan[0].profiles));
+	  pa->achan[0].v26_alternative = V26_A;
+          pa->achan[0].modem_type = MODEM_QPSK;
+          pa->achan[0].mark_freq = 0;
+          pa->achan[0].space_freq = 0;
+	  pa->achan[0].baud = 2400;
+	  strlcpy (pa->achan[0].profiles, "", sizeof(pa->achan[0].profiles));
 	}
 	if (J_opt) {
 
 	  // V.26 compatible with MFJ and maybe others.
 	  //   Example:   -B 2400 -J     or simply   -J
 
-	  my_audio_config.achan[0].v26_alternative = V26_B;
-          my_audio_config.achan[0].modem_type = MODEM_QPSK;
-          my_audio_config.achan[0].mark_freq = 0;
-          my_audio_config.achan[0].space_freq = 0;
-	  my_audio_config.achan[0].baud = 2400;
-	  strlcpy (my_audio_config.achan[0].profiles, "", sizeof(my_audio_config.achan[0].profiles));
+	  pa->achan[0].v26_alternative = V26_B;
+          pa->achan[0].modem_type = MODEM_QPSK;
+          pa->achan[0].mark_freq = 0;
+          pa->achan[0].space_freq = 0;
+	  pa->achan[0].baud = 2400;
+	  strlcpy (pa->achan[0].profiles, "", sizeof(pa->achan[0].profiles));
 	}
 
 	// Needs to be after -B, -j, -J.
-	if (strlen(P_opt) > 0) {
-	  dw_printf ("Demodulator profile set to \"%s\"\n", P_opt);
-	  strlcpy (my_audio_config.achan[0].profiles, P_opt, sizeof(my_audio_config.achan[0].profiles));
+	if (strlen(profile) > 0) {
+	  dw_printf ("Demodulator profile set to \"%s\"\n", profile);
+	  strlcpy (pa->achan[0].profiles, profile, sizeof(pa->achan[0].profiles));
 	}
 
-	memcpy (&my_audio_config.achan[1], &my_audio_config.achan[0], sizeof(my_audio_config.achan[0]));
+	memcpy (&pa->achan[1], &pa->achan[0], sizeof(pa->achan[0]));
 
+} /* end set_modem_config */
 
-	if (optind >= argc) {
+
+/*------------------------------------------------------------------
+ *
+ * Name:        decode_new
+ *
+ * Purpose:     Allocate the state for decoding files.
+ *
+ * Inputs:	pa	- Modem configuration, from set_modem_config.
+ *			  A copy is kept so each can be different.
+ *
+ * Returns:	Pointer to new structure.  Exits if out of memory.
+ *
+ *------------------------------------------------------------------*/
+
+static struct decode_s *decode_new (struct audio_s *pa)
+{
+	struct decode_s *D = calloc (1, sizeof(struct decode_s));
+	if (D == NULL) {
 	  text_color_set(DW_COLOR_ERROR);
-	  dw_printf ("Specify .WAV file name on command line.\n");
-	  usage ();
+	  dw_printf ("FATAL ERROR: Out of memory.\n");
+	  exit (EXIT_FAILURE);
 	}
+	memcpy (&D->config, pa, sizeof(struct audio_s));
+	D->sample_number = -1;
+	return (D);
+}
 
-	fx25_init (d_x_opt);
-	il2p_init (d_2_opt);
 
-	start_time = dtime_now();
+/*------------------------------------------------------------------
+ *
+ * Name:        decode_wav_file
+ *
+ * Purpose:     Run one .WAV file through the receive chain.
+ *
+ * Inputs:	D		- From decode_new.  D->config is the
+ *				  modem configuration.
+ *
+ *		fname		- File name.
+ *
+ * Outputs:	duration	- Length of the audio in seconds.
+ *
+ * Returns:	Number of packets decoded.
+ *		-1 if the file could not be read.
+ *
+ *------------------------------------------------------------------*/
 
-	while (optind < argc) {
+static dw_mutex_t chain_init_lock;	/* See rx_chain.h. */
+
+static int decode_wav_file (struct decode_s *D, char *fname, double *duration)
+{
+	struct riff_header_s header;
+	struct riff_chunk_s chunk;
+	struct wav_format_s format;
+	struct riff_chunk_s wav_data;
+	int err;
+	int c;
+#if EXPERIMENT_G || EXPERIMENT_H
+	int j;
+#endif
+
+	this_decode = D;
 
-	fp = fopen(argv[optind], "rb");
-        if (fp == NULL) {
+	D->fp = fopen(fname, "rb");
+        if (D->fp == NULL) {
 	  text_color_set(DW_COLOR_ERROR);
-          dw_printf ("Couldn't open file for read: %s\n", argv[optind]);
+          dw_printf ("Couldn't open file for read: %s\n", fname);
 	  //perror ("more info?");
-          exit (EXIT_FAILURE);
+          return (-1);
         }
 
 /*
@@ -560,120 +785,160 @@ int main (int argc, char *argv[])
  * Doesn't handle all possible cases but good enough for our purposes.
  */
 
-        err= fread (&header, (size_t)12, (size_t)1, fp);
+        err= fread (&header, (size_t)12, (size_t)1, D->fp);
 	(void)(err);
 
 	if (strncmp(header.riff, "RIFF", 4) != 0 || strncmp(header.wave, "WAVE", 4) != 0) {
 	  text_color_set(DW_COLOR_ERROR);
           dw_printf ("This is not a .WAV format file.\n");
-          exit (EXIT_FAILURE);
+	  fclose (D->fp);
+          return (-1);
 	}
 
-	err = fread (&chunk, (size_t)8, (size_t)1, fp);
+	err = fread (&chunk, (size_t)8, (size_t)1, D->fp);
 
 	if (strncmp(chunk.id, "LIST", 4) == 0) {
-	  err = fseek (fp, (long)chunk.datasize, SEEK_CUR);
-	  err = fread (&chunk, (size_t)8, (size_t)1, fp);
+	  err = fseek (D->fp, (long)chunk.datasize, SEEK_CUR);
+	  err = fread (&chunk, (size_t)8, (size_t)1, D->fp);
 	}
 
 	if (strncmp(chunk.id, "fmt ", 4) != 0) {
 	  text_color_set(DW_COLOR_ERROR);
           dw_printf ("WAV file error: Found \"%4.4s\" where \"fmt \" was expected.\n", chunk.id);
-	  exit(EXIT_FAILURE);
+	  fclose (D->fp);
+	  return (-1);
 	}
-	if (chunk.datasize != 16 && chunk.datasize != 18) {
+	if (chunk.datasize != 16 && chunk.datasize != 18 && chunk.datasize != 40) {
 	  text_color_set(DW_COLOR_ERROR);
-          dw_printf ("WAV file error: Need fmt chunk datasize of 16 or 18.  Found %d.\n", chunk.datasize);
-	  exit(EXIT_FAILURE);
+          dw_printf ("WAV file error: Need fmt chunk datasize of 16, 18, or 40.  Found %d.\n", chunk.datasize);
+	  fclose (D->fp);
+	  return (-1);
 	}
 
-        err = fread (&format, (size_t)chunk.datasize, (size_t)1, fp);	
+        err = fread (&format, (size_t)chunk.datasize, (size_t)1, D->fp);	
 
-	err = fread (&wav_data, (size_t)8, (size_t)1, fp);
+	err = fread (&wav_data, (size_t)8, (size_t)1, D->fp);
 
-	if (strncmp(wav_data.data, "data", 4) != 0) {
+	if (strncmp(wav_data.id, "data", 4) != 0) {
 	  text_color_set(DW_COLOR_ERROR);
-          dw_printf ("WAV file error: Found \"%4.4s\" where \"data\" was expected.\n", wav_data.data);
-	  exit(EXIT_FAILURE);
+          dw_printf ("WAV file error: Found \"%4.4s\" where \"data\" was expected.\n", wav_data.id);
+	  fclose (D->fp);
+	  return (-1);
+	}
+
+	int tag = format.wformattag & 0xffff;
+
+	if (tag == 0xfffe) {		// WAVE_FORMAT_EXTENSIBLE
+	  if (chunk.datasize != 40) {
+	    text_color_set(DW_COLOR_ERROR);
+	    dw_printf ("WAV file error: Extensible format needs fmt chunk datasize of 40.  Found %d.\n", chunk.datasize);
+	    fclose (D->fp);
+	    return (-1);
+	  }
+	  tag = format.subformat[0] | (format.subformat[1] << 8);
 	}
 
-	if (format.wformattag != 1) {
+	if (tag != 1 && tag != 3) {
 	  text_color_set(DW_COLOR_ERROR);
-	  dw_printf ("Sorry, I only understand audio format 1 (PCM).  This file has %d.\n", format.wformattag);
-	  exit (EXIT_FAILURE);
+	  dw_printf ("Sorry, I only understand audio format 1 (PCM) or 3 (float).  This file has %d.\n", tag);
+	  fclose (D->fp);
+	  return (-1);
 	}
 
 	if (format.nchannels != 1 && format.nchannels != 2) {
 	  text_color_set(DW_COLOR_ERROR);
 	  dw_printf ("Sorry, I only understand 1 or 2 channels.  This file has %d.\n", format.nchannels);
-	  exit (EXIT_FAILURE);
+	  fclose (D->fp);
+	  return (-1);
 	}
 
-	if (format.wbitspersample != 8 && format.wbitspersample != 16) {
+	if (tag == 3 && format.wbitspersample != 32) {
 	  text_color_set(DW_COLOR_ERROR);
-	  dw_printf ("Sorry, I only understand 8 or 16 bits per sample.  This file has %d.\n", format.wbitspersample);
-	  exit (EXIT_FAILURE);
+	  dw_printf ("Sorry, I only understand 32 bit floating point.  This file has %d bits per sample.\n", format.wbitspersample);
+	  fclose (D->fp);
+	  return (-1);
 	}
 
-        my_audio_config.adev[0].samples_per_sec = format.nsamplespersec;
-	my_audio_config.adev[0].bits_per_sample = format.wbitspersample;
- 	my_audio_config.adev[0].num_channels = format.nchannels;
+	if (format.wbitspersample != 8 && format.wbitspersample != 16 &&
+	    format.wbitspersample != 24 && format.wbitspersample != 32) {
+	  text_color_set(DW_COLOR_ERROR);
+	  dw_printf ("Sorry, I only understand 8, 16, 24, or 32 bits per sample.  This file has %d.\n", format.wbitspersample);
+	  fclose (D->fp);
+	  return (-1);
+	}
+
+	D->datasize = wav_data.datasize;
 
-	my_audio_config.chan_medium[0] = MEDIUM_RADIO;
+        D->config.adev[0].samples_per_sec = format.nsamplespersec;
+	D->config.adev[0].bits_per_sample = format.wbitspersample;
+	D->config.adev[0].float_samples = (tag == 3);
+ 	D->config.adev[0].num_channels = format.nchannels;
+
+	D->config.chan_medium[0] = MEDIUM_RADIO;
 	if (format.nchannels == 2) {
-	  my_audio_config.chan_medium[1] = MEDIUM_RADIO;
+	  D->config.chan_medium[1] = MEDIUM_RADIO;
 	}
 
 	text_color_set(DW_COLOR_INFO);
-	dw_printf ("%d samples per second.  %d bits per sample.  %d audio channels.\n",
-		my_audio_config.adev[0].samples_per_sec,
-		my_audio_config.adev[0].bits_per_sample,
-		(int)(my_audio_config.adev[0].num_channels));
+	dw_printf ("%d samples per second.  %d bits per sample%s.  %d audio channels.\n",
+		D->config.adev[0].samples_per_sec,
+		D->config.adev[0].bits_per_sample,
+		D->config.adev[0].float_samples ? " float" : "",
+		(int)(D->config.adev[0].num_channels));
 	// nnum_channels is known to be 1 or 2.
-	one_filetime = (double) wav_data.datasize /
-		((my_audio_config.adev[0].bits_per_sample / 8) * (int)(my_audio_config.adev[0].num_channels) * my_audio_config.adev[0].samples_per_sec);
-	total_filetime += one_filetime;
+	*duration = (double) wav_data.datasize /
+		((D->config.adev[0].bits_per_sample / 8) * (int)(D->config.adev[0].num_channels) * D->config.adev[0].samples_per_sec);
 
 	dw_printf ("%d audio bytes in file.  Duration = %.1f seconds.\n",
 		(int)(wav_data.datasize),
-		one_filetime);
-	dw_printf ("Fix Bits level = %d\n", my_audio_config.achan[0].fix_bits);
+		*duration);
+	dw_printf ("Fix Bits level = %d\n", D->config.achan[0].fix_bits);
 		
 /*
  * Initialize the AFSK demodulator and HDLC decoder.
  * Needs to be done for each file because they could have different sample rates.
+ * Chains of our own, for run_matrix, are set up one at a time.
  */
-	multi_modem_init (&my_audio_config);
-	packets_decoded_one = 0;
+	if (D->own_chains) {
+	  dw_mutex_lock (&chain_init_lock);
+	  for (c = 0; c < (int)(D->config.adev[0].num_channels); c++) {
+	    multi_modem_chain_init (D->chain[c], &D->config);
+	  }
+	  dw_mutex_unlock (&chain_init_lock);
+	}
+	else {
+	  multi_modem_init (&D->config);
+	  for (c = 0; c < (int)(D->config.adev[0].num_channels); c++) {
+	    D->chain[c] = rx_chain_get(c);
+	  }
+	}
+	D->packets_decoded = 0;
 
 
-	e_o_f = 0;
-	while ( ! e_o_f) 
+	D->e_o_f = 0;
+	while ( ! D->e_o_f) 
 	{
 
 
-          int audio_sample;
-          int c;
+          float audio_sample;
 
-          for (c=0; c<(int)(my_audio_config.adev[0].num_channels); c++)
+          for (c=0; c<(int)(D->config.adev[0].num_channels); c++)
           {
 
-            /* This reads either 1 or 2 bytes depending on */
+            /* This reads 1, 2, 3, or 4 bytes depending on */
             /* bits per sample.  */
 
-            audio_sample = demod_get_sample (ACHAN2ADEV(c));
-
-            if (audio_sample >= 256 * 256) {
-               e_o_f = 1;
+            if (demod_chain_get_sample (D->chain[c], D->config.chan_adev[c], &audio_sample) < 0) {
+               D->e_o_f = 1;
 	       continue;
 	    }
 
-	    if (c == 0) sample_number++;
+	    if (c == 0) D->sample_number++;
 
             if (decode_only == 0 && c != 0) continue;
             if (decode_only == 1 && c != 1) continue;
 
-            multi_modem_process_sample(c,audio_sample);
+            multi_modem_process_sample(D->chain[c],audio_sample);
           }
 
                 /* When a complete frame is accumulated, */
@@ -686,8 +951,7 @@ int main (int argc, char *argv[])
 #if EXPERIMENT_G
 
 	for (j=0; j<MAX_SUBCHANS; j++) {
-	  float db = 20.0 * log10f(space_gain[j]);
-	  dw_printf ("%+.1f dB, %d\n", db, count[j]);
+	  dw_printf ("slicer %d, %d\n", j, count[j]);
 	}
 #endif
 #if EXPERIMENT_H
@@ -697,34 +961,305 @@ int main (int argc, char *argv[])
 	}
 #endif
 
-	dw_printf ("%d from %s\n", packets_decoded_one, argv[optind]);
-	packets_decoded_total += packets_decoded_one;
+	dw_printf ("%d from %s\n", D->packets_decoded, fname);
 
-	fclose (fp);
-	optind++;
+	fclose (D->fp);
+
+	return (D->packets_decoded);
+
+} /* end decode_wav_file */
+
+
+/*------------------------------------------------------------------
+ *
+ * Name:        run_matrix
+ *
+ * Purpose:     Decode every combination of file, profile, and fix bits
+ *		level as a separate job and print a table of the results.
+ *
+ * Inputs:	num_files, files	- .WAV files from the command line.
+ *
+ *		P_opt or P_list		- Profile or comma separated list.
+ *
+ *		F_list			- Comma separated list of fix bits levels.
+ *					  Otherwise use the single -F value.
+ *
+ *		t_opt			- How many jobs to run at once.
+ *
+ *		error_if_less_than,	- -L and -G limits, checked for each job.
+ *		error_if_greater_than
+ *
+ * Returns:	Number of jobs that failed.
+ *
+ * Description:	Tuning the demodulators can mean hundreds of combinations
+ *		of test files and settings.  Run them on all the processors.
+ *
+ *		Each thread has its own receive chains, from rx_chain_create,
+ *		and its own decode_s, so nothing is shared while decoding.
+ *		The results are the same as running atest separately for
+ *		each combination.
+ *
+ *		Output from the jobs is thrown away, except for the table,
+ *		because it would all be mixed together.
+ *
+ *------------------------------------------------------------------*/
+
+#define MAX_MATRIX_PROFILES 16
+#define MAX_MATRIX_FIX 8
+
+struct job_s {
+	char *fname;
+	char profile[16];
+	int fix_bits;
+	int done;		// Set when results below are valid.
+	int decoded;		// Number of packets decoded.
+	double duration;	// Length of audio, seconds.
+	double elapsed;		// Time to process it, seconds.
+};
+
+struct matrix_s {
+	struct audio_s *config;	// From the command line options.
+	struct job_s *jobs;
+	int num_jobs;
+	int next;		// Next job to be taken by a thread.
+	dw_mutex_t next_lock;
+};
+
+
+static void matrix_output (FILE *fp, const char *buf, int len, int color)
+{
+	if (this_decode != NULL && this_decode->quiet) {
+	  return;
 	}
+	fwrite (buf, 1, len, fp);
+	if (fp != stdout) {
+	  fflush (fp);
+	}
+}
 
-	elapsed = dtime_now() - start_time;
 
-	dw_printf ("%d packets decoded in %.3f seconds.  %.1f x realtime\n", packets_decoded_total, elapsed, total_filetime/elapsed);
-	if (d_o_opt) {
-	  dw_printf ("DCD count = %d\n", dcd_count);
-	  dw_printf ("DCD missing errors = %d\n", dcd_missing_errors);
+#if __WIN32__
+static unsigned __stdcall matrix_thread (void *arg)
+#else
+static void * matrix_thread (void *arg)
+#endif
+{
+	struct matrix_s *M = (struct matrix_s *)arg;
+	struct decode_s *D = decode_new (M->config);
+
+	D->own_chains = 1;
+	D->chain[0] = rx_chain_create (0);
+	D->chain[1] = rx_chain_create (1);
+	D->quiet = 1;
+	this_decode = D;
+
+	while (1) {
+	  int n;
+
+	  dw_mutex_lock (&(M->next_lock));
+	  n = M->next < M->num_jobs ? M->next++ : -1;
+	  dw_mutex_unlock (&(M->next_lock));
+
+	  if (n < 0) {
+	    break;
+	  }
+
+	  struct job_s *J = &(M->jobs[n]);
+
+	  memcpy (&(D->config), M->config, sizeof(struct audio_s));
+	  D->config.achan[0].fix_bits = J->fix_bits;
+	  set_modem_config (&(D->config), J->profile);
+	  D->sample_number = -1;
+
+	  double start = dtime_now();
+	  J->decoded = decode_wav_file (D, J->fname, &(J->duration));
+	  J->elapsed = dtime_now() - start;
+	  J->done = J->decoded >= 0;
 	}
 
-	if (error_if_less_than != -1 && packets_decoded_total < error_if_less_than) {
+	// The chains are reused for every job this thread does and
+	// there is no way to take one apart.  They go away at exit.
+
+	free (D);
+	return (0);
+}
+
+
+static int run_matrix (int num_files, char *files[])
+{
+	char profiles[MAX_MATRIX_PROFILES][16];
+	int num_profiles = 0;
+	int fix_levels[MAX_MATRIX_FIX];
+	int num_fix = 0;
+	char list[80];
+	char *p, *save;
+	struct matrix_s M;
+
+	if (strlen(P_list) > 0) {
+	  strlcpy (list, P_list, sizeof(list));
+	  for (p = strtok_r(list, ",", &save); p != NULL; p = strtok_r(NULL, ",", &save)) {
+	    if (num_profiles >= MAX_MATRIX_PROFILES || strlen(p) >= sizeof(profiles[0])) {
+	      text_color_set(DW_COLOR_ERROR);
+	      dw_printf ("Too many profiles, or too long, in -P %s\n", P_list);
+	      exit (EXIT_FAILURE);
+	    }
+	    strlcpy (profiles[num_profiles++], p, sizeof(profiles[0]));
+	  }
+	}
+	else {
+	  strlcpy (profiles[num_profiles++], P_opt, sizeof(profiles[0]));
+	}
+
+	if (strlen(F_list) > 0) {
+	  strlcpy (list, F_list, sizeof(list));
+	  for (p = strtok_r(list, ",", &save); p != NULL; p = strtok_r(NULL, ",", &save)) {
+	    int f = atoi(p);
+	    if (num_fix >= MAX_MATRIX_FIX || f < RETRY_NONE || f >= RETRY_MAX) {
+	      text_color_set(DW_COLOR_ERROR);
+	      dw_printf ("Too many, or invalid, Fix Bits levels in -F %s\n", F_list);
+	      exit (EXIT_FAILURE);
+	    }
+	    fix_levels[num_fix++] = f;
+	  }
+	}
+	else {
+	  fix_levels[num_fix++] = my_audio_config.achan[0].fix_bits;
+	}
+
+	M.config = &my_audio_config;
+	M.num_jobs = num_files * num_profiles * num_fix;
+	M.jobs = calloc (M.num_jobs, sizeof(struct job_s));
+	M.next = 0;
+	dw_mutex_init (&(M.next_lock));
+	dw_mutex_init (&chain_init_lock);
+
+	if (M.jobs == NULL) {
 	  text_color_set(DW_COLOR_ERROR);
-	  dw_printf ("\n * * * TEST FAILED: number decoded is less than %d * * * \n", error_if_less_than);
+	  dw_printf ("FATAL ERROR: Out of memory.\n");
 	  exit (EXIT_FAILURE);
 	}
-	if (error_if_greater_than != -1 && packets_decoded_total > error_if_greater_than) {
+
+	int n = 0;
+	for (int f = 0; f < num_files; f++) {
+	  for (int pr = 0; pr < num_profiles; pr++) {
+	    for (int fx = 0; fx < num_fix; fx++) {
+	      M.jobs[n].fname = files[f];
+	      strlcpy (M.jobs[n].profile, profiles[pr], sizeof(M.jobs[n].profile));
+	      M.jobs[n].fix_bits = fix_levels[fx];
+	      n++;
+	    }
+	  }
+	}
+
+	int num_threads = t_opt;
+	if (num_threads <= 0) {
+#if __WIN32__
+	  SYSTEM_INFO si;
+	  GetSystemInfo (&si);
+	  num_threads = (int)(si.dwNumberOfProcessors);
+#else
+	  num_threads = (int)sysconf(_SC_NPROCESSORS_ONLN);
+#endif
+	}
+	if (num_threads > M.num_jobs) num_threads = M.num_jobs;
+	if (num_threads < 1) num_threads = 1;
+
+	text_color_set(DW_COLOR_INFO);
+	dw_printf ("Running %d jobs, %d at a time.\n", M.num_jobs, num_threads);
+
+	text_output_set (matrix_output);
+
+	double start_time = dtime_now();
+
+#if __WIN32__
+	HANDLE *th = calloc (num_threads, sizeof(HANDLE));
+#else
+	pthread_t *tid = calloc (num_threads, sizeof(pthread_t));
+#endif
+	for (int t = 0; t < num_threads; t++) {
+#if __WIN32__
+	  th[t] = (HANDLE)_beginthreadex (NULL, 0, matrix_thread, (void *)(&M), 0, NULL);
+	  if (th[t] == NULL) {
+	    text_color_set(DW_COLOR_ERROR);
+	    dw_printf ("Could not create thread for jobs.\n");
+	    exit (EXIT_FAILURE);
+	  }
+#else
+	  if (pthread_create (&tid[t], NULL, matrix_thread, (void *)(&M)) != 0) {
+	    text_color_set(DW_COLOR_ERROR);
+	    perror ("Could not create thread for jobs");
+	    exit (EXIT_FAILURE);
+	  }
+#endif
+	}
+	for (int t = 0; t < num_threads; t++) {
+#if __WIN32__
+	  WaitForSingleObject (th[t], INFINITE);
+	  CloseHandle (th[t]);
+#else
+	  pthread_join (tid[t], NULL);
+#endif
+	}
+#if __WIN32__
+	free (th);
+#else
+	free (tid);
+#endif
+
+	double elapsed = dtime_now() - start_time;
+
+	text_output_set (NULL);
+
+/*
+ * Table of results.
+ */
+	int failed = 0;
+	double cpu = 0;
+
+	text_color_set(DW_COLOR_INFO);
+	dw_printf ("\n");
+	dw_printf ("%-30s  %-8s  %3s  %7s  %9s  %8s  %9s\n", "File", "Profile", "Fix", "Decoded", "Audio sec", "Time sec", "xRealtime");
+	dw_printf ("%-30s  %-8s  %3s  %7s  %9s  %8s  %9s\n", "----", "-------", "---", "-------", "---------", "--------", "---------");
+
+	for (n = 0; n < M.num_jobs; n++) {
+	  struct job_s *J = &(M.jobs[n]);
+
+	  if (J->done) {
+	    int too_few = error_if_less_than != -1 && J->decoded < error_if_less_than;
+	    int too_many = error_if_greater_than != -1 && J->decoded > error_if_greater_than;
+
+	    if (too_few || too_many) {
+	      text_color_set(DW_COLOR_ERROR);
+	      failed++;
+	    }
+	    dw_printf ("%-30s  %-8s  %3d  %7d  %9.1f  %8.3f  %9.1f%s\n", J->fname,
+			strlen(J->profile) > 0 ? J->profile : "-", J->fix_bits, J->decoded,
+			J->duration, J->elapsed,
+			J->elapsed > 0 ? J->duration / J->elapsed : 0,
+			too_few ? "  less than -L" : too_many ? "  greater than -G" : "");
+	    text_color_set(DW_COLOR_INFO);
+	    cpu += J->elapsed;
+	  }
+	  else {
+	    text_color_set(DW_COLOR_ERROR);
+	    dw_printf ("%-30s  %-8s  %3d  FAILED\n", J->fname,
+			strlen(J->profile) > 0 ? J->profile : "-", J->fix_bits);
+	    text_color_set(DW_COLOR_INFO);
+	    failed++;
+	  }
+	}
+
+	dw_printf ("\n%d jobs in %.3f seconds using %d threads.  %.3f seconds of processing.\n",
+			M.num_jobs, elapsed, num_threads, cpu);
+	if (failed) {
 	  text_color_set(DW_COLOR_ERROR);
-	  dw_printf ("\n * * * TEST FAILED: number decoded is greater than %d * * * \n", error_if_greater_than);
-	  exit (EXIT_FAILURE);
+	  dw_printf ("%d jobs failed.  Run atest separately for those to see why.\n", failed);
 	}
 
-	exit (EXIT_SUCCESS);
-}
+	free (M.jobs);
+	return (failed);
+
+} /* end run_matrix */
 
 
 /*
@@ -733,20 +1268,21 @@ int main (int argc, char *argv[])
 
 int audio_get (int a)
 {
+	struct decode_s *D = this_decode;
 	int ch;
 
-	if (wav_data.datasize <= 0) {
-	  e_o_f = 1;
+	if (D->datasize <= 0) {
+	  D->e_o_f = 1;
 	  return (-1);
 	}
 
-	ch = getc(fp);
-	wav_data.datasize--;
+	ch = getc(D->fp);
+	D->datasize--;
 
 	if (ch < 0) {
 	  text_color_set(DW_COLOR_ERROR);
 	  dw_printf ("Unexpected end of file.\n");
-	  e_o_f = 1;
+	  D->e_o_f = 1;
 	}
 
 	return (ch);
@@ -767,9 +1303,15 @@ void dlq_rec_frame (int chan, int subchan, int slice, packet_t pp, alevel_t alev
 	int h;
 	char heard[2 * AX25_MAX_ADDR_LEN + 20];
 	char alevel_text[AX25_ALEVEL_TO_TEXT_SIZE];
+	struct decode_s *D = this_decode;
+
+	D->packets_decoded++;
+	if ( ! hdlc_rec_chain_data_detect_any(D->chain[chan])) D->dcd_missing_errors++;
 
-	packets_decoded_one++;
-	if ( ! hdlc_rec_data_detect_any(chan)) dcd_missing_errors++;
+	if (q_opt || D->quiet) {		/* Only the count at the end. */
+	  ax25_delete (pp);
+	  return;
+	}
 
 	ax25_format_addrs (pp, stemp);
 
@@ -777,8 +1319,6 @@ void dlq_rec_frame (int chan, int subchan, int slice, packet_t pp, alevel_t alev
 
 	/* Print so we can see what is going on. */
 
-//TODO: quiet option - suppress packet printing, only the count at the end.
-
 #if 1
 	/* Display audio input level. */
         /* Who are we hearing?   Original station or digipeater? */
@@ -795,11 +1335,11 @@ void dlq_rec_frame (int chan, int subchan, int slice, packet_t pp, alevel_t alev
 
 	text_color_set(DW_COLOR_DEBUG);
 	dw_printf ("\n");
-	dw_printf("DECODED[%d] ", packets_decoded_one );
+	dw_printf("DECODED[%d] ", D->packets_decoded );
 
 	/* Insert time stamp relative to start of file. */
 
-	double sec = (double)sample_number / my_audio_config.adev[0].samples_per_sec;
+	double sec = (double)D->sample_number / D->config.adev[0].samples_per_sec;
 	int min = (int)(sec / 60.);
 	sec -= min * 60;
 
@@ -839,7 +1379,7 @@ void dlq_rec_frame (int chan, int subchan, int slice, packet_t pp, alevel_t alev
 
 	  case fec_type_none:
 	  default:
-	    if (my_audio_config.achan[chan].fix_bits == RETRY_NONE && my_audio_config.achan[chan].passall == 0) {
+	    if (D->config.achan[chan].fix_bits == RETRY_NONE && D->config.achan[chan].passall == 0) {
 	      // No fix_bits or passall specified.
 	      dw_printf ("%s audio level = %s     %s\n", heard, alevel_text, spectrum);
 	    }
@@ -864,13 +1404,13 @@ void dlq_rec_frame (int chan, int subchan, int slice, packet_t pp, alevel_t alev
 	  text_color_set(DW_COLOR_DEBUG);
 	}
 
-	if (my_audio_config.achan[chan].num_subchan > 1 && my_audio_config.achan[chan].num_slicers == 1) {
+	if (D->config.achan[chan].num_subchan > 1 && D->config.achan[chan].num_slicers == 1) {
 	  dw_printf ("[%d.%d] ", chan, subchan);
 	}
-	else if (my_audio_config.achan[chan].num_subchan == 1 && my_audio_config.achan[chan].num_slicers > 1) {
+	else if (D->config.achan[chan].num_subchan == 1 && D->config.achan[chan].num_slicers > 1) {
 	  dw_printf ("[%d.%d] ", chan, slice);
 	}
-	else if (my_audio_config.achan[chan].num_subchan > 1 && my_audio_config.achan[chan].num_slicers > 1) {
+	else if (D->config.achan[chan].num_subchan > 1 && D->config.achan[chan].num_slicers > 1) {
 	  dw_printf ("[%d.%d.%d] ", chan, subchan, slice);
 	}
 	else {
@@ -924,8 +1464,10 @@ void ptt_set (int ot, int chan, int ptt_signal)
 	// Should only get here for DCD output control.
 	static double dcd_start_time[MAX_RADIO_CHANS];
 
+	struct decode_s *D = this_decode;
+
 	if (d_o_opt) {
-	  double t = (double)sample_number / my_audio_config.adev[0].samples_per_sec;
+	  double t = (double)D->sample_number / D->config.adev[0].samples_per_sec;
 	  double sec1, sec2;
 	  int min1, min2;
 
@@ -936,7 +1478,7 @@ void ptt_set (int ot, int chan, int ptt_signal)
 	    //min1 = (int)(sec1 / 60.);
 	    //sec1 -= min1 * 60;
 	    //dw_printf ("DCD[%d] = ON    %d:%06.3f\n",  chan, min1, sec1);
-	    dcd_count++;
+	    D->dcd_count++;
 	    dcd_start_time[chan] = t;
 	  }
 	  else {
@@ -998,6 +1540,17 @@ static void usage (void) {
 	dw_printf ("\n");
 	dw_printf ("        -d x   Debug information for FX.25.  Repeat for more detail.\n");
 	dw_printf ("\n");
+	dw_printf ("        -q     Quiet.  Don't display each decoded frame.\n");
+	dw_printf ("\n");
+	dw_printf ("        -t n   Decode each combination of file, -P profile, and -F level\n");
+	dw_printf ("               separately, running n at a time.  0 for one per processor.\n");
+	dw_printf ("               -P and -F can be comma separated lists, e.g.  -P A,B,E+ -F 0,1\n");
+	dw_printf ("               A table of results is printed at the end.  -L and -G apply\n");
+	dw_printf ("               to each one.\n");
+	dw_printf ("\n");
+	dw_printf ("        -T     Print a one line summary of processing time for each stage\n");
+	dw_printf ("               of the receive chain, in a form easy for scripts to use.\n");
+	dw_printf ("\n");
 	dw_printf ("        -L     Error if less than this number decoded.\n");
 	dw_printf ("\n");
 	dw_printf ("        -G     Error if greater than this number decoded.\n");
@@ -93,6 +93,7 @@
 #include "textcolor.h"
 #include "dtime_now.h"
 #include "demod.h"		/* for alevel_t & demod_get_audio_level() */
+#include "sdr_iq.h"
 
 
 /* Audio configuration. */
@@ -132,9 +133,20 @@ static struct adev_s {
 
 	int udp_sock;			/* UDP socket for receiving data */
 
+	enum audio_in_type_e iq_source;	/* For IQ input: UDP, stdin, or */
+					/* soundcard meaning a file. */
+	int iq_fd;			/* stdin or file for IQ input. */
+	unsigned char *iqbuf_ptr;	/* IQ before it is split into channels. */
+
 } adev[MAX_ADEVS];
 
 
+// Most bytes of IQ input to process at once.
+// UDP datagrams should not be any larger.
+
+#define IQ_BUF_SIZE 16384
+
+
 // Originally 40.  Version 1.2, try 10 for lower latency.
 
 #define ONE_BUF_TIME 10
@@ -166,6 +178,39 @@ static int calcbufsize(int rate, int chans, int bits)
 }
 
 
+/*
+ * Create and bind socket for UDP input.
+ * Returns socket or -1 for failure.
+ */
+
+static int open_udp_input (int port)
+{
+	int sock;
+	struct sockaddr_in si_me;
+
+	//Create UDP Socket
+	if ((sock=socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP))==-1) {
+	  text_color_set(DW_COLOR_ERROR);
+	  dw_printf ("Couldn't create socket, errno %d\n", errno);
+	  return -1;
+	}
+
+	memset((char *) &si_me, 0, sizeof(si_me));
+	si_me.sin_family = AF_INET;   
+	si_me.sin_port = htons((short)port);
+	si_me.sin_addr.s_addr = htonl(INADDR_ANY);
+
+	//Bind to the socket
+	if (bind(sock, (const struct sockaddr *) &si_me, sizeof(si_me))==-1) {
+	  text_color_set(DW_COLOR_ERROR);
+	  dw_printf ("Couldn't bind socket, errno %d\n", errno);
+	  close (sock);
+	  return -1;
+	}
+	return (sock);
+}
+
+
 /*------------------------------------------------------------------
  *
  * Name:        audio_open
@@ -239,6 +284,7 @@ int audio_open (struct audio_s *pa)
 	  adev[a].oss_audio_device_fd = -1;
 #endif
 	  adev[a].udp_sock = -1;
+	  adev[a].iq_fd = -1;
 	}
 
 
@@ -308,6 +354,13 @@ int audio_open (struct audio_s *pa)
 	      }
 	    } 
 
+	    /* Any of the above can provide IQ rather than audio. */
+
+	    if (pa->adev[a].iq_rate > 0) {
+	      adev[a].iq_source = adev[a].g_audio_in_type;
+	      adev[a].g_audio_in_type = AUDIO_IN_TYPE_SDR_IQ;
+	    }
+
 /* Let user know what is going on. */
 
 	    /* If not specified, the device names should be "default". */
@@ -317,11 +370,14 @@ int audio_open (struct audio_s *pa)
 
 	    char ctemp[40];
 
-	    if (pa->adev[a].num_channels == 2) {
-	      snprintf (ctemp, sizeof(ctemp), " (channels %d & %d)", ADEVFIRSTCHAN(a), ADEVFIRSTCHAN(a)+1);
+	    if (pa->adev[a].num_channels > 2) {
+	      snprintf (ctemp, sizeof(ctemp), " (channels %d thru %d)", pa->adev[a].first_chan, pa->adev[a].first_chan + pa->adev[a].num_channels - 1);
+	    }
+	    else if (pa->adev[a].num_channels == 2) {
+	      snprintf (ctemp, sizeof(ctemp), " (channels %d & %d)", pa->adev[a].first_chan, pa->adev[a].first_chan+1);
 	    }
 	    else {
-	      snprintf (ctemp, sizeof(ctemp), " (channel %d)", ADEVFIRSTCHAN(a));
+	      snprintf (ctemp, sizeof(ctemp), " (channel %d)", pa->adev[a].first_chan);
 	    }
 
             text_color_set(DW_COLOR_INFO);
@@ -404,34 +460,45 @@ int audio_open (struct audio_s *pa)
  */
 	      case AUDIO_IN_TYPE_SDR_UDP:
 
-	        //Create socket and bind socket
-	    
-	        {
-	          struct sockaddr_in si_me;
-	          //int slen=sizeof(si_me);
-	          //int data_size = 0;
+	        adev[a].udp_sock = open_udp_input (atoi(audio_in_name+4));
+	        if (adev[a].udp_sock < 0) {
+	          return -1;
+	        }
+	        adev[a].inbuf_size_in_bytes = SDR_UDP_BUF_MAXLEN; 
+	
+	        break;
 
-	          //Create UDP Socket
-	          if ((adev[a].udp_sock=socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP))==-1) {
-	            text_color_set(DW_COLOR_ERROR);
-	            dw_printf ("Couldn't create socket, errno %d\n", errno);
-	            return -1;
-	          }
+/*
+ * IQ from a software defined radio.  Split into audio channels by sdr_iq.c.
+ */
+	      case AUDIO_IN_TYPE_SDR_IQ:
 
-	          memset((char *) &si_me, 0, sizeof(si_me));
-	          si_me.sin_family = AF_INET;   
-	          si_me.sin_port = htons((short)atoi(audio_in_name+4));
-	          si_me.sin_addr.s_addr = htonl(INADDR_ANY);
+	        if (sdr_iq_init (a, pa) < 0) {
+	          return (-1);
+	        }
 
-	          //Bind to the socket
-	          if (bind(adev[a].udp_sock, (const struct sockaddr *) &si_me, sizeof(si_me))==-1) {
-	            text_color_set(DW_COLOR_ERROR);
-	            dw_printf ("Couldn't bind socket, errno %d\n", errno);
+	        if (adev[a].iq_source == AUDIO_IN_TYPE_SDR_UDP) {
+	          adev[a].udp_sock = open_udp_input (atoi(audio_in_name+4));
+	          if (adev[a].udp_sock < 0) {
 	            return -1;
 	          }
 	        }
-	        adev[a].inbuf_size_in_bytes = SDR_UDP_BUF_MAXLEN; 
-	
+	        else if (adev[a].iq_source == AUDIO_IN_TYPE_STDIN) {
+	          adev[a].iq_fd = STDIN_FILENO;
+	        }
+	        else {
+	          adev[a].iq_fd = open (pa->adev[a].adevice_in, O_RDONLY);
+	          if (adev[a].iq_fd < 0) {
+	            text_color_set(DW_COLOR_ERROR);
+	            dw_printf ("Could not open %s for IQ input, errno %d\n", pa->adev[a].adevice_in, errno);
+	            return (-1);
+	          }
+	        }
+
+	        adev[a].iqbuf_ptr = malloc(IQ_BUF_SIZE);
+	        assert (adev[a].iqbuf_ptr != NULL);
+	        adev[a].inbuf_size_in_bytes = sdr_iq_audio_size (a, IQ_BUF_SIZE);
+
 	        break;
 
 /* 
@@ -580,11 +647,18 @@ static int set_alsa_params (int a, snd_pcm_t *handle, struct audio_s *pa, char *
 	  return (-1);
 	}
 
-	/* Signed 16 bit little endian or unsigned 8 bit. */
+	/* Unsigned 8 bit or signed little endian 16, 24 (packed in 3 bytes), 32 bit, or float. */
+
+	snd_pcm_format_t format;
 
+	switch (pa->adev[a].bits_per_sample) {
+	  case 8:	format = SND_PCM_FORMAT_U8;		break;
+	  case 24:	format = SND_PCM_FORMAT_S24_3LE;	break;
+	  case 32:	format = pa->adev[a].float_samples ? SND_PCM_FORMAT_FLOAT_LE : SND_PCM_FORMAT_S32_LE;	break;
+	  default:	format = SND_PCM_FORMAT_S16_LE;		break;
+	}
 
-	err = snd_pcm_hw_params_set_format (handle, hw_params,
- 		pa->adev[a].bits_per_sample == 8 ? SND_PCM_FORMAT_U8 : SND_PCM_FORMAT_S16_LE);
+	err = snd_pcm_hw_params_set_format (handle, hw_params, format);
 	if (err < 0) {
 	  text_color_set(DW_COLOR_ERROR);
 	  dw_printf ("Could not set bits per sample.\n%s\n", 
@@ -746,7 +820,15 @@ static int set_sndio_params (int a, struct sio_hdl *handle, struct audio_s *pa,
 
 	struct sio_par q, r;
 
-	/* Signed 16 bit little endian or unsigned 8 bit. */
+	/* Unsigned 8 bit or signed little endian 16, 24, or 32 bit. */
+	/* sndio has no floating point format. */
+
+	if (pa->adev[a].float_samples) {
+	  text_color_set(DW_COLOR_ERROR);
+	  dw_printf ("Floating point samples are not supported for %s %s.\n", devname, inout);
+	  return (-1);
+	}
+
 	sio_initpar (&q);
 	q.bits = pa->adev[a].bits_per_sample;
 	q.bps = (q.bits + 7) / 8;
@@ -882,13 +964,39 @@ static int set_oss_params (int a, int fd, struct audio_s *pa)
 	/* This is actually a bit mask but it happens that */
 	/* 0x8 is unsigned 8 bit samples and */
 	/* 0x10 is signed 16 bit little endian. */
+	/* The wider formats are not available everywhere. */
+
+	int format;
+
+	switch (pa->adev[a].bits_per_sample) {
+	  case 8:	format = AFMT_U8;	break;
+	  case 16:	format = AFMT_S16_LE;	break;
+#ifdef AFMT_S24_PACKED
+	  case 24:	format = AFMT_S24_PACKED;	break;
+#endif
+#if defined(AFMT_S32_LE) && defined(AFMT_FLOAT)
+	  case 32:	format = pa->adev[a].float_samples ? AFMT_FLOAT : AFMT_S32_LE;	break;
+#endif
+	  default:
+	    text_color_set(DW_COLOR_ERROR);
+	    dw_printf ("%s%d bits per sample is not supported by this audio system.\n",
+			pa->adev[a].float_samples ? "Floating point " : "", pa->adev[a].bits_per_sample);
+	    return (-1);
+	}
+
+	int asked_for_format = format;
 
-	err = ioctl (fd, SNDCTL_DSP_SETFMT, &(pa->adev[a].bits_per_sample));
+	err = ioctl (fd, SNDCTL_DSP_SETFMT, &format);
    	if (err == -1) {
 	  text_color_set(DW_COLOR_ERROR);
     	  perror("Not able to set audio device sample size");
  	  return (-1);
 	}
+	if (format != asked_for_format) {
+	  text_color_set(DW_COLOR_ERROR);
+	  dw_printf ("Audio device does not support %d bits per sample.\n", pa->adev[a].bits_per_sample);
+	  return (-1);
+	}
 
 /*
  * Determine capabilities.
@@ -1066,6 +1174,7 @@ int audio_get (int a)
 	        adev[a].inbuf_next = 0;
 
 	        audio_stats (a, 
+			save_audio_config_p->adev[a].first_chan,
 			save_audio_config_p->adev[a].num_channels, 
 			n, 
 			save_audio_config_p->statistics_interval);
@@ -1112,6 +1221,7 @@ int audio_get (int a)
 	        }
 
 	        audio_stats (a, 
+			save_audio_config_p->adev[a].first_chan,
 			save_audio_config_p->adev[a].num_channels, 
 			0, 
 			save_audio_config_p->statistics_interval);
@@ -1159,6 +1269,7 @@ int audio_get (int a)
 	      adev[a].inbuf_next = 0;
 
 	      audio_stats (a,
+			save_audio_config_p->adev[a].first_chan,
 			save_audio_config_p->adev[a].num_channels,
 			n / (save_audio_config_p->adev[a].num_channels * save_audio_config_p->adev[a].bits_per_sample / 8),
 			save_audio_config_p->statistics_interval);
@@ -1181,6 +1292,7 @@ int audio_get (int a)
 	        adev[a].inbuf_next = 0;
 
 	        audio_stats (a, 
+			save_audio_config_p->adev[a].first_chan,
 			save_audio_config_p->adev[a].num_channels, 
 			0, 
 			save_audio_config_p->statistics_interval);
@@ -1191,6 +1303,7 @@ int audio_get (int a)
 	      adev[a].inbuf_next = 0;
 
 	      audio_stats (a, 
+			save_audio_config_p->adev[a].first_chan,
 			save_audio_config_p->adev[a].num_channels, 
 			n / (save_audio_config_p->adev[a].num_channels * save_audio_config_p->adev[a].bits_per_sample / 8), 
 			save_audio_config_p->statistics_interval);
@@ -1219,6 +1332,7 @@ int audio_get (int a)
 	        adev[a].inbuf_next = 0;
 
 	        audio_stats (a, 
+			save_audio_config_p->adev[a].first_chan,
 			save_audio_config_p->adev[a].num_channels, 
 			0, 
 			save_audio_config_p->statistics_interval);
@@ -1230,6 +1344,7 @@ int audio_get (int a)
 	      adev[a].inbuf_next = 0;
 
 	      audio_stats (a, 
+			save_audio_config_p->adev[a].first_chan,
 			save_audio_config_p->adev[a].num_channels, 
 			res / (save_audio_config_p->adev[a].num_channels * save_audio_config_p->adev[a].bits_per_sample / 8), 
 			save_audio_config_p->statistics_interval);
@@ -1237,6 +1352,54 @@ int audio_get (int a)
 	    }
 	    break;
 
+/*
+ * IQ from a software defined radio.
+ * Each read becomes a batch of audio samples for all channels of the device.
+ */
+
+	  case AUDIO_IN_TYPE_SDR_IQ:
+
+	    while (adev[a].inbuf_next >= adev[a].inbuf_len) {
+	      int res;
+
+	      if (adev[a].iq_source == AUDIO_IN_TYPE_SDR_UDP) {
+	        res = recv(adev[a].udp_sock, adev[a].iqbuf_ptr, IQ_BUF_SIZE, 0);
+	      }
+	      else {
+	        res = read(adev[a].iq_fd, adev[a].iqbuf_ptr, IQ_BUF_SIZE);
+	        if (res == 0) {
+	          text_color_set(DW_COLOR_INFO);
+	          dw_printf ("\nEnd of file on %s.  Exiting.\n", save_audio_config_p->adev[a].adevice_in);
+	          exit (0);
+	        }
+	      }
+
+	      if (res < 0) {
+	        text_color_set(DW_COLOR_ERROR);
+	        dw_printf ("Can't read IQ input, errno %d\n", errno);
+	        adev[a].inbuf_len = 0;
+	        adev[a].inbuf_next = 0;
+
+	        audio_stats (a, 
+			save_audio_config_p->adev[a].first_chan,
+			save_audio_config_p->adev[a].num_channels, 
+			0, 
+			save_audio_config_p->statistics_interval);
+
+	        return (-1);
+	      }
+
+	      adev[a].inbuf_len = sdr_iq_process (a, adev[a].iqbuf_ptr, res, adev[a].inbuf_ptr);
+	      adev[a].inbuf_next = 0;
+
+	      audio_stats (a, 
+			save_audio_config_p->adev[a].first_chan,
+			save_audio_config_p->adev[a].num_channels, 
+			adev[a].inbuf_len / (save_audio_config_p->adev[a].num_channels * 2), 
+			save_audio_config_p->statistics_interval);
+	    }
+	    break;
+
 /*
  * stdin.
  */
@@ -1254,6 +1417,7 @@ int audio_get (int a)
 	      }
 	    
 	      audio_stats (a, 
+			save_audio_config_p->adev[a].first_chan,
 			save_audio_config_p->adev[a].num_channels, 
 			res / (save_audio_config_p->adev[a].num_channels * save_audio_config_p->adev[a].bits_per_sample / 8), 
 			save_audio_config_p->statistics_interval);
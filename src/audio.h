@@ -43,7 +43,16 @@ typedef enum ptt_line_e ptt_line_t;
 enum audio_in_type_e {
 	AUDIO_IN_TYPE_SOUNDCARD,
 	AUDIO_IN_TYPE_SDR_UDP,
-	AUDIO_IN_TYPE_STDIN };
+	AUDIO_IN_TYPE_STDIN,
+	AUDIO_IN_TYPE_SDR_IQ };		/* Wideband IQ from UDP, stdin, or file.  See sdr_iq.c */
+
+/* Sample format for IQ input. */
+
+enum iq_format_e {
+	IQ_FORMAT_CU8 = 0,	/* Unsigned 8 bit, e.g. rtl_sdr. */
+	IQ_FORMAT_CS8,		/* Signed 8 bit, e.g. hackrf_transfer. */
+	IQ_FORMAT_CS16,		/* Signed 16 bit, little endian. */
+	IQ_FORMAT_CF32 };	/* 32 bit float. */
 
 /* For option to try fixing frames with bad CRC. */
 
@@ -91,9 +100,30 @@ struct audio_s {
 
 	    char adevice_out[80];	/* Name of the audio output device (or file?). */
 
-	    int num_channels;		/* Should be 1 for mono or 2 for stereo. */
+	    int num_channels;		/* 1 for mono or 2 for stereo. */
+					/* Can be more for IQ input. */
+
+	    int first_chan;		/* Radio channel number for first channel of device. */
+					/* The others follow in order.  Set by config.c. */
 	    int samples_per_sec;	/* Audio sampling rate.  Typically 11025, 22050, 44100, or 48000. */
 	    int bits_per_sample;	/* 8 (unsigned char) or 16 (signed short). */
+					/* Version 1.8 adds 24 (signed, packed in 3 bytes) */
+					/* and 32 (signed int or float). */
+
+	    int float_samples;		/* 32 bit float, full scale +-1.0, rather than int. */
+
+	    /* New in version 1.8.  The input can be complex IQ samples from a */
+	    /* software defined radio covering many radio channels.  Each */
+	    /* channel of the device is picked out and FM demodulated. */
+	    /* samples_per_sec then becomes the rate after demodulation. */
+
+	    int iq_rate;		/* IQ samples per second.  0 for ordinary audio. */
+
+	    enum iq_format_e iq_format;
+
+	    double iq_center;		/* Radio frequency, MHz, at center of IQ input. */
+
+	    int iq_spacing;		/* Hz between possible channels.  Default 25000. */
 
 	} adev[MAX_ADEVS];
 
@@ -153,6 +183,10 @@ struct audio_s {
 					// MEDIUM_IGATE allows application access to IGate.
 					// MEDIUM_NETTNC for external TNC via TCP.
 
+	int chan_adev[MAX_TOTAL_CHANS];	/* Audio device for each radio channel. */
+					/* Set along with first_chan above. */
+					/* Meaningful only for MEDIUM_RADIO. */
+
 	int igate_vchannel;		/* Virtual channel mapped to APRS-IS. */
 					/* -1 for none. */
 					/* Redundant but it makes things quicker and simpler */
@@ -244,6 +278,9 @@ struct audio_s {
 					/* Standard rates are 1200 for VHF and 300 for HF. */
 					/* This should really be called bits per second. */
 
+	    double iq_freq;		/* Radio frequency, MHz, when audio device has IQ input. */
+					/* 0 means the center frequency. */
+
 	/* Next 3 come from config file or command line. */
 
 	    char profiles[16];		/* zero or more of ABC etc, optional + */
@@ -436,6 +473,8 @@ struct audio_s {
 
 #define SDR_UDP_BUF_MAXLEN 2000
 
+#define DEFAULT_IQ_SPACING 25000
+
 
 
 #define DEFAULT_NUM_CHANNELS 	1
@@ -609,6 +609,12 @@ int audio_open (struct audio_s *pa)
 
 			adev[a].g_audio_in_type = AUDIO_IN_TYPE_SOUNDCARD;
 
+			if (pa->adev[a].iq_rate > 0) {
+				text_color_set(DW_COLOR_ERROR);
+				dw_printf ("IQINPUT is not supported for Mac OSX yet.\n");
+				return (-1);
+			}
+
 			if (strcasecmp(pa->adev[a].adevice_in, "stdin") == 0 || strcmp(pa->adev[a].adevice_in, "-") == 0) {
 				adev[a].g_audio_in_type = AUDIO_IN_TYPE_STDIN;
 				/* Change "-" to stdin for readability. */
@@ -633,9 +639,9 @@ int audio_open (struct audio_s *pa)
 			char ctemp[40];
 
 			if (pa->adev[a].num_channels == 2) {
-				snprintf (ctemp, sizeof(ctemp), " (channels %d & %d)", ADEVFIRSTCHAN(a), ADEVFIRSTCHAN(a)+1);
+				snprintf (ctemp, sizeof(ctemp), " (channels %d & %d)", pa->adev[a].first_chan, pa->adev[a].first_chan+1);
 			} else {
-				snprintf (ctemp, sizeof(ctemp), " (channel %d)", ADEVFIRSTCHAN(a));
+				snprintf (ctemp, sizeof(ctemp), " (channel %d)", pa->adev[a].first_chan);
 			}
 
 			text_color_set(DW_COLOR_INFO);
@@ -857,6 +863,17 @@ static int set_portaudio_params (int a, struct adev_s *dev, struct audio_s *pa,
 			assert("int16_t size not equal to 2" && sizeof(int16_t) == 2);
 			break;
 
+		case 24:
+			sampleFormat = paInt24;
+			no_of_bytes_per_sample = 3;
+			break;
+
+		case 32:
+			sampleFormat = pa->adev[a].float_samples ? paFloat32 : paInt32;
+			no_of_bytes_per_sample = sizeof(int32_t);
+			assert("int32_t size not equal to 4" && sizeof(int32_t) == 4);
+			break;
+
 		default:
 			dw_printf ("Unsupported Sample Size %s.\n", output_devName);
 			return -1;
@@ -991,6 +1008,7 @@ int audio_get (int a)
 					adev[a].inbuf_next = 0;
 
 	        			audio_stats (a, 
+						save_audio_config_p->adev[a].first_chan,
 						save_audio_config_p->adev[a].num_channels, 
 						n, 
 						save_audio_config_p->statistics_interval);
@@ -1019,6 +1037,7 @@ int audio_get (int a)
 					dw_printf ("Audio input device %d error\n", a);
 
 	        			audio_stats (a, 
+						save_audio_config_p->adev[a].first_chan,
 						save_audio_config_p->adev[a].num_channels, 
 						0, 
 						save_audio_config_p->statistics_interval);
@@ -1069,6 +1088,7 @@ int audio_get (int a)
 					adev[a].inbuf_next = 0;
 
 	        			audio_stats (a, 
+						save_audio_config_p->adev[a].first_chan,
 						save_audio_config_p->adev[a].num_channels, 
 						0, 
 						save_audio_config_p->statistics_interval);
@@ -1080,6 +1100,7 @@ int audio_get (int a)
 				adev[a].inbuf_next = 0;
 
 	      			audio_stats (a, 
+					save_audio_config_p->adev[a].first_chan,
 					save_audio_config_p->adev[a].num_channels, 
 					res / (save_audio_config_p->adev[a].num_channels * save_audio_config_p->adev[a].bits_per_sample / 8), 
 					save_audio_config_p->statistics_interval);
@@ -1102,6 +1123,7 @@ int audio_get (int a)
 				}
 
 	      			audio_stats (a, 
+					save_audio_config_p->adev[a].first_chan,
 					save_audio_config_p->adev[a].num_channels, 
 					res / (save_audio_config_p->adev[a].num_channels * save_audio_config_p->adev[a].bits_per_sample / 8), 
 					save_audio_config_p->statistics_interval);
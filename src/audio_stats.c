@@ -66,6 +66,8 @@
 #include "audio_stats.h"
 #include "textcolor.h"
 #include "demod.h"		/* for alevel_t & demod_get_audio_level() */
+#include "rx_chain.h"
+#include "dtime_now.h"
 
 
 
@@ -78,7 +80,9 @@
  *
  * Inputs:	adev	- Audio device number:  0, 1, ..., MAX_ADEVS-1
  *
- 		nchan	- Number of channels for this device, 1 or 2.
+ *		first_chan - Radio channel number for first channel of device.
+ *
+ 		nchan	- Number of channels for this device, 1 or 2, or more for IQ input.
  *
  *		nsamp	- How many audio samples were read.
  *
@@ -92,25 +96,40 @@
  *----------------------------------------------------------------*/
 
 
-void audio_stats (int adev, int nchan, int nsamp, int interval)
+void audio_stats (int adev, int first_chan, int nchan, int nsamp, int interval)
 {
 
 	/* Gather numbers for read from audio device. */
 
 
-	static time_t last_time[MAX_ADEVS] = { 0, 0, 0 };
+	static time_t last_time[MAX_ADEVS] = { 0 };
 	time_t this_time[MAX_ADEVS];
 	static int sample_count[MAX_ADEVS];
 	static int error_count[MAX_ADEVS];
 	static int suppress_first[MAX_ADEVS];
 
 
+	assert (adev >= 0 && adev < MAX_ADEVS);
+
+/*
+ * Remember when this buffer was read so we can tell how long it
+ * takes to get a frame from the audio to client applications.
+ */
+	if (nsamp > 0) {
+	  double now = dtime_monotonic();
+	  int c;
+
+	  for (c = first_chan; c < first_chan + nchan && c < MAX_RADIO_CHANS; c++) {
+	    if (rx_chain[c] != NULL) {
+	      rx_chain[c]->audio_time = now;
+	    }
+	  }
+	}
+
 	if (interval <= 0) {
 	  return;
 	}
 
-	assert (adev >= 0 && adev < MAX_ADEVS);
-
 /*
  * Print information about the sample rate as a troubleshooting aid.
  * I've never seen an issue with Windows or x86 Linux but the Raspberry Pi
@@ -154,17 +173,32 @@ void audio_stats (int adev, int nchan, int nsamp, int interval)
 
 	      text_color_set(DW_COLOR_DEBUG);
 
-	      if (nchan > 1) {
-	        int ch0 = ADEVFIRSTCHAN(adev);
+	      if (nchan > 2) {
+	        char levels[200];
+	        int c;
+
+	        strlcpy (levels, "", sizeof(levels));
+	        for (c = first_chan; c < first_chan + nchan; c++) {
+	          char ltemp[20];
+	          alevel_t alevel = demod_get_audio_level(c,0);
+	          snprintf (ltemp, sizeof(ltemp), "%sCH%d %d", c == first_chan ? "" : ", ", c, alevel.rec);
+	          strlcat (levels, ltemp, sizeof(levels));
+	        }
+
+	        dw_printf ("\nADEVICE%d: Sample rate approx. %.1f k, %d errors, receive audio levels %s\n\n", 
+			adev, ave_rate, error_count[adev], levels);
+	      }
+	      else if (nchan > 1) {
+	        int ch0 = first_chan;
 	        alevel_t alevel0 = demod_get_audio_level(ch0,0);
-	        int ch1 = ADEVFIRSTCHAN(adev) + 1;
+	        int ch1 = first_chan + 1;
 	        alevel_t alevel1 = demod_get_audio_level(ch1,0);
 
 	        dw_printf ("\nADEVICE%d: Sample rate approx. %.1f k, %d errors, receive audio levels CH%d %d, CH%d %d\n\n", 
 			adev, ave_rate, error_count[adev], ch0, alevel0.rec, ch1, alevel1.rec);
 	      }
 	      else {
-	        int ch0 = ADEVFIRSTCHAN(adev);
+	        int ch0 = first_chan;
 	        alevel_t alevel0 = demod_get_audio_level(ch0,0);
 
 	        dw_printf ("\nADEVICE%d: Sample rate approx. %.1f k, %d errors, receive audio level CH%d %d\n\n", 
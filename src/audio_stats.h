@@ -3,5 +3,5 @@
 /* audio_stats.h */
 
 
-extern void audio_stats (int adev, int nchan, int nsamp, int interval);
+extern void audio_stats (int adev, int first_chan, int nchan, int nsamp, int interval);
 
@@ -54,6 +54,10 @@
 
 #include <mmsystem.h>
 
+#ifndef WAVE_FORMAT_IEEE_FLOAT
+#define WAVE_FORMAT_IEEE_FLOAT 0x0003
+#endif
+
 #ifndef WAVE_FORMAT_96M16
 #define WAVE_FORMAT_96M16 0x40000
 #define WAVE_FORMAT_96S16 0x80000
@@ -295,6 +299,12 @@ int audio_open (struct audio_s *pa)
  * This can be soundcard, UDP stream, or stdin.
  */
 	
+	    if (pa->adev[a].iq_rate > 0) {
+	      text_color_set(DW_COLOR_ERROR);
+	      dw_printf ("IQINPUT is not supported for Windows yet.\n");
+	      return (-1);
+	    }
+
 	    if (strcasecmp(pa->adev[a].adevice_in, "stdin") == 0 || strcmp(pa->adev[a].adevice_in, "-") == 0) {
 	      A->g_audio_in_type = AUDIO_IN_TYPE_STDIN;
 	      /* Change - to stdin for readability. */
@@ -406,10 +416,10 @@ int audio_open (struct audio_s *pa)
 	    for (a=0; a<MAX_ADEVS; a++) {
 	      if (pa->adev[a].defined && n==in_dev_no[a]) {
 	        if (pa->adev[a].num_channels == 2) {
-	          dw_printf ("   (channels %d & %d)", ADEVFIRSTCHAN(a), ADEVFIRSTCHAN(a)+1);
+	          dw_printf ("   (channels %d & %d)", pa->adev[a].first_chan, pa->adev[a].first_chan+1);
 	        }
 	        else {
-	          dw_printf ("   (channel %d)", ADEVFIRSTCHAN(a));
+	          dw_printf ("   (channel %d)", pa->adev[a].first_chan);
 	        }
 	      }
 	    }
@@ -438,10 +448,10 @@ int audio_open (struct audio_s *pa)
 	      dw_printf ("  %s                             ", pa->adev[a].adevice_in);	/* should be UDP:nnnn or stdin */
 
 	      if (pa->adev[a].num_channels == 2) {
-	        dw_printf ("   (channels %d & %d)", ADEVFIRSTCHAN(a), ADEVFIRSTCHAN(a)+1);
+	        dw_printf ("   (channels %d & %d)", pa->adev[a].first_chan, pa->adev[a].first_chan+1);
 	      }
 	      else {
-	        dw_printf ("   (channel %d)", ADEVFIRSTCHAN(a));
+	        dw_printf ("   (channel %d)", pa->adev[a].first_chan);
 	      }
 	      dw_printf ("\n");
 	    }
@@ -487,10 +497,10 @@ int audio_open (struct audio_s *pa)
 	    for (a=0; a<MAX_ADEVS; a++) {
 	      if (pa->adev[a].defined && n==out_dev_no[a]) {
 	        if (pa->adev[a].num_channels == 2) {
-	          dw_printf ("   (channels %d & %d)", ADEVFIRSTCHAN(a), ADEVFIRSTCHAN(a)+1);
+	          dw_printf ("   (channels %d & %d)", pa->adev[a].first_chan, pa->adev[a].first_chan+1);
 	        }
 	        else {
-	          dw_printf ("   (channel %d)", ADEVFIRSTCHAN(a));
+	          dw_printf ("   (channel %d)", pa->adev[a].first_chan);
 	        }
 	      }
 	    }
@@ -510,7 +520,7 @@ int audio_open (struct audio_s *pa)
 
 	     WAVEFORMATEX wf;
 
-	     wf.wFormatTag = WAVE_FORMAT_PCM;
+	     wf.wFormatTag = pa -> adev[a].float_samples ? WAVE_FORMAT_IEEE_FLOAT : WAVE_FORMAT_PCM;
 	     wf.nChannels = pa -> adev[a].num_channels; 
 	     wf.nSamplesPerSec = pa -> adev[a].samples_per_sec;
 	     wf.wBitsPerSample = pa -> adev[a].bits_per_sample;
@@ -807,6 +817,7 @@ int audio_get (int a)
 	          dw_printf ("Timeout waiting for input from audio device %d.\n", a);
 
 	          audio_stats (a, 
+			save_audio_config_p->adev[a].first_chan,
 			save_audio_config_p->adev[a].num_channels, 
 			0, 
 			save_audio_config_p->statistics_interval);
@@ -822,6 +833,7 @@ int audio_get (int a)
 	        p->dwUser = 0;	/* Index for next byte. */
 
 	        audio_stats (a, 
+			save_audio_config_p->adev[a].first_chan,
 			save_audio_config_p->adev[a].num_channels, 
 			p->dwBytesRecorded / (save_audio_config_p->adev[a].num_channels * save_audio_config_p->adev[a].bits_per_sample / 8), 
 			save_audio_config_p->statistics_interval);
@@ -868,6 +880,7 @@ int audio_get (int a)
 	        A->stream_next = 0;
 
 	        audio_stats (a, 
+			save_audio_config_p->adev[a].first_chan,
 			save_audio_config_p->adev[a].num_channels, 
 			0, 
 			save_audio_config_p->statistics_interval);
@@ -876,6 +889,7 @@ int audio_get (int a)
 	      } 
 
 	      audio_stats (a, 
+			save_audio_config_p->adev[a].first_chan,
 			save_audio_config_p->adev[a].num_channels, 
 			res / (save_audio_config_p->adev[a].num_channels * save_audio_config_p->adev[a].bits_per_sample / 8), 
 			save_audio_config_p->statistics_interval);
@@ -903,6 +917,7 @@ int audio_get (int a)
 	      }
 
 	      audio_stats (a, 
+			save_audio_config_p->adev[a].first_chan,
 			save_audio_config_p->adev[a].num_channels, 
 			res / (save_audio_config_p->adev[a].num_channels * save_audio_config_p->adev[a].bits_per_sample / 8), 
 			save_audio_config_p->statistics_interval);
@@ -187,12 +187,16 @@ char *strtok_r(char *str, const char *delim, char **saveptr);
  * Accumulate statistics.
  * If new_count gets much larger than delete_count plus the size of 
  * the transmit queue we have a memory leak.
+ *
+ * Packets are created and deleted by many different threads so these
+ * are updated with atomic operations.
  */
 
 static volatile int new_count = 0;
 static volatile int delete_count = 0;
 static volatile int last_seq_num = 0;
 
+
 #if AX25MEMDEBUG
 
 // TODO:  Make static and use function for any extern references.
@@ -218,6 +222,167 @@ int ax25memdebug_seq (packet_t this_p)
 #endif
 
 
+/*
+ * Packet objects, and the separate buffers holding the frame contents,
+ * are recycled rather than going back to calloc / free each time.
+ * We go through a lot of them: every received candidate, digipeated copy,
+ * beacon, and client frame.
+ *
+ * Each thread keeps a small cache of its own, with no locking.
+ * A packet is often created by one thread (e.g. receive audio) and
+ * deleted by another (e.g. dlq processing) so extras are moved, a batch
+ * at a time, to a global free list where any thread can pick them up.
+ *
+ * Set AX25_POOL to 0 to go back to calloc / free for every packet,
+ * e.g. to look for problems with valgrind or address sanitizer.
+ * The same happens while the AX25MEMDEBUG tracing is turned on.
+ */
+
+#define AX25_POOL 1
+
+#define POOL_CACHE_MAX 32		/* Most to keep in each thread. */
+#define POOL_BATCH 16			/* Number moved to / from global list at once. */
+#define POOL_GLOBAL_MAX 512		/* Beyond this, really free them. */
+
+struct pool_s {
+	size_t size;			/* Size of each object. */
+	void *global;			/* Global free list.  The first pointer */
+					/* sized part of each object is the link. */
+	int global_len;
+	dw_mutex_t lock;		/* Held only long enough to splice a list. */
+};
+
+struct pool_cache_s {
+	void *head;			/* Free list for one thread. */
+	int len;
+};
+
+static struct pool_s packet_pool = { .size = sizeof(struct packet_s) };
+static struct pool_s frame_pool = { .size = sizeof(struct ax25_frame_buf_s) };
+
+static __thread struct pool_cache_s packet_cache;
+static __thread struct pool_cache_s frame_cache;
+
+#define POOL_NEXT(p) (*(void **)(p))
+
+
+/*
+ * There is no initialization function for this file and it is used by
+ * many small applications and tests.  Set up the locks at program start.
+ */
+
+__attribute__((constructor))
+static void pool_init (void)
+{
+	dw_mutex_init (&packet_pool.lock);
+	dw_mutex_init (&frame_pool.lock);
+}
+
+
+/*
+ * Get an object from the pool.  Contents are undefined.
+ */
+
+static void *pool_get (struct pool_s *g, struct pool_cache_s *c)
+{
+	void *p = NULL;
+
+#if AX25_POOL
+
+/*
+ * Try our own cache first, then grab a batch from the global list.
+ */
+	if (c->head == NULL) {
+	  dw_mutex_lock (&g->lock);
+	  while (g->global != NULL && c->len < POOL_BATCH) {
+	    void *q = g->global;
+	    g->global = POOL_NEXT(q);
+	    g->global_len--;
+	    POOL_NEXT(q) = c->head;
+	    c->head = q;
+	    c->len++;
+	  }
+	  dw_mutex_unlock (&g->lock);
+	}
+
+	if (c->head != NULL) {
+	  p = c->head;
+	  c->head = POOL_NEXT(p);
+	  c->len--;
+	  return (p);
+	}
+#endif
+
+	p = malloc (g->size);
+
+	if (p == NULL) {
+	  text_color_set(DW_COLOR_ERROR);
+	  dw_printf ("ERROR - can't allocate memory in ax25_new.\n");
+	}
+	assert (p != NULL);
+
+	return (p);
+}
+
+
+/*
+ * Give object back to the pool.
+ */
+
+static void pool_put (struct pool_s *g, struct pool_cache_s *c, void *p)
+{
+
+#if AX25_POOL
+
+#if AX25MEMDEBUG
+	if ( ! ax25memdebug)
+#endif
+	{
+	  POOL_NEXT(p) = c->head;
+	  c->head = p;
+	  c->len++;
+
+/*
+ * Too many for this thread.  Move a batch to the global list.
+ * If that is also full, they really get freed.
+ */
+	  if (c->len > POOL_CACHE_MAX) {
+	    void *batch = NULL;
+	    int n;
+
+	    for (n = 0; n < POOL_BATCH; n++) {
+	      void *q = c->head;
+	      c->head = POOL_NEXT(q);
+	      c->len--;
+	      POOL_NEXT(q) = batch;
+	      batch = q;
+	    }
+
+	    dw_mutex_lock (&g->lock);
+	    while (batch != NULL && g->global_len < POOL_GLOBAL_MAX) {
+	      void *q = batch;
+	      batch = POOL_NEXT(q);
+	      POOL_NEXT(q) = g->global;
+	      g->global = q;
+	      g->global_len++;
+	    }
+	    dw_mutex_unlock (&g->lock);
+
+	    while (batch != NULL) {
+	      void *q = batch;
+	      batch = POOL_NEXT(q);
+	      free (q);
+	    }
+	  }
+	  return;
+	}
+#endif
+
+	free (p);
+}
+
+
+
 
 #define CLEAR_LAST_ADDR_FLAG  this_p->frame_data[this_p->num_addr*7-1] &= ~ SSID_LAST_MASK
 #define SET_LAST_ADDR_FLAG  this_p->frame_data[this_p->num_addr*7-1] |= SSID_LAST_MASK
@@ -235,9 +400,23 @@ int ax25memdebug_seq (packet_t this_p)
  *------------------------------------------------------------------------------*/
 
 
+static packet_t packet_alloc (int clear_data);
+
 packet_t ax25_new (void)
+{
+	return (packet_alloc (1));
+}
+
+
+/*
+ * ax25_from_frame is about to copy in the whole frame so there
+ * is no need to clear the frame data first.
+ */
+
+static packet_t packet_alloc (int clear_data)
 {
 	struct packet_s *this_p;
+	int seq;
 
 
 #if DEBUG 
@@ -245,8 +424,8 @@ packet_t ax25_new (void)
         dw_printf ("ax25_new(): before alloc, new=%d, delete=%d\n", new_count, delete_count);
 #endif
 
-	last_seq_num++;
-	new_count++;
+	seq = __atomic_add_fetch (&last_seq_num, 1, __ATOMIC_RELAXED);
+	int nc = __atomic_add_fetch (&new_count, 1, __ATOMIC_RELAXED);
 
 /*
  * check for memory leak.
@@ -255,40 +434,99 @@ packet_t ax25_new (void)
 // version 1.4 push up the threshold.   We could have considerably more with connected mode.
 
 	//if (new_count > delete_count + 100) {
-	if (new_count > delete_count + 256) {
+	if (nc > __atomic_load_n (&delete_count, __ATOMIC_RELAXED) + 256) {
 
 
 	  text_color_set(DW_COLOR_ERROR);
-	  dw_printf ("Report to WB2OSZ - Memory leak for packet objects.  new=%d, delete=%d\n", new_count, delete_count);
+	  dw_printf ("Report to WB2OSZ - Memory leak for packet objects.  new=%d, delete=%d\n", nc, delete_count);
 #if AX25MEMDEBUG
 	  // Force on debug option to gather evidence.
 	  ax25memdebug_set();
 #endif
 	}
 
-	this_p = calloc(sizeof (struct packet_s), (size_t)1);
+	this_p = pool_get (&packet_pool, &packet_cache);
+	memset (this_p, 0, sizeof (struct packet_s));
 
-	if (this_p == NULL) {
-	  text_color_set(DW_COLOR_ERROR);
-	  dw_printf ("ERROR - can't allocate memory in ax25_new.\n");
+	this_p->frame_buf = pool_get (&frame_pool, &frame_cache);
+	if (clear_data) {
+	  memset (this_p->frame_buf->data, 0, sizeof(this_p->frame_buf->data));
 	}
-
-	assert (this_p != NULL);
+	else {
+	  this_p->frame_buf->data[0] = 0;
+	}
+	this_p->frame_buf->refcnt = 1;
+	this_p->frame_buf->magic3 = MAGIC;
+	this_p->frame_data = this_p->frame_buf->data;
 
 	this_p->magic1 = MAGIC;
-	this_p->seq = last_seq_num;
+	this_p->seq = seq;
 	this_p->magic2 = MAGIC;
 	this_p->num_addr = (-1);
 
 	return (this_p);
 }
 
+
+/*
+ * Drop our reference to the frame contents.
+ * The storage is recycled when nobody else is using it.
+ */
+
+static void frame_release (struct ax25_frame_buf_s *fb)
+{
+	assert (fb->magic3 == MAGIC);
+	assert (fb->refcnt >= 1);
+
+	if (__atomic_sub_fetch (&(fb->refcnt), 1, __ATOMIC_ACQ_REL) == 0) {
+	  fb->magic3 = 0;
+	  pool_put (&frame_pool, &frame_cache, fb);
+	}
+}
+
+
+/*
+ * Called before anything modifies the frame contents.
+ * If they are shared with another packet object, we get our own copy.
+ * The original is never changed so others sharing it are not affected.
+ */
+
+static void frame_make_writable (packet_t this_p)
+{
+	struct ax25_frame_buf_s *fb = this_p->frame_buf;
+
+	assert (fb->magic3 == MAGIC);
+
+	if (__atomic_load_n (&(fb->refcnt), __ATOMIC_ACQUIRE) == 1) {
+	  return;
+	}
+
+	struct ax25_frame_buf_s *nfb = pool_get (&frame_pool, &frame_cache);
+
+	memcpy (nfb->data, fb->data, this_p->frame_len);
+	memset (nfb->data + this_p->frame_len, 0, sizeof(nfb->data) - this_p->frame_len);
+	nfb->refcnt = 1;
+	nfb->magic3 = MAGIC;
+
+	this_p->frame_buf = nfb;
+	this_p->frame_data = nfb->data;
+
+	frame_release (fb);
+}
+
+
 /*------------------------------------------------------------------------------
  *
  * Name:	ax25_delete
  * 
  * Purpose:	Destroy a packet object, freeing up memory it was using.
  *
+ * Description:	The memory goes back to the pool, described above, to be
+ *		used again by ax25_new.  The magic numbers are cleared so
+ *		any later use of the old handle will still be caught.
+ *		The frame contents stay around while any copy from
+ *		ax25_dup is still using them.
+ *
  *------------------------------------------------------------------------------*/
 
 #if AX25MEMDEBUG
@@ -309,12 +547,13 @@ void ax25_delete (packet_t this_p)
 	}
 
 
-	delete_count++;
+	int dc = __atomic_add_fetch (&delete_count, 1, __ATOMIC_RELAXED);
+	(void)dc;
 
 #if AX25MEMDEBUG	
 	if (ax25memdebug) {
 	  text_color_set(DW_COLOR_DEBUG);
-	  dw_printf ("ax25_delete, seq=%d, called from %s %d, new_count=%d, delete_count=%d\n", this_p->seq, src_file, src_line, new_count, delete_count);
+	  dw_printf ("ax25_delete, seq=%d, called from %s %d, new_count=%d, delete_count=%d\n", this_p->seq, src_file, src_line, new_count, dc);
 	}
 #endif
 
@@ -322,10 +561,13 @@ void ax25_delete (packet_t this_p)
 	assert (this_p->magic2 == MAGIC);
 	
 	this_p->magic1 = 0;
-	this_p->magic1 = 0;
+	this_p->magic2 = 0;
 
-	//memset (this_p, 0, sizeof (struct packet_s));
-	free (this_p);
+	frame_release (this_p->frame_buf);
+	this_p->frame_buf = NULL;
+	this_p->frame_data = NULL;
+
+	pool_put (&packet_pool, &packet_cache, this_p);
 }
 
 
@@ -670,7 +912,7 @@ packet_t ax25_from_frame (unsigned char *fbuf, int flen, alevel_t alevel)
 	  return (NULL);
 	}
 
-	this_p = ax25_new ();
+	this_p = packet_alloc (0);
 
 #if AX25MEMDEBUG	
 	if (ax25memdebug) {
@@ -704,6 +946,10 @@ packet_t ax25_from_frame (unsigned char *fbuf, int flen, alevel_t alevel)
  *
  * Returns:	Pointer to new packet object or NULL if error.
  *
+ * Description:	The copy shares the frame contents with the original.
+ *		Most copies are only looked at.  Functions which modify
+ *		the frame (e.g. the digipeater setting the "H" bit)
+ *		make a private copy first so the original is unchanged.
  *
  *------------------------------------------------------------------------------*/
 
@@ -714,17 +960,22 @@ packet_t ax25_dup_debug (packet_t copy_from, char *src_file, int src_line)
 packet_t ax25_dup (packet_t copy_from)
 #endif
 {
-	int save_seq;
 	packet_t this_p;
+	int seq;
 
+	assert (copy_from->magic1 == MAGIC);
+	assert (copy_from->magic2 == MAGIC);
 	
-	this_p = ax25_new ();
-	assert (this_p != NULL);
+	seq = __atomic_add_fetch (&last_seq_num, 1, __ATOMIC_RELAXED);
+	__atomic_add_fetch (&new_count, 1, __ATOMIC_RELAXED);
 
-	save_seq = this_p->seq;
+	this_p = pool_get (&packet_pool, &packet_cache);
 
 	memcpy (this_p, copy_from, sizeof (struct packet_s));
-	this_p->seq = save_seq;
+	this_p->seq = seq;
+	this_p->nextp = NULL;
+
+	__atomic_add_fetch (&(this_p->frame_buf->refcnt), 1, __ATOMIC_RELAXED);
 
 #if AX25MEMDEBUG
 	if (ax25memdebug) {	
@@ -1031,6 +1282,8 @@ void ax25_set_addr (packet_t this_p, int n, char *ad)
 	assert (this_p->magic2 == MAGIC);
 	assert (n >= 0 && n < AX25_MAX_ADDRS);
 
+	frame_make_writable (this_p);
+
 	//dw_printf ("ax25_set_addr (%d, %s) num_addr=%d\n", n, ad, this_p->num_addr);
 
 	if (strlen(ad) == 0) {
@@ -1117,6 +1370,8 @@ void ax25_insert_addr (packet_t this_p, int n, char *ad)
 	assert (this_p->magic2 == MAGIC);
 	assert (n >= AX25_REPEATER_1 && n < AX25_MAX_ADDRS);
 
+	frame_make_writable (this_p);
+
 	//dw_printf ("ax25_insert_addr (%d, %s)\n", n, ad);
 
 	if (strlen(ad) == 0) {
@@ -1192,6 +1447,8 @@ void ax25_remove_addr (packet_t this_p, int n)
 	assert (this_p->magic2 == MAGIC);
 	assert (n >= AX25_REPEATER_1 && n < AX25_MAX_ADDRS);
 
+	frame_make_writable (this_p);
+
 	/* Shift those beyond to fill this position. */
 
 	CLEAR_LAST_ADDR_FLAG;
@@ -1512,6 +1769,8 @@ void ax25_set_ssid (packet_t this_p, int n, int ssid)
 	assert (this_p->magic1 == MAGIC);
 	assert (this_p->magic2 == MAGIC);
 
+	frame_make_writable (this_p);
+
 
 	if (n >= 0 && n < this_p->num_addr) {
 	  this_p->frame_data[n*7+6] =   (this_p->frame_data[n*7+6] & ~ SSID_SSID_MASK) |
@@ -1582,6 +1841,8 @@ void ax25_set_h (packet_t this_p, int n)
 	assert (this_p->magic1 == MAGIC);
 	assert (this_p->magic2 == MAGIC);
 
+	frame_make_writable (this_p);
+
 	if (n >= 0 && n < this_p->num_addr) {
 	  this_p->frame_data[n*7+6] |= SSID_H_MASK;
 	}
@@ -1737,10 +1998,16 @@ int ax25_get_info (packet_t this_p, unsigned char **paddr)
 	}
 
 	/* Add nul character in case caller treats as printable string. */
+	/* It should already be there.  Avoid writing if the frame is shared. */
 	
 	assert (info_len >= 0);
 
-	info_ptr[info_len] = '\0';
+	if (info_ptr[info_len] != '\0') {
+	  int offset = info_ptr - this_p->frame_data;
+	  frame_make_writable (this_p);
+	  info_ptr = this_p->frame_data + offset;
+	  info_ptr[info_len] = '\0';
+	}
 
 	*paddr = info_ptr;
 	return (info_len);
@@ -1751,6 +2018,9 @@ int ax25_get_info (packet_t this_p, unsigned char **paddr)
 void ax25_set_info (packet_t this_p, unsigned char *new_info_ptr, int new_info_len)
 {
 	unsigned char *old_info_ptr;
+
+	frame_make_writable (this_p);
+
 	int old_info_len = ax25_get_info (this_p, &old_info_ptr);
 	this_p->frame_len -= old_info_len;
 
@@ -1801,7 +2071,9 @@ int ax25_cut_at_crlf (packet_t this_p)
 
 	    int chop = info_len - j;
 
+	    frame_make_writable (this_p);
 	    this_p->frame_len -= chop;
+	    this_p->frame_data[this_p->frame_len] = '\0';
 	    return (chop);
 	  }
 	}
@@ -1919,6 +2191,48 @@ double ax25_get_release_time (packet_t this_p)
 }
 
 
+/*------------------------------------------------------------------------------
+ *
+ * Name:	ax25_set_rx_time
+ *
+ * Purpose:	Remember when a received frame reached some point.
+ *
+ * Inputs:	this_p		- Current packet object.
+ *
+ *		which		- Point along the way.  See enum rx_time_e.
+ *
+ *		t		- Time as returned by dtime_monotonic().
+ *
+ *------------------------------------------------------------------------------*/
+
+void ax25_set_rx_time (packet_t this_p, enum rx_time_e which, double t)
+{
+	assert (this_p->magic1 == MAGIC);
+	assert (this_p->magic2 == MAGIC);
+	assert (which >= 0 && which < RX_TIME_NUM);
+
+	this_p->rx_time[which] = t;
+}
+
+
+/*------------------------------------------------------------------------------
+ *
+ * Name:	ax25_get_rx_time
+ *
+ * Purpose:	Get time when received frame reached some point.  0 if unknown.
+ *
+ *------------------------------------------------------------------------------*/
+
+double ax25_get_rx_time (packet_t this_p, enum rx_time_e which)
+{
+	assert (this_p->magic1 == MAGIC);
+	assert (this_p->magic2 == MAGIC);
+	assert (which >= 0 && which < RX_TIME_NUM);
+
+	return (this_p->rx_time[which]);
+}
+
+
 /*------------------------------------------------------------------------------
  *
  * Name:	ax25_set_modulo
@@ -2622,6 +2936,8 @@ void ax25_set_pid (packet_t this_p, int pid)
 	assert (this_p->magic1 == MAGIC);
 	assert (this_p->magic2 == MAGIC);
 
+	frame_make_writable (this_p);
+
 	// Some applications set this to 0 which is an error.
 	// Change 0 to 0xF0 meaning no layer 3 protocol.
 
@@ -72,6 +72,23 @@
 #define AX25_PID_ZLIB_COMPRESSED 0xf5		/* Dave's creation */
 
 
+/*
+ * Times, from dtime_monotonic(), as a received frame moves along.
+ * 0 means not known.  For example, frames that did not come
+ * from a radio channel have none.
+ */
+
+enum rx_time_e {
+	RX_TIME_AUDIO = 0,	/* Audio buffer, containing end of frame, was read. */
+	RX_TIME_FLAG,		/* Closing flag, or end of FX.25 / IL2P block, found. */
+	RX_TIME_DECODED,	/* After fix bits or FEC, valid frame offered to multi_modem. */
+	RX_TIME_PICKED,		/* Best of multiple decoders picked and put in dlq. */
+	RX_TIME_DLQ,		/* Removed from dlq by the thread which delivers it. */
+	RX_TIME_SENT,		/* Sent to KISS and AGW clients. */
+	RX_TIME_NUM
+};
+
+
 #ifdef AX25_PAD_C	/* Keep this hidden - implementation could change. */
 
 struct packet_s {
@@ -83,6 +100,8 @@ struct packet_s {
 	double release_time;	/* Time stamp in format returned by dtime_now(). */
 				/* When to release from the SATgate mode delay queue. */
 
+	double rx_time[RX_TIME_NUM];	/* Progress of received frame.  See enum rx_time_e. */
+
 #define MAGIC 0x41583235
 
 	struct packet_s *nextp;	/* Pointer to next in queue. */
@@ -139,11 +158,32 @@ struct packet_s {
 				/* For U frames:   	set to 0 - not applicable */
 				/* For I & S frames:	8 or 128 if known.  0 if unknown. */
 
-	unsigned char frame_data[AX25_MAX_PACKET_LEN+1];
+	unsigned char *frame_data;
 				/* Raw frame contents, without the CRC. */
-				
+				/* This points into frame_buf below. */
 
-	int magic2;		/* Will get stomped on if above overflows. */
+	struct ax25_frame_buf_s *frame_buf;
+				/* The frame contents can be shared by copies */
+				/* made with ax25_dup.  It is copied before being */
+				/* modified when there is more than one user. */
+
+	int magic2;
+};
+
+
+/*
+ * Reference counted storage for the raw frame.
+ * Anyone holding a reference must not change data[0 .. frame_len-1]
+ * while refcnt is greater than 1.
+ */
+
+struct ax25_frame_buf_s {
+
+	int refcnt;		/* Number of packet objects using this. */
+
+	unsigned char data[AX25_MAX_PACKET_LEN+1];
+
+	int magic3;		/* Will get stomped on if above overflows. */
 };
 
 
@@ -411,6 +451,9 @@ extern packet_t ax25_get_nextp (packet_t this_p);
 extern void ax25_set_release_time (packet_t this_p, double release_time);
 extern double ax25_get_release_time (packet_t this_p);
 
+extern void ax25_set_rx_time (packet_t this_p, enum rx_time_e which, double t);
+extern double ax25_get_rx_time (packet_t this_p, enum rx_time_e which);
+
 extern void ax25_set_modulo (packet_t this_p, int modulo);
 extern int ax25_get_modulo (packet_t this_p);
 
@@ -57,6 +57,7 @@
 #include "dlq.h"
 #include "aprs_tt.h"		// for dw_run_cmd - should relocate someday.
 #include "mheard.h"
+#include "dtime_now.h"
 
 
 /*
@@ -84,9 +85,9 @@ void beacon_tracker_set_debug (int level)
 	g_tracker_debug_level = level;
 }
 
-static time_t sb_calculate_next_time (time_t now,
+static double sb_calculate_next_time (double now,
 			float current_speed_mph, float current_course,
-			time_t last_xmit_time, float last_xmit_course);
+			double last_xmit_time, float last_xmit_course, double *turn_at);
 
 static void beacon_send (int j, dwgps_info_t *gpsinfo);
 
@@ -408,17 +409,103 @@ void beacon_init (struct audio_s *pmodem, struct misc_config_s *pconfig, struct
  *
  * Inputs:	g_misc_config_p->beacon
  *
- * Outputs:	g_misc_config_p->beacon[].next_time
+ * Outputs:	g_misc_config_p->beacon[].next
  *
  * Description:	Go to sleep until it is time for the next beacon.
  *		Transmit any beacons scheduled for now.
  *		Repeat.
  *
+ *		Version 1.8:  Beacons are kept in a priority queue
+ *		ordered by time so the next one is always at the front
+ *		and times are no longer rounded to whole seconds.
+ *
+ *		When there are tracker beacons we also wake up for each
+ *		update from the GPS receiver rather than checking at the
+ *		SmartBeaconing turn time and fast rate intervals.
+ *		A corner pegging beacon goes out as soon as the turn is
+ *		seen, or as soon as sb_turn_time allows it.
+ *
+ *		Fixed beacons on the same radio channel, scheduled at
+ *		about the same time, are spread out by BEACON_SPACING
+ *		so they don't go out back to back in one transmission,
+ *		tying up the channel.   This only delays the transmission;
+ *		the schedule for the following ones is not affected.
+ *
  *--------------------------------------------------------------------*/
 
-#define MIN(x,y) ((x) < (y) ? (x) : (y))
+#define BEACON_SPACING 5.	/* Minimum seconds between fixed beacons on the same channel. */
+
+
+/*
+ * Schedule.  Binary heap of beacon numbers with the earliest due at sched_heap[0].
+ * sched_pos[] is the position of each beacon in the heap so its time can be
+ * changed in place, e.g. when SmartBeaconing wants a tracker beacon sooner.
+ *
+ * sched_due[] is normally the same as beacon[].next but can be later when
+ * a beacon is held back to keep away from another on the same channel.
+ */
+
+static int *sched_heap;
+static int *sched_pos;
+static double *sched_due;
+static int sched_count = 0;
+
+
+/* Is heap entry a ahead of b?  Among those held back to the same time, */
+/* the one originally scheduled first goes first so none are starved. */
+
+static int sched_before (int a, int b)
+{
+	int ja = sched_heap[a];
+	int jb = sched_heap[b];
+
+	if (sched_due[ja] != sched_due[jb]) {
+	  return (sched_due[ja] < sched_due[jb]);
+	}
+	return (g_misc_config_p->beacon[ja].next < g_misc_config_p->beacon[jb].next);
+}
+
+static void sched_swap (int a, int b)
+{
+	int t = sched_heap[a];
+
+	sched_heap[a] = sched_heap[b];
+	sched_heap[b] = t;
+	sched_pos[sched_heap[a]] = a;
+	sched_pos[sched_heap[b]] = b;
+}
+
+static void sched_set (int j, double due)
+{
+	int i;
+
+	if (sched_pos[j] < 0) {
+	  sched_heap[sched_count] = j;
+	  sched_pos[j] = sched_count;
+	  sched_count++;
+	}
+	sched_due[j] = due;
+	i = sched_pos[j];
+
+	/* Move toward the top if earlier than parent. */
 
+	while (i > 0 && sched_before (i, (i-1)/2)) {
+	  sched_swap (i, (i-1)/2);
+	  i = (i-1)/2;
+	}
+
+	/* Move toward the bottom if later than a child. */
 
+	while (1) {
+	  int c = 2 * i + 1;
+
+	  if (c >= sched_count) break;
+	  if (c + 1 < sched_count && sched_before (c + 1, c)) c++;
+	  if ( ! sched_before (c, i)) break;
+	  sched_swap (i, c);
+	  i = c;
+	}
+}
 
 
 #if __WIN32__
@@ -428,77 +515,96 @@ static void * beacon_thread (void *arg)
 #endif
 {
 	int j;				/* Index into array of beacons. */
-	time_t earliest;
-	time_t now;			/* Current time. */
+	double now;			/* Current time. */
+	double wake;			/* When we need to do something next. */
 	int number_of_tbeacons;		/* Number of tracker beacons. */
+	double last_xmit[MAX_TOTAL_CHANS];	/* Most recent fixed beacon on each channel. */
+	int gps_seq = 0;		/* For noticing updates from GPS. */
+	dwgps_info_t gpsinfo;
 
 
 /*
  * SmartBeaconing state.
  */
-	time_t sb_prev_time = 0;	/* Time of most recent transmission. */
+	double sb_prev_time = 0;	/* Time of most recent transmission. */
 	float sb_prev_course = 0;	/* Most recent course reported. */
+	double sb_turn_at = 0;		/* Turn seen but too soon after previous.  Check again then. */
 
 
 #if DEBUG
 	struct tm tm;
 	char hms[20];
+	time_t t = time(NULL);
 
-	now = time(NULL);
-
-	localtime_r (&now, &tm);
+	localtime_r (&t, &tm);
 
 	strftime (hms, sizeof(hms), "%H:%M:%S", &tm);
 	text_color_set(DW_COLOR_DEBUG);
 	dw_printf ("beacon_thread: started %s\n", hms);
 #endif
 
+	sched_heap = calloc (g_misc_config_p->num_beacons, sizeof(int));
+	sched_pos = calloc (g_misc_config_p->num_beacons, sizeof(int));
+	sched_due = calloc (g_misc_config_p->num_beacons, sizeof(double));
+	if (sched_heap == NULL || sched_pos == NULL || sched_due == NULL) {
+	  text_color_set(DW_COLOR_ERROR);
+	  dw_printf ("FATAL ERROR: Out of memory.\n");
+	  exit (EXIT_FAILURE);
+	}
+
+	for (j = 0; j < MAX_TOTAL_CHANS; j++) {
+	  last_xmit[j] = 0;
+	}
+
+	dwgps_clear (&gpsinfo);
+
 /*
+ * Put all valid beacons in the schedule.
  * See if any tracker beacons are configured.
  * No need to obtain GPS data if none.
  */
 
 	number_of_tbeacons = 0;
 	for (j=0; j<g_misc_config_p->num_beacons; j++) {
+	  sched_pos[j] = -1;
+	  if (g_misc_config_p->beacon[j].btype != BEACON_IGNORE) {
+	    sched_set (j, g_misc_config_p->beacon[j].next);
+	  }
 	  if (g_misc_config_p->beacon[j].btype == BEACON_TRACKER) {
 	    number_of_tbeacons++;
 	  }
 	}
 
-	now = time(NULL);
-
 	while (1) {
 
-	  dwgps_info_t gpsinfo;
-
 /* 
- * Sleep until time for the earliest scheduled or
- * the soonest we could transmit due to corner pegging.
+ * Sleep until time for the earliest scheduled or a pending
+ * corner pegging beacon.  Wake up sooner for GPS updates.
  */
-	  
-	  earliest = now + 60 * 60;
-	  for (j=0; j<g_misc_config_p->num_beacons; j++) {
-	    if (g_misc_config_p->beacon[j].btype != BEACON_IGNORE) {
-	      earliest = MIN(g_misc_config_p->beacon[j].next, earliest);
-	    }
+	  now = dtime_now();
+	  wake = now + 60 * 60;
+	  if (sched_count > 0 && sched_due[sched_heap[0]] < wake) {
+	    wake = sched_due[sched_heap[0]];
 	  }
-
-	  if (g_misc_config_p->sb_configured && number_of_tbeacons > 0) {
-	    earliest = MIN(now + g_misc_config_p->sb_turn_time, earliest);
-            earliest = MIN(now + g_misc_config_p->sb_fast_rate, earliest);
+	  if (sb_turn_at > 0 && sb_turn_at < wake) {
+	    wake = sb_turn_at;
 	  }
 
-	  if (earliest > now) {
-	    SLEEP_SEC (earliest - now);
+	  if (number_of_tbeacons > 0) {
+	    dwgps_wait (&gps_seq, wake);
+	  }
+	  else if (wake > now) {
+	    SLEEP_MS ((int)ceil((wake - now) * 1000));
 	  }
 
 /*
  * Woke up.  See what needs to be done.
  */
-	  now = time(NULL);
+	  now = dtime_now();
 
 #if DEBUG
-	  localtime_r (&now, &tm);
+	  t = (time_t)now;
+	  localtime_r (&t, &tm);
 	  strftime (hms, sizeof(hms), "%H:%M:%S", &tm);
 	  text_color_set(DW_COLOR_DEBUG);
 	  dw_printf ("beacon_thread: woke up %s\n", hms);
@@ -518,9 +624,10 @@ static void * beacon_thread (void *arg)
 	    if (g_tracker_debug_level >= 1) {
 	      struct tm tm;
 	      char hms[20];
+	      time_t t = (time_t)now;
 
 
-	      localtime_r (&now, &tm);
+	      localtime_r (&t, &tm);
 	      strftime (hms, sizeof(hms), "%H:%M:%S", &tm);
 	      text_color_set(DW_COLOR_DEBUG);
 	      if (fix == 3) {
@@ -540,11 +647,13 @@ static void * beacon_thread (void *arg)
 /*
  * Run SmartBeaconing calculation if configured and GPS data available.
  */
+	    sb_turn_at = 0;
+
 	    if (g_misc_config_p->sb_configured && fix >= DWFIX_2D) {
 
-	      time_t tnext = sb_calculate_next_time (now, 
+	      double tnext = sb_calculate_next_time (now, 
 			DW_KNOTS_TO_MPH(gpsinfo.speed_knots), gpsinfo.track,
-			sb_prev_time, sb_prev_course);
+			sb_prev_time, sb_prev_course, &sb_turn_at);
 
 	      for (j=0; j<g_misc_config_p->num_beacons; j++) {
 	        if (g_misc_config_p->beacon[j].btype == BEACON_TRACKER) {
@@ -552,6 +661,7 @@ static void * beacon_thread (void *arg)
 	          /* and having more than one tbeacon configured. */
 	          if (tnext < g_misc_config_p->beacon[j].next) {
 	             g_misc_config_p->beacon[j].next = tnext;
+	             sched_set (j, tnext);
 	          }
 	        }
 	      }  /* Update next time if sooner. */
@@ -559,83 +669,101 @@ static void * beacon_thread (void *arg)
 	  }  /* tbeacon(s) configured. */
 
 /*
- * Send if the time has arrived.
+ * Send those whose time has arrived, earliest first.
  */
-	  for (j=0; j<g_misc_config_p->num_beacons; j++) {
+	  while (sched_count > 0 && sched_due[sched_heap[0]] <= now) {
 
-	    struct beacon_s *bp = & (g_misc_config_p->beacon[j]);
-
-	    if (bp->btype == BEACON_IGNORE)
-	      continue;
+	    struct beacon_s *bp;
+	    int held_back;
 
-	    if (bp->next <= now) {
+	    j = sched_heap[0];
+	    bp = & (g_misc_config_p->beacon[j]);
+	    held_back = sched_due[j] > bp->next;
 
-	      /* Send the beacon. */
+	    /* Hold back a fixed beacon if another one was just sent on the same channel. */
+	    /* Slotted beacons already have their own assigned times. */
 
-	      beacon_send (j, &gpsinfo);
+	    if (bp->btype != BEACON_TRACKER && bp->slot == G_UNKNOWN &&
+			bp->sendto_type == SENDTO_XMIT &&
+			now < last_xmit[bp->sendto_chan] + BEACON_SPACING) {
+	      sched_set (j, last_xmit[bp->sendto_chan] + BEACON_SPACING);
+	      continue;
+	    }
 
-	      /* Calculate when the next one should be sent. */
-	      /* Easy for fixed interval.  SmartBeaconing takes more effort. */
+	    /* Send the beacon. */
 
-	      if (bp->btype == BEACON_TRACKER) {
+	    beacon_send (j, &gpsinfo);
 
-	        if (gpsinfo.fix < DWFIX_2D) {
-	          /* Fix not available so beacon was not sent. */
+	    if (bp->btype != BEACON_TRACKER && bp->sendto_type == SENDTO_XMIT) {
+	      last_xmit[bp->sendto_chan] = now;
+	    }
 
-		  if (g_misc_config_p->sb_configured) {
-	            /* Try again in a couple seconds. */
-	            bp->next = now + 2;
-	          }
-	          else {
-	            /* Stay with the schedule. */
-	            /* Important for slotted.  Might reconsider otherwise. */
-	            bp->next += bp->every;
-	          }
-	        }
-	        else if (g_misc_config_p->sb_configured) {
+	    /* Calculate when the next one should be sent. */
+	    /* Easy for fixed interval.  SmartBeaconing takes more effort. */
 
-		  /* Remember most recent tracker beacon. */
-	          /* Compute next time if not turning. */
+	    if (bp->btype == BEACON_TRACKER) {
 
-		  sb_prev_time = now;
-		  sb_prev_course = gpsinfo.track;
+	      if (gpsinfo.fix < DWFIX_2D) {
+	        /* Fix not available so beacon was not sent. */
 
-	          bp->next = sb_calculate_next_time (now,
-			DW_KNOTS_TO_MPH(gpsinfo.speed_knots), gpsinfo.track,
-			sb_prev_time, sb_prev_course);
+	        if (g_misc_config_p->sb_configured) {
+	          /* Try again in a couple seconds. */
+	          bp->next = now + 2;
 	        }
 	        else {
-	          /* Tracker beacon, fixed spacing. */
+	          /* Stay with the schedule. */
+	          /* Important for slotted.  Might reconsider otherwise. */
 	          bp->next += bp->every;
 	        }
 	      }
-	      else {
-	        /* Non-tracker beacon, fixed spacing. */
-		/* Increment by 'every' so slotted times come out right. */
-	        /* i.e. Don't take relative to now in case there was some delay. */
+	      else if (g_misc_config_p->sb_configured) {
 
-	        bp->next += bp->every;
+	        /* Remember most recent tracker beacon. */
+	        /* Compute next time if not turning. */
 
-	        // https://github.com/wb2osz/direwolf/pull/301
-	        // https://github.com/wb2osz/direwolf/pull/301
-	        // This happens with a portable system with no Internet connection.
-	        // On reboot, the time is in the past.
-	        // After time gets set from GPS, all beacons from that interval are sent.
-	        // FIXME:  This will surely break time slotted scheduling.
-		// TODO: The correct fix will be using monotonic, rather than clock, time.
-
-	        /* craigerl: if next beacon is scheduled in the past, then set next beacon relative to now (happens when NTP pushes clock AHEAD) */
-	        /* fixme: if NTP sets clock BACK an hour, this thread will sleep for that hour */
-	        if ( bp->next < now ) {
-	            bp->next = now + bp->every;
-	            text_color_set(DW_COLOR_INFO);
-	            dw_printf("\nSystem clock appears to have jumped forward.  Beacon schedule updated.\n\n");
-	        }
+	        sb_prev_time = now;
+	        sb_prev_course = gpsinfo.track;
+
+	        bp->next = sb_calculate_next_time (now,
+			DW_KNOTS_TO_MPH(gpsinfo.speed_knots), gpsinfo.track,
+			sb_prev_time, sb_prev_course, &sb_turn_at);
+	      }
+	      else {
+	        /* Tracker beacon, fixed spacing. */
+	        bp->next += bp->every;
+	      }
+	    }
+	    else {
+	      /* Non-tracker beacon, fixed spacing. */
+	      /* Increment by 'every' so slotted times come out right. */
+	      /* i.e. Don't take relative to now in case there was some delay. */
+
+	      bp->next += bp->every;
+
+	      // https://github.com/wb2osz/direwolf/pull/301
+	      // https://github.com/wb2osz/direwolf/pull/301
+	      // This happens with a portable system with no Internet connection.
+	      // On reboot, the time is in the past.
+	      // After time gets set from GPS, all beacons from that interval are sent.
+	      // FIXME:  This will surely break time slotted scheduling.
+	      // TODO: The correct fix will be using monotonic, rather than clock, time.
+
+	      /* craigerl: if next beacon is scheduled in the past, then set next beacon relative to now (happens when NTP pushes clock AHEAD) */
+	      /* fixme: if NTP sets clock BACK an hour, this thread will sleep for that hour */
+	      if ( bp->next < now && held_back ) {
+	          /* Held back long enough to miss the next one.  Stay in step with the schedule. */
+	          while (bp->next < now) bp->next += bp->every;
+	      }
+	      else if ( bp->next < now ) {
+	          bp->next = now + bp->every;
+	          text_color_set(DW_COLOR_INFO);
+	          dw_printf("\nSystem clock appears to have jumped forward.  Beacon schedule updated.\n\n");
 	      }
+	    }
 
-	    }  /* if time to send it */
+	    sched_set (j, bp->next);
 
-	  }  /* for each configured beacon */
+	  }  /* while something due */
 
 	}  /* do forever */
 
@@ -666,6 +794,10 @@ static void * beacon_thread (void *arg)
  *
  *		last_xmit_course	- Direction included in most recent transmission.
  *
+ * Outputs:	turn_at			- Turn is large enough for corner pegging but it is
+ *					  too soon after the previous transmission.
+ *					  Time when it will be allowed.  Otherwise 0.
+ *
  * Global In:	g_misc_config_p->
  *			sb_configured	TRUE if SmartBeaconing is configured.
  *			sb_fast_speed	MPH
@@ -697,12 +829,14 @@ static float heading_change (float a, float b)
 	  return (360. - diff);
 }
 
-static time_t sb_calculate_next_time (time_t now,
+static double sb_calculate_next_time (double now,
 			float current_speed_mph, float current_course,
-			time_t last_xmit_time, float last_xmit_course)
+			double last_xmit_time, float last_xmit_course, double *turn_at)
 {
 	int beacon_rate;
-	time_t next_time;
+	double next_time;
+
+	*turn_at = 0;
 
 /*
  * Compute time between beacons for travelling in a straight line.
@@ -739,15 +873,20 @@ static time_t sb_calculate_next_time (time_t now,
 	  float turn_threshold = g_misc_config_p->sb_turn_angle +
 			g_misc_config_p->sb_turn_slope / current_speed_mph;
 
-	  if (change > turn_threshold &&
-		  now >= last_xmit_time + g_misc_config_p->sb_turn_time) {
+	  if (change > turn_threshold) {
 
-	    if (g_tracker_debug_level >= 2) {
-	      text_color_set(DW_COLOR_DEBUG);
-	      dw_printf ("SmartBeaconing: Send now for heading change of %.0f\n", change);
-	    }
+	    if (now >= last_xmit_time + g_misc_config_p->sb_turn_time) {
 
-	    next_time = now;
+	      if (g_tracker_debug_level >= 2) {
+	        text_color_set(DW_COLOR_DEBUG);
+	        dw_printf ("SmartBeaconing: Send now for heading change of %.0f\n", change);
+	      }
+
+	      next_time = now;
+	    }
+	    else {
+	      *turn_at = last_xmit_time + g_misc_config_p->sb_turn_time;
+	    }
 	  }
 	}
 
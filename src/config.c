@@ -678,6 +678,80 @@ static char *split (char *string, int rest_of_line)
 
 
 
+/*-------------------------------------------------------------------
+ *
+ * Name:        config_assign_channels
+ *
+ * Purpose:     Decide which radio channel numbers belong to each audio device.
+ *
+ * Inputs:	p_audio_config	- adev[].defined and adev[].num_channels.
+ *
+ * Outputs:	p_audio_config	- adev[].first_chan, chan_adev[], and
+ *				  chan_medium[] for the radio channels.
+ *
+ * Description:	Originally each audio device had two channel numbers, whether
+ *		used or not, so device 1 always had channels 2 and 3.
+ *		We keep that numbering when possible so existing configuration
+ *		files still work.  A device with more than two channels, such as
+ *		IQ input, pushes the following devices to higher numbers.
+ *
+ *		Called again whenever ADEVICE or ACHANNELS changes something.
+ *
+ * Errors:	Exits if a channel number needed by an audio device was
+ *		already taken by ICHANNEL or NCHANNEL.
+ *
+ *--------------------------------------------------------------------*/
+
+void config_assign_channels (struct audio_s *p_audio_config)
+{
+	int a, c;
+	int next = 0;		// Next unused channel number.
+
+	for (c = 0; c < MAX_TOTAL_CHANS; c++) {
+	  if (p_audio_config->chan_medium[c] == MEDIUM_RADIO) {
+	    p_audio_config->chan_medium[c] = MEDIUM_NONE;
+	  }
+	  p_audio_config->chan_adev[c] = 0;
+	}
+
+	for (a = 0; a < MAX_ADEVS; a++) {
+
+	  if ( ! p_audio_config->adev[a].defined) continue;
+
+	  int n = p_audio_config->adev[a].num_channels;
+	  int first = a * 2 > next ? a * 2 : next;
+
+	  if (first + n > MAX_TOTAL_CHANS) {
+	    first = next;
+	  }
+	  if (first + n > MAX_TOTAL_CHANS) {
+	    text_color_set(DW_COLOR_ERROR);
+	    dw_printf ("Not enough channel numbers for %d channels of audio device %d.  There can be only %d in total.\n",
+							n, a, MAX_TOTAL_CHANS);
+	    exit (EXIT_FAILURE);
+	  }
+
+	  p_audio_config->adev[a].first_chan = first;
+
+	  for (c = first; c < first + n; c++) {
+	    if (p_audio_config->chan_medium[c] != MEDIUM_NONE) {
+	      // The device's audio would go to the virtual channel.
+	      text_color_set(DW_COLOR_ERROR);
+	      dw_printf ("Channel %d, for audio device %d, is already used by ICHANNEL or NCHANNEL.\n", c, a);
+	      dw_printf ("Audio device %d needs channels %d thru %d.  Pick a different number for the virtual channel.\n", a, first, first + n - 1);
+	      exit (EXIT_FAILURE);
+	    }
+	    p_audio_config->chan_medium[c] = MEDIUM_RADIO;
+	    p_audio_config->chan_adev[c] = a;
+	  }
+	  next = first + n;
+	}
+
+} /* end config_assign_channels */
+
+
+
+
 /*-------------------------------------------------------------------
  *
  * Name:        config_init
@@ -827,7 +901,7 @@ void config_init (char *fname, struct audio_s *p_audio_config,
 	/* First channel should always be valid. */
 	/* If there is no ADEVICE, it uses default device in mono. */
 
-	p_audio_config->chan_medium[0] = MEDIUM_RADIO;
+	config_assign_channels (p_audio_config);
 
 	memset (p_digi_config, 0, sizeof(struct digi_config_s));	// APRS digipeater
 	p_digi_config->dedupe_time = DEFAULT_DEDUPE;
@@ -875,6 +949,7 @@ void config_init (char *fname, struct audio_s *p_audio_config,
 
 	memset (p_misc_config, 0, sizeof(struct misc_config_s));
 	p_misc_config->agwpe_port = DEFAULT_AGWPE_PORT;
+	strlcpy (p_misc_config->stats_addr, "127.0.0.1", sizeof(p_misc_config->stats_addr));
 
 	for (int i=0; i<MAX_KISS_TCP_PORTS; i++) {
 	  p_misc_config->kiss_port[i] = 0;	// entry not used.
@@ -1060,7 +1135,7 @@ void config_init (char *fname, struct audio_s *p_audio_config,
 	    if (adevice < 0 || adevice >= MAX_ADEVS) {
 	      text_color_set(DW_COLOR_ERROR);
 	      dw_printf ("Config file: Device number %d out of range for ADEVICE command on line %d.\n", adevice, line);
-	      dw_printf ("If you really need more than %d audio devices, increase MAX_ADEVS and recompile.\n", MAX_ADEVS);
+	      dw_printf ("There can be at most %d audio devices.\n", MAX_ADEVS);
 	      adevice = 0;
 	      continue;
 	    }
@@ -1099,7 +1174,7 @@ void config_init (char *fname, struct audio_s *p_audio_config,
 	    else {
 	      /* First channel of device is valid. */
 	      // This might be changed to UDP or STDIN when the device name is examined.
-	      p_audio_config->chan_medium[ADEVFIRSTCHAN(adevice)] = MEDIUM_RADIO;
+	      config_assign_channels (p_audio_config);
 
 	      strlcpy (p_audio_config->adev[adevice].adevice_in, t, sizeof(p_audio_config->adev[adevice].adevice_in));
 	      strlcpy (p_audio_config->adev[adevice].adevice_out, t, sizeof(p_audio_config->adev[adevice].adevice_out));
@@ -1156,7 +1231,7 @@ void config_init (char *fname, struct audio_s *p_audio_config,
 		  p_audio_config->adev[adevice].defined = 1;
 
 		  /* First channel of device is valid. */
-		  p_audio_config->chan_medium[ADEVFIRSTCHAN(adevice)] = MEDIUM_RADIO;
+		  config_assign_channels (p_audio_config);
 
 		  strlcpy (p_audio_config->adev[adevice].adevice_in, t, sizeof(p_audio_config->adev[adevice].adevice_in));
 	  }
@@ -1183,7 +1258,7 @@ void config_init (char *fname, struct audio_s *p_audio_config,
 		  p_audio_config->adev[adevice].defined = 1;
 
 		  /* First channel of device is valid. */
-		  p_audio_config->chan_medium[ADEVFIRSTCHAN(adevice)] = MEDIUM_RADIO;
+		  config_assign_channels (p_audio_config);
 
 		  strlcpy (p_audio_config->adev[adevice].adevice_out, t, sizeof(p_audio_config->adev[adevice].adevice_out));		  
 	  }
@@ -1214,6 +1289,7 @@ void config_init (char *fname, struct audio_s *p_audio_config,
 
 /*
  * ACHANNELS 		- Number of audio channels for current device: 1 or 2
+ *			  More are possible for IQINPUT or an unusual sound card.
  */
 
 	  else if (strcasecmp(t, "ACHANNELS") == 0) {
@@ -1225,22 +1301,128 @@ void config_init (char *fname, struct audio_s *p_audio_config,
 	      continue;
 	    }
 	    n = atoi(t);
-            if (n ==1 || n == 2) {
+            if (n >= 1 && n <= MAX_TOTAL_CHANS) {
 	      p_audio_config->adev[adevice].num_channels = n;
 
 	      /* Set valid channels depending on mono or stereo. */
+	      /* This can move channels of later devices. */
 
-	      p_audio_config->chan_medium[ADEVFIRSTCHAN(adevice)] = MEDIUM_RADIO;
-	      if (n == 2) {
-	        p_audio_config->chan_medium[ADEVFIRSTCHAN(adevice) + 1] = MEDIUM_RADIO;
-	      }
+	      config_assign_channels (p_audio_config);
 	    }
 	    else {
 	      text_color_set(DW_COLOR_ERROR);
-              dw_printf ("Line %d: Number of audio channels must be 1 or 2.\n", line);
+              dw_printf ("Line %d: Number of audio channels must be in range of 1 to %d.\n", line, MAX_TOTAL_CHANS);
    	    }
 	  }
 
+/*
+ * AFORMAT		- Audio sample format for current device.
+ *
+ *			  U8, S16 (default), S24, S32, or F32.
+ *			  All little endian.  S24 is packed in 3 bytes.
+ *			  F32 is float with full scale of +-1.0, common for SDR software.
+ */
+
+	  else if (strcasecmp(t, "AFORMAT") == 0) {
+	    t = split(NULL,0);
+	    if (t == NULL) {
+	      text_color_set(DW_COLOR_ERROR);
+	      dw_printf ("Line %d: Missing sample format for AFORMAT command.\n", line);
+	      continue;
+	    }
+
+	    p_audio_config->adev[adevice].float_samples = 0;
+
+	    if (strcasecmp(t, "U8") == 0) {
+	      p_audio_config->adev[adevice].bits_per_sample = 8;
+	    }
+	    else if (strcasecmp(t, "S16") == 0) {
+	      p_audio_config->adev[adevice].bits_per_sample = 16;
+	    }
+	    else if (strcasecmp(t, "S24") == 0) {
+	      p_audio_config->adev[adevice].bits_per_sample = 24;
+	    }
+	    else if (strcasecmp(t, "S32") == 0) {
+	      p_audio_config->adev[adevice].bits_per_sample = 32;
+	    }
+	    else if (strcasecmp(t, "F32") == 0) {
+	      p_audio_config->adev[adevice].bits_per_sample = 32;
+	      p_audio_config->adev[adevice].float_samples = 1;
+	    }
+	    else {
+	      text_color_set(DW_COLOR_ERROR);
+	      dw_printf ("Line %d: Sample format must be U8, S16, S24, S32, or F32.\n", line);
+	    }
+	  }
+
+/*
+ * IQINPUT rate format center-MHz [ spacing-Hz ]
+ *
+ *			- New in version 1.8.  Input for current device is complex IQ
+ *			  from a software defined radio rather than audio.
+ *			  Each channel of the device picks out one radio frequency, set
+ *			  with IQFREQ, and FM demodulates it.  See sdr_iq.c.
+ *
+ *			  format is CU8 (e.g. rtl_sdr), CS8, CS16, or CF32.
+ *			  spacing is the step between possible channel frequencies.
+ *			  Default 25000.  rate must be an even multiple of it.
+ */
+
+	  else if (strcasecmp(t, "IQINPUT") == 0) {
+	    int n;
+	    t = split(NULL,0);
+	    if (t == NULL) {
+	      text_color_set(DW_COLOR_ERROR);
+	      dw_printf ("Line %d: Missing IQ sample rate for IQINPUT command.\n", line);
+	      continue;
+	    }
+	    n = atoi(t);
+	    if (n < 2 * MIN_SAMPLES_PER_SEC || n > 20000000) {
+	      text_color_set(DW_COLOR_ERROR);
+	      dw_printf ("Line %d: Use a more reasonable IQ sample rate in range of %d - %d.\n", line, 2 * MIN_SAMPLES_PER_SEC, 20000000);
+	      continue;
+	    }
+
+	    t = split(NULL,0);
+	    if (t == NULL) {
+	      text_color_set(DW_COLOR_ERROR);
+	      dw_printf ("Line %d: Missing IQ sample format for IQINPUT command.  Use CU8, CS8, CS16, or CF32.\n", line);
+	      continue;
+	    }
+	    if (strcasecmp(t, "CU8") == 0)		p_audio_config->adev[adevice].iq_format = IQ_FORMAT_CU8;
+	    else if (strcasecmp(t, "CS8") == 0)		p_audio_config->adev[adevice].iq_format = IQ_FORMAT_CS8;
+	    else if (strcasecmp(t, "CS16") == 0)	p_audio_config->adev[adevice].iq_format = IQ_FORMAT_CS16;
+	    else if (strcasecmp(t, "CF32") == 0)	p_audio_config->adev[adevice].iq_format = IQ_FORMAT_CF32;
+	    else {
+	      text_color_set(DW_COLOR_ERROR);
+	      dw_printf ("Line %d: Invalid IQ sample format \"%s\".  Use CU8, CS8, CS16, or CF32.\n", line, t);
+	      continue;
+	    }
+
+	    t = split(NULL,0);
+	    if (t == NULL || atof(t) <= 0) {
+	      text_color_set(DW_COLOR_ERROR);
+	      dw_printf ("Line %d: Missing center frequency, in MHz, for IQINPUT command.\n", line);
+	      continue;
+	    }
+	    p_audio_config->adev[adevice].iq_center = atof(t);
+	    p_audio_config->adev[adevice].iq_rate = n;
+	    p_audio_config->adev[adevice].iq_spacing = DEFAULT_IQ_SPACING;
+
+	    t = split(NULL,0);
+	    if (t != NULL) {
+	      n = atoi(t);
+	      if (n >= MIN_SAMPLES_PER_SEC / 2 && n <= MAX_SAMPLES_PER_SEC / 2) {
+	        p_audio_config->adev[adevice].iq_spacing = n;
+	      }
+	      else {
+	        text_color_set(DW_COLOR_ERROR);
+	        dw_printf ("Line %d: Channel spacing for IQINPUT should be in range of %d - %d.  Using %d.\n",
+				line, MIN_SAMPLES_PER_SEC / 2, MAX_SAMPLES_PER_SEC / 2, DEFAULT_IQ_SPACING);
+	      }
+	    }
+	  }
+
 /*
  * ==================== Radio channel parameters ==================== 
  */
@@ -1267,15 +1449,21 @@ void config_init (char *fname, struct audio_s *p_audio_config,
 
 	      if (p_audio_config->chan_medium[n] != MEDIUM_RADIO) {
 
-	        if ( ! p_audio_config->adev[ACHAN2ADEV(n)].defined) {
-	          text_color_set(DW_COLOR_ERROR);
-                  dw_printf ("Line %d: Channel number %d is not valid because audio device %d is not defined.\n", 
-								line, n, ACHAN2ADEV(n));
+	        // Find the device just before, to give a hint.
+
+	        int a, before = -1;
+	        for (a = 0; a < MAX_ADEVS; a++) {
+	          if (p_audio_config->adev[a].defined && p_audio_config->adev[a].first_chan <= n) {
+	            before = a;
+	          }
 	        }
-	        else {
-	          text_color_set(DW_COLOR_ERROR);
-                  dw_printf ("Line %d: Channel number %d is not valid because audio device %d is not in stereo.\n", 
-								line, n, ACHAN2ADEV(n));
+
+	        text_color_set(DW_COLOR_ERROR);
+                dw_printf ("Line %d: Channel number %d is not valid because it does not belong to any audio device.\n", line, n);
+	        if (before >= 0) {
+                  dw_printf ("Audio device %d has channel(s) %d thru %d.  Is ACHANNELS or another ADEVICE needed?\n", 
+								before, p_audio_config->adev[before].first_chan,
+								p_audio_config->adev[before].first_chan + p_audio_config->adev[before].num_channels - 1);
 	        }
 	      }
 	    }
@@ -1285,11 +1473,30 @@ void config_init (char *fname, struct audio_s *p_audio_config,
    	    }
 	  }
 
+/*
+ * IQFREQ MHz		- Radio frequency for channel when the audio device has IQINPUT.
+ */
+
+	  else if (strcasecmp(t, "IQFREQ") == 0) {
+	    if (channel < 0 || channel >= MAX_RADIO_CHANS) {
+	      text_color_set(DW_COLOR_ERROR);
+	      dw_printf ("Line %d: IQFREQ can only be used with radio channel 0 - %d.\n", line, MAX_RADIO_CHANS-1);
+	      continue;
+	    }
+	    t = split(NULL,0);
+	    if (t == NULL || atof(t) <= 0) {
+	      text_color_set(DW_COLOR_ERROR);
+	      dw_printf ("Line %d: Missing frequency, in MHz, for IQFREQ command.\n", line);
+	      continue;
+	    }
+	    p_audio_config->achan[channel].iq_freq = atof(t);
+	  }
+
 /*
  * ICHANNEL n			- Define IGate virtual channel.
  *
  *	This allows a client application to talk to to APRS-IS
- *	by using a channel number outside the normal range for modems.
+ *	by using a channel number not used by a modem.
  *	In the future there might be other typs of virtual channels.
  *	This does not change the current channel number used by MODEM, PTT, etc.
  */
@@ -1302,7 +1509,7 @@ void config_init (char *fname, struct audio_s *p_audio_config,
 	      continue;
 	    }
 	    int ichan = atoi(t);
-            if (ichan >= MAX_RADIO_CHANS && ichan < MAX_TOTAL_CHANS) {
+            if (ichan >= 0 && ichan < MAX_TOTAL_CHANS) {
 
 	      if (p_audio_config->chan_medium[ichan] == MEDIUM_NONE) {
 
@@ -1319,7 +1526,7 @@ void config_init (char *fname, struct audio_s *p_audio_config,
 	    }
 	    else {
 	      text_color_set(DW_COLOR_ERROR);
-              dw_printf ("Line %d: ICHANNEL number must in range of %d to %d.\n", line, MAX_RADIO_CHANS, MAX_TOTAL_CHANS-1);
+              dw_printf ("Line %d: ICHANNEL number must in range of 0 to %d.\n", line, MAX_TOTAL_CHANS-1);
 	    }
 	  }
 
@@ -1327,7 +1534,7 @@ void config_init (char *fname, struct audio_s *p_audio_config,
  * NCHANNEL chan addr port			- Define Network TNC virtual channel.
  *
  *	This allows a client application to talk to to an external TNC over TCP KISS
- *	by using a channel number outside the normal range for modems.
+ *	by using a channel number not used by a modem.
  *	This does not change the current channel number used by MODEM, PTT, etc.
  *
  *	chan = direwolf channel.
@@ -1348,7 +1555,7 @@ void config_init (char *fname, struct audio_s *p_audio_config,
 	      continue;
 	    }
 	    int nchan = atoi(t);
-            if (nchan >= MAX_RADIO_CHANS && nchan < MAX_TOTAL_CHANS) {
+            if (nchan >= 0 && nchan < MAX_TOTAL_CHANS) {
 
 	      if (p_audio_config->chan_medium[nchan] == MEDIUM_NONE) {
 
@@ -1361,7 +1568,7 @@ void config_init (char *fname, struct audio_s *p_audio_config,
 	    }
 	    else {
 	      text_color_set(DW_COLOR_ERROR);
-              dw_printf ("Line %d: NCHANNEL number must in range of %d to %d.\n", line, MAX_RADIO_CHANS, MAX_TOTAL_CHANS-1);
+              dw_printf ("Line %d: NCHANNEL number must in range of 0 to %d.\n", line, MAX_TOTAL_CHANS-1);
 	    }
 
 	    t = split(NULL,0);
@@ -2141,7 +2348,7 @@ void config_init (char *fname, struct audio_s *p_audio_config,
 	      // Failure at this point is not an error.
 	      // See if config file sets it explicitly before complaining.
 
-	      cm108_find_ptt (p_audio_config->adev[ACHAN2ADEV(channel)].adevice_out,
+	      cm108_find_ptt (p_audio_config->adev[p_audio_config->chan_adev[channel]].adevice_out,
 				p_audio_config->achan[channel].octrl[ot].ptt_device,
 				(int)sizeof(p_audio_config->achan[channel].octrl[ot].ptt_device));
 
@@ -2183,7 +2390,7 @@ void config_init (char *fname, struct audio_s *p_audio_config,
 	      if (strlen(p_audio_config->achan[channel].octrl[ot].ptt_device) == 0) {
 	        text_color_set(DW_COLOR_ERROR);
 	        dw_printf ("Config file line %d: Could not determine USB Audio GPIO PTT device for audio output %s.\n", line,
-					p_audio_config->adev[ACHAN2ADEV(channel)].adevice_out);
+					p_audio_config->adev[p_audio_config->chan_adev[channel]].adevice_out);
 #if __WIN32__
 	        dw_printf ("You must explicitly mention a HID path.\n");
 #else
@@ -4685,6 +4892,40 @@ void config_init (char *fname, struct audio_s *p_audio_config,
 	    //exit (0);
 	  }
 
+/*
+ * IGSTANDBY		- Keep a second IGate server connection ready to take over.
+ *
+ * IGSTANDBY						-- another address for the IGSERVER name.
+ *
+ * IGSTANDBY  hostname[:port]				-- a different server.
+ *
+ * New in version 1.8.  Not used for CWOP.
+ */
+
+	  else if (strcasecmp(t, "IGSTANDBY") == 0) {
+	    p_igate_config->t2_standby = 1;
+	    t = split(NULL,0);
+	    if (t != NULL) {
+	      strlcpy (p_igate_config->t2_standby_name, t, sizeof(p_igate_config->t2_standby_name));
+	      p_igate_config->t2_standby_port = DEFAULT_IGATE_PORT;
+
+	      t = strchr (p_igate_config->t2_standby_name, ':');
+	      if (t != NULL) {
+	        *t = '\0';
+	        t++;
+	        int n = atoi(t);
+	        if (n >= MIN_IP_PORT_NUMBER && n <= MAX_IP_PORT_NUMBER) {
+	          p_igate_config->t2_standby_port = n;
+	        }
+	        else {
+	          text_color_set(DW_COLOR_ERROR);
+	          dw_printf ("Line %d: Invalid port number for standby IGate server. Using default %d.\n",
+			line, p_igate_config->t2_standby_port);
+	        }
+	      }
+	    }
+	  }
+
 /*
  * IGLOGIN 		- Login callsign and passcode for IGate server
  *
@@ -4935,6 +5176,36 @@ void config_init (char *fname, struct audio_s *p_audio_config,
    	    }
 	  }
 
+/*
+ * STATSPORT port [ address ]	- Port number for receive performance statistics.
+ *
+ * New in version 1.8.  Default 0 is disabled.
+ * Listens only on 127.0.0.1 unless another local IPv4 address is given.
+ * Use 0.0.0.0 for all interfaces.
+ */
+
+	  else if (strcasecmp(t, "STATSPORT") == 0) {
+	    int n;
+	    t = split(NULL,0);
+	    if (t == NULL) {
+	      text_color_set(DW_COLOR_ERROR);
+	      dw_printf ("Line %d: Missing port number for STATSPORT command.\n", line);
+	      continue;
+	    }
+	    n = atoi(t);
+            if ((n >= MIN_IP_PORT_NUMBER && n <= MAX_IP_PORT_NUMBER) || n == 0) {
+	      p_misc_config->stats_port = n;
+	    }
+	    else {
+	      text_color_set(DW_COLOR_ERROR);
+              dw_printf ("Line %d: Invalid port number for STATSPORT.\n", line);
+   	    }
+	    t = split(NULL,0);
+	    if (t != NULL) {
+	      strlcpy (p_misc_config->stats_addr, t, sizeof(p_misc_config->stats_addr));
+	    }
+	  }
+
 /*
  * KISSPORT port [ chan ]		- Port number for KISS over IP.
  */
@@ -5315,6 +5586,24 @@ void config_init (char *fname, struct audio_s *p_audio_config,
 	    }
 	  }
 
+/*
+ * PKTLOGDIR	- Directory for daily binary logs of all received frames.  See pktlog.c.
+ */
+	  else if (strcasecmp(t, "pktlogdir") == 0) {
+	    t = split(NULL,0);
+	    if (t == NULL) {
+	      text_color_set(DW_COLOR_ERROR);
+	      dw_printf ("Config file: Missing directory name for PKTLOGDIR on line %d.\n", line);
+	      continue;
+	    }
+	    strlcpy (p_misc_config->pktlog_path, t, sizeof(p_misc_config->pktlog_path));
+	    t = split(NULL,0);
+	    if (t != NULL) {
+	      text_color_set(DW_COLOR_ERROR);
+	      dw_printf ("Config file: PKTLOGDIR on line %d should have directory path and nothing more.\n", line);
+	    }
+	  }
+
 /*
  * BEACON channel delay every message
  *
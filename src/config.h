@@ -36,6 +36,12 @@ struct misc_config_s {
 
 	int agwpe_port;		/* TCP Port number for the "AGW TCPIP Socket Interface" */
 
+	int stats_port;		/* TCP Port number for receive performance statistics. */
+				/* 0 to disable.  See statsnet.c. */
+
+	char stats_addr[48];	/* Local IPv4 address for stats_port to listen on. */
+				/* Default 127.0.0.1 so it is only seen from this computer. */
+
 	// Previously we allowed only a single TCP port for KISS.
 	// An increasing number of people want to run multiple radios.
 	// Unfortunately, most applications don't know how to deal with multi-radio TNCs.
@@ -109,6 +115,8 @@ struct misc_config_s {
 
 	char log_path[80];	/* Either directory or full file name depending on above. */
 
+	char pktlog_path[80];	/* Directory for binary packet logs.  Empty if not used. */
+
 	int dns_sd_enabled;	/* DNS Service Discovery announcement enabled. */
 	char dns_sd_name[64];	/* Name announced on dns-sd; defaults to "Dire Wolf on <hostname>" */
 
@@ -182,7 +190,7 @@ struct misc_config_s {
 				/* Remains fixed for PBEACON and OBEACON. */
 				/* Dynamically adjusted for TBEACON. */
 
-	  time_t next;		/* Unix time to transmit next one. */
+	  double next;		/* Unix time to transmit next one.  Fraction of second allowed. */
 
 	  char *source;		/* NULL or explicit AX.25 source address to use */
 				/* instead of the mycall value for the channel. */
@@ -253,6 +261,8 @@ extern void config_init (char *fname, struct audio_s *p_modem,
 			struct igate_config_s *p_igate_config,
 			struct misc_config_s *misc_config);
 
+extern void config_assign_channels (struct audio_s *p_audio_config);
+
 
 
 #endif /* CONFIG_H */
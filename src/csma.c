@@ -0,0 +1,347 @@
+//
+//    This file is part of Dire Wolf, an amateur radio packet TNC.
+//
+//    Copyright (C) 2026  Dire Wolf contributors
+//
+//    This program is free software: you can redistribute it and/or modify
+//    it under the terms of the GNU General Public License as published by
+//    the Free Software Foundation, either version 2 of the License, or
+//    (at your option) any later version.
+//
+//    This program is distributed in the hope that it will be useful,
+//    but WITHOUT ANY WARRANTY; without even the implied warranty of
+//    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//    GNU General Public License for more details.
+//
+//    You should have received a copy of the GNU General Public License
+//    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+
+
+/********************************************************************************
+ *
+ * File:	csma.c
+ *
+ * Purpose:	Decide when a half duplex channel may be used for transmitting.
+ *
+ * Description:	This was part of wait_for_clear_channel in xmit.c.  It is
+ *		kept separate so the slot timing can be tested without
+ *		a radio, audio device, or transmit queue.
+ *
+ *		All times are from dtime_monotonic so a step of the wall
+ *		clock, e.g. NTP setting the time on a Raspberry Pi without
+ *		a real time clock, doesn't hold off transmitting or make
+ *		it give up early.
+ *
+ *******************************************************************************/
+
+#include "direwolf.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+#include "textcolor.h"
+#include "ax25_pad.h"
+#include "tq.h"
+#include "hdlc_rec.h"
+#include "dtime_now.h"
+#include "csma.h"
+
+
+/*-------------------------------------------------------------------
+ *
+ * Name:        csma_wait
+ *
+ * Purpose:     Wait for the radio channel to be clear and any
+ *		additional time for collision avoidance.
+ *
+ * Inputs:	chan	-	Radio channel number.
+ *
+ *		slottime - 	Amount of time to wait for each iteration
+ *				of the waiting algorithm.  10 mSec units.
+ *
+ *		persist -	Probability of transmitting.
+ *
+ *		dwait -		Extra time to wait after the channel becomes
+ *				clear.  10 mSec units.
+ *
+ *		give_up -	Time limit, from dtime_monotonic().
+ *
+ * Returns:	1 for OK.  0 for timeout.
+ *
+ * Description:	Version 1.8: wait for notification from dcd_change
+ *		rather than checking every 10 ms.   Slot times are measured
+ *		from when the channel became clear, not from when we noticed.
+ *		A DCD change during a slot time starts over right away rather
+ *		than being found, or missed, at the end of the slot.
+ *
+ * Transmit delay algorithm:
+ *
+ *		Wait for channel to be clear.
+ *		If anything in high priority queue, bail out of the following.
+ *
+ *		Wait slottime * 10 milliseconds.
+ *		Generate an 8 bit random number in range of 0 - 255.
+ *		If random number <= persist value, return.
+ *		Otherwise repeat.
+ *
+ *		If the channel has already been clear for at least a slot
+ *		time, that first slot has already gone by so we don't
+ *		wait for it again.
+ *
+ * Example:
+ *
+ *		For typical values of slottime=10 and persist=63,
+ *
+ *		Delay		Probability
+ *		-----		-----------
+ *		100		.25					= 25%
+ *		200		.75 * .25				= 19%
+ *		300		.75 * .75 * .25				= 14%
+ *		400		.75 * .75 * .75 * .25			= 11%
+ *		500		.75 * .75 * .75 * .75 * .25		= 8%
+ *		600		.75 * .75 * .75 * .75 * .75 * .25	= 6%
+ *		700		.75 * .75 * .75 * .75 * .75 * .75 * .25	= 4%
+ *		etc.		...
+ *
+ *--------------------------------------------------------------------*/
+
+int csma_wait (int chan, int slottime, int persist, int dwait, double give_up)
+{
+	double clear_at;	/* When channel became clear. */
+	double slot_end;
+
+start_over_again:
+
+	if (dcd_wait (chan, 1, give_up, &clear_at)) {
+	  return 0;
+	}
+
+	slot_end = dtime_monotonic();
+	if (clear_at < slot_end) {
+	  slot_end = clear_at;
+	}
+
+//TODO:  rethink dwait.
+
+/*
+ * Added in version 1.2 - for transceivers that can't
+ * turn around fast enough when using squelch and VOX.
+ */
+
+	if (dwait > 0) {
+	  slot_end += dwait * 0.01;
+	  if (dcd_wait (chan, 0, slot_end, NULL)) {
+	    goto start_over_again;
+	  }
+	}
+
+/*
+ * Don't count more than one slot time that has already gone by.
+ */
+	double now = dtime_monotonic();
+
+	if (slot_end < now - slottime * 0.01) {
+	  slot_end = now - slottime * 0.01;
+	}
+
+/*
+ * Wait random time.
+ * Proceed to transmit sooner if anything shows up in high priority queue.
+ */
+	while (tq_peek(chan, TQ_PRIO_0_HI) == NULL) {
+	  int r;
+
+	  slot_end += slottime * 0.01;
+	  if (slot_end > give_up) {
+	    slot_end = give_up;
+	  }
+
+	  if (dcd_wait (chan, 0, slot_end, NULL)) {
+	    goto start_over_again;
+	  }
+	  if (slot_end >= give_up) {
+	    return 0;
+	  }
+
+	  r = rand() & 0xff;
+	  if (r <= persist) {
+	    break;
+ 	  }
+	}
+
+	return 1;
+
+} /* end csma_wait */
+
+
+
+/*-------------------------------------------------------------------
+ *
+ * Unit test for the slot timing.
+ *
+ * The channel is simulated by a list of times when it is busy.
+ * Times in the list are relative to the start of each case.
+ *
+ * Usage:	gcc -DCSMA_TEST csma.c dtime_now.c textcolor.c -lpthread ; ./a.out
+ *
+ *--------------------------------------------------------------------*/
+
+#if CSMA_TEST
+
+#define MAX_BUSY 4
+
+static double t0;
+
+static struct {
+	double start;
+	double end;
+} busy_list[MAX_BUSY];
+
+static int num_busy;
+
+static packet_t hi_prio = NULL;
+
+static int errors = 0;
+
+
+/* Stand in for hdlc_rec.c. */
+
+int dcd_wait (int chan, int busy, double until, double *clear_at)
+{
+	int state;
+	double last_clear;
+
+	while (1) {
+	  double now = dtime_monotonic() - t0;
+	  double next = until - t0;
+	  int n;
+
+	  state = 0;
+	  last_clear = 0;
+	  for (n = 0; n < num_busy; n++) {
+	    if (now >= busy_list[n].start && now < busy_list[n].end) {
+	      state = 1;
+	      if (busy_list[n].end < next) next = busy_list[n].end;
+	    }
+	    else if (busy_list[n].start > now) {
+	      if (busy_list[n].start < next) next = busy_list[n].start;
+	    }
+	    else if (busy_list[n].end + t0 > last_clear) {
+	      last_clear = busy_list[n].end + t0;
+	    }
+	  }
+
+	  if (state != busy || now >= until - t0) {
+	    break;
+	  }
+	  SLEEP_MS ((int)((next - now) * 1000) + 1);
+	}
+
+	if (clear_at != NULL) {
+	  *clear_at = last_clear;
+	}
+	return (state);
+}
+
+
+/* Stand in for tq.c. */
+
+packet_t tq_peek (int chan, int prio)
+{
+	return (hi_prio);
+}
+
+
+static void try_case (char *title, int slottime, int persist, int dwait, double limit, int expect_ok, double expect_sec)
+{
+	int ok;
+	double elapsed;
+
+	t0 = dtime_monotonic();
+	ok = csma_wait (0, slottime, persist, dwait, t0 + limit);
+	elapsed = dtime_monotonic() - t0;
+
+	text_color_set(DW_COLOR_INFO);
+	dw_printf ("%s: %s after %.3f sec, expected %.3f.\n", title, ok ? "transmit" : "give up", elapsed, expect_sec);
+
+	if (ok != expect_ok || elapsed < expect_sec - 0.005 || elapsed > expect_sec + 0.050) {
+	  text_color_set(DW_COLOR_ERROR);
+	  dw_printf ("    ERROR!\n");
+	  errors++;
+	}
+}
+
+
+int main (int argc, char *argv[])
+{
+
+	text_color_init (1);
+
+	/* Clear for a long time.  The first slot has already gone by. */
+
+	num_busy = 1;
+	busy_list[0].start = -10.0;  busy_list[0].end = -9.9;
+	try_case ("Long idle", 10, 255, 0, 60, 1, 0.0);
+
+	/* Just became clear.  Wait one slot. */
+
+	busy_list[0].start = -1.0;  busy_list[0].end = 0.0;
+	try_case ("Just clear", 10, 255, 0, 60, 1, 0.1);
+
+	/* Clear part of a slot ago.  Wait for the rest of it. */
+
+	busy_list[0].start = -1.0;  busy_list[0].end = -0.06;
+	try_case ("Partial slot", 10, 255, 0, 60, 1, 0.04);
+
+	/* Busy at first.  Slot starts when it becomes clear. */
+
+	busy_list[0].start = -1.0;  busy_list[0].end = 0.2;
+	try_case ("Busy then clear", 10, 255, 0, 60, 1, 0.3);
+
+	/* Busy again in the middle of the slot.  Start over when clear. */
+
+	num_busy = 2;
+	busy_list[0].start = -1.0;  busy_list[0].end = 0.0;
+	busy_list[1].start = 0.05;  busy_list[1].end = 0.15;
+	try_case ("DCD during slot", 10, 255, 0, 60, 1, 0.25);
+
+	/* DWAIT adds to the first slot. */
+
+	num_busy = 1;
+	busy_list[0].start = -1.0;  busy_list[0].end = 0.0;
+	try_case ("DWAIT", 10, 255, 20, 60, 1, 0.3);
+
+	/* Anything in high priority queue goes right away. */
+
+	hi_prio = (packet_t)(&errors);
+	try_case ("High priority", 10, 255, 0, 60, 1, 0.0);
+	hi_prio = NULL;
+
+	/* Channel never clear. */
+
+	busy_list[0].start = -1.0;  busy_list[0].end = 1000.0;
+	try_case ("Always busy", 10, 255, 0, 0.2, 0, 0.2);
+
+	/* Persist 0 almost never transmits so we run out of time. */
+
+	busy_list[0].start = -1.0;  busy_list[0].end = 0.0;
+	srand (1);
+	try_case ("Time limit during slots", 5, -1, 0, 0.2, 0, 0.2);
+
+	if (errors != 0) {
+	  text_color_set(DW_COLOR_ERROR);
+	  dw_printf ("\n%d errors.\n", errors);
+	  exit (EXIT_FAILURE);
+	}
+
+	text_color_set(DW_COLOR_REC);
+	dw_printf ("\nSuccess!\n");
+	exit (EXIT_SUCCESS);
+
+}  /* end main */
+
+#endif
+
+/* end csma.c */
@@ -0,0 +1,9 @@
+
+/* csma.h - Wait for a clear channel before transmitting. */
+
+#ifndef CSMA_H
+#define CSMA_H 1
+
+int csma_wait (int chan, int slottime, int persist, int dwait, double give_up);
+
+#endif
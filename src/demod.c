@@ -36,6 +36,7 @@
 #include "direwolf.h"
 
 #include <stdlib.h>
+#include <stdint.h>
 #include <stdio.h>
 #include <math.h>
 #include <unistd.h>
@@ -54,6 +55,7 @@
 #include "demod_9600.h"
 #include "demod_afsk.h"
 #include "demod_psk.h"
+#include "rx_chain.h"
 
 
 
@@ -63,13 +65,16 @@ static struct audio_s          *save_audio_config_p;
 
 
 
-// Current state of all the decoders.
+// Current state of the decoders for one channel.
+// Found in the rx_chain_s for the channel.
 
-static struct demodulator_state_s demodulator_state[MAX_RADIO_CHANS][MAX_SUBCHANS];
+struct demod_chan_s {
 
+	struct demodulator_state_s state[MAX_SUBCHANS];
 
-static int sample_sum[MAX_RADIO_CHANS][MAX_SUBCHANS];
-static int sample_count[MAX_RADIO_CHANS][MAX_SUBCHANS];
+	float sample_sum[MAX_SUBCHANS];		// For decimation.
+	int sample_count[MAX_SUBCHANS];
+};
 
 
 /*------------------------------------------------------------------
@@ -92,7 +97,6 @@ static int sample_count[MAX_RADIO_CHANS][MAX_SUBCHANS];
 int demod_init (struct audio_s *pa)
 {
 	int chan;		/* Loop index over number of radio channels. */
-	char profile;
 	
 
 
@@ -102,9 +106,66 @@ int demod_init (struct audio_s *pa)
 
 	save_audio_config_p = pa;
 
+/*
+ * Every channel gets space for its decoders, even if not used,
+ * because others might ask about the audio level.
+ */
 	for (chan = 0; chan < MAX_RADIO_CHANS; chan++) {
+	  demod_chain_init (rx_chain_get (chan), pa);
+	}
 
-	 if (save_audio_config_p->chan_medium[chan] == MEDIUM_RADIO) {
+
+	// Now the virtual channels.  FIXME:  could be single loop.
+
+	for (chan = MAX_RADIO_CHANS; chan < MAX_TOTAL_CHANS; chan++) {
+
+// FIXME dw_printf ("-------- virtual channel loop %d \n", chan);
+
+	  if (chan == save_audio_config_p->igate_vchannel) {
+	    text_color_set(DW_COLOR_DEBUG);
+	    dw_printf ("Channel %d: IGate virtual channel.\n", chan);
+	  }
+	}
+
+        return (0);
+
+} /* end demod_init */
+
+
+
+/*------------------------------------------------------------------
+ *
+ * Name:        demod_chain_init
+ *
+ * Purpose:     Initialize the demodulator(s) for one receive chain.
+ *
+ * Inputs:      R		- Receive chain.  R->chan selects the
+ *				  channel configuration to use.
+ *
+ *		pa		- Pointer to audio_s structure with
+ *				  various parameters for the modem(s).
+ *				  Derived values, such as the number of
+ *				  subchannels, are filled in.
+ *
+ * Returns:     0 for success.
+ *
+ * Description:	Called by demod_init for each channel or directly for
+ *		a chain created with rx_chain_create.
+ *
+ *----------------------------------------------------------------*/
+
+int demod_chain_init (struct rx_chain_s *R, struct audio_s *pa)
+{
+	int chan = R->chan;
+	char profile;
+
+	if (R->demod == NULL) {
+	  R->demod = rx_chain_alloc (sizeof(struct demod_chan_s));
+	}
+	R->audio_config = pa;
+
+
+	 if (pa->chan_medium[chan] == MEDIUM_RADIO) {
 
 	  char *p;
 	  char just_letters[16];
@@ -122,10 +183,10 @@ int demod_init (struct audio_s *pa)
 	   * num_slicers is set to max by the "+" option.
 	   */
 
-	  save_audio_config_p->achan[chan].num_subchan = 1;
-	  save_audio_config_p->achan[chan].num_slicers = 1;
+	  pa->achan[chan].num_subchan = 1;
+	  pa->achan[chan].num_slicers = 1;
 
-	  switch (save_audio_config_p->achan[chan].modem_type) {
+	  switch (pa->achan[chan].modem_type) {
 
 	    case MODEM_OFF:
 	      break;
@@ -133,16 +194,16 @@ int demod_init (struct audio_s *pa)
 	    case MODEM_AFSK:
 	    case MODEM_EAS:
 
-	      if (save_audio_config_p->achan[chan].modem_type == MODEM_EAS) {
-		if (save_audio_config_p->achan[chan].fix_bits != RETRY_NONE) {
+	      if (pa->achan[chan].modem_type == MODEM_EAS) {
+		if (pa->achan[chan].fix_bits != RETRY_NONE) {
 	          text_color_set(DW_COLOR_INFO);
 		  dw_printf ("Channel %d: FIX_BITS option has been turned off for EAS.\n", chan);
-	          save_audio_config_p->achan[chan].fix_bits = RETRY_NONE;
+	          pa->achan[chan].fix_bits = RETRY_NONE;
 	        }
-		if (save_audio_config_p->achan[chan].passall != 0) {
+		if (pa->achan[chan].passall != 0) {
 	          text_color_set(DW_COLOR_INFO);
 		  dw_printf ("Channel %d: PASSALL option has been turned off for EAS.\n", chan);
-	          save_audio_config_p->achan[chan].passall = 0;
+	          pa->achan[chan].passall = 0;
 	        }
 	      }
 
@@ -155,7 +216,7 @@ int demod_init (struct audio_s *pa)
 	      num_letters = 0;
 	      just_letters[num_letters] = '\0';
 	      have_plus = 0;
-	      for (p = save_audio_config_p->achan[chan].profiles; *p != '\0'; p++) {
+	      for (p = pa->achan[chan].profiles; *p != '\0'; p++) {
 
 	        if (islower(*p)) {
 	          just_letters[num_letters] = toupper(*p);
@@ -174,7 +235,7 @@ int demod_init (struct audio_s *pa)
 	          if (p[1] != '\0') {
 		    text_color_set(DW_COLOR_ERROR);
 		    dw_printf ("Channel %d: + option must appear at end of demodulator types \"%s\" \n", 
-					chan, save_audio_config_p->achan[chan].profiles);
+					chan, pa->achan[chan].profiles);
 		  }	    
 	        }
 
@@ -183,13 +244,13 @@ int demod_init (struct audio_s *pa)
 	          if (p[1] != '\0') {
 		    text_color_set(DW_COLOR_ERROR);
 		    dw_printf ("Channel %d: - option must appear at end of demodulator types \"%s\" \n", 
-					chan, save_audio_config_p->achan[chan].profiles);
+					chan, pa->achan[chan].profiles);
 		  }	
     
 	        } else {
 		  text_color_set(DW_COLOR_ERROR);
 		  dw_printf ("Channel %d: Demodulator types \"%s\" can contain only letters and + - characters.\n", 
-					chan, save_audio_config_p->achan[chan].profiles);
+					chan, pa->achan[chan].profiles);
 	        }
 	      }
 
@@ -221,9 +282,9 @@ int demod_init (struct audio_s *pa)
  * Someone concerned about 1/2 of one percent difference can add "-D 1"
  */
 #if __arm__
-	      if (save_audio_config_p->achan[chan].decimate == 0) {
-	        if (save_audio_config_p->adev[ACHAN2ADEV(chan)].samples_per_sec > 40000) {
-	          save_audio_config_p->achan[chan].decimate = 3;
+	      if (pa->achan[chan].decimate == 0) {
+	        if (pa->adev[pa->chan_adev[chan]].samples_per_sec > 40000) {
+	          pa->achan[chan].decimate = 3;
 	        }
 	      }
 #endif
@@ -233,13 +294,13 @@ int demod_init (struct audio_s *pa)
  * These can get extremely large for low speeds, e.g. 300 baud.
  * In this case, increase the decimation ration.  Crude approximation. Could be improved.
  */
-	      if (save_audio_config_p->achan[chan].decimate == 0 &&
-		  save_audio_config_p->adev[ACHAN2ADEV(chan)].samples_per_sec > 40000 &&
-	          save_audio_config_p->achan[chan].baud < 600) {
+	      if (pa->achan[chan].decimate == 0 &&
+		  pa->adev[pa->chan_adev[chan]].samples_per_sec > 40000 &&
+	          pa->achan[chan].baud < 600) {
 
 		// Avoid enormous number of filter taps.
 
-	        save_audio_config_p->achan[chan].decimate = 3;
+	        pa->achan[chan].decimate = 3;
 	      }
 
 
@@ -255,18 +316,18 @@ int demod_init (struct audio_s *pa)
 
 	      if (have_plus == -1) have_plus = 0;
 
-	      strlcpy (save_audio_config_p->achan[chan].profiles, just_letters, sizeof(save_audio_config_p->achan[chan].profiles));
+	      strlcpy (pa->achan[chan].profiles, just_letters, sizeof(pa->achan[chan].profiles));
 	      
-	      assert (strlen(save_audio_config_p->achan[chan].profiles) >= 1);
+	      assert (strlen(pa->achan[chan].profiles) >= 1);
 
 	      if (have_plus) {
-	        strlcat (save_audio_config_p->achan[chan].profiles, "+", sizeof(save_audio_config_p->achan[chan].profiles));
+	        strlcat (pa->achan[chan].profiles, "+", sizeof(pa->achan[chan].profiles));
 	      }
 
 	      /* These can be increased later for the multi-frequency case. */
 
-	      save_audio_config_p->achan[chan].num_subchan = num_letters;
-	      save_audio_config_p->achan[chan].num_slicers = 1;
+	      pa->achan[chan].num_subchan = num_letters;
+	      pa->achan[chan].num_slicers = 1;
 
 /*
  * Some error checking - Can use only one of these:
@@ -276,40 +337,40 @@ int demod_init (struct audio_s *pa)
  *	- Multiple frequencies.
  */
 
-	      if (have_plus && save_audio_config_p->achan[chan].num_freq > 1) {
+	      if (have_plus && pa->achan[chan].num_freq > 1) {
 
 		  text_color_set(DW_COLOR_ERROR);
 		  dw_printf ("Channel %d: Demodulator + option can't be combined with multiple frequencies.\n", chan);
-	          save_audio_config_p->achan[chan].num_subchan = 1;	// Will be set higher later.
-	          save_audio_config_p->achan[chan].num_freq = 1;
+	          pa->achan[chan].num_subchan = 1;	// Will be set higher later.
+	          pa->achan[chan].num_freq = 1;
 	      }
 
-	      if (num_letters > 1 && save_audio_config_p->achan[chan].num_freq > 1) {
+	      if (num_letters > 1 && pa->achan[chan].num_freq > 1) {
 
 		  text_color_set(DW_COLOR_ERROR);
 		  dw_printf ("Channel %d: Multiple demodulator types can't be combined with multiple frequencies.\n", chan);
 
-	          save_audio_config_p->achan[chan].profiles[1] = '\0';
+	          pa->achan[chan].profiles[1] = '\0';
 		  num_letters = 1;
 	      }
 
-	      if (save_audio_config_p->achan[chan].decimate == 0) {
-	        save_audio_config_p->achan[chan].decimate = 1;
-		if (strchr (just_letters, 'B') != NULL && save_audio_config_p->adev[ACHAN2ADEV(chan)].samples_per_sec > 40000) {
-		  save_audio_config_p->achan[chan].decimate = 3;
+	      if (pa->achan[chan].decimate == 0) {
+	        pa->achan[chan].decimate = 1;
+		if (strchr (just_letters, 'B') != NULL && pa->adev[pa->chan_adev[chan]].samples_per_sec > 40000) {
+		  pa->achan[chan].decimate = 3;
 		}
 	      }
 
 	      text_color_set(DW_COLOR_DEBUG);
 	      dw_printf ("Channel %d: %d baud, AFSK %d & %d Hz, %s, %d sample rate",
-		    chan, save_audio_config_p->achan[chan].baud, 
-		    save_audio_config_p->achan[chan].mark_freq, save_audio_config_p->achan[chan].space_freq,
-		    save_audio_config_p->achan[chan].profiles,
-		    save_audio_config_p->adev[ACHAN2ADEV(chan)].samples_per_sec);
-	      if (save_audio_config_p->achan[chan].decimate != 1) 
-	        dw_printf (" / %d", save_audio_config_p->achan[chan].decimate);
-	      dw_printf (", Tx %s", layer2_tx[(int)(save_audio_config_p->achan[chan].layer2_xmit)]);
-	      if (save_audio_config_p->achan[chan].dtmf_decode != DTMF_DECODE_OFF) 
+		    chan, pa->achan[chan].baud, 
+		    pa->achan[chan].mark_freq, pa->achan[chan].space_freq,
+		    pa->achan[chan].profiles,
+		    pa->adev[pa->chan_adev[chan]].samples_per_sec);
+	      if (pa->achan[chan].decimate != 1) 
+	        dw_printf (" / %d", pa->achan[chan].decimate);
+	      dw_printf (", Tx %s", layer2_tx[(int)(pa->achan[chan].layer2_xmit)]);
+	      if (pa->achan[chan].dtmf_decode != DTMF_DECODE_OFF) 
 	        dw_printf (", DTMF decoder enabled");
 	      dw_printf (".\n");
 
@@ -334,38 +395,38 @@ int demod_init (struct audio_s *pa)
  * In version 1.3 this can be combined with the + option.
  */
 
-	        save_audio_config_p->achan[chan].num_subchan = num_letters;
+	        pa->achan[chan].num_subchan = num_letters;
 		
-		if (save_audio_config_p->achan[chan].num_subchan != num_letters) {
+		if (pa->achan[chan].num_subchan != num_letters) {
 		  text_color_set(DW_COLOR_ERROR);
 		  dw_printf ("INTERNAL ERROR, %s:%d, chan=%d, num_subchan(%d) != strlen(\"%s\")\n",
-				__FILE__, __LINE__, chan, save_audio_config_p->achan[chan].num_subchan, save_audio_config_p->achan[chan].profiles);
+				__FILE__, __LINE__, chan, pa->achan[chan].num_subchan, pa->achan[chan].profiles);
 		}
 
-	        if (save_audio_config_p->achan[chan].num_freq != 1) {
+	        if (pa->achan[chan].num_freq != 1) {
 		  text_color_set(DW_COLOR_ERROR);
 		  dw_printf ("INTERNAL ERROR, %s:%d, chan=%d, num_freq(%d) != 1\n",
-				__FILE__, __LINE__, chan, save_audio_config_p->achan[chan].num_freq);
+				__FILE__, __LINE__, chan, pa->achan[chan].num_freq);
 		}
 
-	        for (d = 0; d < save_audio_config_p->achan[chan].num_subchan; d++) {
+	        for (d = 0; d < pa->achan[chan].num_subchan; d++) {
 	          int mark, space;
 	          assert (d >= 0 && d < MAX_SUBCHANS);
 
 	          struct demodulator_state_s *D;
-	          D = &demodulator_state[chan][d];
+	          D = &R->demod->state[d];
 
-	          profile = save_audio_config_p->achan[chan].profiles[d];
-	          mark = save_audio_config_p->achan[chan].mark_freq;
-	          space = save_audio_config_p->achan[chan].space_freq;
+	          profile = pa->achan[chan].profiles[d];
+	          mark = pa->achan[chan].mark_freq;
+	          space = pa->achan[chan].space_freq;
 
-	          if (save_audio_config_p->achan[chan].num_subchan != 1) {
+	          if (pa->achan[chan].num_subchan != 1) {
 	            text_color_set(DW_COLOR_DEBUG);
 	            dw_printf ("        %d.%d: %c %d & %d\n", chan, d, profile, mark, space);
 	          }
 
-	          demod_afsk_init (save_audio_config_p->adev[ACHAN2ADEV(chan)].samples_per_sec / save_audio_config_p->achan[chan].decimate, 
-			    save_audio_config_p->achan[chan].baud,
+	          demod_afsk_init (pa->adev[pa->chan_adev[chan]].samples_per_sec / pa->achan[chan].decimate, 
+			    pa->achan[chan].baud,
 		            mark, 
 	                    space,
 			    profile,
@@ -375,7 +436,7 @@ int demod_init (struct audio_s *pa)
 		    /* I'm not happy about putting this hack here. */
 		    /* should pass in as a parameter rather than adding on later. */
 
-	            save_audio_config_p->achan[chan].num_slicers = MAX_SLICERS;
+	            pa->achan[chan].num_slicers = MAX_SLICERS;
 		    D->num_slicers = MAX_SLICERS;
 	          }
 
@@ -400,38 +461,38 @@ int demod_init (struct audio_s *pa)
 				__FILE__, __LINE__, chan, just_letters);
 		}
 
-	        if (save_audio_config_p->achan[chan].num_freq != 1) {
+	        if (pa->achan[chan].num_freq != 1) {
 		  text_color_set(DW_COLOR_ERROR);
 		  dw_printf ("INTERNAL ERROR, %s:%d, chan=%d, num_freq(%d) != 1\n",
-				__FILE__, __LINE__, chan, save_audio_config_p->achan[chan].num_freq);
+				__FILE__, __LINE__, chan, pa->achan[chan].num_freq);
 		}
 
-	        if (save_audio_config_p->achan[chan].num_freq != save_audio_config_p->achan[chan].num_subchan) {
+	        if (pa->achan[chan].num_freq != pa->achan[chan].num_subchan) {
 		  text_color_set(DW_COLOR_ERROR);
 		  dw_printf ("INTERNAL ERROR, %s:%d, chan=%d, num_freq(%d) != num_subchan(%d)\n",
-				__FILE__, __LINE__, chan, save_audio_config_p->achan[chan].num_freq, save_audio_config_p->achan[chan].num_subchan);
+				__FILE__, __LINE__, chan, pa->achan[chan].num_freq, pa->achan[chan].num_subchan);
 		}
 
 	        struct demodulator_state_s *D;
-	        D = &demodulator_state[chan][0];
+	        D = &R->demod->state[0];
 
 		/* I'm not happy about putting this hack here. */
 		/* This belongs in demod_afsk_init but it doesn't have access to the audio config. */
 
-	        save_audio_config_p->achan[chan].num_slicers = MAX_SLICERS;
+	        pa->achan[chan].num_slicers = MAX_SLICERS;
      
-	        demod_afsk_init (save_audio_config_p->adev[ACHAN2ADEV(chan)].samples_per_sec / save_audio_config_p->achan[chan].decimate, 
-			save_audio_config_p->achan[chan].baud,
-			save_audio_config_p->achan[chan].mark_freq, 
-	                save_audio_config_p->achan[chan].space_freq,
-			save_audio_config_p->achan[chan].profiles[0],
+	        demod_afsk_init (pa->adev[pa->chan_adev[chan]].samples_per_sec / pa->achan[chan].decimate, 
+			pa->achan[chan].baud,
+			pa->achan[chan].mark_freq, 
+	                pa->achan[chan].space_freq,
+			pa->achan[chan].profiles[0],
 			D);
 
 	        if (have_plus) {
 		  /* I'm not happy about putting this hack here. */
 		  /* should pass in as a parameter rather than adding on later. */
 
-	          save_audio_config_p->achan[chan].num_slicers = MAX_SLICERS;
+	          pa->achan[chan].num_slicers = MAX_SLICERS;
 		  D->num_slicers = MAX_SLICERS;
 	        }
 
@@ -450,32 +511,32 @@ int demod_init (struct audio_s *pa)
 	        if (num_letters != 1) {
 		  text_color_set(DW_COLOR_ERROR);
 		  dw_printf ("INTERNAL ERROR, %s:%d, chan=%d, strlen(\"%s\") != 1\n",
-				__FILE__, __LINE__, chan, save_audio_config_p->achan[chan].profiles);
+				__FILE__, __LINE__, chan, pa->achan[chan].profiles);
 		}
 
-	        save_audio_config_p->achan[chan].num_subchan = save_audio_config_p->achan[chan].num_freq;
+	        pa->achan[chan].num_subchan = pa->achan[chan].num_freq;
 
-	        for (d = 0; d < save_audio_config_p->achan[chan].num_freq; d++) {
+	        for (d = 0; d < pa->achan[chan].num_freq; d++) {
 
 	          int mark, space, k;
 	          assert (d >= 0 && d < MAX_SUBCHANS);
 
 	          struct demodulator_state_s *D;
-	          D = &demodulator_state[chan][d];
+	          D = &R->demod->state[d];
 
-	          profile = save_audio_config_p->achan[chan].profiles[0];
+	          profile = pa->achan[chan].profiles[0];
 
-	          k = d * save_audio_config_p->achan[chan].offset - ((save_audio_config_p->achan[chan].num_freq - 1) * save_audio_config_p->achan[chan].offset) / 2;
-	          mark = save_audio_config_p->achan[chan].mark_freq + k;
-	          space = save_audio_config_p->achan[chan].space_freq + k;
+	          k = d * pa->achan[chan].offset - ((pa->achan[chan].num_freq - 1) * pa->achan[chan].offset) / 2;
+	          mark = pa->achan[chan].mark_freq + k;
+	          space = pa->achan[chan].space_freq + k;
 
-	          if (save_audio_config_p->achan[chan].num_freq != 1) {
+	          if (pa->achan[chan].num_freq != 1) {
 	            text_color_set(DW_COLOR_DEBUG);
 	            dw_printf ("        %d.%d: %c %d & %d\n", chan, d, profile, mark, space);
 	          }
       
-	          demod_afsk_init (save_audio_config_p->adev[ACHAN2ADEV(chan)].samples_per_sec / save_audio_config_p->achan[chan].decimate, 
-			save_audio_config_p->achan[chan].baud,
+	          demod_afsk_init (pa->adev[pa->chan_adev[chan]].samples_per_sec / pa->achan[chan].decimate, 
+			pa->achan[chan].baud,
 			mark, space,
 			profile,
 			D);
@@ -484,7 +545,7 @@ int demod_init (struct audio_s *pa)
 		    /* I'm not happy about putting this hack here. */
 		    /* should pass in as a parameter rather than adding on later. */
 
-	            save_audio_config_p->achan[chan].num_slicers = MAX_SLICERS;
+	            pa->achan[chan].num_slicers = MAX_SLICERS;
 		    D->num_slicers = MAX_SLICERS;
 	          }
 
@@ -509,7 +570,7 @@ int demod_init (struct audio_s *pa)
 	      // a default.  My current thinking is that we default to direwolf <= 1.5
 	      // compatible for version 1.6 and MFJ compatible after that.
 
-	      if (save_audio_config_p->achan[chan].v26_alternative == V26_UNSPECIFIED) {
+	      if (pa->achan[chan].v26_alternative == V26_UNSPECIFIED) {
 
 	        text_color_set(DW_COLOR_ERROR);
 	        dw_printf ("Two incompatible versions of 2400 bps QPSK are now available.\n");
@@ -520,55 +581,55 @@ int demod_init (struct audio_s *pa)
 	        dw_printf ("2400-4800-PSK-for-APRS-Packet-Radio.pdf.\n");
 	        dw_printf ("The default is now MFJ-2400 compatibility mode.\n");
 
-	        save_audio_config_p->achan[chan].v26_alternative = V26_DEFAULT;
+	        pa->achan[chan].v26_alternative = V26_DEFAULT;
 	      }
 
 
 // TODO: See how much CPU this takes on ARM and decide if we should have different defaults.
 
-	      if (strlen(save_audio_config_p->achan[chan].profiles) == 0) {
+	      if (strlen(pa->achan[chan].profiles) == 0) {
 //#if __arm__
-//	        strlcpy (save_audio_config_p->achan[chan].profiles, "R", sizeof(save_audio_config_p->achan[chan].profiles));
+//	        strlcpy (pa->achan[chan].profiles, "R", sizeof(pa->achan[chan].profiles));
 //#else
-	        strlcpy (save_audio_config_p->achan[chan].profiles, "PQRS", sizeof(save_audio_config_p->achan[chan].profiles));
+	        strlcpy (pa->achan[chan].profiles, "PQRS", sizeof(pa->achan[chan].profiles));
 //#endif
 	      }
-	      save_audio_config_p->achan[chan].num_subchan = strlen(save_audio_config_p->achan[chan].profiles);
+	      pa->achan[chan].num_subchan = strlen(pa->achan[chan].profiles);
 
-	      save_audio_config_p->achan[chan].decimate = 1;	// think about this later.
+	      pa->achan[chan].decimate = 1;	// think about this later.
 	      text_color_set(DW_COLOR_DEBUG);
 	      dw_printf ("Channel %d: %d bps, QPSK, %s, %d sample rate",
-		    chan, save_audio_config_p->achan[chan].baud,
-		    save_audio_config_p->achan[chan].profiles,
-		    save_audio_config_p->adev[ACHAN2ADEV(chan)].samples_per_sec);
-	      if (save_audio_config_p->achan[chan].decimate != 1)
-	        dw_printf (" / %d", save_audio_config_p->achan[chan].decimate);
-	      dw_printf (", Tx %s", layer2_tx[(int)(save_audio_config_p->achan[chan].layer2_xmit)]);
-	      if (save_audio_config_p->achan[chan].v26_alternative == V26_B)
+		    chan, pa->achan[chan].baud,
+		    pa->achan[chan].profiles,
+		    pa->adev[pa->chan_adev[chan]].samples_per_sec);
+	      if (pa->achan[chan].decimate != 1)
+	        dw_printf (" / %d", pa->achan[chan].decimate);
+	      dw_printf (", Tx %s", layer2_tx[(int)(pa->achan[chan].layer2_xmit)]);
+	      if (pa->achan[chan].v26_alternative == V26_B)
 	        dw_printf (", compatible with MFJ-2400");
 	      else
 	        dw_printf (", compatible with earlier direwolf");
 
-	      if (save_audio_config_p->achan[chan].dtmf_decode != DTMF_DECODE_OFF)
+	      if (pa->achan[chan].dtmf_decode != DTMF_DECODE_OFF)
 	        dw_printf (", DTMF decoder enabled");
 	      dw_printf (".\n");
 
 	      int d;
-	      for (d = 0; d < save_audio_config_p->achan[chan].num_subchan; d++) {
+	      for (d = 0; d < pa->achan[chan].num_subchan; d++) {
 
 	        assert (d >= 0 && d < MAX_SUBCHANS);
 	        struct demodulator_state_s *D;
-	        D = &demodulator_state[chan][d];
-	        profile = save_audio_config_p->achan[chan].profiles[d];
+	        D = &R->demod->state[d];
+	        profile = pa->achan[chan].profiles[d];
 
 	        //text_color_set(DW_COLOR_DEBUG);
 	        //dw_printf ("About to call demod_psk_init for Q-PSK case, modem_type=%d, profile='%c'\n",
-		//	save_audio_config_p->achan[chan].modem_type, profile);
+		//	pa->achan[chan].modem_type, profile);
 
-	        demod_psk_init (save_audio_config_p->achan[chan].modem_type,
-			save_audio_config_p->achan[chan].v26_alternative,
-			save_audio_config_p->adev[ACHAN2ADEV(chan)].samples_per_sec / save_audio_config_p->achan[chan].decimate, 
-			save_audio_config_p->achan[chan].baud,
+	        demod_psk_init (pa->achan[chan].modem_type,
+			pa->achan[chan].v26_alternative,
+			pa->adev[pa->chan_adev[chan]].samples_per_sec / pa->achan[chan].decimate, 
+			pa->achan[chan].baud,
 			profile,
 			D);
 
@@ -587,44 +648,44 @@ int demod_init (struct audio_s *pa)
 
 // TODO: See how much CPU this takes on ARM and decide if we should have different defaults.
 
-	      if (strlen(save_audio_config_p->achan[chan].profiles) == 0) {
+	      if (strlen(pa->achan[chan].profiles) == 0) {
 //#if __arm__
-//	        strlcpy (save_audio_config_p->achan[chan].profiles, "V", sizeof(save_audio_config_p->achan[chan].profiles));
+//	        strlcpy (pa->achan[chan].profiles, "V", sizeof(pa->achan[chan].profiles));
 //#else
-	        strlcpy (save_audio_config_p->achan[chan].profiles, "TUVW", sizeof(save_audio_config_p->achan[chan].profiles));
+	        strlcpy (pa->achan[chan].profiles, "TUVW", sizeof(pa->achan[chan].profiles));
 //#endif
 	      }
-	      save_audio_config_p->achan[chan].num_subchan = strlen(save_audio_config_p->achan[chan].profiles);
+	      pa->achan[chan].num_subchan = strlen(pa->achan[chan].profiles);
 
-	      save_audio_config_p->achan[chan].decimate = 1;	// think about this later
+	      pa->achan[chan].decimate = 1;	// think about this later
 	      text_color_set(DW_COLOR_DEBUG);
 	      dw_printf ("Channel %d: %d bps, 8PSK, %s, %d sample rate",
-		    chan, save_audio_config_p->achan[chan].baud,
-		    save_audio_config_p->achan[chan].profiles,
-		    save_audio_config_p->adev[ACHAN2ADEV(chan)].samples_per_sec);
-	      if (save_audio_config_p->achan[chan].decimate != 1)
-	        dw_printf (" / %d", save_audio_config_p->achan[chan].decimate);
-	      dw_printf (", Tx %s", layer2_tx[(int)(save_audio_config_p->achan[chan].layer2_xmit)]);
-	      if (save_audio_config_p->achan[chan].dtmf_decode != DTMF_DECODE_OFF)
+		    chan, pa->achan[chan].baud,
+		    pa->achan[chan].profiles,
+		    pa->adev[pa->chan_adev[chan]].samples_per_sec);
+	      if (pa->achan[chan].decimate != 1)
+	        dw_printf (" / %d", pa->achan[chan].decimate);
+	      dw_printf (", Tx %s", layer2_tx[(int)(pa->achan[chan].layer2_xmit)]);
+	      if (pa->achan[chan].dtmf_decode != DTMF_DECODE_OFF)
 	        dw_printf (", DTMF decoder enabled");
 	      dw_printf (".\n");
 
 	      //int d;
-	      for (d = 0; d < save_audio_config_p->achan[chan].num_subchan; d++) {
+	      for (d = 0; d < pa->achan[chan].num_subchan; d++) {
 
 	        assert (d >= 0 && d < MAX_SUBCHANS);
 	        struct demodulator_state_s *D;
-	        D = &demodulator_state[chan][d];
-	        profile = save_audio_config_p->achan[chan].profiles[d];
+	        D = &R->demod->state[d];
+	        profile = pa->achan[chan].profiles[d];
 
 	        //text_color_set(DW_COLOR_DEBUG);
 	        //dw_printf ("About to call demod_psk_init for 8-PSK case, modem_type=%d, profile='%c'\n",
-		//	save_audio_config_p->achan[chan].modem_type, profile);
+		//	pa->achan[chan].modem_type, profile);
 
-	        demod_psk_init (save_audio_config_p->achan[chan].modem_type,
-			save_audio_config_p->achan[chan].v26_alternative,
-			save_audio_config_p->adev[ACHAN2ADEV(chan)].samples_per_sec / save_audio_config_p->achan[chan].decimate,
-			save_audio_config_p->achan[chan].baud,
+	        demod_psk_init (pa->achan[chan].modem_type,
+			pa->achan[chan].v26_alternative,
+			pa->adev[pa->chan_adev[chan]].samples_per_sec / pa->achan[chan].decimate,
+			pa->achan[chan].baud,
 			profile,
 			D);
 
@@ -650,20 +711,20 @@ int demod_init (struct audio_s *pa)
 	      // For AIS we will accept only a good CRC without any fixup attempts.
 	      // Even with that, there are still a lot of CRC false matches with random noise.
 
-	      if (save_audio_config_p->achan[chan].modem_type == MODEM_AIS) {
-		if (save_audio_config_p->achan[chan].fix_bits != RETRY_NONE) {
+	      if (pa->achan[chan].modem_type == MODEM_AIS) {
+		if (pa->achan[chan].fix_bits != RETRY_NONE) {
 	          text_color_set(DW_COLOR_INFO);
 		  dw_printf ("Channel %d: FIX_BITS option has been turned off for AIS.\n", chan);
-	          save_audio_config_p->achan[chan].fix_bits = RETRY_NONE;
+	          pa->achan[chan].fix_bits = RETRY_NONE;
 	        }
-		if (save_audio_config_p->achan[chan].passall != 0) {
+		if (pa->achan[chan].passall != 0) {
 	          text_color_set(DW_COLOR_INFO);
 		  dw_printf ("Channel %d: PASSALL option has been turned off for AIS.\n", chan);
-	          save_audio_config_p->achan[chan].passall = 0;
+	          pa->achan[chan].passall = 0;
 	        }
 	      }
 
-	      if (strcmp(save_audio_config_p->achan[chan].profiles, "") == 0) {
+	      if (strcmp(pa->achan[chan].profiles, "") == 0) {
 
 		/* Apply default if not set earlier. */
 		/* Not sure if it should be on for ARM too. */
@@ -673,7 +734,7 @@ int demod_init (struct audio_s *pa)
 		/* We want higher performance to be the default. */
 		/* "MODEM 9600 -" can be used on very slow CPU if necessary. */
 
-	        strlcpy (save_audio_config_p->achan[chan].profiles, "+", sizeof(save_audio_config_p->achan[chan].profiles));
+	        strlcpy (pa->achan[chan].profiles, "+", sizeof(pa->achan[chan].profiles));
 	      }
 
 /*
@@ -681,14 +742,14 @@ int demod_init (struct audio_s *pa)
  * Easier to check here because demod_9600_init might have an adjusted sample rate.
  */
 
-	      float ratio = (float)(save_audio_config_p->adev[ACHAN2ADEV(chan)].samples_per_sec)
-							/ (float)(save_audio_config_p->achan[chan].baud);
+	      float ratio = (float)(pa->adev[pa->chan_adev[chan]].samples_per_sec)
+							/ (float)(pa->achan[chan].baud);
 
 /*
  * Set reasonable upsample ratio if user did not override.
  */
 
-	      if (save_audio_config_p->achan[chan].upsample == 0) {
+	      if (pa->achan[chan].upsample == 0) {
 
 	        if (ratio < 4) {
 
@@ -697,74 +758,74 @@ int demod_init (struct audio_s *pa)
 		   // amazingly a recording with 22050 rate can be decoded.
 	           // 3 and 4 are the same.  Need more tests.
 
-	          save_audio_config_p->achan[chan].upsample = 4;
+	          pa->achan[chan].upsample = 4;
 	        }
 	        else if (ratio < 5) {
 
 	          // example: 44100 / 9600 is 4.59
 	          // 3 is slightly better than 2 or 4.
 
-	          save_audio_config_p->achan[chan].upsample = 3;
+	          pa->achan[chan].upsample = 3;
 	        }
 	        else if (ratio < 10) {
 
 	          // example: 48000 / 9600 = 5
 	          // 3 is slightly better than 2 or 4.
 
-	          save_audio_config_p->achan[chan].upsample = 3;
+	          pa->achan[chan].upsample = 3;
 	        }
 	        else if (ratio < 15) {
 
 	          // ... guessing
 
-	          save_audio_config_p->achan[chan].upsample = 2;
+	          pa->achan[chan].upsample = 2;
 	        }
 	        else {	// >= 15
 	          //
 	          // An example of this might be .....
 	          // Probably no benefit.
 
-	          save_audio_config_p->achan[chan].upsample = 1;
+	          pa->achan[chan].upsample = 1;
 	        }
 	      }
 
 #ifdef TUNE_UPSAMPLE
-	      save_audio_config_p->achan[chan].upsample = TUNE_UPSAMPLE;
+	      pa->achan[chan].upsample = TUNE_UPSAMPLE;
 #endif
 
 	      text_color_set(DW_COLOR_DEBUG);
 	      dw_printf ("Channel %d: %d baud, %s, %s, %d sample rate x %d",
 		    chan,
-	            save_audio_config_p->achan[chan].baud,
-	            save_audio_config_p->achan[chan].modem_type == MODEM_AIS ? "AIS" : "K9NG/G3RUH",
-		    save_audio_config_p->achan[chan].profiles,
-		    save_audio_config_p->adev[ACHAN2ADEV(chan)].samples_per_sec,
-	            save_audio_config_p->achan[chan].upsample);
-	      dw_printf (", Tx %s", layer2_tx[(int)(save_audio_config_p->achan[chan].layer2_xmit)]);
-	      if (save_audio_config_p->achan[chan].dtmf_decode != DTMF_DECODE_OFF) 
+	            pa->achan[chan].baud,
+	            pa->achan[chan].modem_type == MODEM_AIS ? "AIS" : "K9NG/G3RUH",
+		    pa->achan[chan].profiles,
+		    pa->adev[pa->chan_adev[chan]].samples_per_sec,
+	            pa->achan[chan].upsample);
+	      dw_printf (", Tx %s", layer2_tx[(int)(pa->achan[chan].layer2_xmit)]);
+	      if (pa->achan[chan].dtmf_decode != DTMF_DECODE_OFF) 
 	        dw_printf (", DTMF decoder enabled");
 	      dw_printf (".\n");
 	      
 	      struct demodulator_state_s *D;
-	      D = &demodulator_state[chan][0];	// first subchannel
+	      D = &R->demod->state[0];	// first subchannel
 
 
-	      save_audio_config_p->achan[chan].num_subchan = 1;
-              save_audio_config_p->achan[chan].num_slicers = 1;
+	      pa->achan[chan].num_subchan = 1;
+              pa->achan[chan].num_slicers = 1;
 
-	      if (strchr(save_audio_config_p->achan[chan].profiles, '+') != NULL) {
+	      if (strchr(pa->achan[chan].profiles, '+') != NULL) {
 
 		/* I'm not happy about putting this hack here. */
 		/* This belongs in demod_9600_init but it doesn't have access to the audio config. */
 
-	        save_audio_config_p->achan[chan].num_slicers = MAX_SLICERS;
+	        pa->achan[chan].num_slicers = MAX_SLICERS;
      	      }
 	        
 
 	      text_color_set(DW_COLOR_INFO);
 	      dw_printf ("The ratio of audio samples per sec (%d) to data rate in baud (%d) is %.1f\n",
-				save_audio_config_p->adev[ACHAN2ADEV(chan)].samples_per_sec,
-				save_audio_config_p->achan[chan].baud,
+				pa->adev[pa->chan_adev[chan]].samples_per_sec,
+				pa->achan[chan].baud,
 				(double)ratio);
 	      if (ratio < 3) {
 	        text_color_set(DW_COLOR_ERROR);
@@ -772,7 +833,7 @@ int demod_init (struct audio_s *pa)
 	      }
 	      else if (ratio < 5) {
 	        dw_printf ("This is on the low side for best performance.  Can you use a higher sample rate?\n");
-	        if (save_audio_config_p->adev[ACHAN2ADEV(chan)].samples_per_sec == 44100) {
+	        if (pa->adev[pa->chan_adev[chan]].samples_per_sec == 44100) {
 	          dw_printf ("For example, can you use 48000 rather than 44100?\n");
 	        }
 	      }
@@ -786,17 +847,17 @@ int demod_init (struct audio_s *pa)
 	        dw_printf ("This is a suitable ratio for good performance.\n");
 	      }
 
-	      demod_9600_init (save_audio_config_p->achan[chan].modem_type,
-			save_audio_config_p->adev[ACHAN2ADEV(chan)].samples_per_sec,
-			save_audio_config_p->achan[chan].upsample,
-			save_audio_config_p->achan[chan].baud, D);
+	      demod_9600_init (pa->achan[chan].modem_type,
+			pa->adev[pa->chan_adev[chan]].samples_per_sec,
+			pa->achan[chan].upsample,
+			pa->achan[chan].baud, D);
 
-	      if (strchr(save_audio_config_p->achan[chan].profiles, '+') != NULL) {
+	      if (strchr(pa->achan[chan].profiles, '+') != NULL) {
 
 		/* I'm not happy about putting this hack here. */
 		/* should pass in as a parameter rather than adding on later. */
 
-	        save_audio_config_p->achan[chan].num_slicers = MAX_SLICERS;
+	        pa->achan[chan].num_slicers = MAX_SLICERS;
 		D->num_slicers = MAX_SLICERS;
 	      }
 
@@ -811,25 +872,9 @@ int demod_init (struct audio_s *pa)
     
 	 }  /* if channel medium is radio */
 
-// FIXME dw_printf ("-------- end of loop for chn %d \n", chan);
+	return (0);
 
-	}  /* for chan ... */
-
-	// Now the virtual channels.  FIXME:  could be single loop.
-
-	for (chan = MAX_RADIO_CHANS; chan < MAX_TOTAL_CHANS; chan++) {
-
-// FIXME dw_printf ("-------- virtual channel loop %d \n", chan);
-
-	  if (chan == save_audio_config_p->igate_vchannel) {
-	    text_color_set(DW_COLOR_DEBUG);
-	    dw_printf ("Channel %d: IGate virtual channel.\n", chan);
-	  }
-	}
-
-        return (0);
-
-} /* end demod_init */
+} /* end demod_chain_init */
 
 
 
@@ -841,13 +886,28 @@ int demod_init (struct audio_s *pa)
  *
  * Inputs:	a	- Index for audio device.  0 = first.
  *
- * Returns:     -32768 .. 32767 for a valid audio sample.
- *              256*256 for end of file or other error.
+ * Outputs:	fsam	- Audio sample scaled so that 16384 from a 16 bit
+ *			  sound card becomes 1.0.  Full scale is about +-2.0
+ *			  which leaves some headroom in the demodulators.
+ *
+ * Returns:     0 for success.
+ *              -1 for end of file or other error.
+ *
+ * Global In:	save_audio_config_p->adev[a].bits_per_sample and float_samples -
+ *			So we know how many bytes to read and what they mean.
+ *			demod_chain_get_sample uses the configuration the
+ *			chain was initialized from instead.
  *
- * Global In:	save_audio_config_p->adev[ACHAN2ADEV(chan)].bits_per_sample - So we know whether to 
- *			read 1 or 2 bytes from audio stream.
+ * Description:	Grab 1, 2, 3, or 4 bytes depending on data source.
  *
- * Description:	Grab 1 or two bytes depending on data source.
+ *			 8	unsigned.
+ *			16	signed, little endian.
+ *			24	signed, little endian, packed in 3 bytes.
+ *			32	signed, little endian, or float with full scale of +-1.0.
+ *
+ *		The demodulators all work with float so the conversion
+ *		is done once here.  The wider formats keep more dynamic range,
+ *		e.g. a weak signal next to a strong one from an SDR.
  *
  *		When processing stereo, the caller will call this
  *		at twice the normal rate to obtain alternating left 
@@ -855,43 +915,81 @@ int demod_init (struct audio_s *pa)
  *
  *----------------------------------------------------------------*/
 
-#define FSK_READ_ERR (256*256)
-
 __attribute__((hot))
-int demod_get_sample (int a)		
+static inline int get_sample (struct audio_s *pa, int a, float *fsam)
 {
-	int x1, x2;
-	signed short sam;	/* short to force sign extension. */
+	int n, x;
+	unsigned int u = 0;
+
 
+	switch (pa->adev[a].bits_per_sample) {
 
-	assert (save_audio_config_p->adev[a].bits_per_sample == 8 || save_audio_config_p->adev[a].bits_per_sample == 16);
+	  case 8:
 
-	if (save_audio_config_p->adev[a].bits_per_sample == 8) {
+	    x = audio_get(a);
+	    if (x < 0) return (-1);
 
-	  x1 = audio_get(a);				
-	  if (x1 < 0) return(FSK_READ_ERR);
+	    assert (x >= 0 && x <= 255);
 
-	  assert (x1 >= 0 && x1 <= 255);
+	    /* Scale 0..255 into -2.0 .. +2.0 */
 
-	  /* Scale 0..255 into -32k..+32k */
+	    *fsam = (x - 128) * (1.0f / 64.0f);
+	    break;
 
-	  sam = (x1 - 128) * 256;
+	  case 16:
 
-	}
-	else {
-	  x1 = audio_get(a);	/* lower byte first */
-	  if (x1 < 0) return(FSK_READ_ERR);
+	    for (n = 0; n < 2; n++) {		/* lower byte first */
+	      x = audio_get(a);
+	      if (x < 0) return (-1);
+	      u |= (unsigned int)x << (n * 8);
+	    }
+	    *fsam = (int16_t)u * (1.0f / 16384.0f);
+	    break;
+
+	  case 24:
 
-	  x2 = audio_get(a);
-	  if (x2 < 0) return(FSK_READ_ERR);
+	    for (n = 0; n < 3; n++) {
+	      x = audio_get(a);
+	      if (x < 0) return (-1);
+	      u |= (unsigned int)x << (n * 8 + 8);	/* Sign extend by putting it on top. */
+	    }
+	    *fsam = (int32_t)u * (1.0f / (16384.0f * 65536.0f));
+	    break;
+
+	  case 32:
 
-	  assert (x1 >= 0 && x1 <= 255);
-	  assert (x2 >= 0 && x2 <= 255);
+	    for (n = 0; n < 4; n++) {
+	      x = audio_get(a);
+	      if (x < 0) return (-1);
+	      u |= (unsigned int)x << (n * 8);
+	    }
+
+	    if (pa->adev[a].float_samples) {
+	      float f;
+	      memcpy (&f, &u, sizeof(f));
+	      *fsam = f * 2.0f;
+	    }
+	    else {
+	      *fsam = (int32_t)u * (1.0f / (16384.0f * 65536.0f));
+	    }
+	    break;
 
-          sam = ( x2 << 8 ) | x1;
+	  default:
+	    assert (0);
+	    return (-1);
 	}
 
-	return (sam);
+	return (0);
+}
+
+int demod_get_sample (int a, float *fsam)
+{
+	return (get_sample (save_audio_config_p, a, fsam));
+}
+
+int demod_chain_get_sample (struct rx_chain_s *R, int a, float *fsam)
+{
+	return (get_sample (R->audio_config, a, fsam));
 }
 
 
@@ -902,10 +1000,10 @@ int demod_get_sample (int a)
  * Purpose:     (1) Demodulate the AFSK signal.
  *		(2) Recover clock and data.
  *
- * Inputs:	chan	- Audio channel.  0 for left, 1 for right.
+ * Inputs:	R	- Receive chain for the radio channel.
  *		subchan - modem of the channel.
- *		sam	- One sample of audio.
- *			  Should be in range of -32768 .. 32767.
+ *		fsam	- One sample of audio from demod_get_sample.
+ *			  Actually -2.0 to +2.0 for extra headroom.
  *
  * Returns:	None 
  *
@@ -932,8 +1030,6 @@ int demod_get_sample (int a)
  *
  *--------------------------------------------------------------------*/
 
-static volatile int mute_input[MAX_RADIO_CHANS];
-
 // New in 1.7.
 // A few people have a really bad audio cross talk situation where they receive their own transmissions.
 // It usually doesn't cause a problem but it is confusing to look at.
@@ -941,35 +1037,34 @@ static volatile int mute_input[MAX_RADIO_CHANS];
 // Receiving was still active.
 // I think the simplest solution is to mute/unmute the audio input at this point if not full duplex.
 // This is called from ptt_set for half duplex.
+// Version 1.8: Kept in the receive chain used for the channel.
 
 void demod_mute_input (int chan, int mute_during_xmit)
 {
 	assert (chan >= 0 && chan < MAX_RADIO_CHANS);
-	mute_input[chan] = mute_during_xmit;
+	if (rx_chain[chan] != NULL) {
+	  rx_chain[chan]->mute_input = mute_during_xmit;
+	}
 }
 
 __attribute__((hot))
-void demod_process_sample (int chan, int subchan, int sam)
+void demod_process_sample (struct rx_chain_s *R, int subchan, float fsam)
 {
-	float fsam;
 	//int k;
 
 
+	struct demod_chan_s *M;
 	struct demodulator_state_s *D;
+	struct achan_param_s *achan = &R->audio_config->achan[R->chan];
 
-	assert (chan >= 0 && chan < MAX_RADIO_CHANS);
 	assert (subchan >= 0 && subchan < MAX_SUBCHANS);
 
-	if (mute_input[chan]) {
-	  sam = 0;
+	if (R->mute_input) {
+	  fsam = 0;
 	};
 
-	D = &demodulator_state[chan][subchan];
-
-
-	/* Scale to nice number, actually -2.0 to +2.0 for extra headroom */
-
-	fsam = sam / 16384.0f;
+	M = R->demod;
+	D = &M->state[subchan];
 
 /*
  * Accumulate measure of the input signal level.
@@ -1002,7 +1097,7 @@ void demod_process_sample (int chan, int subchan, int sam)
  * Select decoder based on modulation type.
  */
 
-	switch (save_audio_config_p->achan[chan].modem_type) {
+	switch (achan->modem_type) {
 
 	  case MODEM_OFF:
 
@@ -1013,25 +1108,25 @@ void demod_process_sample (int chan, int subchan, int sam)
 	  case MODEM_AFSK:
 	  case MODEM_EAS:
 
-	    if (save_audio_config_p->achan[chan].decimate > 1) {
+	    if (achan->decimate > 1) {
 
-	      sample_sum[chan][subchan] += sam;
-	      sample_count[chan][subchan]++;
-	      if (sample_count[chan][subchan] >= save_audio_config_p->achan[chan].decimate) {
-  	        demod_afsk_process_sample (chan, subchan, sample_sum[chan][subchan] / save_audio_config_p->achan[chan].decimate, D);
-	        sample_sum[chan][subchan] = 0;
-	        sample_count[chan][subchan] = 0;
+	      M->sample_sum[subchan] += fsam;
+	      M->sample_count[subchan]++;
+	      if (M->sample_count[subchan] >= achan->decimate) {
+  	        demod_afsk_process_sample (R, subchan, M->sample_sum[subchan] / achan->decimate, D);
+	        M->sample_sum[subchan] = 0;
+	        M->sample_count[subchan] = 0;
 	      }
 	    }
 	    else {
-	      demod_afsk_process_sample (chan, subchan, sam, D);
+	      demod_afsk_process_sample (R, subchan, fsam, D);
 	    }
 	    break;
 
 	  case MODEM_QPSK:
 	  case MODEM_8PSK:
 
-	    if (save_audio_config_p->achan[chan].decimate > 1) {
+	    if (achan->decimate > 1) {
 
 	      text_color_set(DW_COLOR_ERROR);
 	      dw_printf ("Invalid combination of options.  Exiting.\n");
@@ -1039,7 +1134,7 @@ void demod_process_sample (int chan, int subchan, int sam)
 	      exit (1);
 	    }
 	    else {
-	      demod_psk_process_sample (chan, subchan, sam, D);
+	      demod_psk_process_sample (R, subchan, fsam, D);
 	    }
 	    break;
 
@@ -1048,7 +1143,7 @@ void demod_process_sample (int chan, int subchan, int sam)
 	  case MODEM_AIS:
 	  default:
 	
-	    demod_9600_process_sample (chan, sam, save_audio_config_p->achan[chan].upsample, D);
+	    demod_9600_process_sample (R, fsam, achan->upsample, D);
 	    break;
 
 	}  /* switch modem_type */
@@ -1067,37 +1162,47 @@ void demod_process_sample (int chan, int subchan, int sam)
 /* We currently produce a message when this goes over 90. */
 
 alevel_t demod_get_audio_level (int chan, int subchan) 
+{
+	assert (chan >= 0 && chan < MAX_RADIO_CHANS);
+
+	return (demod_chain_audio_level (rx_chain_get(chan), subchan));
+}
+
+
+/* Same thing for the receive path which already has the chain. */
+
+alevel_t demod_chain_audio_level (struct rx_chain_s *R, int subchan) 
 {
 	struct demodulator_state_s *D;
 	alevel_t alevel;
+	enum modem_t modem_type = R->audio_config->achan[R->chan].modem_type;
 
-	assert (chan >= 0 && chan < MAX_RADIO_CHANS);
 	assert (subchan >= 0 && subchan < MAX_SUBCHANS);
 
 	/* We have to consider two different cases here. */
 	/* N demodulators, each with own slicer and HDLC decoder. */
 	/* Single demodulator, multiple slicers each with own HDLC decoder. */
 
-	if (demodulator_state[chan][0].num_slicers > 1) {
+	if (R->demod->state[0].num_slicers > 1) {
 	  subchan = 0;
 	}
 
-	D = &demodulator_state[chan][subchan];
+	D = &R->demod->state[subchan];
 
 	// Take half of peak-to-peak for received audio level.
 
 	alevel.rec = (int) (( D->alevel_rec_peak - D->alevel_rec_valley ) * 50.0f + 0.5f);
 
-	if (save_audio_config_p->achan[chan].modem_type == MODEM_AFSK ||
-	    save_audio_config_p->achan[chan].modem_type == MODEM_EAS) {
+	if (modem_type == MODEM_AFSK ||
+	    modem_type == MODEM_EAS) {
 
 	  /* For AFSK, we have mark and space amplitudes. */
 
 	  alevel.mark = (int) ((D->alevel_mark_peak ) * 100.0f + 0.5f);
 	  alevel.space = (int) ((D->alevel_space_peak ) * 100.0f + 0.5f);
 	}
-	else if (save_audio_config_p->achan[chan].modem_type == MODEM_QPSK ||
-	         save_audio_config_p->achan[chan].modem_type == MODEM_8PSK) {
+	else if (modem_type == MODEM_QPSK ||
+	         modem_type == MODEM_8PSK) {
 	  alevel.mark = -1;
 	  alevel.space = -1;
 	}
@@ -4,17 +4,24 @@
 
 #include "audio.h" 	/* for struct audio_s */
 #include "ax25_pad.h"	/* for alevel_t */
+#include "rx_chain.h"	/* for struct rx_chain_s */
 
 
 int demod_init (struct audio_s *pa);
 
+int demod_chain_init (struct rx_chain_s *R, struct audio_s *pa);
+
 void demod_mute_input (int chan, int mute);
 
-int demod_get_sample (int a);
+int demod_get_sample (int a, float *fsam);
+
+int demod_chain_get_sample (struct rx_chain_s *R, int a, float *fsam);
 
-void demod_process_sample (int chan, int subchan, int sam);
+void demod_process_sample (struct rx_chain_s *R, int subchan, float fsam);
 
 void demod_print_agc (int chan, int subchan);
 
 alevel_t demod_get_audio_level (int chan, int subchan);
 
+alevel_t demod_chain_audio_level (struct rx_chain_s *R, int subchan);
+
@@ -18,7 +18,6 @@
 //
 
 
-//#define DEBUG4 1	/* capture 9600 output to log files */
 
 
 /*------------------------------------------------------------------
@@ -65,9 +64,6 @@
 
 
 
-static float slice_point[MAX_SUBCHANS];
-
-
 /* Add sample to buffer and shift the rest down. */
 
 __attribute__((hot)) __attribute__((always_inline))
@@ -93,6 +89,24 @@ static inline float convolve (const float *__restrict__ data, const float *__res
 	return (sum);
 }
 
+/* All phases of the polyphase filter at once.  See demod_9600_init. */
+
+__attribute__((hot)) __attribute__((always_inline))
+static inline void convolve_polyphase (const float *__restrict__ data, const float (*__restrict__ filter)[4], int filter_size, float *__restrict__ out)
+{
+	float sum[4] = { 0.0f, 0.0f, 0.0f, 0.0f };
+	int j, p;
+
+	for (j=0; j<filter_size; j++) {
+	    for (p=0; p<4; p++) {
+	        sum[p] += filter[j][p] * data[j];
+	    }
+	}
+	for (p=0; p<4; p++) {
+	    out[p] = sum[p];
+	}
+}
+
 /* Automatic gain control. */
 /* Result should settle down to 1 unit peak to peak.  i.e. -0.5 to +0.5 */
 
@@ -294,17 +308,17 @@ void demod_9600_init (enum modem_t modem_type, int original_sample_rate, int ups
 // Maybe we should turn that off by default, especially for ARM.
 //
 
+// Later: The phases are interleaved, a d g ... for the first goes into
+// lp_polyphase[0..][0], b e h ... into lp_polyphase[0..][1], and so on.
+// For each tap, we multiply one audio sample by 4 coefficients, which
+// is a single SIMD operation, and get all the outputs in one pass.
+// When not upsampling, the original filter is used directly.
+
 	int k = 0;
+	memset (D->u.bb.lp_polyphase, 0, sizeof(D->u.bb.lp_polyphase));
 	for (int i = 0; i < D->lp_filter_size; i++) {
-	    D->u.bb.lp_polyphase_1[i] = D->u.bb.lp_filter[k++];
-	    if (upsample >= 2) {
-	        D->u.bb.lp_polyphase_2[i] = D->u.bb.lp_filter[k++];
-	        if (upsample >= 3) {
-	            D->u.bb.lp_polyphase_3[i] = D->u.bb.lp_filter[k++];
-	            if (upsample >= 4) {
-	                D->u.bb.lp_polyphase_4[i] = D->u.bb.lp_filter[k++];
-	            }
-	        }
+	    for (int p = 0; p < upsample; p++) {
+	        D->u.bb.lp_polyphase[i][p] = D->u.bb.lp_filter[k++];
 	    }
 	}
 
@@ -312,9 +326,9 @@ void demod_9600_init (enum modem_t modem_type, int original_sample_rate, int ups
 	/* Version 1.2: Experiment with different slicing levels. */
 	// Really didn't help that much because we should have a symmetrical signal.
 
-	for (j = 0; j < MAX_SUBCHANS; j++) {
-	  slice_point[j] = 0.02f * (j - 0.5f * (MAX_SUBCHANS-1));
-	  //dw_printf ("slice_point[%d] = %+5.2f\n", j, slice_point[j]);
+	for (j = 0; j < MAX_SLICERS; j++) {
+	  D->u.bb.slice_point[j] = 0.02f * (j - 0.5f * (MAX_SLICERS-1));
+	  //dw_printf ("slice_point[%d] = %+5.2f\n", j, D->u.bb.slice_point[j]);
 	}
 
 } /* end fsk_demod_init */
@@ -329,10 +343,10 @@ void demod_9600_init (enum modem_t modem_type, int original_sample_rate, int ups
  *		(2) Descramble it.
  *		(2) Recover clock and data.
  *
- * Inputs:	chan	- Audio channel.  0 for left, 1 for right.
+ * Inputs:	R	- Receive chain for the radio channel.
  *
- *		sam	- One sample of audio.
- *			  Should be in range of -32768 .. 32767.
+ *		fsam	- One sample of audio, scaled so that +-1.0 is
+ *			  +-16384 from a 16 bit sound card.  See demod_get_sample.
  *
  * Returns:	None 
  *
@@ -378,59 +392,45 @@ void demod_9600_init (enum modem_t modem_type, int original_sample_rate, int ups
  *
  *--------------------------------------------------------------------*/
 
-inline static void nudge_pll (int chan, int subchan, int slice, float demod_out, struct demodulator_state_s *D);
+inline static void nudge_pll (struct rx_chain_s *R, int subchan, int slice, float demod_out, struct demodulator_state_s *D);
 
-static void process_filtered_sample (int chan, float fsam, struct demodulator_state_s *D);
+static void process_filtered_block (struct rx_chain_s *R, float *fsam, int count, struct demodulator_state_s *D);
 
 
 __attribute__((hot))
-void demod_9600_process_sample (int chan, int sam, int upsample, struct demodulator_state_s *D)
+void demod_9600_process_sample (struct rx_chain_s *R, float fsam, int upsample, struct demodulator_state_s *D)
 {
-	float fsam;
-
-#if DEBUG4
-	static FILE *demod_log_fp = NULL;
-	static int log_file_seq = 0;		/* Part of log file name */
-#endif
+	float filtered[4];
 
-	int subchan = 0;
-
-	assert (chan >= 0 && chan < MAX_RADIO_CHANS);
-	assert (subchan >= 0 && subchan < MAX_SUBCHANS);
-
-	/* Scale to nice number for convenience. */
-	/* Consistent with the AFSK demodulator, we'd like to use */
-	/* only half of the dynamic range to have some headroom. */
-	/* i.e.  input range +-16k becomes +-1 here and is */
-	/* displayed in the heard line as audio level 100. */
-
-	fsam = (float)sam / 16384.0f;
 
 	// Low pass filter
 	push_sample (fsam, D->u.bb.audio_in, D->lp_filter_size);
 
-	fsam = convolve (D->u.bb.audio_in, D->u.bb.lp_polyphase_1, D->lp_filter_size);
-	process_filtered_sample (chan, fsam, D);
-	if (upsample >= 2) {
-	    fsam = convolve (D->u.bb.audio_in, D->u.bb.lp_polyphase_2, D->lp_filter_size);
-	    process_filtered_sample (chan, fsam, D);
-	    if (upsample >= 3) {
-	        fsam = convolve (D->u.bb.audio_in, D->u.bb.lp_polyphase_3, D->lp_filter_size);
-	        process_filtered_sample (chan, fsam, D);
-	        if (upsample >= 4) {
-	            fsam = convolve (D->u.bb.audio_in, D->u.bb.lp_polyphase_4, D->lp_filter_size);
-	            process_filtered_sample (chan, fsam, D);
-	        }
-	    }
+	if (upsample <= 1) {
+	  filtered[0] = convolve (D->u.bb.audio_in, D->u.bb.lp_filter, D->lp_filter_size);
 	}
+	else {
+	  convolve_polyphase (D->u.bb.audio_in, D->u.bb.lp_polyphase, D->lp_filter_size, filtered);
+	}
+
+	process_filtered_block (R, filtered, upsample, D);
 }
 
 
+/*
+ * Level, AGC, and slicing for the block of 1 to 4 samples produced
+ * from one audio sample.  Each slicer handles the whole block before
+ * moving on to the next.
+ */
+
 __attribute__((hot))
-static void process_filtered_sample (int chan, float fsam, struct demodulator_state_s *D)
+static void process_filtered_block (struct rx_chain_s *R, float *fsam, int count, struct demodulator_state_s *D)
 {
-
 	int subchan = 0;
+	float demod_out[4];
+	int k;
+
+	for (k = 0; k < count; k++) {
 
 /*
  * Version 1.2: Capture the post-filtering amplitude for display.
@@ -443,19 +443,19 @@ static void process_filtered_sample (int chan, float fsam, struct demodulator_st
 
 // TODO:  probably no need for this.  Just use  D->m_peak, D->m_valley
 
-	if (fsam >= D->alevel_mark_peak) {
-	  D->alevel_mark_peak = fsam * D->quick_attack + D->alevel_mark_peak * (1.0f - D->quick_attack);
-	}
-	else {
-	  D->alevel_mark_peak = fsam * D->sluggish_decay + D->alevel_mark_peak * (1.0f - D->sluggish_decay);
-	}
+	  if (fsam[k] >= D->alevel_mark_peak) {
+	    D->alevel_mark_peak = fsam[k] * D->quick_attack + D->alevel_mark_peak * (1.0f - D->quick_attack);
+	  }
+	  else {
+	    D->alevel_mark_peak = fsam[k] * D->sluggish_decay + D->alevel_mark_peak * (1.0f - D->sluggish_decay);
+	  }
 
-	if (fsam <= D->alevel_space_peak) {
-	  D->alevel_space_peak = fsam * D->quick_attack + D->alevel_space_peak * (1.0f - D->quick_attack);
-	}
-	else {
-	  D->alevel_space_peak = fsam * D->sluggish_decay + D->alevel_space_peak * (1.0f - D->sluggish_decay);
-	}
+	  if (fsam[k] <= D->alevel_space_peak) {
+	    D->alevel_space_peak = fsam[k] * D->quick_attack + D->alevel_space_peak * (1.0f - D->quick_attack);
+	  }
+	  else {
+	    D->alevel_space_peak = fsam[k] * D->sluggish_decay + D->alevel_space_peak * (1.0f - D->sluggish_decay);
+	  }
 
 /* 
  * The input level can vary greatly.
@@ -465,14 +465,8 @@ static void process_filtered_sample (int chan, float fsam, struct demodulator_st
  * This works by looking at the minimum and maximum signal peaks
  * and scaling the results to be roughly in the -1.0 to +1.0 range.
  */
-	float demod_out;
-	int demod_data;				/* Still scrambled. */
-
-	demod_out = agc (fsam, D->agc_fast_attack, D->agc_slow_decay, &(D->m_peak), &(D->m_valley));
-
-// TODO: There is potential for multiple decoders with one filter.
-
-//dw_printf ("peak=%.2f valley=%.2f fsam=%.2f norm=%.2f\n", D->m_peak, D->m_valley, fsam, norm);
+	  demod_out[k] = agc (fsam[k], D->agc_fast_attack, D->agc_slow_decay, &(D->m_peak), &(D->m_valley));
+	}
 
 	if (D->num_slicers <= 1) {
 
@@ -480,8 +474,9 @@ static void process_filtered_sample (int chan, float fsam, struct demodulator_st
 	  /* Demodulator output is difference between response from two filters. */
 	  /* AGC should generally keep this around -1 to +1 range. */
 
-	  demod_data = demod_out > 0;
-	  nudge_pll (chan, subchan, 0, demod_out, D);
+	  for (k = 0; k < count; k++) {
+	    nudge_pll (R, subchan, 0, demod_out[k], D);
+	  }
 	}
 	else {
 	  int slice;
@@ -489,57 +484,13 @@ static void process_filtered_sample (int chan, float fsam, struct demodulator_st
 	  /* Multiple slicers each feeding its own HDLC decoder. */
 
 	  for (slice=0; slice<D->num_slicers; slice++) {
-	    demod_data = demod_out - slice_point[slice] > 0;
-	    nudge_pll (chan, subchan, slice, demod_out - slice_point[slice], D);
-	  }
-	}
-
-	// demod_data is used only for debug out.
-	// suppress compiler warning about it not being used.
-	(void) demod_data;
-
-#if DEBUG4
-
-	if (chan == 0) {
-
-	  if (1) {
-	  //if (D->slicer[slice].data_detect) {
-	    char fname[30];
-	    int slice = 0;
-
-	    if (demod_log_fp == NULL) {
-	      log_file_seq++;
-	      snprintf (fname, sizeof(fname), "demod/%04d.csv", log_file_seq);
-	      //if (log_file_seq == 1) mkdir ("demod", 0777);
-	      if (log_file_seq == 1) mkdir ("demod");
-
-	      demod_log_fp = fopen (fname, "w");
-	      text_color_set(DW_COLOR_DEBUG);
-	      dw_printf ("Starting demodulator log file %s\n", fname);
-	      fprintf (demod_log_fp, "Audio, Filtered,  Max,  Min, Normalized, Sliced, Clock\n");
-	    }
-
-	    fprintf (demod_log_fp, "%.3f, %.3f, %.3f, %.3f, %.3f, %d, %.2f\n",
-			fsam + 6,
-			fsam + 4,
-			D->m_peak + 4,
-			D->m_valley + 4,
-			demod_out + 2,
-			demod_data + 2,
-			(D->slicer[slice].data_clock_pll & 0x80000000) ? .5 : .0);
-
-	    fflush (demod_log_fp);
-	  }
-	  else {
-	    if (demod_log_fp != NULL) {
-	      fclose (demod_log_fp);
-	      demod_log_fp = NULL;
+	    for (k = 0; k < count; k++) {
+	      nudge_pll (R, subchan, slice, demod_out[k] - D->u.bb.slice_point[slice], D);
 	    }
 	  }
 	}
-#endif
 
-} /* end demod_9600_process_sample */
+} /* end process_filtered_block */
 
 
 /*-------------------------------------------------------------------
@@ -551,7 +502,7 @@ static void process_filtered_sample (int chan, float fsam, struct demodulator_st
  *		(2) Descramble it.
  *		(2) Recover clock and data.
  *
- * Inputs:	chan	- Audio channel.  0 for left, 1 for right.
+ * Inputs:	R	- Receive chain for the radio channel.
  *
  *		subchan	- Which demodulator.  We could have several running in parallel.
  *
@@ -600,7 +551,7 @@ static void process_filtered_sample (int chan, float fsam, struct demodulator_st
  *--------------------------------------------------------------------*/
 
 __attribute__((hot))
-inline static void nudge_pll (int chan, int subchan, int slice, float demod_out_f, struct demodulator_state_s *D)
+inline static void nudge_pll (struct rx_chain_s *R, int subchan, int slice, float demod_out_f, struct demodulator_state_s *D)
 {
 	D->slicer[slice].prev_d_c_pll = D->slicer[slice].data_clock_pll;
 
@@ -611,11 +562,16 @@ inline static void nudge_pll (int chan, int subchan, int slice, float demod_out_
 
 	  /* Overflow.  Was large positive, wrapped around, now large negative. */
 
-	  hdlc_rec_bit_new (chan, subchan, slice, demod_out_f > 0, D->modem_type == MODEM_SCRAMBLE, D->slicer[slice].lfsr,
+	  // AGC output is about -0.5 to +0.5 so this gives 0 to 100 like the others.
+
+	  int quality = fabsf(demod_out_f) * 200.0f;
+	  if (quality > 100) quality = 100;
+
+	  hdlc_rec_bit_new (R, subchan, slice, demod_out_f > 0, D->modem_type == MODEM_SCRAMBLE, quality,
 			&(D->slicer[slice].pll_nudge_total), &(D->slicer[slice].pll_symbol_count));
 	  D->slicer[slice].pll_symbol_count++;
 
-	  pll_dcd_each_symbol2 (D, chan, subchan, slice);
+	  pll_dcd_each_symbol2 (D, R, subchan, slice);
 	}
 
 /*
@@ -643,7 +599,7 @@ inline static void nudge_pll (int chan, int subchan, int slice, float demod_out_
 
 #if DEBUG5
 
-	//if (chan == 0) {
+	//if (R->chan == 0) {
 	if (D->slicer[slice].data_detect) {
 	
 	  char fname[30];
@@ -78,7 +78,8 @@ static float fcos256_table[256];
 #define fcos256(x) (fcos256_table[((x)>>24)&0xff])
 #define fsin256(x) (fcos256_table[(((x)>>24)-64)&0xff])
 
-static void nudge_pll (int chan, int subchan, int slice, float demod_out, struct demodulator_state_s *D, float amplitude);
+static void nudge_pll (struct rx_chain_s *R, int subchan, int slice, float demod_out, struct demodulator_state_s *D, float amplitude);
+static void nudge_pll_multi (struct rx_chain_s *R, int subchan, const float *demod_out, struct demodulator_state_s *D, const float *amplitude);
 
 
 /* Quick approximation to sqrt(x*x + y*y) */
@@ -208,8 +209,6 @@ static inline float agc (float in, float fast_attack, float slow_decay, float *p
 #define MIN_G 0.5f
 #define MAX_G 4.0f
 
-/* TODO: static */  float space_gain[MAX_SUBCHANS];
-
 
 
 /*------------------------------------------------------------------
@@ -240,9 +239,16 @@ void demod_afsk_init (int samples_per_sec, int baud, int mark_freq,
 {
 	
 	int j;
+	static int fcos256_ready = 0;
+
+	// Only the first time.  Otherwise setting up one chain would
+	// write it while another thread is using it for a different chain.
 
-	for (j = 0; j < 256; j++) {
-	  fcos256_table[j] = cosf((float)j * 2.0f * (float)M_PI / 256.0f);
+	if ( ! fcos256_ready) {
+	  for (j = 0; j < 256; j++) {
+	    fcos256_table[j] = cosf((float)j * 2.0f * (float)M_PI / 256.0f);
+	  }
+	  fcos256_ready = 1;
 	}
 	
 	memset (D, 0, sizeof(struct demodulator_state_s));
@@ -510,10 +516,10 @@ void demod_afsk_init (int samples_per_sec, int baud, int mark_freq,
  * Starting with version 1.2
  * try using multiple slicing points instead of the traditional AGC.
  */
-	space_gain[0] = MIN_G;
-	float step = powf(10.0, log10f(MAX_G/MIN_G) / (MAX_SUBCHANS-1));
-	for (j=1; j<MAX_SUBCHANS; j++) {
-	  space_gain[j] = space_gain[j-1] * step;
+	D->u.afsk.space_gain[0] = MIN_G;
+	float step = powf(10.0, log10f(MAX_G/MIN_G) / (MAX_SLICERS-1));
+	for (j=1; j<MAX_SLICERS; j++) {
+	  D->u.afsk.space_gain[j] = D->u.afsk.space_gain[j-1] * step;
 	}
 
 }  /* demod_afsk_init */
@@ -527,10 +533,10 @@ void demod_afsk_init (int samples_per_sec, int baud, int mark_freq,
  * Purpose:     (1) Demodulate the AFSK signal.
  *		(2) Recover clock and data.
  *
- * Inputs:	chan	- Audio channel.  0 for left, 1 for right.
+ * Inputs:	R	- Receive chain for the radio channel.
  *		subchan - modem of the channel.
- *		sam	- One sample of audio.
- *			  Should be in range of -32768 .. 32767.
+ *		fsam	- One sample of audio, scaled so that +-1.0 is
+ *			  +-16384 from a 16 bit sound card.  See demod_get_sample.
  *
  * Returns:	None 
  *
@@ -602,14 +608,13 @@ void demod_afsk_init (int samples_per_sec, int baud, int mark_freq,
 
 
 __attribute__((hot))
-void demod_afsk_process_sample (int chan, int subchan, int sam, struct demodulator_state_s *D)
+void demod_afsk_process_sample (struct rx_chain_s *R, int subchan, float fsam, struct demodulator_state_s *D)
 {
 #if DEBUG4
 	static FILE *demod_log_fp = NULL;
 	static int seq = 0;			/* for log file name */
 #endif
 
-	assert (chan >= 0 && chan < MAX_RADIO_CHANS);
 	assert (subchan >= 0 && subchan < MAX_SUBCHANS);
 
 /* 
@@ -622,10 +627,6 @@ void demod_afsk_process_sample (int chan, int subchan, int sam, struct demodulat
  * Future project?  Can we do better than shifting each time?
  */
 
-	/* Scale to nice number. */
-
-	float fsam = (float)sam / 16384.0f;
-
 	switch (D->profile) {
 
 	  case 'E':
@@ -700,7 +701,7 @@ void demod_afsk_process_sample (int chan, int subchan, int sam, struct demodulat
 	      // Tested and it looks good.  Range of about -1 to +1.
 	      //printf ("JWL DEBUG demod A with agc = %6.2f\n", demod_out);
 
-	      nudge_pll (chan, subchan, 0, demod_out, D, 1.0);
+	      nudge_pll (R, subchan, 0, demod_out, D, 1.0);
 
 	    }
 	    else {
@@ -716,17 +717,20 @@ void demod_afsk_process_sample (int chan, int subchan, int sam, struct demodulat
 	      (void) agc (m_amp, D->agc_fast_attack, D->agc_slow_decay, &(D->m_peak), &(D->m_valley));
 	      (void) agc (s_amp, D->agc_fast_attack, D->agc_slow_decay, &(D->s_peak), &(D->s_valley));
 
+	      float demod_out[MAX_SLICERS] __attribute__((aligned(16)));
+	      float amp[MAX_SLICERS] __attribute__((aligned(16)));
+
 	      for (int slice=0; slice<D->num_slicers; slice++) {
-	        float demod_out = m_amp - s_amp * space_gain[slice];
-	        float amp = 0.5f * (D->m_peak - D->m_valley + (D->s_peak - D->s_valley) * space_gain[slice]);
-	        if (amp < 0.0000001f) amp = 1;	// avoid divide by zero with no signal.
+	        demod_out[slice] = m_amp - s_amp * D->u.afsk.space_gain[slice];
+	        amp[slice] = 0.5f * (D->m_peak - D->m_valley + (D->s_peak - D->s_valley) * D->u.afsk.space_gain[slice]);
+	        if (amp[slice] < 0.0000001f) amp[slice] = 1;	// avoid divide by zero with no signal.
 
 	        // Tested and it looks good.  Range of about -1 to +1 relative to amp.
 		// Biased one way or the other depending on the space gain.
-	        //printf ("JWL DEBUG demod A with slicer %d: %6.2f / %6.2f = %6.2f\n", slice, demod_out, amp, demod_out/amp);
-
-	        nudge_pll (chan, subchan, slice, demod_out, D, amp);
+	        //printf ("JWL DEBUG demod A with slicer %d: %6.2f / %6.2f = %6.2f\n", slice, demod_out[slice], amp[slice], demod_out[slice]/amp[slice]);
 	      }
+
+	      nudge_pll_multi (R, subchan, demod_out, D, amp);
 	    }
 	  }
 	  break;
@@ -768,7 +772,7 @@ void demod_afsk_process_sample (int chan, int subchan, int sam, struct demodulat
 	    // Tested and it looks good.  Range roughly -1 to +1.
 	    //printf ("JWL DEBUG demod B single = %6.2f\n", demod_out);
 
-	    nudge_pll (chan, subchan, 0, demod_out, D, 1.0);
+	    nudge_pll (R, subchan, 0, demod_out, D, 1.0);
 
 	  }
 	  else {
@@ -784,15 +788,17 @@ void demod_afsk_process_sample (int chan, int subchan, int sam, struct demodulat
 	    // Assuming a 300 Hz shift, this would put slicing thresholds up
 	    // to +-75 Hz from the center.
 
+	    float demod_out[MAX_SLICERS] __attribute__((aligned(16)));
+
 	    for (int slice=0; slice<D->num_slicers; slice++) {
 
 	      float offset = -0.5 + slice * (1. / (D->num_slicers - 1));
-	      float demod_out = norm_rate + offset;
-
-	      //printf ("JWL DEBUG demod B slice %d, offset = %6.3f, demod_out = %6.2f\n", slice, offset, demod_out);
+	      demod_out[slice] = norm_rate + offset;
 
-	      nudge_pll (chan, subchan, slice, demod_out, D, 1.0);
+	      //printf ("JWL DEBUG demod B slice %d, offset = %6.3f, demod_out = %6.2f\n", slice, offset, demod_out[slice]);
 	    }
+
+	    nudge_pll_multi (R, subchan, demod_out, D, NULL);
 	  }
 	  }
 	  break;
@@ -800,7 +806,7 @@ void demod_afsk_process_sample (int chan, int subchan, int sam, struct demodulat
 		
 #if DEBUG4
 
-	if (chan == 0) {
+	if (R->chan == 0) {
 	if (D->slicer[slice].data_detect) {
 	  char fname[30];
 
@@ -866,7 +872,7 @@ void demod_afsk_process_sample (int chan, int subchan, int sam, struct demodulat
  */
 
 __attribute__((hot))
-static void nudge_pll (int chan, int subchan, int slice, float demod_out, struct demodulator_state_s *D, float amplitude)
+static void nudge_pll (struct rx_chain_s *R, int subchan, int slice, float demod_out, struct demodulator_state_s *D, float amplitude)
 {
 	D->slicer[slice].prev_d_c_pll = D->slicer[slice].data_clock_pll;
 
@@ -891,7 +897,7 @@ static void nudge_pll (int chan, int subchan, int slice, float demod_out, struct
 
 	  static FILE *bsfp = NULL;
 	  static int bcount = 0;
-	  if (chan == 0 && subchan == 0 && slice == 0) {
+	  if (R->chan == 0 && subchan == 0 && slice == 0) {
 	    if (bsfp == NULL) {
 	       bsfp = fopen ("bitstream.txt", "w");
 	    }
@@ -906,14 +912,14 @@ static void nudge_pll (int chan, int subchan, int slice, float demod_out, struct
 
 
 #if 1
-	  hdlc_rec_bit (chan, subchan, slice, demod_out > 0, 0, quality);
+	  hdlc_rec_bit (R, subchan, slice, demod_out > 0, 0, quality);
 #else  // TODO: new feature to measure data speed error.
 // Maybe hdlc_rec_bit could provide indication when frame starts.
-	  hdlc_rec_bit_new (chan, subchan, slice, demod_out > 0, 0, quality,
+	  hdlc_rec_bit_new (R, subchan, slice, demod_out > 0, 0, quality,
 			&(D->slicer[slice].pll_nudge_total), &(D->slicer[slice].pll_symbol_count));
 	  D->slicer[slice].pll_symbol_count++;
 #endif
-	  pll_dcd_each_symbol2 (D, chan, subchan, slice);
+	  pll_dcd_each_symbol2 (D, R, subchan, slice);
 	}
 
 	// Transitions nudge the DPLL phase toward the incoming signal.
@@ -941,4 +947,78 @@ static void nudge_pll (int chan, int subchan, int slice, float demod_out, struct
 } /* end nudge_pll */
 
 
+
+/*
+ * Same as above for all of the slicers at once.
+ *
+ * With multiple slicers, nudge_pll was called once per slicer for every
+ * audio sample, but nearly all of those calls only advance the DPLL
+ * and find that nothing else happened.  A bit is sampled about once per
+ * symbol time and transitions are just as rare.
+ *
+ * Here the DPLL advance, overflow test, and transition test are done for
+ * all slicers in one simple loop, over parallel arrays, which the compiler
+ * can vectorize.  Only the slicers with something to do take the slow path
+ * which is the same as nudge_pll so the results are identical.
+ *
+ * amplitude can be NULL when it is 1.0 for all slicers.
+ */
+
+__attribute__((hot))
+static void nudge_pll_multi (struct rx_chain_s *R, int subchan, const float *demod_out, struct demodulator_state_s *D, const float *amplitude)
+{
+	signed int *pll = D->u.afsk.slicer_pll;
+	int *prev_data = D->u.afsk.slicer_prev_data;
+	const int num_slicers = D->num_slicers;
+	const unsigned int step = D->pll_step_per_sample;
+
+	int event[MAX_SLICERS] __attribute__((aligned(16)));	// 1 = sample data bit, 2 = transition.
+	int any = 0;
+
+	for (int slice = 0; slice < num_slicers; slice++) {
+	  signed int prev = pll[slice];
+	  // Perform the add as unsigned to avoid signed overflow error.
+	  signed int next = (signed)((unsigned)prev + step);
+	  int demod_data = demod_out[slice] > 0;
+
+	  pll[slice] = next;
+	  event[slice] = ((next < 0) & (prev > 0)) | ((demod_data != prev_data[slice]) << 1);
+	  prev_data[slice] = demod_data;
+	  any |= event[slice];
+	}
+
+	if ( ! any) return;
+
+	for (int slice = 0; slice < num_slicers; slice++) {
+
+	  if (event[slice] & 1) {
+
+	    /* Overflow - this is where we sample. */
+
+	    float amp = amplitude != NULL ? amplitude[slice] : 1.0f;
+	    int quality = fabsf(demod_out[slice]) * 100.0f / amp;
+	    if (quality > 100) quality = 100;
+
+	    hdlc_rec_bit (R, subchan, slice, demod_out[slice] > 0, 0, quality);
+	    pll_dcd_each_symbol2 (D, R, subchan, slice);
+	  }
+
+	  if (event[slice] & 2) {
+
+	    // Transitions nudge the DPLL phase toward the incoming signal.
+
+	    pll_dcd_signal_transition2 (D, slice, pll[slice]);
+
+	    if (D->slicer[slice].data_detect) {
+	      pll[slice] = (int)(pll[slice] * D->pll_locked_inertia);
+	    }
+	    else {
+	      pll[slice] = (int)(pll[slice] * D->pll_searching_inertia);
+	    }
+	  }
+	}
+
+} /* end nudge_pll_multi */
+
+
 /* end demod_afsk.c */
@@ -5,4 +5,6 @@
 void demod_afsk_init (int samples_per_sec, int baud, int mark_freq,
 			int space_freq, char profile, struct demodulator_state_s *D);
 
-void demod_afsk_process_sample (int chan, int subchan, int sam, struct demodulator_state_s *D);
+struct rx_chain_s;
+
+void demod_afsk_process_sample (struct rx_chain_s *R, int subchan, float fsam, struct demodulator_state_s *D);
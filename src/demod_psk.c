@@ -148,6 +148,43 @@ static inline float convolve (const float *__restrict__ data, const float *__res
 }
 
 
+/* Same for I and Q at once so the filter is only read once. */
+
+__attribute__((hot)) __attribute__((always_inline))
+static inline void convolve2 (const float *__restrict__ data1, const float *__restrict__ data2,
+		const float *__restrict__ filter, int filter_size, float *out1, float *out2)
+{
+	float sum1 = 0.0;
+	float sum2 = 0.0;
+	int j;
+
+	for (j=0; j<filter_size; j++) {
+	    sum1 += filter[j] * data1[j];
+	    sum2 += filter[j] * data2[j];
+	}
+
+	*out1 = sum1;
+	*out2 = sum2;
+}
+
+
+/*
+ * Which 1/8 of the circle is the angle of (x,y) in?
+ * Same as (int)(atan2f(y,x) * 4 / pi) with result in range of 0 thru 7.
+ */
+
+__attribute__((hot)) __attribute__((always_inline))
+static inline int octant (float x, float y)
+{
+	if (y >= 0) {
+	  if (x > 0) return (y < x ? 0 : 1);
+	  return (y > -x ? 2 : 3);
+	}
+	if (x < 0) return (y > x ? 4 : 5);
+	return (-y > x ? 6 : 7);
+}
+
+
 /* Might replace this with faster, lower precision, approximation someday if it does not harm results. */
 
 static inline float my_atan2f (float y, float x)
@@ -400,6 +437,36 @@ void demod_psk_init (enum modem_t modem_type, enum v26_e v26_alt, int samples_pe
 	}
 
 
+/*
+ * The phase shift between symbols is rotated by a fixed amount, depending on the variation,
+ * before deciding which symbol it is.  Each symbol owns two sectors of the circle,
+ * one on each side of its ideal angle.
+ */
+	float offset;
+
+	if (D->u.psk.psk_use_lo) {
+	  offset = (modem_type == MODEM_QPSK && v26_alt == V26_B) ? -M_PI/4 : 0;
+	}
+	else if (modem_type == MODEM_QPSK) {
+	  offset = (v26_alt == V26_B) ? M_PI/2 : 3*M_PI/4;
+	}
+	else {
+	  offset = 3*M_PI/2;
+	}
+	D->u.psk.rot_cos = cosf(offset);
+	D->u.psk.rot_sin = sinf(offset);
+
+	if (modem_type == MODEM_QPSK) {
+	  for (j = 0; j < 8; j++) {
+	    D->u.psk.sector_gray[j] = phase_to_gray_v26[((j + 1) / 2) & 3];
+	  }
+	}
+	else {
+	  for (j = 0; j < 16; j++) {
+	    D->u.psk.sector_gray[j] = phase_to_gray_v27[((j + 1) / 2) & 7];
+	  }
+	}
+
 	if (D->u.psk.psk_use_lo) {
 	  D->u.psk.lo_step = (int) round( 256. * 256. * 256. * 256. * carrier_freq / (double)samples_per_sec);
 
@@ -649,10 +716,10 @@ static inline int phase_shift_to_symbol (float phase_shift, int bits_per_symbol,
  *		(2) Recover clock and sample data at the right time.
  *		(3) Produce two bits per symbol based on phase change from previous.
  *
- * Inputs:	chan	- Audio channel.  0 for left, 1 for right.
+ * Inputs:	R	- Receive chain for the radio channel.
  *		subchan - modem of the channel.
- *		sam	- One sample of audio.
- *			  Should be in range of -32768 .. 32767.
+ *		fsam	- One sample of audio, scaled so that +-1.0 is
+ *			  +-16384 from a 16 bit sound card.  See demod_get_sample.
  *
  * Outputs:	For each recovered data bit, we call:
  *
@@ -696,20 +763,15 @@ static inline int phase_shift_to_symbol (float phase_shift, int bits_per_symbol,
 
 
 
-inline static void nudge_pll (int chan, int subchan, int slice, int demod_bits, struct demodulator_state_s *D, int *bit_quality);
+inline static void nudge_pll (struct rx_chain_s *R, int subchan, int slice, int demod_bits, struct demodulator_state_s *D, float x, float y);
 
 __attribute__((hot))
-void demod_psk_process_sample (int chan, int subchan, int sam, struct demodulator_state_s *D)
+void demod_psk_process_sample (struct rx_chain_s *R, int subchan, float fsam, struct demodulator_state_s *D)
 {
 	int slice = 0;		// Would it make sense to have more than one?
 
-	assert (chan >= 0 && chan < MAX_RADIO_CHANS);
 	assert (subchan >= 0 && subchan < MAX_SUBCHANS);
 
-	/* Scale to nice number for plotting during debug. */
-
-	float fsam = sam / 16384.0f;
-
 /*
  * Optional bandpass filter before the phase detector.
  */
@@ -719,42 +781,31 @@ void demod_psk_process_sample (int chan, int subchan, int sam, struct demodulato
 	  fsam = convolve (D->u.psk.audio_in, D->u.psk.pre_filter, D->u.psk.pre_filter_taps);
 	}
 
+	float x, y;		// Phase shift from previous symbol, as a vector.
+
 	if (D->u.psk.psk_use_lo) {
 /*
  * Mix with local oscillator to obtain phase.
  * The absolute phase doesn't matter.  
  * We are just concerned with the change since the previous symbol.
  */
+	  float I, Q;
 
-	  float sam_x_cos = fsam * D->u.psk.sin_table256[((D->u.psk.lo_phase >> 24) + 64) & 0xff];
-	  push_sample (sam_x_cos, D->u.psk.I_raw, D->u.psk.lp_filter_taps);
-	  float I = convolve (D->u.psk.I_raw, D->u.psk.lp_filter, D->u.psk.lp_filter_taps);
-
-	  float sam_x_sin = fsam * D->u.psk.sin_table256[(D->u.psk.lo_phase >> 24) & 0xff];
-	  push_sample (sam_x_sin, D->u.psk.Q_raw, D->u.psk.lp_filter_taps);
-	  float Q = convolve (D->u.psk.Q_raw, D->u.psk.lp_filter, D->u.psk.lp_filter_taps);
-
-	  float a = my_atan2f(I,Q);
+	  push_sample (fsam * D->u.psk.sin_table256[((D->u.psk.lo_phase >> 24) + 64) & 0xff], D->u.psk.I_raw, D->u.psk.lp_filter_taps);
+	  push_sample (fsam * D->u.psk.sin_table256[(D->u.psk.lo_phase >> 24) & 0xff], D->u.psk.Q_raw, D->u.psk.lp_filter_taps);
+	  convolve2 (D->u.psk.I_raw, D->u.psk.Q_raw, D->u.psk.lp_filter, D->u.psk.lp_filter_taps, &I, &Q);
 
 	  // This is just a delay line of one symbol time.
+	  // Rather than the difference of two angles, the phase shift is
+	  // the product of (Q,I) and the complex conjugate of (Q,I) one symbol earlier.
 
-	  push_sample (a, D->u.psk.delay_line, D->u.psk.delay_line_taps);
-	  float delta = a - D->u.psk.delay_line[D->u.psk.boffs];
+	  push_sample (I, D->u.psk.delay_line, D->u.psk.delay_line_taps);
+	  push_sample (Q, D->u.psk.delay_line_q, D->u.psk.delay_line_taps);
+	  float Ip = D->u.psk.delay_line[D->u.psk.boffs];
+	  float Qp = D->u.psk.delay_line_q[D->u.psk.boffs];
 
-	  int gray;
-	  int bit_quality[3];
-	  if (D->modem_type == MODEM_QPSK) {
-	    if (D->u.psk.v26_alt == V26_B) {
-	      gray = phase_shift_to_symbol (delta + (float)(-M_PI/4), 2, bit_quality);;	// MFJ compatible
-	    }
-	    else {
-	      gray = phase_shift_to_symbol (delta, 2, bit_quality);	// Classic
-	    }
-	  }
-	  else {
-	      gray = phase_shift_to_symbol (delta, 3, bit_quality);;	// 8-PSK
-	  }
-	  nudge_pll (chan, subchan, slice, gray, D, bit_quality);
+	  x = Q * Qp + I * Ip;
+	  y = I * Qp - Q * Ip;
 
 	  D->u.psk.lo_phase += D->u.psk.lo_step;
 	}
@@ -762,40 +813,44 @@ void demod_psk_process_sample (int chan, int subchan, int sam, struct demodulato
 /*
  * Correlate with previous symbol.  We are looking for the phase shift.
  */
+	  float I, Q;
+
 	  push_sample (fsam, D->u.psk.delay_line, D->u.psk.delay_line_taps);
 
-	  float sam_x_cos = fsam *  D->u.psk.delay_line[D->u.psk.coffs];
-	  push_sample (sam_x_cos, D->u.psk.I_raw, D->u.psk.lp_filter_taps);
-	  float I = convolve (D->u.psk.I_raw, D->u.psk.lp_filter, D->u.psk.lp_filter_taps);
+	  push_sample (fsam * D->u.psk.delay_line[D->u.psk.coffs], D->u.psk.I_raw, D->u.psk.lp_filter_taps);
+	  push_sample (fsam * D->u.psk.delay_line[D->u.psk.soffs], D->u.psk.Q_raw, D->u.psk.lp_filter_taps);
+	  convolve2 (D->u.psk.I_raw, D->u.psk.Q_raw, D->u.psk.lp_filter, D->u.psk.lp_filter_taps, &I, &Q);
 
-	  float sam_x_sin = fsam *  D->u.psk.delay_line[D->u.psk.soffs];
-	  push_sample (sam_x_sin, D->u.psk.Q_raw, D->u.psk.lp_filter_taps);
-	  float Q = convolve (D->u.psk.Q_raw, D->u.psk.lp_filter, D->u.psk.lp_filter_taps);
+	  x = Q;
+	  y = I;
+	}
 
-	  int gray;
-	  int bit_quality[3];
-	  float delta = my_atan2f(I,Q);
+/*
+ * Rotate for the variation in use, then find the nearest symbol without
+ * calculating the angle.  This is needed for every sample so the PLL can
+ * see transitions.  The angle, for the bit quality, is needed only when
+ * the PLL samples a symbol.
+ */
+	float xr = x * D->u.psk.rot_cos - y * D->u.psk.rot_sin;
+	float yr = x * D->u.psk.rot_sin + y * D->u.psk.rot_cos;
+	int sector = octant (xr, yr);
 
-	  if (D->modem_type == MODEM_QPSK) {
-	    if (D->u.psk.v26_alt == V26_B) {
-	      gray = phase_shift_to_symbol (delta + (float)(M_PI/2), 2, bit_quality);	// MFJ compatible
-	    }
-	    else {
-	      gray = phase_shift_to_symbol (delta + (float)(3*M_PI/4), 2, bit_quality);	// Classic
-	    }
-	  }
-	  else {
-	    gray = phase_shift_to_symbol (delta + (float)(3*M_PI/2), 3, bit_quality);
-	  }
-	  nudge_pll (chan, subchan, slice, gray, D, bit_quality);
+	if (D->modem_type != MODEM_QPSK) {
+
+	  // Rotating back by 22.5 degrees stays in the same octant for the upper half of it.
+
+	  const float c = 0.92387953f, s = 0.38268343f;
+	  sector = sector * 2 + (octant (xr * c + yr * s, yr * c - xr * s) == sector);
 	}
 
+	nudge_pll (R, subchan, slice, D->u.psk.sector_gray[sector], D, xr, yr);
+
 } /* end demod_psk_process_sample */
 
 
 
 __attribute__((hot))
-static void nudge_pll (int chan, int subchan, int slice, int demod_bits, struct demodulator_state_s *D, int *bit_quality)
+static void nudge_pll (struct rx_chain_s *R, int subchan, int slice, int demod_bits, struct demodulator_state_s *D, float x, float y)
 {
 
 /*
@@ -833,28 +888,31 @@ static void nudge_pll (int chan, int subchan, int slice, int demod_bits, struct
 
 	  /* Overflow of PLL counter. */
 	  /* This is where we sample the data. */
+	  /* Only now do we need the angle, to get the quality of each bit. */
+
+	  int bit_quality[3];
 
 	  if (D->modem_type == MODEM_QPSK) {
 
-	    int gray = demod_bits;
+	    int gray = phase_shift_to_symbol (my_atan2f(y,x), 2, bit_quality);
 
-	    hdlc_rec_bit_new (chan, subchan, slice, (gray >> 1) & 1, 0, bit_quality[1],
+	    hdlc_rec_bit_new (R, subchan, slice, (gray >> 1) & 1, 0, bit_quality[1],
 			&(D->slicer[slice].pll_nudge_total), &(D->slicer[slice].pll_symbol_count));
-	    hdlc_rec_bit_new (chan, subchan, slice, gray & 1, 0, bit_quality[0],
+	    hdlc_rec_bit_new (R, subchan, slice, gray & 1, 0, bit_quality[0],
 			&(D->slicer[slice].pll_nudge_total), &(D->slicer[slice].pll_symbol_count));
 	  }
 	  else {
-	    int gray = demod_bits;
+	    int gray = phase_shift_to_symbol (my_atan2f(y,x), 3, bit_quality);
 
-	    hdlc_rec_bit_new (chan, subchan, slice, (gray >> 2) & 1, 0, bit_quality[2],
+	    hdlc_rec_bit_new (R, subchan, slice, (gray >> 2) & 1, 0, bit_quality[2],
 			&(D->slicer[slice].pll_nudge_total), &(D->slicer[slice].pll_symbol_count));
-	    hdlc_rec_bit_new (chan, subchan, slice, (gray >> 1) & 1, 0, bit_quality[1],
+	    hdlc_rec_bit_new (R, subchan, slice, (gray >> 1) & 1, 0, bit_quality[1],
 			&(D->slicer[slice].pll_nudge_total), &(D->slicer[slice].pll_symbol_count));
-	    hdlc_rec_bit_new (chan, subchan, slice, gray & 1, 0, bit_quality[0],
+	    hdlc_rec_bit_new (R, subchan, slice, gray & 1, 0, bit_quality[0],
 			&(D->slicer[slice].pll_nudge_total), &(D->slicer[slice].pll_symbol_count));
 	  }
 	  D->slicer[slice].pll_symbol_count++;
-	  pll_dcd_each_symbol2 (D, chan, subchan, slice);
+	  pll_dcd_each_symbol2 (D, R, subchan, slice);
 	}
 
 /*
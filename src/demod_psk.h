@@ -4,4 +4,6 @@
 
 void demod_psk_init (enum modem_t modem_type, enum v26_e v26_alt, int samples_per_sec, int bps, char profile, struct demodulator_state_s *D);
 
-void demod_psk_process_sample (int chan, int subchan, int sam, struct demodulator_state_s *D);
+struct rx_chain_s;
+
+void demod_psk_process_sample (struct rx_chain_s *R, int subchan, float fsam, struct demodulator_state_s *D);
@@ -100,6 +100,9 @@
 #include "server.h"
 #include "kiss.h"
 #include "kissnet.h"
+#include "statsnet.h"
+#include "textasync.h"
+#include "pktlog.h"
 #include "kissserial.h"
 #include "kiss_frame.h"
 #include "waypoint.h"
@@ -139,6 +142,8 @@
 static BOOL cleanup_win (int);
 #else
 static void cleanup_linux (int);
+static void *cleanup_thread (void *arg);
+static int cleanup_pipe[2] = { -1, -1 };
 #endif
 
 static void usage (void);
@@ -204,6 +209,7 @@ int main (int argc, char *argv[])
 	struct cdigi_config_s cdigi_config;
 	struct igate_config_s igate_config;
 	int r_opt = 0, n_opt = 0, b_opt = 0, B_opt = 0, D_opt = 0, U_opt = 0;	/* Command line options. */
+	int b_float = 0;
 	char P_opt[16];
 	char l_opt_logdir[80];
 	char L_opt_logfile[80];
@@ -304,6 +310,7 @@ int main (int argc, char *argv[])
 	// https://www.dennisbabkin.com/blog/?t=how-to-tell-the-real-version-of-windows-your-app-is-running-on
 
 	text_color_init(t_opt);
+	text_async_init();
 	text_color_set(DW_COLOR_INFO);
 	//dw_printf ("Dire Wolf version %d.%d (%s) BETA TEST 1\n", MAJOR_VERSION, MINOR_VERSION, __DATE__);
 	//dw_printf ("Dire Wolf DEVELOPMENT version %d.%d %s (%s)\n", MAJOR_VERSION, MINOR_VERSION, "E", __DATE__);
@@ -338,7 +345,19 @@ int main (int argc, char *argv[])
 	SetConsoleCtrlHandler ((PHANDLER_ROUTINE)cleanup_win, TRUE);
 #else
 	setlinebuf (stdout);
-	signal (SIGINT, cleanup_linux);
+	{
+	  pthread_t cleanup_tid;
+
+	  if (pipe (cleanup_pipe) != 0 ||
+		pthread_create (&cleanup_tid, NULL, cleanup_thread, NULL) != 0) {
+	    text_color_set(DW_COLOR_ERROR);
+	    dw_printf ("Could not set up handler for control C.\n");
+	  }
+	  else {
+	    pthread_detach (cleanup_tid);
+	    signal (SIGINT, cleanup_linux);
+	  }
+	}
 #endif
 
 
@@ -601,13 +620,14 @@ int main (int argc, char *argv[])
    	    }
             break;
 
-          case 'b':				/* -b bits per sample.  8 or 16. */
+          case 'b':				/* -b bits per sample.  8, 16, 24, 32, or F32 for float. */
 	 
-	    b_opt = atoi(optarg);
-	    if (b_opt != 8 && b_opt != 16) 
+	    b_float = strcasecmp(optarg, "F32") == 0;
+	    b_opt = b_float ? 32 : atoi(optarg);
+	    if (b_opt != 8 && b_opt != 16 && b_opt != 24 && b_opt != 32) 
 	    {
 	      text_color_set(DW_COLOR_ERROR);
-              dw_printf("-b option, bits per sample, must be 8 or 16.\n");
+              dw_printf("-b option, bits per sample, must be 8, 16, 24, 32, or F32.\n");
 	      b_opt = 0;
    	    }
             break;
@@ -800,13 +820,12 @@ int main (int argc, char *argv[])
 
 	if (n_opt != 0) {
 	  audio_config.adev[0].num_channels = n_opt;
-	  if (n_opt == 2) {
-	    audio_config.chan_medium[1] = MEDIUM_RADIO;
-	  }
+	  config_assign_channels (&audio_config);
 	}
 
 	if (b_opt != 0) {
 	  audio_config.adev[0].bits_per_sample = b_opt;
+	  audio_config.adev[0].float_samples = b_float;
 	}
 
 	if (B_opt != 0) {
@@ -1040,8 +1059,9 @@ int main (int argc, char *argv[])
 	gen_tone_init (&audio_config, audio_amplitude, 0);
 	morse_init (&audio_config, audio_amplitude);
 
-	assert (audio_config.adev[0].bits_per_sample == 8 || audio_config.adev[0].bits_per_sample == 16);
-	assert (audio_config.adev[0].num_channels == 1 || audio_config.adev[0].num_channels == 2);
+	assert (audio_config.adev[0].bits_per_sample == 8 || audio_config.adev[0].bits_per_sample == 16 ||
+		audio_config.adev[0].bits_per_sample == 24 || audio_config.adev[0].bits_per_sample == 32);
+	assert (audio_config.adev[0].num_channels >= 1);
 	assert (audio_config.adev[0].samples_per_sec >= MIN_SAMPLES_PER_SEC && audio_config.adev[0].samples_per_sec <= MAX_SAMPLES_PER_SEC);
 
 /*
@@ -1136,6 +1156,7 @@ int main (int argc, char *argv[])
  */
 	server_init (&audio_config, &misc_config);
 	kissnet_init (&misc_config);
+	statsnet_init (&audio_config, &misc_config);
 
 #if (USE_AVAHI_CLIENT|USE_MACOS_DNSSD)
 	if (misc_config.kiss_port[0] > 0 && misc_config.dns_sd_enabled)
@@ -1163,6 +1184,7 @@ int main (int argc, char *argv[])
  */
 
 	log_init(misc_config.log_daily_names, misc_config.log_path);
+	pktlog_init(misc_config.pktlog_path);
 	mheard_init (d_m_opt);
 	beacon_init (&audio_config, &misc_config, &igate_config);
 
@@ -1220,6 +1242,8 @@ void app_process_rec_packet (int chan, int subchan, int slice, packet_t pp, alev
 	int h;
 	char display_retries[32];				// Extra stuff before slice indicators.
 								// Can indicate FX.25/IL2P or fix_bits.
+	double pos_lat = G_UNKNOWN;				// Position for binary packet log, if APRS.
+	double pos_lon = G_UNKNOWN;
 
 	assert (chan >= 0 && chan < MAX_TOTAL_CHANS);		// TOTAL for virtual channels
 	assert (subchan >= -3 && subchan < MAX_SUBCHANS);
@@ -1508,6 +1532,8 @@ void app_process_rec_packet (int chan, int subchan, int slice, packet_t pp, alev
 	  // Send to log file.
 
 	  log_write (chan, &A, pp, alevel, retries);
+	  pos_lat = A.g_lat;
+	  pos_lon = A.g_lon;
 
 	  // temp experiment.
 	  //log_rr_bits (&A, pp);
@@ -1563,16 +1589,20 @@ void app_process_rec_packet (int chan, int subchan, int slice, packet_t pp, alev
 // TODO:  Put a wrapper around this so we only call one function to send by all methods.
 // We see the same sequence in tt_user.c.
 
-	int flen;
-	unsigned char fbuf[AX25_MAX_PACKET_LEN];
+// The frame contents are used in place, rather than making a copy with ax25_pack,
+// because nothing here modifies them.
 
-	flen = ax25_pack(pp, fbuf);
+	int flen = ax25_get_frame_len (pp);
+	unsigned char *fbuf = ax25_get_frame_data_ptr (pp);
 
 	server_send_rec_packet (chan, pp, fbuf, flen);					// AGW net protocol
 	kissnet_send_rec_packet (chan, KISS_CMD_DATA_FRAME, fbuf, flen, NULL, -1);	// KISS TCP
 	kissserial_send_rec_packet (chan, KISS_CMD_DATA_FRAME, fbuf, flen, NULL, -1);	// KISS serial port
 	kisspt_send_rec_packet (chan, KISS_CMD_DATA_FRAME, fbuf, flen, NULL, -1);	// KISS pseudo terminal
 
+	statsnet_rec_frame (chan, fec_type, retries, pp);
+	pktlog_write (chan, pp, alevel, fec_type, retries, pos_lat, pos_lon);
+
 	if (A_opt_ais_to_obj && strlen(ais_obj_packet) != 0) {
 	  packet_t ao_pp = ax25_from_text (ais_obj_packet, 1);
 	  if (ao_pp != NULL) {
@@ -1656,7 +1686,7 @@ void app_process_rec_packet (int chan, int subchan, int slice, packet_t pp, alev
  * Use only those with correct CRC (or using FEC.)
  */
 
-	  if (chan < MAX_RADIO_CHANS) {
+	  if (audio_config.chan_medium[chan] == MEDIUM_RADIO) {
 	    if (retries == RETRY_NONE || fec_type == fec_type_fx25 || fec_type == fec_type_il2p) {
 	      cdigipeater (chan, pp);
 	    }
@@ -1677,6 +1707,7 @@ static BOOL cleanup_win (int ctrltype)
 	  text_color_set(DW_COLOR_INFO);
 	  dw_printf ("\nQRT\n");
 	  log_term ();
+	  pktlog_term ();
 	  ptt_term ();
 	  waypoint_term ();
 	  dwgps_term ();
@@ -1689,15 +1720,39 @@ static BOOL cleanup_win (int ctrltype)
 
 #else
 
+/*
+ * The signal could arrive while the interrupted thread holds a lock,
+ * such as the one for console output, so the handler only passes it
+ * along to cleanup_thread which does the real work.
+ */
+
 static void cleanup_linux (int x)
 {
+	char c = 'x';
+
+	if (write (cleanup_pipe[1], &c, 1) != 1) {
+	  _exit (1);
+	}
+}
+
+static void *cleanup_thread (void *arg)
+{
+	char c;
+
+	while (read (cleanup_pipe[0], &c, 1) != 1) {
+	  ;
+	}
+
 	text_color_set(DW_COLOR_INFO);
 	dw_printf ("\nQRT\n");
 	log_term ();
+	pktlog_term ();
 	ptt_term ();
 	dwgps_term ();
 	SLEEP_SEC(1);
 	exit(0);
+
+	return (NULL);
 }
 
 #endif
@@ -1717,7 +1772,7 @@ static void usage (void)
 	dw_printf ("    -l logdir      Directory name for log files.  Use . for current.\n");
 	dw_printf ("    -r n           Audio sample rate, per sec.\n");
 	dw_printf ("    -n n           Number of audio channels, 1 or 2.\n");
-	dw_printf ("    -b n           Bits per audio sample, 8 or 16.\n");
+	dw_printf ("    -b n           Bits per audio sample, 8, 16, 24, 32, or F32 for float.\n");
 	dw_printf ("    -B n           Data rate in bits/sec for channel 0.  Standard values are 300, 1200, 2400, 4800, 9600.\n");
 	dw_printf ("                     300 bps defaults to AFSK tones of 1600 & 1800.\n");
 	dw_printf ("                     1200 bps uses AFSK tones of 1200 & 2200.\n");
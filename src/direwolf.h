@@ -42,51 +42,57 @@
 
 #endif
 
-/*
- * Maximum number of audio devices.
- * Three is probably adequate for standard version.
- * Larger reasonable numbers should also be fine.
- *
- * For example, if you wanted to use 4 audio devices at once, change this to 4.
- */
-
-#define MAX_ADEVS 3			
-
-	
 /*
  * Maximum number of radio channels.
+ *
+ * This used to be two for each audio device, left and right, so
+ * each device owned a fixed pair of channel numbers.  Now a device
+ * can have more than two channels (e.g. IQ input from an SDR split
+ * into many frequencies) so any channel number can be used for a
+ * radio channel.  The audio device for each channel is kept in
+ * chan_adev[] of the audio configuration.  See config.c.
+ *
  * Note that there could be gaps.
  * Suppose audio device 0 was in mono mode and audio device 1 was stereo.
  * The channels available would be:
  *
  *	ADevice 0:	channel 0
  *	ADevice 1:	left = 2, right = 3
+ *
+ * The limit now comes from the 4 bit channel field in KISS.
+ *
+ * Only the large per-channel receive state (demodulators, HDLC decoders,
+ * and raw bit buffers, see rx_chain.h) is allocated from the configuration.
+ * The remaining tables dimensioned by these are a few integers, pointers,
+ * or locks for each channel or device, in tq.c, xmit.c, ptt.c, gen_tone.c,
+ * digipeater.c, etc., and stay fixed.  Raising the limit only needs a
+ * larger value here plus a way to address channels above 15 over KISS.
  */
 
-#define MAX_RADIO_CHANS ((MAX_ADEVS) * 2)
-
-
 #define MAX_TOTAL_CHANS 16		// v1.7 allows additional virtual channels which are connected
 					// to something other than radio modems.
 					// Total maximum channels is based on the 4 bit KISS field.
 					// Someone with very unusual requirements could increase this and
 					// use only the AGW network protocol.
 
+#define MAX_RADIO_CHANS MAX_TOTAL_CHANS	// Radio and virtual channels share the same numbers.
+
+
 /*
- * Maximum number of rigs.
+ * Maximum number of audio devices.
+ * Each needs at least one channel number so there can't be more than that.
  */
 
-#ifdef USE_HAMLIB
-#define MAX_RIGS MAX_RADIO_CHANS
-#endif
+#define MAX_ADEVS MAX_TOTAL_CHANS
+
 
 /*
- * Get audio device number for given channel.
- * and first channel for given device.
+ * Maximum number of rigs.
  */
 
-#define ACHAN2ADEV(n) ((n)>>1)
-#define ADEVFIRSTCHAN(n) ((n) * 2)
+#ifdef USE_HAMLIB
+#define MAX_RIGS MAX_RADIO_CHANS
+#endif
 
 /*
  * Maximum number of modems per channel.
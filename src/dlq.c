@@ -61,6 +61,8 @@
 
 static struct dlq_item_s *queue_head = NULL;	/* Head of linked list for queue. */
 
+static volatile int s_queue_length = 0;		/* Number of items in queue, for statistics. */
+
 #if __WIN32__
 
 // TODO1.2: use dw_mutex_t
@@ -353,6 +355,7 @@ static void append_to_queue (struct dlq_item_s *pnew)
 	  }
 	  plast->nextp = pnew;
 	}
+	s_queue_length = queue_length;
 
 
 #if __WIN32__ 
@@ -1133,6 +1136,7 @@ struct dlq_item_s *dlq_remove (void)
 	if (queue_head != NULL) {
 	  result = queue_head;
 	  queue_head = queue_head->nextp;
+	  s_queue_length--;
 	}
 	 
 #if __WIN32__
@@ -1147,6 +1151,10 @@ struct dlq_item_s *dlq_remove (void)
 	}
 #endif
 
+	if (result != NULL && result->type == DLQ_REC_FRAME && result->pp != NULL) {
+	  ax25_set_rx_time (result->pp, RX_TIME_DLQ, dtime_monotonic());	// For latency statistics.
+	}
+
 #if DEBUG
 	text_color_set(DW_COLOR_DEBUG);
 	dw_printf ("dlq_remove()  returns \n");
@@ -1170,6 +1178,22 @@ struct dlq_item_s *dlq_remove (void)
 }
 
 
+/*-------------------------------------------------------------------
+ *
+ * Name:        dlq_get_length
+ *
+ * Purpose:     Get number of items waiting in the queue.
+ *
+ * Description:	This is only for statistics so it is read without locking.
+ *
+ *--------------------------------------------------------------------*/
+
+int dlq_get_length (void)
+{
+	return (s_queue_length);
+}
+
+
 /*-------------------------------------------------------------------
  *
  * Name:        dlq_delete
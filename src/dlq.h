@@ -135,6 +135,8 @@ int dlq_wait_while_empty (double timeout_val);
 
 struct dlq_item_s *dlq_remove (void);
 
+int dlq_get_length (void);
+
 void dlq_delete (struct dlq_item_s *pitem);
 
 
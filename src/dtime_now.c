@@ -178,6 +178,59 @@ double dtime_monotonic (void)
 }
 
 
+/*------------------------------------------------------------------
+ *
+ * Name:	dtime_cond_init
+ *		dtime_cond_timedwait
+ *
+ * Purpose:   	Wait on a condition variable until a dtime_monotonic() time.
+ *
+ * Inputs:	cond	- Condition variable, set up by dtime_cond_init.
+ *
+ *		mutex	- Locked by caller, as for pthread_cond_timedwait.
+ *
+ *		until	- Give up at this time, from dtime_monotonic().
+ *
+ * Returns:	Same as pthread_cond_timedwait.
+ *
+ * Description:	pthread_cond_timedwait normally takes a wall clock time so
+ *		a clock step, e.g. when NTP first sets the time on a
+ *		Raspberry Pi, would make a wait much too long or too short.
+ *		The condition variable is set up to use CLOCK_MONOTONIC,
+ *		the same clock as dtime_monotonic.
+ *
+ *		On MacOS, dtime_monotonic is still the wall clock so the
+ *		default clock for the condition variable matches it.
+ *		Windows uses events with relative times instead.
+ *
+ *---------------------------------------------------------------*/
+
+#if ! __WIN32__
+
+void dtime_cond_init (pthread_cond_t *cond)
+{
+	pthread_condattr_t attr;
+
+	pthread_condattr_init (&attr);
+#ifndef __APPLE__
+	pthread_condattr_setclock (&attr, CLOCK_MONOTONIC);
+#endif
+	pthread_cond_init (cond, &attr);
+	pthread_condattr_destroy (&attr);
+}
+
+int dtime_cond_timedwait (pthread_cond_t *cond, pthread_mutex_t *mutex, double until)
+{
+	struct timespec abstime;
+
+	abstime.tv_sec = (time_t)(long)until;
+	abstime.tv_nsec = (long)((until - (long)abstime.tv_sec) * 1000000000.0);
+	return (pthread_cond_timedwait (cond, mutex, &abstime));
+}
+
+#endif
+
+
 
 /*------------------------------------------------------------------
  *
@@ -5,6 +5,15 @@ extern double dtime_realtime (void);
 extern double dtime_monotonic (void);
 
 
+#if ! __WIN32__
+#include <pthread.h>
+
+void dtime_cond_init (pthread_cond_t *cond);
+
+int dtime_cond_timedwait (pthread_cond_t *cond, pthread_mutex_t *mutex, double until);
+#endif
+
+
 void timestamp_now (char *result, int result_size, int show_ms);
 
 void timestamp_user_format (char *result, int result_size, char *user_format);
@@ -68,6 +68,7 @@ static int const dtmf_tones[NUM_TONES] = { 697, 770, 852, 941, 1209, 1336, 1477,
 
 static struct dd_s {	 /* Separate for each audio channel. */
 
+	int adev;		/* Audio device for the channel. */
 	int sample_rate;	/* Samples per sec.  Typ. 44100, 8000, etc. */
 	int block_size;		/* Number of samples to process in one block. */
 	float coef[NUM_TONES];	
@@ -131,8 +132,9 @@ void dtmf_init (struct audio_s *p_audio_config, int amp)
 
 	for (c=0; c<MAX_RADIO_CHANS; c++) {
 	  struct dd_s *D = &(dd[c]);
-	  int a = ACHAN2ADEV(c);
+	  int a = p_audio_config->chan_adev[c];
 
+	  D->adev = a;
 	  D->sample_rate = p_audio_config->adev[a].samples_per_sec;
 
 	  if (p_audio_config->achan[c].dtmf_decode != DTMF_DECODE_OFF) {
@@ -374,7 +376,7 @@ int dtmf_send (int chan, char *str, int speed, int txdelay, int txtail)
 	push_button (chan, ' ', txtail);
 
 #ifndef DTMF_TEST
-	audio_flush(ACHAN2ADEV(chan));
+	audio_flush(dd[chan].adev);
 #endif
 	return (txdelay +
 		(int) (1000.0f * (float)strlen(str) / (float)speed + 0.5f) +
@@ -503,7 +505,7 @@ static void push_button (int chan, char button, int ms)
 	  // Amplitude of 100 would use full +-32k range.
 
 	  int sam = (int)(dtmf * 16383.0f * (float)s_amplitude / 100.0f);
-	  gen_tone_put_sample (chan, ACHAN2ADEV(chan), sam);
+	  gen_tone_put_sample (chan, dd[chan].adev, sam);
 
 #endif
 	}
@@ -532,8 +534,8 @@ int main ()
 	int c = 0;	// radio channel.
 
 	memset (&my_audio_config, 0, sizeof(my_audio_config));
-	my_audio_config.adev[ACHAN2ADEV(c)].defined = 1;
-	my_audio_config.adev[ACHAN2ADEV(c)].samples_per_sec = 44100;
+	my_audio_config.adev[my_audio_config.chan_adev[c]].defined = 1;
+	my_audio_config.adev[my_audio_config.chan_adev[c]].samples_per_sec = 44100;
 	my_audio_config.chan_medium[c] = MEDIUM_RADIO;
 	my_audio_config.achan[c].dtmf_decode = DTMF_DECODE_ON;
 
@@ -42,6 +42,8 @@
  *
  *		dwgps_term	Shutdown on exit.
  *
+ *		dwgps_wait	Wait for an update from the GPS receiver.
+ *
  *
  * from below:	dwgps_set_data	Called from other two implementations to
  *				save data until it is needed.
@@ -57,6 +59,7 @@
 #include <time.h>
 
 #include "textcolor.h"
+#include "dtime_now.h"
 #include "dwgps.h"
 #include "dwgpsnmea.h"
 #include "dwgpsd.h"
@@ -85,6 +88,20 @@ static dwgps_info_t s_dwgps_info = {
 
 static dw_mutex_t s_gps_mutex;
 
+/*
+ * Version 1.8:  The beacon thread used to poll for new data at fixed
+ * intervals.  Now it can wait for the next update instead.
+ * s_gps_seq is incremented each time new data is deposited.
+ */
+
+static int s_gps_seq = 0;
+
+#if __WIN32__
+static HANDLE s_gps_wake_up_event;		/* Only one waiter, the beacon thread. */
+#else
+static pthread_cond_t s_gps_wake_up_cond;	/* Used with s_gps_mutex. */
+#endif
+
 
 /*-------------------------------------------------------------------
  *
@@ -118,6 +135,16 @@ void dwgps_init (struct misc_config_s *pconfig, int debug)
 	s_dwgps_debug = debug;
 
 	dw_mutex_init (&s_gps_mutex);
+#if __WIN32__
+	s_gps_wake_up_event = CreateEvent (NULL, 0, 0, NULL);
+	if (s_gps_wake_up_event == NULL) {
+	  text_color_set(DW_COLOR_ERROR);
+	  dw_printf ("dwgps_init: CreateEvent: can't create GPS wake up event");
+	  exit (1);
+	}
+#else
+	pthread_cond_init (&s_gps_wake_up_cond, NULL);
+#endif
 
 	dwgpsnmea_init (pconfig, debug);
 
@@ -257,12 +284,79 @@ void dwgps_set_data (dwgps_info_t *gpsinfo)
 	dw_mutex_lock (&s_gps_mutex);
 
 	memcpy (&s_dwgps_info, gpsinfo, sizeof(s_dwgps_info));
+	s_gps_seq++;
 
+#if __WIN32__
+	dw_mutex_unlock (&s_gps_mutex);
+	SetEvent (s_gps_wake_up_event);
+#else
+	pthread_cond_broadcast (&s_gps_wake_up_cond);
 	dw_mutex_unlock (&s_gps_mutex);
+#endif
 
 }  /* end dwgps_set_data */
 
 
+/*-------------------------------------------------------------------
+ *
+ * Name:        dwgps_wait
+ *
+ * Purpose:     Wait for new data from the GPS receiver.
+ *
+ * Inputs:	pseq		- Update count from the previous call.
+ *				  Start with 0.
+ *
+ *		until		- Give up at this time, from dtime_now().
+ *
+ * Outputs:	pseq		- Updated to the current count.
+ *
+ * Returns:	1 if there was an update since the previous call.
+ *		0 if the time limit was reached.
+ *
+ * Description:	Return right away if something arrived since the
+ *		previous call so an update is never missed.
+ *		Use dwgps_read to get the data.
+ *
+ *--------------------------------------------------------------------*/
+
+int dwgps_wait (int *pseq, double until)
+{
+	int updated;
+
+	dw_mutex_lock (&s_gps_mutex);
+
+#if __WIN32__
+	if (s_gps_seq == *pseq) {
+	  double now = dtime_now();
+
+	  dw_mutex_unlock (&s_gps_mutex);
+	  if (until > now) {
+	    WaitForSingleObject (s_gps_wake_up_event, (DWORD)((until - now) * 1000) + 1);
+	  }
+	  dw_mutex_lock (&s_gps_mutex);
+	}
+#else
+	while (s_gps_seq == *pseq && dtime_now() < until) {
+	  struct timespec abstime;
+
+	  abstime.tv_sec = (time_t)(long)until;
+	  abstime.tv_nsec = (long)((until - (long)abstime.tv_sec) * 1000000000.0);
+	  if (pthread_cond_timedwait (&s_gps_wake_up_cond, &s_gps_mutex, &abstime) != 0) {
+	    break;	/* timeout */
+	  }
+	}
+#endif
+
+	updated = (s_gps_seq != *pseq);
+	*pseq = s_gps_seq;
+
+	dw_mutex_unlock (&s_gps_mutex);
+
+	return (updated);
+
+}  /* end dwgps_wait */
+
+
 /* end dwgps.c */
 
 
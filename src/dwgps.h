@@ -52,6 +52,8 @@ void dwgps_term (void);
 
 void dwgps_set_data (dwgps_info_t *gpsinfo);
 
+int dwgps_wait (int *pseq, double until);
+
 
 #endif /* DWGPS_H 1 */
 
@@ -302,6 +302,16 @@ struct demodulator_state_s
 
 	    float normalize_rpsam;	// Normalize to -1 to +1 for expected tones.
 
+	    // Version 1.8: DPLL state for the multiple slicer case, kept as parallel
+	    // arrays so all slicers can be advanced together by nudge_pll_multi.
+	    // The corresponding slicer[].data_clock_pll and prev_demod_data are
+	    // not used when num_slicers > 1.
+
+	    signed int slicer_pll[MAX_SLICERS] __attribute__((aligned(16)));
+	    int slicer_prev_data[MAX_SLICERS] __attribute__((aligned(16)));
+
+	    float space_gain[MAX_SLICERS];	// Space tone gain for each slicer.
+
 	  } afsk;
 
 //////////////////////////////////////////////////////////////////////////////////
@@ -329,11 +339,10 @@ struct demodulator_state_s
 		float lp_filter[MAX_FILTER_SIZE] __attribute__((aligned(16)));	// Low pass filter.
 
 		// New in 1.7 - Polyphase filter to reduce CPU requirements.
+		// The phases are interleaved so all can be computed in one pass.
+		// Unused phases are zero.
 
-		float lp_polyphase_1[MAX_FILTER_SIZE] __attribute__((aligned(16)));
-		float lp_polyphase_2[MAX_FILTER_SIZE] __attribute__((aligned(16)));
-		float lp_polyphase_3[MAX_FILTER_SIZE] __attribute__((aligned(16)));
-		float lp_polyphase_4[MAX_FILTER_SIZE] __attribute__((aligned(16)));
+		float lp_polyphase[MAX_FILTER_SIZE][4] __attribute__((aligned(16)));
 
 		float lp_1_iir_param;		// very low pass filters to get DC offset.
 		float lp_1_out;
@@ -373,6 +382,8 @@ struct demodulator_state_s
 		cic_t cic_above;
 		cic_t cic_below;
 
+		float slice_point[MAX_SLICERS];	// Threshold for each slicer.
+
 	  } bb;
 
 //////////////////////////////////////////////////////////////////////////////////
@@ -436,6 +447,17 @@ struct demodulator_state_s
 		int delay_line_taps;	// In audio samples.
 
 		float delay_line[MAX_FILTER_SIZE] __attribute__((aligned(16)));
+						// Audio for self correlation, I for local oscillator.
+		float delay_line_q[MAX_FILTER_SIZE] __attribute__((aligned(16)));
+						// Q for local oscillator.
+
+	// Phase shift between symbols is (x,y) = conjugate product of the two,
+	// rotated by (rot_cos,rot_sin) so the symbol boundaries fall on
+	// multiples of 45 or 22.5 degrees.  See demod_psk_process_sample.
+
+		float rot_cos;
+		float rot_sin;
+		int sector_gray[16];		// Gray code for each 1/8 or 1/16 of circle.
 
 	// Low pass filter Second is frequency as ratio to baud rate for FIR.
 
@@ -469,7 +491,7 @@ struct demodulator_state_s
  *
  * Inputs:	D		Pointer to demodulator state.
  *
- *		chan		Radio channel: 0 to MAX_RADIO_CHANS - 1
+ *		R		Receive chain.
  *
  *		subchan		Which of multiple demodulators: 0 to MAX_SUBCHANS - 1
  *
@@ -492,7 +514,7 @@ struct demodulator_state_s
  *
  *--------------------------------------------------------------------*/
 
-#include "hdlc_rec.h"        // for dcd_change
+#include "hdlc_rec.h"        // for dcd_chain_change
 
 // These are good for 1200 bps AFSK.
 // Might want to override for other modems.
@@ -523,7 +545,7 @@ inline static void pll_dcd_signal_transition2 (struct demodulator_state_s *D, in
 }
 
 __attribute__((always_inline))
-inline static void pll_dcd_each_symbol2 (struct demodulator_state_s *D, int chan, int subchan, int slice)
+inline static void pll_dcd_each_symbol2 (struct demodulator_state_s *D, struct rx_chain_s *R, int subchan, int slice)
 {
 	D->slicer[slice].good_hist <<= 1;
 	D->slicer[slice].good_hist |= D->slicer[slice].good_flag;
@@ -542,13 +564,13 @@ inline static void pll_dcd_each_symbol2 (struct demodulator_state_s *D, int chan
 	if (s >= DCD_THRESH_ON) {
 	  if (D->slicer[slice].data_detect == 0) {
 	    D->slicer[slice].data_detect = 1;
-	    dcd_change (chan, subchan, slice, D->slicer[slice].data_detect);
+	    dcd_chain_change (R, subchan, slice, D->slicer[slice].data_detect);
 	  }
 	}
 	else if (s <= DCD_THRESH_OFF) {
 	  if (D->slicer[slice].data_detect != 0) {
 	    D->slicer[slice].data_detect = 0;
-	    dcd_change (chan, subchan, slice, D->slicer[slice].data_detect);
+	    dcd_chain_change (R, subchan, slice, D->slicer[slice].data_detect);
 	  }
 	}
 }
@@ -65,8 +65,9 @@ void FREE_RS(struct rs *rs);
 
 void fx25_init ( int debug_level );
 int fx25_send_frame (int chan, unsigned char *fbuf, int flen, int fx_mode);
-void fx25_rec_bit (int chan, int subchan, int slice, int dbit);
-int fx25_rec_busy (int chan);
+struct rx_chain_s;
+void fx25_rec_bit (struct rx_chain_s *R, int subchan, int slice, int dbit, int quality);
+int fx25_rec_busy (struct rx_chain_s *R);
 
 
 // Other functions in fx25_init.c.
@@ -79,6 +80,7 @@ int fx25_get_nroots (int ctag_num);
 int fx25_get_debug (void);
 int fx25_tag_find_match (uint64_t t);
 int fx25_pick_mode (int fx_mode, int dlen);
+int fx25_pick_erasures (const unsigned char *conf, int n, int count, int offset, int *eras_pos);
 
 void fx_hex_dump(unsigned char *x, int len);
 
@@ -387,6 +387,60 @@ int fx25_pick_mode (int fx_mode, int dlen)
 }
 
 
+/*-------------------------------------------------------------
+ *
+ * Name:	fx25_pick_erasures
+ *
+ * Purpose:	Pick the least reliable bytes of a received block so
+ *		the Reed-Solomon decoder can treat them as erasures.
+ *
+ * Inputs:	conf	- Confidence for each received byte, 0 to 100.
+ *			  This is the worst of its bits, from the demodulator.
+ *
+ *		n	- Number of bytes in conf.
+ *
+ *		count	- Number of erasures wanted.
+ *
+ *		offset	- Added to each position.  The RS decoder counts from
+ *			  the start of the whole 255 byte block, including any
+ *			  zero padding in front of what was received.
+ *
+ * Outputs:	eras_pos - Positions for DECODE_RS.
+ *
+ * Returns:	Number of positions picked.
+ *
+ * Description:	An erasure, where we know the location but not the value,
+ *		costs one check byte to fix rather than two for an error
+ *		at an unknown location.  When the hard decision decode fails,
+ *		guessing where the bad bytes are can often get it right.
+ *
+ *		This is done only after a failure so a simple selection
+ *		is good enough.
+ *
+ *--------------------------------------------------------------*/
+
+int fx25_pick_erasures (const unsigned char *conf, int n, int count, int offset, int *eras_pos)
+{
+	unsigned char taken[FX25_BLOCK_SIZE];
+
+	assert (n >= 0 && n <= FX25_BLOCK_SIZE);
+	if (count > n) count = n;
+
+	memset (taken, 0, n);
+	for (int k = 0; k < count; k++) {
+	  int best = -1;
+	  for (int i = 0; i < n; i++) {
+	    if ( ! taken[i] && (best < 0 || conf[i] < conf[best])) {
+	      best = i;
+	    }
+	  }
+	  taken[best] = 1;
+	  eras_pos[k] = offset + best;
+	}
+	return (count);
+}
+
+
 /* Initialize a Reed-Solomon codec
  *   symsize = symbol size, bits (1-8) - always 8 for this application.
  *   gfpoly = Field generator polynomial coefficients
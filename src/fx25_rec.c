@@ -44,6 +44,8 @@
 #include "textcolor.h"
 #include "multi_modem.h"
 #include "demod.h"
+#include "rxprof.h"
+#include "rx_chain.h"
 
 struct fx_context_s {
 
@@ -57,13 +59,17 @@ struct fx_context_s {
 	int clen;		// Accumulated length in "check" below.
 	unsigned char imask;	// Mask for storing a bit.
 	unsigned char block[FX25_BLOCK_SIZE+1];
+	unsigned char conf[FX25_BLOCK_SIZE];	// Confidence for each byte of block, worst of its bits.
+						// 255 for the zero fill which is known.
 };
 
-static struct fx_context_s *fx_context[MAX_RADIO_CHANS][MAX_SUBCHANS][MAX_SLICERS];
+// One for each subchannel and slicer is found in the rx_chain_s for the channel.
 
-static void process_rs_block (int chan, int subchan, int slice, struct fx_context_s *F);
+static void process_rs_block (struct rx_chain_s *R, int subchan, int slice, struct fx_context_s *F);
 
-static int my_unstuff (int chan, int subchan, int slice, unsigned char * restrict pin, int ilen, unsigned char * restrict frame_buf);
+static int erasure_decode (struct fx_context_s *F, struct rs *rs, unsigned char *received, int *derrlocs);
+
+static int my_unstuff (int chan, int subchan, int slice, unsigned char * restrict pin, int ilen, unsigned char * restrict frame_buf, int quiet);
 
 //#define FXTEST 1	// Define for standalone test application.
 			// It expects to find files fx01.dat, fx02.dat, ..., fx0b.dat/
@@ -71,6 +77,8 @@ static int my_unstuff (int chan, int subchan, int slice, unsigned char * restric
 #if FXTEST
 static int fx25_test_count = 0;
 
+static void erasure_test (int num_high);
+
 int main ()
 {
 	fx25_init(3);
@@ -98,13 +106,17 @@ int main ()
 	  unsigned char ch;
 	  while (fread(&ch, 1, 1, fp) == 1) {
 	    for (unsigned char imask = 0x01; imask != 0; imask <<=1) {
-	      fx25_rec_bit (0, 0, 0, ch & imask);
+	      fx25_rec_bit (rx_chain_get(0), 0, 0, ch & imask, 100);
 	    }
 	  }
 	  fclose (fp);
 	}
+	int file_count = fx25_test_count;
 
-	if (fx25_test_count == 11) {
+	erasure_test (0);
+	erasure_test (3);
+
+	if (file_count == 11) {
 	  text_color_set(DW_COLOR_REC);
 	  dw_printf ("\n");
 	  dw_printf ("\n");
@@ -115,11 +127,71 @@ int main ()
 	text_color_set(DW_COLOR_ERROR);
 	dw_printf ("\n");
 	dw_printf ("\n");
-	dw_printf ("***** FX25 unit test FAILED.  Only %d/11 tests passed. *****\n", fx25_test_count);
+	dw_printf ("***** FX25 unit test FAILED.  Only %d/11 tests passed. *****\n", file_count);
 	exit (EXIT_SUCCESS);
 
 } // end main 
 
+
+/*
+ * Version 1.8:  Test decoding with erasures.
+ *
+ * fx01.dat, RS(255,239), already has 8 bad data bytes, as many as its
+ * 16 check bytes can fix.  Make 4 more bad so the hard decision decode
+ * fails, and give their bits low confidence so they are picked as erasures.
+ *
+ * num_high more bad bytes, with full confidence, are more than can
+ * be fixed along with them.  Whatever the decoder comes up with must
+ * be rejected.
+ */
+
+static void erasure_test (int num_high)
+{
+	unsigned char buf[16 + 8 + FX25_BLOCK_SIZE + 16];
+	unsigned char qual[sizeof(buf)];
+
+	FILE *fp = fopen("fx01.dat", "rb");
+	if (fp == NULL) {
+	  text_color_set(DW_COLOR_ERROR);
+	  dw_printf ("****** Could not open fx01.dat ******\n");
+	  exit (EXIT_FAILURE);
+	}
+	int len = fread (buf, 1, sizeof(buf), fp);
+	fclose (fp);
+
+	int data = 16 + 8;		// After flags and correlation tag.
+
+	memset (qual, 100, sizeof(qual));
+	for (int j = 8; j < 16; j++) {	// Corrupted by fxsend.
+	  qual[data + j] = 10;
+	}
+	for (int j = 20; j < 24; j++) {
+	  buf[data + j] ^= 0x5a;
+	  qual[data + j] = 10;
+	}
+	for (int j = 30; j < 30 + num_high; j++) {
+	  buf[data + j] ^= 0x5a;
+	}
+
+	int before = fx25_test_count;
+
+	for (int k = 0; k < len; k++) {
+	  for (unsigned char imask = 0x01; imask != 0; imask <<=1) {
+	    fx25_rec_bit (rx_chain_get(0), 0, 0, buf[k] & imask, qual[k]);
+	  }
+	}
+
+	int expected = num_high == 0 ? 1 : 0;
+	if (fx25_test_count - before != expected) {
+	  text_color_set(DW_COLOR_ERROR);
+	  dw_printf ("\n***** FX25 erasure test FAILED with %d low and %d high confidence errors.  Decoded %d, expected %d. *****\n",
+				12, num_high, fx25_test_count - before, expected);
+	  exit (EXIT_FAILURE);
+	}
+	text_color_set(DW_COLOR_INFO);
+	dw_printf ("FX25 erasure test with %d low and %d high confidence errors OK.\n", 12, num_high);
+}
+
 #endif  // FXTEST
 
 
@@ -132,7 +204,7 @@ int main ()
  *		In a completely integrated AX.25 / FX.25 receive system,
  *		this would see the same bit stream as hdlc_rec_bit.
  *
- * Inputs:      chan    - Channel number.
+ * Inputs:      R       - Receive chain for the radio channel.
  *
  *              subchan - This allows multiple demodulators per channel.
  *
@@ -141,6 +213,9 @@ int main ()
  *              dbit	- Data bit after NRZI and any descrambling.
  *			  Any non-zero value is logic '1'.
  *
+ *		quality	- Confidence in the bit, 0 to 100.
+ *			  Used to pick erasures if the block can't be fixed otherwise.
+ *
  * Description: This is called once for each received bit.
  *              For each valid frame, process_rec_frame() is called for further processing.
  *		It can gather multiple candidates from different parallel demodulators
@@ -150,19 +225,17 @@ int main ()
 
 #define FENCE 0x55		// to detect buffer overflow.
 
-void fx25_rec_bit (int chan, int subchan, int slice, int dbit)
+void fx25_rec_bit (struct rx_chain_s *R, int subchan, int slice, int dbit, int quality)
 {
+	int chan = R->chan;
 
 // Allocate context blocks only as needed.
 
-	struct fx_context_s *F = fx_context[chan][subchan][slice];
+	struct fx_context_s *F = R->fx25[subchan][slice];
 	if (F == NULL) {
-          assert (chan >= 0 && chan < MAX_RADIO_CHANS);
           assert (subchan >= 0 && subchan < MAX_SUBCHANS);
           assert (slice >= 0 && slice < MAX_SLICERS);
-	  F = fx_context[chan][subchan][slice] = (struct fx_context_s *)malloc(sizeof (struct fx_context_s));
-	  assert (F != NULL);
-	  memset (F, 0, sizeof(struct fx_context_s));
+	  F = R->fx25[subchan][slice] = rx_chain_alloc (sizeof (struct fx_context_s));
 	}
 
 // State machine to identify correlation tag then gather appropriate number of data and check bytes.
@@ -194,12 +267,14 @@ void fx25_rec_bit (int chan, int subchan, int slice, int dbit)
 	      F->clen = 0;
 	      memset (F->block, 0, sizeof(F->block));
 	      F->block[FX25_BLOCK_SIZE] = FENCE;
+	      memset (F->conf, 255, sizeof(F->conf));
 	      F->state = FX_DATA;
 	    }
 	    break;
 
 	  case FX_DATA:
 	    if (dbit) F->block[F->dlen] |= F->imask;
+	    if (quality < F->conf[F->dlen]) F->conf[F->dlen] = quality;
 	    F->imask <<= 1;
 	    if (F->imask == 0) {
 	      F->imask = 0x01;
@@ -212,13 +287,17 @@ void fx25_rec_bit (int chan, int subchan, int slice, int dbit)
 
 	  case FX_CHECK:
 	    if (dbit) F->block[F->coffs + F->clen] |= F->imask;
+	    if (quality < F->conf[F->coffs + F->clen]) F->conf[F->coffs + F->clen] = quality;
 	    F->imask <<= 1;
 	    if (F->imask == 0) {
 	      F->imask = 0x01;
 	      F->clen++;
 	      if (F->clen >= F->nroots) {
 
-	        process_rs_block (chan, subchan, slice, F);		// see below
+	        rx_chain_frame_end (R);
+	        RXPROF_FRAME_ENTER (&R->prof, RXPROF_FEC)
+	        process_rs_block (R, subchan, slice, F);		// see below
+	        RXPROF_FRAME_LEAVE (&R->prof, RXPROF_FEC)
 
 	        F->ctag_num = -1;
 	        F->accum = 0;
@@ -237,7 +316,7 @@ void fx25_rec_bit (int chan, int subchan, int slice, int dbit)
  *
  * Purpose:     Is FX.25 reception currently in progress?
  *
- * Inputs:      chan    - Channel number.
+ * Inputs:      R       - Receive chain for the radio channel.
  *
  * Returns:	True if currently in progress for the specified channel.
  *
@@ -254,17 +333,15 @@ void fx25_rec_bit (int chan, int subchan, int slice, int dbit)
  *
  ***********************************************************************************/
 
-int fx25_rec_busy (int chan)
+int fx25_rec_busy (struct rx_chain_s *R)
 {
-	assert (chan >= 0 && chan < MAX_RADIO_CHANS);
-
 	// This could be a little faster if we knew number of
 	// subchannels and slicers but it is probably insignificant.
 
 	for (int i = 0; i < MAX_SUBCHANS; i++) {
 	  for (int j = 0; j < MAX_SLICERS; j++) {
-	    if (fx_context[chan][i][j] != NULL) {
-	      if (fx_context[chan][i][j]->state != FX_TAG) {
+	    if (R->fx25[i][j] != NULL) {
+	      if (R->fx25[i][j]->state != FX_TAG) {
 	        return (1);
 	      }
 	    }
@@ -283,7 +360,7 @@ int fx25_rec_busy (int chan)
  * Purpose:     After the correlation tag was detected and the appropriate number
  *		of data and check bytes are accumulated, this performs the processing
  *
- * Inputs:	chan, subchan, slice
+ * Inputs:	R, subchan, slice
  *
  *		F->ctag_num	- Correlation tag number  (index into table)
  *
@@ -301,12 +378,16 @@ int fx25_rec_busy (int chan)
  *		+-----------------------+---------------+---------------+
  *
  * Description:	Use Reed-Solomon decoder to fix up any errors.
+ *		If that fails, try again with the least reliable bytes
+ *		marked as erasures.
  *		Extract the AX.25 frame from the corrected data.
  *
  ***********************************************************************************/
 
-static void process_rs_block (int chan, int subchan, int slice, struct fx_context_s *F)
+static void process_rs_block (struct rx_chain_s *R, int subchan, int slice, struct fx_context_s *F)
 {
+	int chan = R->chan;
+
 	if (fx25_get_debug() >= 3) {
 	  text_color_set(DW_COLOR_DEBUG);
 	  dw_printf ("FX.25[%d.%d]: Received RS codeblock.\n", chan, slice);
@@ -316,9 +397,16 @@ static void process_rs_block (int chan, int subchan, int slice, struct fx_contex
 
 	int derrlocs[FX25_MAX_CHECK];	// Half would probably be OK.
 	struct rs *rs = fx25_get_rs(F->ctag_num);
+	unsigned char received[FX25_BLOCK_SIZE];
+
+	memcpy (received, F->block, FX25_BLOCK_SIZE);	// Decoder can leave a mess when it fails.
 
 	int derrors = DECODE_RS(rs, F->block, derrlocs, 0);
 
+	if (derrors < 0) {
+	  derrors = erasure_decode (F, rs, received, derrlocs);
+	}
+
 	if (derrors >= 0) {		// -1 for failure.  >= 0 for success, number of bytes corrected.
 
 	  if (fx25_get_debug() >= 2) {
@@ -336,7 +424,7 @@ static void process_rs_block (int chan, int subchan, int slice, struct fx_contex
 	  }
 
 	  unsigned char frame_buf[FX25_MAX_DATA+1];	// Out must be shorter than input.
-	  int frame_len = my_unstuff (chan, subchan, slice, F->block, F->dlen, frame_buf);
+	  int frame_len = my_unstuff (chan, subchan, slice, F->block, F->dlen, frame_buf, 0);
 
 	  if (frame_len >= 14 + 1 + 2) {		// Minimum length: Two addresses & control & FCS.
 
@@ -353,9 +441,9 @@ static void process_rs_block (int chan, int subchan, int slice, struct fx_contex
 #if FXTEST 
 	      fx25_test_count++;
 #else
-	      alevel_t alevel = demod_get_audio_level (chan, subchan);
+	      alevel_t alevel = demod_chain_audio_level (R, subchan);
 
-	      multi_modem_process_rec_frame (chan, subchan, slice, frame_buf, frame_len - 2, alevel, derrors, 1);   /* len-2 to remove FCS. */
+	      multi_modem_process_rec_frame (R, subchan, slice, frame_buf, frame_len - 2, alevel, derrors, 1);   /* len-2 to remove FCS. */
 
 #endif
 	    } else {
@@ -382,6 +470,75 @@ static void process_rs_block (int chan, int subchan, int slice, struct fx_contex
 } // process_rs_block
 
 
+/***********************************************************************************
+ *
+ * Name:	erasure_decode
+ *
+ * Purpose:     Second try at a codeblock that could not be fixed the usual way.
+ *
+ * Inputs:	F->conf		- Confidence for each byte.
+ *
+ *		rs		- Reed-Solomon codec for the correlation tag.
+ *
+ *		received	- Codeblock as received.
+ *
+ * Outputs:	F->block	- Corrected codeblock, if successful.
+ *
+ *		derrlocs	- Byte positions that were changed.
+ *
+ * Returns:	Number of bytes corrected or -1 for failure.
+ *
+ * Description:	Each erasure uses one check byte and each error at an unknown
+ *		location uses two.  First erase half as many of the least
+ *		reliable bytes as there are check bytes, leaving some to find
+ *		other errors.  Then erase more, up to as many as there are check
+ *		bytes, which can fix twice as many bad bytes when the guesses
+ *		are right.
+ *
+ *		Using up the check bytes leaves little or nothing for detecting
+ *		a wrong result.  A guess is accepted only if the zero fill, which
+ *		is known, is still zero and the AX.25 frame inside has a good FCS.
+ *
+ ***********************************************************************************/
+
+static int erasure_decode (struct fx_context_s *F, struct rs *rs, unsigned char *received, int *derrlocs)
+{
+	int eras_pos[FX25_MAX_CHECK];
+	int step = F->nroots / 8;
+
+	for (int no_eras = F->nroots / 2; no_eras <= F->nroots; no_eras += step) {
+
+	  memcpy (F->block, received, FX25_BLOCK_SIZE);
+	  fx25_pick_erasures (F->conf, FX25_BLOCK_SIZE, no_eras, 0, eras_pos);
+
+	  int derrors = DECODE_RS(rs, F->block, eras_pos, no_eras);
+	  if (derrors < 0) continue;
+
+	  int fill_ok = 1;
+	  for (int i = F->dlen; i < F->coffs; i++) {
+	    if (F->block[i] != 0) fill_ok = 0;
+	  }
+	  if ( ! fill_ok) continue;
+
+	  unsigned char frame_buf[FX25_MAX_DATA+1];
+	  int frame_len = my_unstuff (0, 0, 0, F->block, F->dlen, frame_buf, 1);
+	  if (frame_len < 14 + 1 + 2) continue;
+	  if (fcs_calc (frame_buf, frame_len - 2) != (frame_buf[frame_len-2] | (frame_buf[frame_len-1] << 8))) continue;
+
+	  if (fx25_get_debug() >= 2) {
+	    text_color_set(DW_COLOR_INFO);
+	    dw_printf ("FX.25: Block fixed with %d erasures.\n", no_eras);
+	  }
+	  memcpy (derrlocs, eras_pos, derrors * sizeof(int));
+	  return (derrors);
+	}
+
+	memcpy (F->block, received, FX25_BLOCK_SIZE);
+	return (-1);
+
+} // end erasure_decode
+
+
 /***********************************************************************************
  *
  * Name:	my_unstuff  
@@ -397,6 +554,8 @@ static void process_rs_block (int chan, int subchan, int slice, struct fx_contex
  *
  *		ilen	- Number of bytes in pin.
  *
+ *		quiet	- Don't complain about errors.  For trying possible corrections.
+ *
  * Outputs:	frame_buf - Frame contents including FCS.
  *			    Bit stuffing is gone so it should be a whole number of bytes.
  *
@@ -412,7 +571,7 @@ static void process_rs_block (int chan, int subchan, int slice, struct fx_contex
  *
  ***********************************************************************************/
 
-static int my_unstuff (int chan, int subchan, int slice, unsigned char * restrict pin, int ilen, unsigned char * restrict frame_buf)
+static int my_unstuff (int chan, int subchan, int slice, unsigned char * restrict pin, int ilen, unsigned char * restrict frame_buf, int quiet)
 {
 	unsigned char pat_det = 0;	// Pattern detector.
 	unsigned char oacc = 0;		// Accumulator for a byte out.
@@ -420,6 +579,7 @@ static int my_unstuff (int chan, int subchan, int slice, unsigned char * restric
 	int frame_len = 0;		// Number of bytes accumulated, including CRC.
 	
 	if (*pin != 0x7e) {
+	  if (quiet) return (0);
 	  text_color_set(DW_COLOR_ERROR);
 	  dw_printf ("FX.25[%d.%d] error: Data section did not start with 0x7e.\n", chan, slice);
 	  fx_hex_dump (pin, ilen);
@@ -438,6 +598,7 @@ static int my_unstuff (int chan, int subchan, int slice, unsigned char * restric
 	    pat_det |= dbit << 7; 
 
 	    if (pat_det == 0xfe) {
+	      if (quiet) return (0);
 	      text_color_set(DW_COLOR_ERROR);
 	      dw_printf ("FX.25[%d.%d]: Invalid AX.25 frame - Seven '1' bits in a row.\n", chan, slice);
 	      fx_hex_dump (pin, ilen);
@@ -453,6 +614,7 @@ static int my_unstuff (int chan, int subchan, int slice, unsigned char * restric
 	          return (frame_len);	// Whole number of bytes in result including CRC
 		}
 	        else {
+	          if (quiet) return (0);
 	          text_color_set(DW_COLOR_ERROR);
 	          dw_printf ("FX.25[%d.%d]: Invalid AX.25 frame - Not a whole number of bytes.\n", chan, slice);
 	          fx_hex_dump (pin, ilen);
@@ -472,6 +634,7 @@ static int my_unstuff (int chan, int subchan, int slice, unsigned char * restric
 	  }
 	}	/* end of loop on all bits in block */
 
+	if (quiet) return (0);
 	text_color_set(DW_COLOR_ERROR);
 	dw_printf ("FX.25[%d.%d]: Invalid AX.25 frame - Terminating flag not found.\n", chan, slice);
 	fx_hex_dump (pin, ilen);
@@ -72,6 +72,7 @@
 
 #include <stdio.h>     
 #include <stdlib.h>    
+#include <stdint.h>
 #include <getopt.h>
 #include <string.h>
 #include <assert.h>
@@ -281,7 +282,7 @@ int main(int argc, char **argv)
 
 	  /* ':' following option character means arg is required. */
 
-          c = getopt_long(argc, argv, "gjJm:s:a:b:B:r:n:N:o:z:82M:X:I:i:v:",
+          c = getopt_long(argc, argv, "gjJm:s:a:b:B:r:n:N:o:z:82f:M:X:I:i:v:",
                         long_options, &option_index);
           if (c == -1)
             break;
@@ -488,6 +489,34 @@ int main(int argc, char **argv)
               dw_printf("8 bits per audio sample rather than 16.\n");
               break;
 
+            case 'f':				/* -f for sample Format */
+
+              modem.adev[0].float_samples = 0;
+              if (strcasecmp(optarg, "U8") == 0) {
+                modem.adev[0].bits_per_sample = 8;
+              }
+              else if (strcasecmp(optarg, "S16") == 0) {
+                modem.adev[0].bits_per_sample = 16;
+              }
+              else if (strcasecmp(optarg, "S24") == 0) {
+                modem.adev[0].bits_per_sample = 24;
+              }
+              else if (strcasecmp(optarg, "S32") == 0) {
+                modem.adev[0].bits_per_sample = 32;
+              }
+              else if (strcasecmp(optarg, "F32") == 0) {
+                modem.adev[0].bits_per_sample = 32;
+                modem.adev[0].float_samples = 1;
+              }
+              else {
+                text_color_set(DW_COLOR_ERROR);
+                dw_printf ("Sample format must be U8, S16, S24, S32, or F32.\n");
+                exit (EXIT_FAILURE);
+              }
+              text_color_set(DW_COLOR_INFO);
+              dw_printf("Audio sample format %s.\n", optarg);
+              break;
+
             case '2':				/* -2 for 2 channels of sound */
   
               modem.adev[0].num_channels = 2;
@@ -662,7 +691,8 @@ int main(int argc, char **argv)
 	fx25_init (1);
 	il2p_init (0);		// There are no "-d" options so far but it could be handy here.
 
-        assert (modem.adev[0].bits_per_sample == 8 || modem.adev[0].bits_per_sample == 16);
+        assert (modem.adev[0].bits_per_sample == 8 || modem.adev[0].bits_per_sample == 16 ||
+		modem.adev[0].bits_per_sample == 24 || modem.adev[0].bits_per_sample == 32);
         assert (modem.adev[0].num_channels == 1 || modem.adev[0].num_channels == 2);
         assert (modem.adev[0].samples_per_sec >= MIN_SAMPLES_PER_SEC && modem.adev[0].samples_per_sec <= MAX_SAMPLES_PER_SEC);
 
@@ -838,6 +868,7 @@ static void usage (char **argv)
 	dw_printf ("  -n <number>   Generate specified number of frames with increasing noise.\n");
 	dw_printf ("  -o <file>     Send output to .wav file.\n");
 	dw_printf ("  -8            8 bit audio rather than 16.\n");
+	dw_printf ("  -f <format>   Audio sample format U8, S16, S24, S32, or F32.\n");
 	dw_printf ("  -2            2 channels (stereo) audio rather than one channel.\n");
 	dw_printf ("  -v max[,incr] Variable speed with specified maximum error and increment.\n");
 //	dw_printf ("  -z <number>   Number of leading zero bits before frame.\n");
@@ -901,12 +932,12 @@ struct wav_header {             /* .WAV file header. */
         char wave[4];           /* "WAVE" */
         char fmt[4];            /* "fmt " */
         int fmtsize;           /* 16. */
-        short wformattag;       /* 1 for PCM. */
+        short wformattag;       /* 1 for PCM, 3 for float. */
         short nchannels;        /* 1 for mono, 2 for stereo. */
         int nsamplespersec;    /* sampling freq, Hz. */
         int navgbytespersec;   /* = nblockalign * nsamplespersec. */
         short nblockalign;      /* = wbitspersample / 8 * nchannels. */
-        short wbitspersample;   /* 16 or 8. */
+        short wbitspersample;   /* 8, 16, 24, or 32. */
         char data[4];           /* "data" */
         int datasize;          /* number of bytes following. */
 } ;
@@ -960,7 +991,7 @@ static int audio_file_open (char *fname, struct audio_s *pa)
         memcpy (header.wave, "WAVE", (size_t)4);
         memcpy (header.fmt, "fmt ", (size_t)4);
         header.fmtsize = 16;			// Always 16.
-        header.wformattag = 1;     		// 1 for PCM.
+        header.wformattag = pa -> adev[0].float_samples ? 3 : 1;	// 1 for PCM, 3 for float.
 
         header.nchannels = pa -> adev[0].num_channels;   		
         header.nsamplespersec = pa -> adev[0].samples_per_sec;    
@@ -1014,22 +1045,37 @@ static int audio_file_open (char *fname, struct audio_s *pa)
 
 int audio_put (int a, int c)
 {
-	static short sample16;
-	int s;
+	static unsigned char sample[4];		/* Bytes of current sample. */
+	int nbytes = modem.adev[0].bits_per_sample / 8;
 
 	if (g_add_noise) {
 
-	  if ((byte_count & 1) == 0) {
-	    sample16 = c & 0xff;		/* save lower byte. */
-	    byte_count++;
-	    return c;
+	  sample[byte_count % nbytes] = c & 0xff;
+	  byte_count++;
+	  if (byte_count % nbytes != 0) {
+	    return c;			/* wait for rest of sample. */
 	  }
 	  else {
 	    float r;
-
-	    sample16 |= (c << 8) & 0xff00;	/* insert upper byte. */
-	    byte_count++;
-	    s = sample16;  // sign extend.
+	    float x;			/* Scaled like 16 bit sample. */
+	    int32_t i32;
+
+	    switch (nbytes) {
+	      case 1:  x = (sample[0] - 128) * 256.0f;  break;
+	      case 2:  x = (int16_t)(sample[0] | (sample[1] << 8));  break;
+	      case 3:  x = (int32_t)(((uint32_t)sample[0] << 8) | ((uint32_t)sample[1] << 16) | ((uint32_t)sample[2] << 24)) / 65536.0f;  break;
+	      default:
+	        i32 = (int32_t)(sample[0] | (sample[1] << 8) | (sample[2] << 16) | ((uint32_t)sample[3] << 24));
+	        if (modem.adev[0].float_samples) {
+	          float f;
+	          memcpy (&f, &i32, sizeof(f));
+	          x = f * 32768.0f;
+	        }
+	        else {
+	          x = i32 / 65536.0f;
+	        }
+	        break;
+	    }
 
 /* Add random noise to the signal. */
 /* r should be in range of -1 .. +1. */
@@ -1041,13 +1087,31 @@ int audio_put (int a, int c)
 
 	    r = (my_rand() - MY_RAND_MAX/2.0) / (MY_RAND_MAX/2.0);
 
-	    s += 5 * r * g_noise_level * 32767;
-
-	    if (s > 32767) s = 32767;
-	    if (s < -32767) s = -32767;
+	    x += 5 * r * g_noise_level * 32767;
+
+	    if (x > 32767) x = 32767;
+	    if (x < -32767) x = -32767;
+
+	    switch (nbytes) {
+	      case 1:  i32 = lrintf(x / 256.0f) + 128;  break;
+	      case 2:  i32 = (int)x;  break;		/* Truncate as always done for 16 bits. */
+	      case 3:  i32 = lrintf(x * 256.0f);  break;
+	      default:
+	        if (modem.adev[0].float_samples) {
+	          float f = x / 32768.0f;
+	          memcpy (&i32, &f, sizeof(f));
+	        }
+	        else {
+	          i32 = lrintf(x * 65536.0f);
+	        }
+	        break;
+	    }
 
-	    putc(s & 0xff, out_fp);  
-	    return (putc((s >> 8) & 0xff, out_fp));
+	    int k;
+	    for (k = 0; k < nbytes - 1; k++) {
+	      putc((i32 >> (k * 8)) & 0xff, out_fp);
+	    }
+	    return (putc((i32 >> (k * 8)) & 0xff, out_fp));
 	  }
 	}
 	else {
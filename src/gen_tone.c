@@ -167,7 +167,7 @@ int gen_tone_init (struct audio_s *audio_config_p, int amp, int gen_packets)
 
 	  if (audio_config_p->chan_medium[chan] == MEDIUM_RADIO) {
 
-	    int a = ACHAN2ADEV(chan);
+	    int a = audio_config_p->chan_adev[chan];
 
 #if DEBUG
 	text_color_set(DW_COLOR_DEBUG);
@@ -363,10 +363,10 @@ static const float sq[8] = { 0,	.7071,	1,	.7071,	0,	-.7071,	-1,	-.7071	};
 
 void tone_gen_put_bit (int chan, int dat)
 {
-	int a = ACHAN2ADEV(chan);	/* device for channel. */
-
 	assert (save_audio_config_p != NULL);
 
+	int a = save_audio_config_p->chan_adev[chan];	/* device for channel. */
+
 	if (save_audio_config_p->chan_medium[chan] != MEDIUM_RADIO) {
 	  text_color_set(DW_COLOR_ERROR);
 	  dw_printf ("Invalid channel %d for tone generation.\n", chan);
@@ -581,17 +581,73 @@ void tone_gen_put_bit (int chan, int dat)
 }  /* end tone_gen_put_bit */
 
 
+/*
+ * Write one sample, or silence, in the format used by the audio device.
+ * sam is always on the 16 bit scale.  The wider formats simply
+ * put it in the upper bits.  Float has full scale of +-1.0.
+ */
+
+static void put_one (int a, int sam)
+{
+	struct adev_param_s *A = &(save_audio_config_p->adev[a]);
+	unsigned int u;
+	int n;
+
+	switch (A->bits_per_sample) {
+
+	  case 8:
+            audio_put (a, ((sam+32768) >> 8) & 0xff);
+	    return;
+
+	  case 16:
+	  default:
+            audio_put (a, sam & 0xff);
+            audio_put (a, (sam >> 8) & 0xff);
+	    return;
+
+	  case 24:
+	    u = (unsigned int)sam << 8;
+	    break;
+
+	  case 32:
+	    if (A->float_samples) {
+	      float f = sam * (1.0f / 32768.0f);
+	      memcpy (&u, &f, sizeof(u));
+	    }
+	    else {
+	      u = (unsigned int)sam << 16;
+	    }
+	    break;
+	}
+
+	for (n = 0; n < A->bits_per_sample / 8; n++) {
+	  audio_put (a, (u >> (n * 8)) & 0xff);
+	}
+}
+
+static void put_silence (int a)
+{
+	int n;
+
+	for (n = 0; n < save_audio_config_p->adev[a].bits_per_sample / 8; n++) {
+	  audio_put (a, 0);
+	}
+}
+
+
 void gen_tone_put_sample (int chan, int a, int sam) {
 
         /* Ship out an audio sample. */
 	/* 16 bit is signed, little endian, range -32768 .. +32767 */
 	/* 8 bit is unsigned, range 0 .. 255 */
+	/* 24 and 32 bit are signed, little endian, or 32 bit float. */
 
 	assert (save_audio_config_p != NULL);
 
-	assert (save_audio_config_p->adev[a].num_channels == 1 || save_audio_config_p->adev[a].num_channels == 2);
+	assert (save_audio_config_p->adev[a].num_channels >= 1);
 
-	assert (save_audio_config_p->adev[a].bits_per_sample == 16 || save_audio_config_p->adev[a].bits_per_sample == 8);
+	assert (save_audio_config_p->adev[a].bits_per_sample == 16 || save_audio_config_p->adev[a].bits_per_sample == 8 ||
+		save_audio_config_p->adev[a].bits_per_sample == 24 || save_audio_config_p->adev[a].bits_per_sample == 32);
 
 	// Bad news if we are clipping and distorting the signal.
 	// We are using the full range.
@@ -613,46 +669,22 @@ void gen_tone_put_sample (int chan, int a, int sam) {
 
 	  /* Mono */
 
-	  if (save_audio_config_p->adev[a].bits_per_sample == 8) {
-            audio_put (a, ((sam+32768) >> 8) & 0xff);
-	  }
-	  else {
-            audio_put (a, sam & 0xff);
-            audio_put (a, (sam >> 8) & 0xff);
-	  }
+	  put_one (a, sam);
  	}
 	else {
 
-	  if (chan == ADEVFIRSTCHAN(a)) {
-	  
-	    /* Stereo, left channel. */
+	  /* Stereo, or more channels from an unusual device. */
+	  /* Silence in all but the one for this channel. */
 
-	    if (save_audio_config_p->adev[a].bits_per_sample == 8) {
-              audio_put (a, ((sam+32768) >> 8) & 0xff);
-              audio_put (a, 0);
-	    }
-	    else {
-              audio_put (a, sam & 0xff);
-              audio_put (a, (sam >> 8) & 0xff);
- 
-              audio_put (a, 0);
-              audio_put (a, 0);
-	    }
-	  }
-	  else { 
+	  int c;
+
+	  for (c = 0; c < save_audio_config_p->adev[a].num_channels; c++) {
 
-	    /* Stereo, right channel. */
-	  
-	    if (save_audio_config_p->adev[a].bits_per_sample == 8) {
-              audio_put (a, 0);
-              audio_put (a, ((sam+32768) >> 8) & 0xff);
+	    if (save_audio_config_p->adev[a].first_chan + c == chan) {
+	      put_one (a, sam);
 	    }
 	    else {
-              audio_put (a, 0);
-              audio_put (a, 0);
-
-              audio_put (a, sam & 0xff);
-              audio_put (a, (sam >> 8) & 0xff);
+	      put_silence (a);
 	    }
 	  }
 	}
@@ -660,7 +692,7 @@ void gen_tone_put_sample (int chan, int a, int sam) {
 
 void gen_tone_put_quiet_ms (int chan, int time_ms) {
 
-	int a = ACHAN2ADEV(chan);	/* device for channel. */
+	int a = save_audio_config_p->chan_adev[chan];	/* device for channel. */
 	int sam = 0;
 
 	int nsamples = (int) ((time_ms * (float)save_audio_config_p->adev[a].samples_per_sec / 1000.) + 0.5);
@@ -674,6 +706,14 @@ void gen_tone_put_quiet_ms (int chan, int time_ms) {
 }
 
 
+/* Push out the final partial buffer for the audio device of a channel. */
+
+void gen_tone_flush (int chan) {
+
+	audio_flush (save_audio_config_p->chan_adev[chan]);
+}
+
+
 /*-------------------------------------------------------------------
  *
  * Name:        main
@@ -16,4 +16,6 @@ void tone_gen_put_bit (int chan, int dat);
 
 void gen_tone_put_sample (int chan, int a, int sam);
 
-void gen_tone_put_quiet_ms (int chan, int time_ms);
\ No newline at end of file
+void gen_tone_put_quiet_ms (int chan, int time_ms);
+
+void gen_tone_flush (int chan);
\ No newline at end of file
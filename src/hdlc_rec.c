@@ -30,6 +30,7 @@
 #include "direwolf.h"
 
 #include <stdio.h>
+#include <stdlib.h>
 #include <assert.h>
 #include <string.h>
 #include <stdint.h>          // uint64_t
@@ -47,6 +48,9 @@
 #include "ptt.h"
 #include "fx25.h"
 #include "il2p.h"
+#include "rxprof.h"
+#include "rx_chain.h"
+#include "dtime_now.h"
 
 
 //#define TEST 1				/* Define for unit testing. */
@@ -69,11 +73,29 @@
  * It is possible to run multiple decoders concurrently by
  * having a separate set of state variables for each.
  *
- * Should have a reset function instead of initializations here.
+ * hdlc_rec_bit_new is called for every bit from every slicer so
+ * the state has been split in two.  The fields touched for each
+ * bit are kept together in a small structure so the slicers of a
+ * subchannel share a few cache lines.  The bulky frame buffer and
+ * the rarely used EAS state are kept off to the side.
+ *
+ * A separate array for each field would not help.  Each call works
+ * on one decoder and uses nearly all of its fields, which would then
+ * be spread over a dozen cache lines rather than one.
  */
 
 struct hdlc_state_s {
 
+	unsigned char pat_det; 		/* 8 bit pattern detector shift register. */
+					/* See below for more details. */
+
+	unsigned char oacc;		/* Accumulator for building up an octet. */
+
+	short olen;			/* Number of bits in oacc. */
+					/* When this reaches 8, oacc is copied */
+					/* to the frame buffer and olen is zeroed. */
+					/* The value of -1 is a special case meaning */
+					/* bits should not be accumulated. */
 
 	int prev_raw;			/* Keep track of previous bit so */
 					/* we can look for transitions. */
@@ -83,28 +105,20 @@ struct hdlc_state_s {
 
 	int prev_descram;		/* Previous descrambled for 9600 baud. */
 
-	unsigned char pat_det; 		/* 8 bit pattern detector shift register. */
-					/* See below for more details. */
-
 	unsigned int flag4_det;		/* Last 32 raw bits to look for 4 */
 					/* flag patterns in a row. */
 
-	unsigned char oacc;		/* Accumulator for building up an octet. */
+	unsigned char qhist[32];	/* Quality of the most recent raw bits, */
+	unsigned char qpos;		/* for FX.25 & IL2P erasure decoding. */
 
-	int olen;			/* Number of bits in oacc. */
-					/* When this reaches 8, oacc is copied */
-					/* to the frame buffer and olen is zeroed. */
-					/* The value of -1 is a special case meaning */
-					/* bits should not be accumulated. */
+	rrbb_t rrbb;			/* Handle for bit array for raw received bits. */
+};
 
-	unsigned char frame_buf[MAX_FRAME_LEN];
-					/* One frame is kept here. */
+struct hdlc_frame_s {
 
 	int frame_len;			/* Number of octets in frame_buf. */
 					/* Should be in range of 0 .. MAX_FRAME_LEN. */
 
-	rrbb_t rrbb;			/* Handle for bit array for raw received bits. */
-
 	uint64_t eas_acc;		/* Accumulate most recent 64 bits received for EAS. */
 
 	int eas_gathering;		/* Decoding in progress. */
@@ -112,13 +126,52 @@ struct hdlc_state_s {
 	int eas_plus_found;		/* "+" seen, indicating end of geographical area list. */
 
 	int eas_fields_after_plus;	/* Number of "-" characters after the "+". */
+
+	unsigned char frame_buf[MAX_FRAME_LEN];
+					/* One frame is kept here. */
 };
 
-static struct hdlc_state_s hdlc_state[MAX_RADIO_CHANS][MAX_SUBCHANS][MAX_SLICERS];
 
-static int num_subchan[MAX_RADIO_CHANS];		//TODO1.2 use ptr rather than copy.
+/*
+ * Both are allocated, as a single block for each channel, when hdlc_rec_init
+ * is called.  Only the subchannels and slicers actually configured get
+ * space rather than MAX_SUBCHANS * MAX_SLICERS.
+ *
+ * Everything for a channel is found in the rx_chain_s for the channel.
+ * State for a decoder is at state[subchan * num_slicers + slice].
+ */
+
+struct hdlc_chan_s {
+
+	int num_subchan;		//TODO1.2 use ptr rather than copy.
+
+	int num_slicers;
+
+	struct hdlc_state_s *state;
+
+	struct hdlc_frame_s *frame;
+
+	int composite_dcd[MAX_SUBCHANS+1];
 
-static int composite_dcd[MAX_RADIO_CHANS][MAX_SUBCHANS+1];
+	int seed;			/* For my_rand. */
+
+/*
+ * Version 1.8:  The transmit side used to poll hdlc_rec_data_detect_any
+ * every 10 ms.  Now it can wait for a change with dcd_wait.
+ * dcd_chain_change signals when the overall state for the channel changes.
+ */
+	dw_mutex_t dcd_mutex;
+
+#if __WIN32__
+	HANDLE dcd_wake_up_event;	/* One waiter, xmit thread for the channel. */
+#else
+	pthread_cond_t dcd_wake_up_cond;	/* Used with dcd_mutex. */
+#endif
+
+	volatile double dcd_clear_at;	/* When channel most recently went from busy to clear. */
+};
+
+#define HDLC_INDEX(C,subchan,slice) ((subchan) * (C)->num_slicers + (slice))
 
 
 /***********************************************************************************
@@ -127,68 +180,125 @@ static int composite_dcd[MAX_RADIO_CHANS][MAX_SUBCHANS+1];
  *
  * Purpose:	Call once at the beginning to initialize.
  *
- * Inputs:	None.
+ * Inputs:	pa	- Audio configuration.  demod_init must have been
+ *			  called first so the number of subchannels and
+ *			  slicers for each channel is final.
+ *
+ * Description:	This can be called again, e.g. by atest for each file.
+ *		Anything from the previous time is released first.
  *
  ***********************************************************************************/
 
-static int was_init = 0;
-
-static struct audio_s *g_audio_p;
-
-
 void hdlc_rec_init (struct audio_s *pa)
 {
-	int ch, sub, slice;
-	struct hdlc_state_s *H;
+	int ch;
 
 	//text_color_set(DW_COLOR_DEBUG);
 	//dw_printf ("hdlc_rec_init (%p) \n", pa);
 
 	assert (pa != NULL);
-	g_audio_p = pa;
 
-	memset (composite_dcd, 0, sizeof(composite_dcd));
+	for (ch = 0; ch < MAX_RADIO_CHANS; ch++) {
+	  hdlc_rec_chain_init (rx_chain_get (ch), pa);
+	}
+}
+
+
+/***********************************************************************************
+ *
+ * Name:	hdlc_rec_chain_init
+ *
+ * Purpose:	Initialize the HDLC decoders for one receive chain.
+ *
+ * Inputs:	R	- Receive chain.  R->chan selects the channel configuration.
+ *
+ *		pa	- Audio configuration, after demod_chain_init.
+ *
+ ***********************************************************************************/
+
+void hdlc_rec_chain_init (struct rx_chain_s *R, struct audio_s *pa)
+{
+	int ch = R->chan;
+	int n;
+	struct hdlc_state_s *H;
+	struct hdlc_chan_s *C = R->hdlc;
+
+	if (C == NULL) {
+	  C = R->hdlc = rx_chain_alloc (sizeof(struct hdlc_chan_s));
+	  C->seed = 1;
+	  dw_mutex_init (&(C->dcd_mutex));
+#if __WIN32__
+	  C->dcd_wake_up_event = CreateEvent (NULL, 0, 0, NULL);
+	  if (C->dcd_wake_up_event == NULL) {
+	    text_color_set(DW_COLOR_ERROR);
+	    dw_printf ("hdlc_rec_init: CreateEvent: can't create DCD wake up event, chan=%d", ch);
+	    exit (1);
+	  }
+#else
+	  dtime_cond_init (&(C->dcd_wake_up_cond));
+#endif
+	}
+	C->dcd_clear_at = 0;
+	R->audio_config = pa;
+
+/*
+ * Give back anything from a previous time.
+ */
+	for (n = 0; n < C->num_subchan * C->num_slicers; n++) {
+	  if (C->state[n].rrbb != NULL) {
+	    rrbb_delete (C->state[n].rrbb);
+	  }
+	}
+	rx_chain_free (C->state);
+	C->state = NULL;
+	C->frame = NULL;
+	C->num_subchan = 0;
+	C->num_slicers = 0;
+	memset (C->composite_dcd, 0, sizeof(C->composite_dcd));
 
-	for (ch = 0; ch < MAX_RADIO_CHANS; ch++)
-	{
+	if (pa->chan_medium[ch] == MEDIUM_RADIO) {
+	  int total;
+	  int sub, slice;
 
-	  if (pa->chan_medium[ch] == MEDIUM_RADIO) {
+	  C->num_subchan = pa->achan[ch].num_subchan;
+	  C->num_slicers = pa->achan[ch].num_slicers;
 
-	    num_subchan[ch] = pa->achan[ch].num_subchan;
+	  assert (C->num_subchan >= 1 && C->num_subchan <= MAX_SUBCHANS);
+	  assert (C->num_slicers >= 1 && C->num_slicers <= MAX_SLICERS);
 
-	    assert (num_subchan[ch] >= 1 && num_subchan[ch] <= MAX_SUBCHANS);
+	  total = C->num_subchan * C->num_slicers;
 
-	    for (sub = 0; sub < num_subchan[ch]; sub++)
-	    {
-	      for (slice = 0; slice < MAX_SLICERS; slice++) {
+/*
+ * All of the small hot structures first, then the frame buffers.
+ */
+	  C->state = rx_chain_alloc (total * (sizeof(struct hdlc_state_s) + sizeof(struct hdlc_frame_s)));
+	  C->frame = (struct hdlc_frame_s *)(C->state + total);
 
-	        H = &hdlc_state[ch][sub][slice];
+	  for (sub = 0; sub < C->num_subchan; sub++) {
+	    for (slice = 0; slice < C->num_slicers; slice++) {
 
-	        H->olen = -1;
+	      H = &C->state[HDLC_INDEX(C,sub,slice)];
 
-		// TODO: FIX13 wasteful if not needed.
-		// Should loop on number of slicers, not max.
+	      H->olen = -1;
 
-	        H->rrbb = rrbb_new(ch, sub, slice, pa->achan[ch].modem_type == MODEM_SCRAMBLE, H->lfsr, H->prev_descram);
-	      }
+	      H->rrbb = rrbb_new(R, sub, slice, pa->achan[ch].modem_type == MODEM_SCRAMBLE, H->lfsr, H->prev_descram);
 	    }
 	  }
 	}
-	hdlc_rec2_init (pa);
-	was_init = 1;
 }
 
 /* Own copy of random number generator so we can get */
 /* same predictable results on different operating systems. */
 /* TODO: Consolidate multiple copies somewhere. */
 
+/* Each channel has its own seed so threads don't step on each other. */
+
 #define MY_RAND_MAX 0x7fffffff
-static int seed = 1;
 
-static int my_rand (void) {
+static int my_rand (struct hdlc_chan_s *C) {
 	// Perform the calculation as unsigned to avoid signed overflow error.
-	seed = (int)(((unsigned)seed * 1103515245) + 12345) & MY_RAND_MAX;
-	return (seed);
+	C->seed = (int)(((unsigned)C->seed * 1103515245) + 12345) & MY_RAND_MAX;
+	return (C->seed);
 }
 
 
@@ -222,14 +332,17 @@ static int my_rand (void) {
 #define EAS_MAX_LEN 268  	// Not including preamble.  Up to 31 geographic areas.
 
 
-static void eas_rec_bit (int chan, int subchan, int slice, int raw, int future_use)
+static void eas_rec_bit (struct rx_chain_s *R, int subchan, int slice, int raw, int future_use)
 {
-	struct hdlc_state_s *H;
+	struct hdlc_frame_s *H;
 
 /*
  * Different state information for each channel / subchannel / slice.
+ * EAS uses olen as a bit counter.  The rest is in the frame part.
  */
-	H = &hdlc_state[chan][subchan][slice];
+	struct hdlc_chan_s *C = R->hdlc;
+	struct hdlc_state_s *S = &C->state[HDLC_INDEX(C,subchan,slice)];
+	H = &C->frame[HDLC_INDEX(C,subchan,slice)];
 
 	  //dw_printf ("slice %d = %d\n", slice, raw);
 
@@ -244,7 +357,7 @@ static void eas_rec_bit (int chan, int subchan, int slice, int raw, int future_u
 
 	if (H->eas_acc == PREAMBLE_ZCZC) {
 	  //dw_printf ("ZCZC\n");
-	  H->olen = 0;
+	  S->olen = 0;
 	  H->eas_gathering = 1;
 	  H->eas_plus_found = 0;
 	  H->eas_fields_after_plus = 0;
@@ -253,16 +366,16 @@ static void eas_rec_bit (int chan, int subchan, int slice, int raw, int future_u
 	}
 	else if (H->eas_acc == PREAMBLE_NNNN) {
 	  //dw_printf ("NNNN\n");
-	  H->olen = 0;
+	  S->olen = 0;
 	  H->eas_gathering = 1;
 	  strlcpy ((char*)(H->frame_buf), "NNNN", sizeof(H->frame_buf));
 	  H->frame_len = 4;
 	  done = 1;
 	}
 	else if (H->eas_gathering) {
-	  H->olen++;
-	  if (H->olen == 8) {
-	    H->olen = 0;
+	  S->olen++;
+	  if (S->olen == 8) {
+	    S->olen = 0;
 	    char ch = H->eas_acc >> 56;
 	    H->frame_buf[H->frame_len++] = ch;
 	    H->frame_buf[H->frame_len] = '\0';
@@ -308,8 +421,8 @@ static void eas_rec_bit (int chan, int subchan, int slice, int raw, int future_u
 #ifdef DEBUG_E
 	  dw_printf ("frame_buf %d = %s\n", slice, H->frame_buf);
 #endif
-	  alevel_t alevel = demod_get_audio_level (chan, subchan);
-	  multi_modem_process_rec_frame (chan, subchan, slice, H->frame_buf, H->frame_len, alevel, 0, 0);
+	  alevel_t alevel = demod_chain_audio_level (R, subchan);
+	  multi_modem_process_rec_frame (R, subchan, slice, H->frame_buf, H->frame_len, alevel, 0, 0);
 	  H->eas_gathering = 0;
 	}
 
@@ -407,7 +520,7 @@ a good modem here and providing a result when it is received.
  *
  * Purpose:	Extract HDLC frames from a stream of bits.
  *
- * Inputs:	chan	- Channel number.  
+ * Inputs:	R	- Receive chain for the radio channel.
  *
  *		subchan	- This allows multiple demodulators per channel.
  *
@@ -418,9 +531,10 @@ a good modem here and providing a result when it is received.
  *	
  *		is_scrambled - Is the data scrambled?
  *
- *		descram_state - Current descrambler state.  (not used - remove)
- *				Not so fast - plans to add new parameter.  PSK already provides it.
- *					
+ *		quality	- Confidence in the bit, 0 to 100, from the demodulator.
+ *			  It is used by FX.25 and IL2P to pick the least reliable
+ *			  bytes as erasures when Reed-Solomon decoding fails.
+ *
  *
  * Description:	This is called once for each received bit.
  *		For each valid frame, process_rec_frame()
@@ -428,37 +542,54 @@ a good modem here and providing a result when it is received.
  *
  ***********************************************************************************/
 
-void hdlc_rec_bit (int chan, int subchan, int slice, int raw, int is_scrambled, int not_used_remove)
+void hdlc_rec_bit (struct rx_chain_s *R, int subchan, int slice, int raw, int is_scrambled, int quality)
 {
-	static int64_t dummyll = 0;
-	static int dummy = 0;
-	hdlc_rec_bit_new (chan, subchan, slice, raw, is_scrambled, not_used_remove,
+	int64_t dummyll = 0;	/* Not static.  Chains could be run by different threads. */
+	int dummy = 0;
+	hdlc_rec_bit_new (R, subchan, slice, raw, is_scrambled, quality,
 		&dummyll, &dummy);
 }
 
-void hdlc_rec_bit_new (int chan, int subchan, int slice, int raw, int is_scrambled, int not_used_remove,
+static inline void rec_bit (struct rx_chain_s *R, int subchan, int slice, int raw, int is_scrambled, int quality,
+		int64_t *pll_nudge_total, int *pll_symbol_count);
+
+static inline int qmin (int a, int b)
+{
+	return (a < b ? a : b);
+}
+
+void hdlc_rec_bit_new (struct rx_chain_s *R, int subchan, int slice, int raw, int is_scrambled, int quality,
+		int64_t *pll_nudge_total, int *pll_symbol_count)
+{
+	RXPROF_BIT_ENTER (&R->prof, RXPROF_HDLC)
+	rec_bit (R, subchan, slice, raw, is_scrambled, quality, pll_nudge_total, pll_symbol_count);
+	RXPROF_BIT_LEAVE (&R->prof, RXPROF_HDLC)
+}
+
+__attribute__((always_inline))
+static inline void rec_bit (struct rx_chain_s *R, int subchan, int slice, int raw, int is_scrambled, int quality,
 		int64_t *pll_nudge_total, int *pll_symbol_count)
 {
 
 	int dbit;			/* Data bit after undoing NRZI. */
 					/* Should be only 0 or 1. */
 
-	assert (was_init == 1);
+	struct hdlc_chan_s *C = R->hdlc;
+	struct audio_s *pa = R->audio_config;
 
-	assert (chan >= 0 && chan < MAX_RADIO_CHANS);
-	assert (subchan >= 0 && subchan < MAX_SUBCHANS);
-	assert (slice >= 0 && slice < MAX_SLICERS);
+	assert (subchan >= 0 && subchan < C->num_subchan);
+	assert (slice >= 0 && slice < C->num_slicers);
 
 // -e option can be used to artificially introduce the desired
 // Bit Error Rate (BER) for testing.
 
-	if (g_audio_p->recv_ber != 0) {
-	  double r = (double)my_rand() / (double)MY_RAND_MAX;  // calculate as double to preserve all 31 bits.
-	  if (g_audio_p->recv_ber > r) {
+	if (pa->recv_ber != 0) {
+	  double r = (double)my_rand(C) / (double)MY_RAND_MAX;  // calculate as double to preserve all 31 bits.
+	  if (pa->recv_ber > r) {
 
 // FIXME
 //text_color_set(DW_COLOR_DEBUG);
-//dw_printf ("hdlc_rec_bit randomly clobber bit, ber = %.6f\n", g_audio_p->recv_ber);
+//dw_printf ("hdlc_rec_bit randomly clobber bit, ber = %.6f\n", pa->recv_ber);
 
 	    raw = ! raw;
 	  }
@@ -466,16 +597,16 @@ void hdlc_rec_bit_new (int chan, int subchan, int slice, int raw, int is_scrambl
 
 // EAS does not use HDLC.
 
-	if (g_audio_p->achan[chan].modem_type == MODEM_EAS) {
-	  eas_rec_bit (chan, subchan, slice, raw, not_used_remove);
+	if (pa->achan[R->chan].modem_type == MODEM_EAS) {
+	  eas_rec_bit (R, subchan, slice, raw, quality);
 	  return;
 	}
 
 /*
  * Different state information for each channel / subchannel / slice.
  */
-	struct hdlc_state_s *H = &hdlc_state[chan][subchan][slice];
-
+	struct hdlc_state_s *H = &C->state[HDLC_INDEX(C,subchan,slice)];
+	struct hdlc_frame_s *F = &C->frame[HDLC_INDEX(C,subchan,slice)];
 
 /*
  * Using NRZI encoding,
@@ -502,9 +633,24 @@ void hdlc_rec_bit_new (int chan, int subchan, int slice, int raw, int is_scrambl
 // After BER insertion, NRZI, and any descrambling, feed into FX.25 decoder as well.
 // Don't waste time on this if AIS.  EAS does not get this far.
 
-	if (g_audio_p->achan[chan].modem_type != MODEM_AIS) {
-	  fx25_rec_bit (chan, subchan, slice, dbit);
-	  il2p_rec_bit (chan, subchan, slice, raw);	// Note: skip NRZI.
+// A data bit depends on more than one raw bit so it can be no more reliable
+// than the worst of them:  previous bit for NRZI, and the descrambler taps.
+
+	if (pa->achan[R->chan].modem_type != MODEM_AIS) {
+	  int dq = quality;
+
+	  H->qhist[H->qpos & 31] = quality;
+	  dq = qmin (dq, H->qhist[(H->qpos - 1) & 31]);
+	  if (is_scrambled) {
+	    dq = qmin (dq, H->qhist[(H->qpos - 12) & 31]);
+	    dq = qmin (dq, H->qhist[(H->qpos - 13) & 31]);
+	    dq = qmin (dq, H->qhist[(H->qpos - 17) & 31]);
+	    dq = qmin (dq, H->qhist[(H->qpos - 18) & 31]);
+	  }
+	  H->qpos++;
+
+	  fx25_rec_bit (R, subchan, slice, dbit, dq);
+	  il2p_rec_bit (R, subchan, slice, raw, quality);	// Note: skip NRZI.
 	}
 
 /*
@@ -521,7 +667,7 @@ void hdlc_rec_bit_new (int chan, int subchan, int slice, int raw, int is_scrambl
 	  H->flag4_det |= 0x80000000;
 	}
 
-	rrbb_append_bit (H->rrbb, raw);
+	rrbb_append_bit (H->rrbb, raw, quality);
 
 	if (H->pat_det == 0x7e) {
 
@@ -544,15 +690,15 @@ void hdlc_rec_bit_new (int chan, int subchan, int slice, int raw, int is_scrambl
 	  text_color_set(DW_COLOR_DEBUG);
 	  dw_printf ("\nfound flag, olen = %d, frame_len = %d\n", olen, frame_len);
 #endif
-	  if (H->olen == 7 && H->frame_len >= MIN_FRAME_LEN) {
+	  if (H->olen == 7 && F->frame_len >= MIN_FRAME_LEN) {
 
 	    unsigned short actual_fcs, expected_fcs;
 
 #if TEST
 	    int j;
-	    dw_printf ("TRADITIONAL: frame len = %d\n", H->frame_len);
-	    for (j=0; j<H->frame_len; j++) {
-	      dw_printf ("  %02x", H->frame_buf[j]);
+	    dw_printf ("TRADITIONAL: frame len = %d\n", F->frame_len);
+	    for (j=0; j<F->frame_len; j++) {
+	      dw_printf ("  %02x", F->frame_buf[j]);
 	    }
 	    dw_printf ("\n");
 
@@ -566,14 +712,14 @@ void hdlc_rec_bit_new (int chan, int subchan, int slice, int raw, int is_scrambl
 	    /* I think making a second pass over it and comparing is */
 	    /* easier to understand. */
 
-	    actual_fcs = H->frame_buf[H->frame_len-2] | (H->frame_buf[H->frame_len-1] << 8);
+	    actual_fcs = F->frame_buf[F->frame_len-2] | (F->frame_buf[F->frame_len-1] << 8);
 
-	    expected_fcs = fcs_calc (H->frame_buf, H->frame_len - 2);
+	    expected_fcs = fcs_calc (F->frame_buf, F->frame_len - 2);
 
 	    if (actual_fcs == expected_fcs) {
-	      alevel_t alevel = demod_get_audio_level (chan, subchan);
+	      alevel_t alevel = demod_chain_audio_level (R, subchan);
 
-	      multi_modem_process_rec_frame (chan, subchan, slice, H->frame_buf, H->frame_len - 2, alevel, RETRY_NONE, 0);   /* len-2 to remove FCS. */
+	      multi_modem_process_rec_frame (R, subchan, slice, F->frame_buf, F->frame_len - 2, alevel, RETRY_NONE, 0);   /* len-2 to remove FCS. */
 	    }
 	    else {
 
@@ -593,7 +739,7 @@ void hdlc_rec_bit_new (int chan, int subchan, int slice, int raw, int is_scrambl
 
 #if TEST
 	  text_color_set(DW_COLOR_DEBUG);
-	  dw_printf ("\nfound flag, channel %d.%d, %d bits in frame\n", chan, subchan, rrbb_get_len(H->rrbb) - 1);
+	  dw_printf ("\nfound flag, channel %d.%d, %d bits in frame\n", R->chan, subchan, rrbb_get_len(H->rrbb) - 1);
 #endif
 	  if (rrbb_get_len(H->rrbb) >= MIN_FRAME_LEN * 8) {
 
@@ -620,14 +766,17 @@ void hdlc_rec_bit_new (int chan, int subchan, int slice, int raw, int is_scrambl
 	    }
 	    rrbb_set_speed_error (H->rrbb, speed_error);
 
-	    alevel_t alevel = demod_get_audio_level (chan, subchan);
+	    alevel_t alevel = demod_chain_audio_level (R, subchan);
 
 	    rrbb_set_audio_level (H->rrbb, alevel);
+	    rx_chain_frame_end (R);
+	    RXPROF_FRAME_ENTER (&R->prof, RXPROF_FIX_BITS)
 	    hdlc_rec2_block (H->rrbb);
+	    RXPROF_FRAME_LEAVE (&R->prof, RXPROF_FIX_BITS)
 	    	/* Now owned by someone else who will free it. */
 	    H->rrbb = NULL;
 
-	    H->rrbb = rrbb_new (chan, subchan, slice, is_scrambled, H->lfsr, H->prev_descram); /* Allocate a new one. */
+	    H->rrbb = rrbb_new (R, subchan, slice, is_scrambled, H->lfsr, H->prev_descram); /* Allocate a new one. */
 	  }
 	  else {
 
@@ -638,10 +787,10 @@ void hdlc_rec_bit_new (int chan, int subchan, int slice, int raw, int is_scrambl
 	  }
 
 	  H->olen = 0;		/* Allow accumulation of octets. */
-	  H->frame_len = 0;
+	  F->frame_len = 0;
 
 
-	  rrbb_append_bit (H->rrbb, H->prev_raw); /* Last bit of flag.  Needed to get first data bit. */
+	  rrbb_append_bit (H->rrbb, H->prev_raw, 100); /* Last bit of flag.  Needed to get first data bit. */
 						/* Now that we are saving other initial state information, */
 						/* it would be sensible to do the same for this instead */
 						/* of lumping it in with the frame data bits. */
@@ -687,7 +836,7 @@ void hdlc_rec_bit_new (int chan, int subchan, int slice, int raw, int is_scrambl
 #endif
 
 	  H->olen = -1;		/* Stop accumulating octets. */
-	  H->frame_len = 0;	/* Discard anything in progress. */
+	  F->frame_len = 0;	/* Discard anything in progress. */
 
 	  rrbb_clear (H->rrbb, is_scrambled, H->lfsr, H->prev_descram); 
 
@@ -721,10 +870,16 @@ void hdlc_rec_bit_new (int chan, int subchan, int slice, int raw, int is_scrambl
 	    if (H->olen == 8) {
 	      H->olen = 0;
 
-	      if (H->frame_len < MAX_FRAME_LEN) {
-		H->frame_buf[H->frame_len] = H->oacc;
-		H->frame_len++;
+/*
+ * The new way decodes from the rrbb so the octets are only needed by
+ * the old way.  Leaving the frame buffer alone keeps it out of the cache.
+ */
+#if OLD_WAY
+	      if (F->frame_len < MAX_FRAME_LEN) {
+		F->frame_buf[F->frame_len] = H->oacc;
+		F->frame_len++;
 	      }
+#endif
 	    }
 	  }
 	}
@@ -738,11 +893,14 @@ void hdlc_rec_bit_new (int chan, int subchan, int slice, int raw, int is_scrambl
 /*-------------------------------------------------------------------
  *
  * Name:        dcd_change
+ *		dcd_chain_change
  *
  * Purpose:     Combine DCD states of all subchannels/ into an overall
  *		state for the channel.
  *
- * Inputs:	chan	
+ * Inputs:	chan	- Radio channel, for the chain in rx_chain[].
+ *
+ *		R	- Receive chain.
  *
  *		subchan		0 to MAX_SUBCHANS-1 for HDLC.
  *				SPECIAL CASE --> MAX_SUBCHANS for DTMF decoder.
@@ -759,13 +917,38 @@ void hdlc_rec_bit_new (int chan, int subchan, int slice, int raw, int is_scrambl
  * version 1.3:	Add DTMF detection into the final result.
  *		This is now called from dtmf.c too.
  *
+ * Version 1.8:	Wake up anyone waiting in dcd_wait.
+ *		The demodulators use dcd_chain_change with their own chain.
+ *		Only the chain in rx_chain[] for the channel drives the
+ *		DCD output and holds off transmitting.
+ *
  *--------------------------------------------------------------------*/
 
 void dcd_change (int chan, int subchan, int slice, int state)
 {
+	assert (chan >= 0 && chan < MAX_RADIO_CHANS);
+
+	dcd_chain_change (rx_chain_get(chan), subchan, slice, state);
+}
+
+static int chain_dcd_any (struct hdlc_chan_s *C)
+{
+	int sc;
+
+	for (sc = 0; sc < C->num_subchan; sc++) {
+	  if (C->composite_dcd[sc] != 0)
+	    return (1);
+	}
+	return (0);
+}
+
+void dcd_chain_change (struct rx_chain_s *R, int subchan, int slice, int state)
+{
+	struct hdlc_chan_s *C = R->hdlc;
+	int chan = R->chan;
+	int mine = R == rx_chain[chan];		/* Not one from rx_chain_create. */
 	int old, new;
 
-	assert (chan >= 0 && chan < MAX_RADIO_CHANS);
 	assert (subchan >= 0 && subchan <= MAX_SUBCHANS);
 	assert (slice >= 0 && slice < MAX_SLICERS);
 	assert (state == 0 || state == 1);
@@ -775,23 +958,119 @@ void dcd_change (int chan, int subchan, int slice, int state)
 	dw_printf ("DCD %d.%d.%d = %d \n", chan, subchan, slice, state);
 #endif
 
-	old = hdlc_rec_data_detect_any(chan);
+	old = mine ? hdlc_rec_data_detect_any(chan) : chain_dcd_any(C);
 
 	if (state) {
-	  composite_dcd[chan][subchan] |= (1 << slice);
+	  C->composite_dcd[subchan] |= (1 << slice);
 	}
 	else {
-	  composite_dcd[chan][subchan] &=  ~ (1 << slice);
+	  C->composite_dcd[subchan] &=  ~ (1 << slice);
 	}
 
-	new = hdlc_rec_data_detect_any(chan);
+	new = mine ? hdlc_rec_data_detect_any(chan) : chain_dcd_any(C);
 
-	if (new != old) {
+	if (new != old && mine) {
 	  ptt_set (OCTYPE_DCD, chan, new);
+
+	  dw_mutex_lock (&(C->dcd_mutex));
+	  if ( ! new) {
+	    C->dcd_clear_at = dtime_monotonic();
+	  }
+#if __WIN32__
+	  dw_mutex_unlock (&(C->dcd_mutex));
+	  SetEvent (C->dcd_wake_up_event);
+#else
+	  pthread_cond_broadcast (&(C->dcd_wake_up_cond));
+	  dw_mutex_unlock (&(C->dcd_mutex));
+#endif
 	}
 }
 
 
+/*-------------------------------------------------------------------
+ *
+ * Name:        dcd_wait
+ *
+ * Purpose:     Wait for the radio channel to become busy or clear.
+ *
+ * Inputs:	chan	- Radio channel.
+ *
+ *		busy	- Current state that we are waiting to change.
+ *			  1 to wait for the channel to become clear.
+ *			  0 to wait for the channel to become busy.
+ *
+ *		until	- Give up at this time, from dtime_monotonic().
+ *
+ * Outputs:	clear_at - If not NULL, time when channel most recently
+ *			  went from busy to clear.  0 if it has not been busy.
+ *
+ * Returns:	State when finished, same as hdlc_rec_data_detect_any.
+ *		Same as busy means the time limit was reached.
+ *
+ * Description:	Returns as soon as dcd_change sees the state change,
+ *		rather than at the next check of a polling loop.
+ *
+ *		The transmit inhibit input is a GPIO pin that must be
+ *		read to find its state.  If configured, we still have
+ *		to look every 10 ms.
+ *
+ *--------------------------------------------------------------------*/
+
+#define TXINH_CHECK_EVERY_SEC 0.01
+
+int dcd_wait (int chan, int busy, double until, double *clear_at)
+{
+	int state;
+	int txinh;
+	double last_busy = 0;	/* Most recent time we saw it busy. */
+
+	assert (chan >= 0 && chan < MAX_RADIO_CHANS);
+
+	struct rx_chain_s *R = rx_chain_get(chan);
+	struct hdlc_chan_s *C = R->hdlc;
+
+	txinh = R->audio_config->achan[chan].ictrl[ICTYPE_TXINH].method != PTT_METHOD_NONE;
+
+	dw_mutex_lock (&(C->dcd_mutex));
+
+	while ((state = hdlc_rec_data_detect_any(chan)) == busy) {
+	  double now = dtime_monotonic();
+	  double t = until;
+
+	  if (busy) {
+	    last_busy = now;
+	  }
+	  if (now >= until) {
+	    break;
+	  }
+	  if (txinh && now + TXINH_CHECK_EVERY_SEC < t) {
+	    t = now + TXINH_CHECK_EVERY_SEC;
+	  }
+
+#if __WIN32__
+	  dw_mutex_unlock (&(C->dcd_mutex));
+	  WaitForSingleObject (C->dcd_wake_up_event, (DWORD)((t - now) * 1000) + 1);
+	  dw_mutex_lock (&(C->dcd_mutex));
+#else
+	  dtime_cond_timedwait (&(C->dcd_wake_up_cond), &(C->dcd_mutex), t);
+#endif
+	}
+
+	if (clear_at != NULL) {
+	  /* Transmit inhibit changes are not reported by dcd_change. */
+	  *clear_at = C->dcd_clear_at;
+	  if (*clear_at < last_busy) {
+	    *clear_at = last_busy;
+	  }
+	}
+
+	dw_mutex_unlock (&(C->dcd_mutex));
+
+	return (state);
+
+} /* end dcd_wait */
+
+
 /*-------------------------------------------------------------------
  *
  * Name:        hdlc_rec_data_detect_any
@@ -820,18 +1099,19 @@ void dcd_change (int chan, int subchan, int slice, int state)
  *
  * Version 1.3: New option for input signal to inhibit transmit.
  *
+ * Version 1.8:	hdlc_rec_chain_data_detect_any is for a chain which
+ *		might not be the one in rx_chain[].  It has only the
+ *		decoders, not the transmit inhibit input.
+ *
  *--------------------------------------------------------------------*/
 
 int hdlc_rec_data_detect_any (int chan)
 {
 
-	int sc;
 	assert (chan >= 0 && chan < MAX_RADIO_CHANS);
 
-	for (sc = 0; sc < num_subchan[chan]; sc++) {
-	  if (composite_dcd[chan][sc] != 0)
-	    return (1);
-	}
+	if (chain_dcd_any(rx_chain[chan]->hdlc))
+	  return (1);
 
 	if (get_input(ICTYPE_TXINH, chan) == 1) return (1);
 
@@ -839,6 +1119,11 @@ int hdlc_rec_data_detect_any (int chan)
 
 } /* end hdlc_rec_data_detect_any */
 
+int hdlc_rec_chain_data_detect_any (struct rx_chain_s *R)
+{
+	return (chain_dcd_any(R->hdlc));
+}
+
 /* end hdlc_rec.c */
 
 
@@ -7,14 +7,17 @@
 #include <stdint.h>          // int64_t
 
 #include "audio.h"
+#include "rx_chain.h"
 
 
 void hdlc_rec_init (struct audio_s *pa);
 
+void hdlc_rec_chain_init (struct rx_chain_s *R, struct audio_s *pa);
+
 // TODO: change all to _new.
-void hdlc_rec_bit (int chan, int subchan, int slice, int raw, int is_scrambled, int descram_state);
+void hdlc_rec_bit (struct rx_chain_s *R, int subchan, int slice, int raw, int is_scrambled, int descram_state);
 
-void hdlc_rec_bit_new (int chan, int subchan, int slice, int raw, int is_scrambled, int descram_state,
+void hdlc_rec_bit_new (struct rx_chain_s *R, int subchan, int slice, int raw, int is_scrambled, int descram_state,
 			int64_t *pll_nudge_total, int *pll_nudge_count);
 
 /* Provided elsewhere to process a complete frame. */
@@ -32,4 +35,10 @@ int hdlc_rec_gathering (int chan, int subchan, int slice);
 
 void dcd_change (int chan, int subchan, int slice, int state);
 
+void dcd_chain_change (struct rx_chain_s *R, int subchan, int slice, int state);
+
 int hdlc_rec_data_detect_any (int chan);
+
+int hdlc_rec_chain_data_detect_any (struct rx_chain_s *R);
+
+int dcd_wait (int chan, int busy, double until, double *clear_at);
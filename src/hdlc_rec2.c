@@ -88,6 +88,7 @@
 #include "direwolf.h"
 
 #include <stdio.h>
+#include <stdlib.h>
 #include <assert.h>
 #include <ctype.h>
 #include <string.h>
@@ -110,9 +111,10 @@
 //#define DEBUGx 1
 //#define DEBUG_LATER 1
 
-/* Audio configuration. */
-
-static struct audio_s          *save_audio_config_p;
+/*
+ * The audio configuration for the channel comes from the receive chain
+ * the block was collected on.  See rrbb_get_chain.
+ */
 
 
 /* 
@@ -166,49 +168,13 @@ struct hdlc_state2_s {
 };
 
 
-static int try_decode (rrbb_t block, int chan, int subchan, int slice, alevel_t alevel, retry_conf_t retry_conf, int passall);
+static int try_decode (rrbb_t block, struct rx_chain_s *R, int subchan, int slice, alevel_t alevel, retry_conf_t retry_conf, int passall);
 
-static int try_to_fix_quick_now (rrbb_t block, int chan, int subchan, int slice, alevel_t alevel);
+static int try_to_fix_quick_now (rrbb_t block, struct rx_chain_s *R, int subchan, int slice, alevel_t alevel);
 
 static int sanity_check (unsigned char *buf, int blen, retry_t bits_flipped, enum sanity_e sanity_test);
 
 
-/***********************************************************************************
- *
- * Name:	hdlc_rec2_init
- *
- * Purpose:	Initialization.   
- *
- * Inputs:	p_audio_config	 - Pointer to configuration settings.
- *				   This is what we care about for each channel.
- *
- *	   			enum retry_e fix_bits;	
- *					Level of effort to recover from 
- *					a bad FCS on the frame. 
- *					0 = no effort 
- *					1 = try inverting a single bit
- *					2... = more techniques... 
- *
- *	    			enum sanity_e sanity_test;
- *					Sanity test to apply when finding a good 
- *					CRC after changing one or more bits. 
- *					Must look like APRS, AX.25, or anything. 
- *
- *	    			int passall;		
- *					Allow thru even with bad CRC after exhausting
- *					all fixup attempts.
- *
- * Description:	Save pointer to configuration for later use.
- *
- ***********************************************************************************/
-
-void hdlc_rec2_init (struct audio_s *p_audio_config)
-{
-	save_audio_config_p = p_audio_config;
-}
-
-
-
 /***********************************************************************************
  *
  * Name:	hdlc_rec2_block
@@ -235,12 +201,12 @@ void hdlc_rec2_init (struct audio_s *p_audio_config)
 
 void hdlc_rec2_block (rrbb_t block)
 {
-	int chan = rrbb_get_chan(block);
+	struct rx_chain_s *R = rrbb_get_chain(block);
 	int subchan = rrbb_get_subchan(block);
 	int slice = rrbb_get_slice(block);
 	alevel_t alevel = rrbb_get_audio_level(block);
-	retry_t fix_bits = save_audio_config_p->achan[chan].fix_bits;
-	int passall = save_audio_config_p->achan[chan].passall;
+	retry_t fix_bits = R->audio_config->achan[R->chan].fix_bits;
+	int passall = R->audio_config->achan[R->chan].passall;
 	int ok;
 
 #if DEBUGx
@@ -264,7 +230,7 @@ void hdlc_rec2_block (rrbb_t block)
 	retry_cfg.u_bits.contig.nr_bits = 0;
 	retry_cfg.u_bits.contig.bit_idx = 0;
 
-	ok = try_decode (block, chan, subchan, slice, alevel, retry_cfg, passall & (fix_bits == RETRY_NONE));
+	ok = try_decode (block, R, subchan, slice, alevel, retry_cfg, passall & (fix_bits == RETRY_NONE));
 	if (ok) {
 #if DEBUG
 	  text_color_set(DW_COLOR_INFO);
@@ -278,7 +244,7 @@ void hdlc_rec2_block (rrbb_t block)
  * Not successful with frame in original form.
  * See if we can "fix" it.
  */
-	if (try_to_fix_quick_now (block, chan, subchan, slice, alevel)) {
+	if (try_to_fix_quick_now (block, R, subchan, slice, alevel)) {
 	  rrbb_delete (block);
 	  return;
 	}
@@ -288,7 +254,7 @@ void hdlc_rec2_block (rrbb_t block)
 	  /* Exhausted all desired fix up attempts. */
 	  /* Let thru even with bad CRC.  Of course, it still */
 	  /* needs to be a minimum number of whole octets. */
-	  ok = try_decode (block, chan, subchan, slice, alevel, retry_cfg, 1);
+	  ok = try_decode (block, R, subchan, slice, alevel, retry_cfg, 1);
 	}
 
 	rrbb_delete (block);
@@ -296,6 +262,59 @@ void hdlc_rec2_block (rrbb_t block)
 } /* end hdlc_rec2_block */
 
 
+/*
+ * Order in which to try changing bits, least reliable first.
+ *
+ * Each entry is the sum of the bit qualities in the upper part and
+ * the starting bit index in the lower 16 bits so a plain sort of
+ * integers does the job.  Equal qualities stay in order of position,
+ * which is the same as before when quality is not known.
+ */
+
+static int cmp_int (const void *a, const void *b)
+{
+	return (*(const int *)a - *(const int *)b);
+}
+
+static int order_by_quality (rrbb_t block, int nr_bits, int *order)
+{
+	int len = rrbb_get_len(block);
+	int n = 0;
+
+	for (int i = 0; i <= len - nr_bits; i++) {
+	  int q = 0;
+	  for (int k = 0; k < nr_bits; k++) {
+	    q += rrbb_get_quality (block, i + k);
+	  }
+	  order[n++] = (q << 16) | i;
+	}
+	qsort (order, n, sizeof(int), cmp_int);
+	for (int i = 0; i < n; i++) {
+	  order[i] &= 0xffff;
+	}
+	return (n);
+}
+
+/*
+ * Number of least reliable bits considered for two separated bits.
+ * All pairs of them are tried.  Taking a quarter of the bits cuts the
+ * work to about 1/16 of trying every pair, for any frame size.
+ * A fixed number was found to lose a frame from the 1200 baud test
+ * recording where the second bad bit was 115th of 619 bits.
+ * At least CHASE_BITS_MIN are used so short frames still get a thorough search.
+ */
+
+#define CHASE_BITS_MIN 40
+
+static inline int chase_bits (int nbits)
+{
+	int k = nbits / 4;
+
+	if (k < CHASE_BITS_MIN) k = CHASE_BITS_MIN;
+	return (k);
+}
+
+
 /***********************************************************************************
  *
  * Name:	try_to_fix_quick_now
@@ -331,17 +350,19 @@ void hdlc_rec2_block (rrbb_t block)
  *		The separated bit case is now handled immediately instead of
  *		being thrown in a queue for later processing.
  *
+ * Version 1.8:	Bits are tried in order of confidence from the demodulator,
+ *		least reliable first, so the right one is usually found quickly.
+ *		Two separated bits are limited to pairs of the least reliable.
+ *
  ***********************************************************************************/
 
-static int try_to_fix_quick_now (rrbb_t block, int chan, int subchan, int slice, alevel_t alevel)
+static int try_to_fix_quick_now (rrbb_t block, struct rx_chain_s *R, int subchan, int slice, alevel_t alevel)
 {
 	int ok;
-	int len, i;
-	retry_t fix_bits = save_audio_config_p->achan[chan].fix_bits;
-	//int passall = save_audio_config_p->achan[chan].passall;
+	int n, i;
+	retry_t fix_bits = R->audio_config->achan[R->chan].fix_bits;
+	int order[MAX_NUM_BITS];
 
-
-	len = rrbb_get_len(block);
 	/* Prepare the retry configuration */
         retry_conf_t retry_cfg;
 
@@ -363,14 +384,15 @@ static int try_to_fix_quick_now (rrbb_t block, int chan, int subchan, int slice,
 	retry_cfg.retry = RETRY_INVERT_SINGLE;
 	retry_cfg.u_bits.contig.nr_bits = 1;
 
-	for (i=0; i<len; i++) {
+	n = order_by_quality (block, 1, order);
+	for (i=0; i<n; i++) {
 	  /* Set the index of the bit to swap */
-	  retry_cfg.u_bits.contig.bit_idx = i;
-	  ok = try_decode (block, chan, subchan, slice, alevel, retry_cfg, 0);
+	  retry_cfg.u_bits.contig.bit_idx = order[i];
+	  ok = try_decode (block, R, subchan, slice, alevel, retry_cfg, 0);
 	  if (ok) {
 #if DEBUG
 	    text_color_set(DW_COLOR_ERROR);
-	    dw_printf ("*** Success by flipping SINGLE bit %d of %d ***\n", i, len);
+	    dw_printf ("*** Success by flipping SINGLE bit %d of %d, try %d ***\n", order[i], rrbb_get_len(block), i + 1);
 #endif
 	    return 1;
 	  }
@@ -386,14 +408,14 @@ static int try_to_fix_quick_now (rrbb_t block, int chan, int subchan, int slice,
 	retry_cfg.retry = RETRY_INVERT_DOUBLE;
 	retry_cfg.u_bits.contig.nr_bits = 2;
 
-
-	for (i=0; i<len-1; i++) {
-	  retry_cfg.u_bits.contig.bit_idx = i;
-	  ok = try_decode (block, chan, subchan, slice, alevel, retry_cfg, 0);
+	n = order_by_quality (block, 2, order);
+	for (i=0; i<n; i++) {
+	  retry_cfg.u_bits.contig.bit_idx = order[i];
+	  ok = try_decode (block, R, subchan, slice, alevel, retry_cfg, 0);
 	  if (ok) {
 #if DEBUG
 	    text_color_set(DW_COLOR_ERROR);
-	    dw_printf ("*** Success by flipping DOUBLE bit %d of %d ***\n", i, len);
+	    dw_printf ("*** Success by flipping DOUBLE bit %d of %d, try %d ***\n", order[i], rrbb_get_len(block), i + 1);
 #endif
 	    return 1;
 	  }
@@ -409,13 +431,14 @@ static int try_to_fix_quick_now (rrbb_t block, int chan, int subchan, int slice,
 	retry_cfg.retry = RETRY_INVERT_TRIPLE;
 	retry_cfg.u_bits.contig.nr_bits = 3;
 
-	for (i=0; i<len-2; i++) {
-	  retry_cfg.u_bits.contig.bit_idx = i;
-	  ok = try_decode (block, chan, subchan, slice, alevel, retry_cfg, 0);
+	n = order_by_quality (block, 3, order);
+	for (i=0; i<n; i++) {
+	  retry_cfg.u_bits.contig.bit_idx = order[i];
+	  ok = try_decode (block, R, subchan, slice, alevel, retry_cfg, 0);
 	  if (ok) {
 #if DEBUG
 	    text_color_set(DW_COLOR_ERROR);
-	    dw_printf ("*** Success by flipping TRIPLE bit %d of %d ***\n", i, len);
+	    dw_printf ("*** Success by flipping TRIPLE bit %d of %d, try %d ***\n", order[i], rrbb_get_len(block), i + 1);
 #endif
 	    return 1;
 	  }
@@ -424,9 +447,10 @@ static int try_to_fix_quick_now (rrbb_t block, int chan, int subchan, int slice,
 
 /*
  * Two  non-adjacent ("separated") single bits.
- * It chews up a lot of CPU time.  Usual test takes 4 times longer to run.
  *
- * Processing time is order N squared so time goes up rapidly with larger frames.
+ * Trying every pair is order N squared and chews up a lot of CPU time.
+ * Now only a quarter of the bits, the least reliable, are considered, pairs
+ * with the least reliable bits first.  (Similar to Chase decoding.)
  */
 	if (fix_bits < RETRY_INVERT_TWO_SEP) {
 	  return 0;
@@ -439,28 +463,25 @@ static int try_to_fix_quick_now (rrbb_t block, int chan, int subchan, int slice,
 
 #ifdef DEBUG_LATER
 	tstart = dtime_monotonic();
-	dw_printf ("*** Try flipping TWO SEPARATED BITS %d bits\n", len);
+	dw_printf ("*** Try flipping TWO SEPARATED BITS %d bits\n", rrbb_get_len(block));
 #endif
-	len = rrbb_get_len(block);
-	for (i=0; i<len-2; i++) {
-	  retry_cfg.u_bits.sep.bit_idx_a = i;
-	  int j;
+	n = order_by_quality (block, 1, order);
+	if (n > chase_bits (n)) n = chase_bits (n);
 
-	  ok = 0;
-	  for (j=i+2; j<len; j++) {
-	    retry_cfg.u_bits.sep.bit_idx_b = j;
-	    ok = try_decode (block, chan, subchan, slice, alevel, retry_cfg, 0);
-	    if (ok) {
-	      break;
-	    }
+	for (int j=1; j<n; j++) {
+	  for (i=0; i<j; i++) {
+	    if (abs(order[i] - order[j]) < 2) continue;		// Adjacent was done above.
 
-	  }	  
-	  if (ok) {
+	    retry_cfg.u_bits.sep.bit_idx_a = order[i];
+	    retry_cfg.u_bits.sep.bit_idx_b = order[j];
+	    ok = try_decode (block, R, subchan, slice, alevel, retry_cfg, 0);
+	    if (ok) {
 #if DEBUG
-	    text_color_set(DW_COLOR_ERROR);
-	    dw_printf ("*** Success by flipping TWO SEPARATED bits %d and %d of %d \n", i, j, len);
+	      text_color_set(DW_COLOR_ERROR);
+	      dw_printf ("*** Success by flipping TWO SEPARATED bits %d and %d of %d \n", order[i], order[j], rrbb_get_len(block));
 #endif
-	    return (1);
+	      return (1);
+	    }
 	  }
 	}
 
@@ -468,7 +489,6 @@ static int try_to_fix_quick_now (rrbb_t block, int chan, int subchan, int slice,
 }
 
 
-
 // TODO:  Remove this.  but first figure out what to do in atest.c
 
 
@@ -477,8 +497,8 @@ int hdlc_rec2_try_to_fix_later (rrbb_t block, int chan, int subchan, int slice,
 {
 	int ok;
 	//int len;
-	//retry_t fix_bits = save_audio_config_p->achan[chan].fix_bits;
-	int passall = save_audio_config_p->achan[chan].passall;
+	struct rx_chain_s *R = rrbb_get_chain(block);
+	int passall = R->audio_config->achan[R->chan].passall;
 #if DEBUG_LATER
 	double tstart, tend;
 #endif
@@ -501,7 +521,7 @@ int hdlc_rec2_try_to_fix_later (rrbb_t block, int chan, int subchan, int slice,
 	  retry_cfg.retry = RETRY_NONE;
 	  retry_cfg.u_bits.contig.nr_bits = 0;
 	  retry_cfg.u_bits.contig.bit_idx = 0;
-	  ok = try_decode (block, chan, subchan, slice, alevel, retry_cfg, passall);
+	  ok = try_decode (block, R, subchan, slice, alevel, retry_cfg, passall);
 	  return (ok);
 	}
 
@@ -550,7 +570,7 @@ inline static char is_sep_bit_modified(int bit_idx, retry_conf_t retry_conf) {
  *
  * Inputs:	block		- Bit string that was collected between "flag" patterns.
  *
- *		chan, subchan	- where it came from.
+ *		R, subchan	- Receive chain and modem where it came from.
  *
  *		alevel		- audio level for later reporting.
  *
@@ -585,7 +605,7 @@ inline static char is_sep_bit_modified(int bit_idx, retry_conf_t retry_conf) {
  *
  ***********************************************************************************/
 
-static int try_decode (rrbb_t block, int chan, int subchan, int slice, alevel_t alevel, retry_conf_t retry_conf, int passall)
+static int try_decode (rrbb_t block, struct rx_chain_s *R, int subchan, int slice, alevel_t alevel, retry_conf_t retry_conf, int passall)
 {
 	struct hdlc_state2_s H2;
 	int blen;			/* Block length in bits. */
@@ -769,11 +789,11 @@ static int try_decode (rrbb_t block, int chan, int subchan, int slice, alevel_t
 
 	  expected_fcs = fcs_calc (H2.frame_buf, H2.frame_len - 2);
 
-	  if (actual_fcs == expected_fcs && save_audio_config_p->achan[chan].modem_type == MODEM_AIS) {
+	  if (actual_fcs == expected_fcs && R->audio_config->achan[R->chan].modem_type == MODEM_AIS) {
 
 	      // Sanity check for AIS.
 	      if (ais_check_length((H2.frame_buf[0] >> 2) & 0x3f, H2.frame_len - 2) == 0) {
-	          multi_modem_process_rec_frame (chan, subchan, slice, H2.frame_buf, H2.frame_len - 2, alevel, retry_conf.retry, 0);   /* len-2 to remove FCS. */
+	          multi_modem_process_rec_frame (R, subchan, slice, H2.frame_buf, H2.frame_len - 2, alevel, retry_conf.retry, 0);   /* len-2 to remove FCS. */
 	          return 1;		/* success */
 	      }
 	      else {
@@ -781,15 +801,15 @@ static int try_decode (rrbb_t block, int chan, int subchan, int slice, alevel_t
 	      }
 	  }
 	  else if (actual_fcs == expected_fcs &&
-			sanity_check (H2.frame_buf, H2.frame_len - 2, retry_conf.retry, save_audio_config_p->achan[chan].sanity_test)) {
+			sanity_check (H2.frame_buf, H2.frame_len - 2, retry_conf.retry, R->audio_config->achan[R->chan].sanity_test)) {
 
-	      // TODO: Shouldn't be necessary to pass chan, subchan, alevel into
+	      // TODO: Shouldn't be necessary to pass chain, subchan, alevel into
 	      // try_decode because we can obtain them from block.
 	      // Let's make sure that assumption is good...
 
-	      assert (rrbb_get_chan(block) == chan);
+	      assert (rrbb_get_chain(block) == R);
 	      assert (rrbb_get_subchan(block) == subchan);
-	      multi_modem_process_rec_frame (chan, subchan, slice, H2.frame_buf, H2.frame_len - 2, alevel, retry_conf.retry, 0);   /* len-2 to remove FCS. */
+	      multi_modem_process_rec_frame (R, subchan, slice, H2.frame_buf, H2.frame_len - 2, alevel, retry_conf.retry, 0);   /* len-2 to remove FCS. */
 	      return 1;		/* success */
 
 	  } else if (passall) {
@@ -798,7 +818,7 @@ static int try_decode (rrbb_t block, int chan, int subchan, int slice, alevel_t
 	      //text_color_set(DW_COLOR_ERROR);
 	      //dw_printf ("ATTEMPTING PASSALL PROCESSING\n");
   
-	      multi_modem_process_rec_frame (chan, subchan, slice, H2.frame_buf, H2.frame_len - 2, alevel, RETRY_MAX, 0);   /* len-2 to remove FCS. */
+	      multi_modem_process_rec_frame (R, subchan, slice, H2.frame_buf, H2.frame_len - 2, alevel, RETRY_MAX, 0);   /* len-2 to remove FCS. */
 	      return 1;		/* success */
 	    }
 	    else {
@@ -211,7 +211,7 @@ int layer2_preamble_postamble (int chan, int nbytes, int finish, struct audio_s
 /* Push out the final partial buffer! */
 
 	if (finish) {
-	  audio_flush(ACHAN2ADEV(chan));
+	  gen_tone_flush (chan);
 	}
 
 	return (number_of_bits_sent[chan]);
@@ -360,7 +360,7 @@ int eas_send (int chan, unsigned char *str, int repeat, int txdelay, int txtail)
 
 	gen_tone_put_quiet_ms (chan, txtail);
 
-	audio_flush(ACHAN2ADEV(chan));
+	gen_tone_flush (chan);
 
 	int elapsed = txdelay + (int) (bytes_sent * 8 * 1.92) + (gaps_sent * gap) + txtail;
 
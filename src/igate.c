@@ -116,11 +116,13 @@ static unsigned __stdcall connnect_thread_aprs (void *arg);
 static unsigned __stdcall connnect_thread_cwop (void *arg);
 static unsigned __stdcall igate_recv_thread (void *arg);
 static unsigned __stdcall satgate_delay_thread (void *arg);
+static unsigned __stdcall uplink_thread (void *arg);
 #else
 static void * connnect_thread_aprs (void *arg);
 static void * connnect_thread_cwop (void *arg);
 static void * igate_recv_thread (void *arg);
 static void * satgate_delay_thread (void *arg);
+static void * uplink_thread (void *arg);
 #endif
 
 
@@ -133,12 +135,71 @@ static void * satgate_delay_thread (void *arg);
 
 static dw_mutex_t dp_mutex;				/* Critical section for delayed packet queue. */
 static packet_t dp_queue_head;
+static packet_t dp_queue_tail;				/* All have the same delay so new packets */
+							/* go at the end and the head is due first. */
+static int dp_queue_depth;				/* Number of packets waiting. */
+static int dp_queue_max_depth;				/* Most ever waiting at the same time. */
+
+#if __WIN32__
+static HANDLE dp_wake_up_event;				/* Notify delay thread when queue not empty. */
+#else
+static pthread_cond_t dp_wake_up_cond;			/* Used with dp_mutex. */
+#endif
+
+
+// Lines going up to the ham APRS-IS server are queued and written by
+// a separate thread.  Previously they were sent by whichever thread
+// called igate_send_rec_packet, usually the one that also does the
+// digipeating, so a stalled connection stalled everything else.
+// The writer also combines lines which arrive close together into
+// one larger write.
+
+#define UPLINK_MAX_QUEUE 500			/* Drop oldest line if more than this are waiting. */
+#define UPLINK_MAX_AGE 60.			/* Seconds.  Drop lines waiting longer. */
+#define UPLINK_MAX_AGE_RECONNECT 5.		/* Seconds.  Stricter limit for the first write to a new connection. */
+#define UPLINK_COALESCE_DELAY 0.1		/* Seconds.  Wait this long for more lines to send together... */
+#define UPLINK_BATCH_BYTES 1400			/* ...unless this many bytes are already waiting. */
+
+#define UL_HEARTBEAT 0				/* Kinds of lines in the uplink queue. */
+#define UL_PACKET 1
+#define UL_PROBE 2				/* Round trip time measurement.  See rtt_probe. */
+
+struct uplink_line_s {
+	struct uplink_line_s *next;
+	double queued_at;			/* dtime_now() when added. */
+	int kind;				/* UL_HEARTBEAT, UL_PACKET, or UL_PROBE. */
+	int len;				/* Number of bytes in data, including CR/LF. */
+	char data[];				/* Not nul terminated.  Could contain nul characters. */
+};
+
+static dw_mutex_t ul_mutex;				/* Critical section for uplink queue. */
+static struct uplink_line_s *ul_queue_head;
+static struct uplink_line_s *ul_queue_tail;
+static int ul_queue_depth;				/* Number of lines waiting. */
+static int ul_queue_bytes;				/* Total bytes waiting. */
+
+#if __WIN32__
+static HANDLE ul_wake_up_event;				/* Notify writer when there is something to send. */
+#else
+static pthread_cond_t ul_wake_up_cond;			/* Used with ul_mutex. */
+#endif
 
 static void setup_cwop_connect_threads(void);
+static void uplink_queue_line (const char *imsg, int imsg_len, int kind);
+static void server_sock_set (int my_server_index, int sock);
+static int server_sock_drop (int my_server_index, int sock);
+static void server_sock_put (int my_server_index);
+static int aprs_server_ready (void);
+static int select_aprs_server (void);
+static void rtt_probe (int my_server_index);
+static void set_connecting (int my_server_index, const char *ipaddr_str);
+static int other_server_busy (int other, const char *ipaddr_str);
+static void rtt_response (int my_server_index);
 static void satgate_delay_packet (packet_t pp, int chan);
 static void send_packet_to_server (packet_t pp, int chan);
 static void send_msg_to_server (int my_server_index, const char *msg, int msg_len);
-static void maybe_xmit_packet_from_igate (char *message, int chan);
+struct is_line_s;
+static void maybe_xmit_packet_from_igate (char *message, const struct is_line_s *line, int chan);
 
 static void rx_to_ig_init (void);
 static void rx_to_ig_remember (packet_t pp);
@@ -166,16 +227,56 @@ static struct s_server {
 
 	volatile int igate_sock;
 
+	// Number of threads writing to igate_sock outside of ul_mutex.
+	// If the connection is lost meanwhile, the socket is only shut down
+	// and the last one out closes it.  That way the same file descriptor
+	// can't be handed out for a new connection while still being written.
+
+	int sock_users;
+	volatile int sock_closing;	// Shut down socket waiting to be closed, or -1.
+
+	// Incremented for each new connection so uplink_thread can tell
+	// when it is about to write to a different one than last time.
+
+	int conn_seq;
+
+	// Set while trying to connect to the address in ipaddr_str.
+	// Lets a standby connection, to the same server name, stay away from it.
+	// For ham APRS-IS, ipaddr_str and connecting are changed only with ul_mutex
+	// held because the other connection thread looks at them.
+
+	volatile int connecting;
+
 	// After connecting to server, we want to make sure
 	// that the login sequence is sent first.  Starts out false.
 	// This is set to true after the login is complete.
 
 	volatile int ok_to_send;
 
+	// Time login was sent and how long it took for the server to respond.
+	// With a standby connection, the faster one is used.
+	// After login, it is measured again every few minutes.  See rtt_probe.
+	// Changed only with ul_mutex held.
+
+	double login_sent_at;
+	double probe_sent_at;		// 0 if no measurement in progress.
+	volatile double latency;
+
 } is_server[MAX_IS_HOSTS];
 
 static int num_is_servers = 0;	// Number of elements used above for CWOP mode.
-				// Should be 1 for normal ham APRS-IS.
+				// Should be 1 for normal ham APRS-IS, or 2 with IGSTANDBY.
+
+static volatile int active_server = -1;	// Ham APRS-IS connection used for packets in both
+					// directions.  -1 if none ready.  The other one, if any,
+					// is kept logged in as a standby.  Changed only by
+					// select_aprs_server with ul_mutex held.
+
+#define UNKNOWN_LATENCY 10.	// No response to login.  We went ahead after a while anyhow.
+
+#define RTT_PROBE_EVERY 4	// Heartbeats.  Measure round trip time every 2 minutes.
+
+#define STANDBY_WAIT_SEC 60	// Longest time the standby waits for the other connection to pick an address.
 
 
 #if ITEST
@@ -301,12 +402,23 @@ static int stats_rf_recv_packets;	/* Number of candidate packets from the radio.
 					/* This is not the total number of AX.25 frames received */
 					/* over the radio; only APRS packets get this far. */
 
+// The uplink counters are changed only with ul_mutex held.
+
 static int stats_uplink_packets;	/* Number of packets passed along to the IGate */
 					/* server after filtering. */
 
 static int stats_uplink_bytes;		/* Total number of bytes sent to IGate server */
 					/* including login, packets, and heartbeats. */
 
+static int stats_uplink_queued;		/* Number of lines, packets and heartbeats, */
+					/* put into the uplink queue. */
+
+static int stats_uplink_sent;		/* Number of lines from uplink queue written to server. */
+
+static int stats_uplink_dropped;	/* Number of lines from uplink queue discarded because */
+					/* the queue was full, they waited too long, */
+					/* or there was an error writing them. */
+
 static int stats_downlink_bytes;	/* Total number of bytes from IGate server including */
 					/* packets, heartbeats, other messages. */
 
@@ -341,13 +453,41 @@ int igate_get_pkt_cnt (void) {
 }
 
 int igate_get_upl_cnt (void) {
-	return (stats_uplink_packets);
+	return (__atomic_load_n(&stats_uplink_packets, __ATOMIC_RELAXED));
 }
 
 int igate_get_dnl_cnt (void) {
 	return (stats_downlink_packets);
 }
 
+/* SATgate delay queue, for network statistics. */
+
+int igate_get_satgate_depth (void) {
+	return (dp_queue_depth);
+}
+
+int igate_get_satgate_max_depth (void) {
+	return (dp_queue_max_depth);
+}
+
+/* Uplink queue, for network statistics. */
+
+int igate_get_uplink_depth (void) {
+	return (__atomic_load_n(&ul_queue_depth, __ATOMIC_RELAXED));
+}
+
+int igate_get_uplink_queued (void) {
+	return (__atomic_load_n(&stats_uplink_queued, __ATOMIC_RELAXED));
+}
+
+int igate_get_uplink_sent (void) {
+	return (__atomic_load_n(&stats_uplink_sent, __ATOMIC_RELAXED));
+}
+
+int igate_get_uplink_dropped (void) {
+	return (__atomic_load_n(&stats_uplink_dropped, __ATOMIC_RELAXED));
+}
+
 
 
 /*-------------------------------------------------------------------
@@ -397,6 +537,13 @@ void igate_init (struct audio_s *p_audio_config, struct igate_config_s *p_igate_
 #endif
 	s_debug = debug_level;
 	dp_queue_head = NULL;
+	dp_queue_tail = NULL;
+	dp_queue_depth = 0;
+	dp_queue_max_depth = 0;
+	ul_queue_head = NULL;
+	ul_queue_tail = NULL;
+	ul_queue_depth = 0;
+	ul_queue_bytes = 0;
 
 #if DEBUGx
 	text_color_set(DW_COLOR_DEBUG);
@@ -421,6 +568,9 @@ void igate_init (struct audio_s *p_audio_config, struct igate_config_s *p_igate_
 	stats_rf_recv_packets = 0;
 	stats_uplink_packets = 0;
 	stats_uplink_bytes = 0;
+	stats_uplink_queued = 0;
+	stats_uplink_sent = 0;
+	stats_uplink_dropped = 0;
 	stats_downlink_bytes = 0;
 	stats_downlink_packets = 0;
 	stats_rf_xmit_packets = 0;
@@ -428,13 +578,25 @@ void igate_init (struct audio_s *p_audio_config, struct igate_config_s *p_igate_
 
 	for (int j=0; j<MAX_IS_HOSTS; j++) {
 	  is_server[j].igate_sock = -1;
+	  is_server[j].sock_users = 0;
+	  is_server[j].sock_closing = -1;
+	  is_server[j].conn_seq = 0;
+	  is_server[j].connecting = 0;
 	  is_server[j].ok_to_send = 0;
+	  is_server[j].login_sent_at = 0;
+	  is_server[j].probe_sent_at = 0;
+	  is_server[j].latency = UNKNOWN_LATENCY;
 	}
 	num_is_servers = 0;
+	active_server = -1;
 
 	rx_to_ig_init ();
 	ig_to_tx_init ();
 
+/*
+ * Changes to igate_sock are made with this held, in CWOP mode too.
+ */
+	dw_mutex_init(&ul_mutex);
 
 /*
  * Continue only if we have server name, login, and passcode.
@@ -449,12 +611,35 @@ void igate_init (struct audio_s *p_audio_config, struct igate_config_s *p_igate_
 	  setup_cwop_connect_threads();
 	}
 	else {
+/*
+ * This writes packets and heartbeats to the ham APRS-IS server.
+ */
+#if __WIN32__
+	  ul_wake_up_event = CreateEvent (NULL, 0, 0, NULL);
+	  HANDLE uplink_th = (HANDLE)_beginthreadex (NULL, 0, uplink_thread, NULL, 0, NULL);
+	  if (uplink_th == NULL) {
+	    text_color_set(DW_COLOR_ERROR);
+	    dw_printf ("Internal error: Could not create IGate uplink thread\n");
+	    return;
+	  }
+#else
+	  pthread_t uplink_tid;
+	  pthread_cond_init (&ul_wake_up_cond, NULL);
+	  e = pthread_create (&uplink_tid, NULL, uplink_thread, NULL);
+	  if (e != 0) {
+	    text_color_set(DW_COLOR_ERROR);
+	    perror("Internal error: Could not create IGate uplink thread");
+	    return;
+	  }
+#endif
+
 /*
  * This connects to the ham AORS-IS server and sets igate_sock.
  * It also sends periodic messages to say I'm still alive.
  * If connection is lost reconnection is attempted.
+ * With IGSTANDBY, a second one does the same for the standby connection.
  */
-	  num_is_servers = 1;
+	  num_is_servers = p_igate_config->t2_standby ? 2 : 1;
 	  for (int n=0; n<num_is_servers; n++) {
 #if __WIN32__
 	    HANDLE connnect_th = (HANDLE)_beginthreadex (NULL, 0, connnect_thread_aprs, (void*)(ptrdiff_t)n, 0, NULL);
@@ -471,7 +656,7 @@ void igate_init (struct audio_s *p_audio_config, struct igate_config_s *p_igate_
 	      return;
 	    }
 #endif  // __WIN32__
-	  }  //  for each is_server - should be one.
+	  }  //  for each is_server - one, or two with standby.
 	}
 
 
@@ -503,7 +688,9 @@ void igate_init (struct audio_s *p_audio_config, struct igate_config_s *p_igate_
  */
 
 	if (p_igate_config->satgate_delay > 0) {
+	  dw_mutex_init(&dp_mutex);
 #if __WIN32__
+	  dp_wake_up_event = CreateEvent (NULL, 0, 0, NULL);
 	  satgate_delay_th = (HANDLE)_beginthreadex (NULL, 0, satgate_delay_thread, NULL, 0, NULL);
 	  if (satgate_delay_th == NULL) {
 	    text_color_set(DW_COLOR_ERROR);
@@ -511,6 +698,7 @@ void igate_init (struct audio_s *p_audio_config, struct igate_config_s *p_igate_
 	    return;
 	  }
 #else
+	  pthread_cond_init (&dp_wake_up_cond, NULL);
 	  e = pthread_create (&satgate_delay_tid, NULL, satgate_delay_thread, NULL);
 	  if (e != 0) {
 	    text_color_set(DW_COLOR_ERROR);
@@ -518,7 +706,6 @@ void igate_init (struct audio_s *p_audio_config, struct igate_config_s *p_igate_
 	    return;
 	  }
 #endif
-	  dw_mutex_init(&dp_mutex);
 	}
 
 } /* end igate_init */
@@ -658,6 +845,13 @@ static void setup_cwop_connect_threads(void)
  *		If connection is lost, expand the DNS name into a new list of addresses
  *		because it might have changed.  Attempt connecting to one of them again.
  *
+ *		Version 1.8:  With IGSTANDBY, there are two of these.  The second
+ *		uses the standby server name if one was given.  Otherwise it avoids
+ *		the address already in use, if there is a choice.  Both stay logged
+ *		in and select_aprs_server decides which one is used for packets.
+ *		Both threads start at the same time so, without a standby server
+ *		name, the standby waits for the other to pick an address first.
+ *
  *--------------------------------------------------------------------*/
 
 /*
@@ -705,11 +899,20 @@ static void * connnect_thread_aprs (void *arg)
 	int err;
 	char server_port_str[12];	/* text form of port number */
 	char ipaddr_str[46];		/* text form of IP address */
+	char *server_name = save_igate_config_p->t2_server_name;
+	int server_port = save_igate_config_p->t2_server_port;
+	int other = 1 - my_server_index;	/* Other one when there is a standby. */
+	int heartbeats = 0;
+
+	if (my_server_index == 1 && strlen(save_igate_config_p->t2_standby_name) > 0) {
+	  server_name = save_igate_config_p->t2_standby_name;
+	  server_port = save_igate_config_p->t2_standby_port;
+	}
 
-	snprintf (server_port_str, sizeof(server_port_str), "%d", save_igate_config_p->t2_server_port);
+	snprintf (server_port_str, sizeof(server_port_str), "%d", server_port);
 #if DEBUGx
 	text_color_set(DW_COLOR_DEBUG);
-        dw_printf ("DEBUG: igate connect_thread_aprs start, port = %d = '%s'\n", save_igate_config_p->t2_server_port, server_port_str);
+        dw_printf ("DEBUG: igate connect_thread_aprs start, port = %d = '%s'\n", server_port, server_port_str);
 #endif
 
 	memset (&hints, 0, sizeof(hints));
@@ -741,16 +944,33 @@ static void * connnect_thread_aprs (void *arg)
 
 	    SLEEP_SEC (5);
 
+	    // Previous socket must be closed first.  See server_sock_drop.
+
+	    while (is_server[my_server_index].sock_closing != -1) {
+	      SLEEP_MS (100);
+	    }
+
+	    // Standby for the same server name.  Let the other connection choose its
+	    // address first, so it can be avoided below, but don't wait forever in
+	    // case the other one can't connect at all.
+
+	    if (my_server_index == 1 && strlen(save_igate_config_p->t2_standby_name) == 0) {
+	      int w;
+	      for (w = 0; w < STANDBY_WAIT_SEC && ! other_server_busy(other, NULL); w++) {
+	        SLEEP_SEC (1);
+	      }
+	    }
+
 	    ai_head = NULL;
-	    err = getaddrinfo(save_igate_config_p->t2_server_name, server_port_str, &hints, &ai_head);
+	    err = getaddrinfo(server_name, server_port_str, &hints, &ai_head);
 	    if (err != 0) {
 	      text_color_set(DW_COLOR_ERROR);
 #if __WIN32__
 	      dw_printf ("Can't get address for IGate server %s, err=%d\n", 
-					save_igate_config_p->t2_server_name, WSAGetLastError());
+					server_name, WSAGetLastError());
 #else 
 	      dw_printf ("Can't get address for IGate server %s, %s\n", 
-					save_igate_config_p->t2_server_name, gai_strerror(err));
+					server_name, gai_strerror(err));
 #endif
 	      freeaddrinfo(ai_head);
 
@@ -800,6 +1020,13 @@ static void * connnect_thread_aprs (void *arg)
 	      ai = hosts[n];
 
 	      dwsock_ia_to_text (ai->ai_family, ai->ai_addr, ipaddr_str, sizeof(ipaddr_str));
+
+	      // The standby should be a different server than the one in use, if there is a choice.
+
+	      if (num_is_servers == 2 && num_hosts > 1 && other_server_busy(other, ipaddr_str)) {
+	        continue;
+	      }
+
 	      is = socket(ai->ai_family, ai->ai_socktype, ai->ai_protocol);
 #if __WIN32__
 	      if (is == INVALID_SOCKET) {
@@ -814,7 +1041,7 @@ static void * connnect_thread_aprs (void *arg)
 	      if (err != 0) {
 	        text_color_set(DW_COLOR_INFO);
 	        dw_printf("Connect to IGate server %s (%s) failed.\n\n",
-					save_igate_config_p->t2_server_name, ipaddr_str);
+					server_name, ipaddr_str);
 	        (void) close (is);
 	        is = -1;
 		stats_failed_connect++;
@@ -824,12 +1051,15 @@ static void * connnect_thread_aprs (void *arg)
 
 //#ifndef DEBUG_DNS
 #if 1
+	      set_connecting (my_server_index, ipaddr_str);
+
 	      err = connect(is, ai->ai_addr, (int)ai->ai_addrlen);
 #if __WIN32__
 	      if (err == SOCKET_ERROR) {
+	        set_connecting (my_server_index, NULL);
 	        text_color_set(DW_COLOR_INFO);
 	        dw_printf("Connect to IGate server %s (%s) failed.\n\n",
-					save_igate_config_p->t2_server_name, ipaddr_str);
+					server_name, ipaddr_str);
 	        closesocket (is);
 	        is = -1;
 		stats_failed_connect++; 
@@ -838,9 +1068,10 @@ static void * connnect_thread_aprs (void *arg)
 	      // TODO: set TCP_NODELAY?
 #else
 	      if (err != 0) {
+	        set_connecting (my_server_index, NULL);
 	        text_color_set(DW_COLOR_INFO);
 	        dw_printf("Connect to IGate server %s (%s) failed.\n\n",
-					save_igate_config_p->t2_server_name, ipaddr_str);
+					server_name, ipaddr_str);
 	        (void) close (is);
 	        is = -1;
 		stats_failed_connect++;
@@ -861,7 +1092,7 @@ static void * connnect_thread_aprs (void *arg)
 /* Success. */
 
 	      text_color_set(DW_COLOR_INFO);
- 	      dw_printf("\nNow connected to IGate server %s (%s)\n", save_igate_config_p->t2_server_name, ipaddr_str );
+ 	      dw_printf("\nNow connected to IGate server %s (%s)\n", server_name, ipaddr_str );
 	      if (strchr(ipaddr_str, ':') != NULL) {
 	      	dw_printf("Check server status here http://[%s]:14501\n\n", ipaddr_str);
 	      }
@@ -875,7 +1106,7 @@ static void * connnect_thread_aprs (void *arg)
  */
 
 	      is_server[my_server_index].ok_to_send = 0;
-	      is_server[my_server_index].igate_sock = is;
+	      server_sock_set (my_server_index, is);
 #endif	  
 	      break;
 	    }
@@ -898,9 +1129,15 @@ static void * connnect_thread_aprs (void *arg)
 	        strlcat (stemp, " filter ", sizeof(stemp));
 	        strlcat (stemp, save_igate_config_p->t2_filter, sizeof(stemp));
 	      }
+	      dw_mutex_lock (&ul_mutex);
+	      is_server[my_server_index].login_sent_at = dtime_now();
+	      dw_mutex_unlock (&ul_mutex);
 	      send_msg_to_server (my_server_index, stemp, strlen(stemp));
 
-/* Delay until it is ok to start sending packets. */
+/*
+ * Delay until it is ok to start sending packets.
+ * Version 1.8:  igate_recv_thread sets ok_to_send sooner when the server responds to the login.
+ */
 
 	      SLEEP_SEC(7);
 	      is_server[my_server_index].ok_to_send = 1;
@@ -925,10 +1162,22 @@ static void * connnect_thread_aprs (void *arg)
 
 	    char heartbeat[10];
 
+	    if (++heartbeats % RTT_PROBE_EVERY == 0 && save_igate_config_p->t2_filter != NULL) {
+	      rtt_probe (my_server_index);
+	      continue;
+	    }
+
 	    strlcpy (heartbeat, "#", sizeof(heartbeat));
 
-	    /* This will close the socket if any error. */
-	    send_msg_to_server (my_server_index, heartbeat, strlen(heartbeat));
+	    /* For the connection in use, this goes in line with packets. */
+	    /* Either way, the socket is closed if any error. */
+
+	    if (my_server_index == active_server) {
+	      uplink_queue_line (heartbeat, strlen(heartbeat), UL_HEARTBEAT);
+	    }
+	    else {
+	      send_msg_to_server (my_server_index, heartbeat, strlen(heartbeat));
+	    }
 
 	  }
 	}
@@ -938,6 +1187,90 @@ static void * connnect_thread_aprs (void *arg)
 } /* end connnect_thread_aprs */
 
 
+/*-------------------------------------------------------------------
+ *
+ * Name:        rtt_probe
+ *
+ * Purpose:     Measure the round trip time to a ham APRS-IS server again.
+ *
+ * Inputs:	my_server_index - Index into is_servers.
+ *
+ * Description:	The time to respond to the login is only a first guess.
+ *		A server can become busy, or the path to it congested,
+ *		long after that.
+ *
+ *		Servers don't echo comment lines but they acknowledge a
+ *		filter command with "# filter ... active".  We send the
+ *		filter from the configuration again, which doesn't change
+ *		anything, and time the acknowledgement in rtt_response.
+ *		This takes the place of a heartbeat every couple minutes.
+ *
+ *		For the connection in use, the probe goes through the
+ *		uplink queue in line with packets.  The clock starts when
+ *		uplink_thread writes it so time waiting in the queue
+ *		doesn't count against the server.
+ *
+ *		A server that never acknowledges keeps the latency it had.
+ *
+ *--------------------------------------------------------------------*/
+
+static void rtt_probe (int my_server_index)
+{
+	char stemp[256];
+
+	snprintf (stemp, sizeof(stemp), "#filter %s", save_igate_config_p->t2_filter);
+
+	dw_mutex_lock (&ul_mutex);
+	if (is_server[my_server_index].probe_sent_at > 0 && s_debug >= 1) {
+	  text_color_set(DW_COLOR_DEBUG);
+	  dw_printf ("No response from IGate server %s to filter command.\n", is_server[my_server_index].ipaddr_str);
+	}
+	is_server[my_server_index].probe_sent_at = 0;
+	dw_mutex_unlock (&ul_mutex);
+
+	if (my_server_index == active_server) {
+	  uplink_queue_line (stemp, strlen(stemp), UL_PROBE);
+	}
+	else {
+	  dw_mutex_lock (&ul_mutex);
+	  is_server[my_server_index].probe_sent_at = dtime_now();
+	  dw_mutex_unlock (&ul_mutex);
+	  send_msg_to_server (my_server_index, stemp, strlen(stemp));
+	}
+}
+
+
+/*
+ * Called by igate_recv_thread for "# filter" from the server.
+ * Smooth the measurements a little so one slow response doesn't
+ * cause a switch to the standby.
+ */
+
+static void rtt_response (int my_server_index)
+{
+	struct s_server *s = &is_server[my_server_index];
+
+	dw_mutex_lock (&ul_mutex);
+	if (s->probe_sent_at > 0) {
+	  double rtt = dtime_now() - s->probe_sent_at;
+
+	  if (s->latency >= UNKNOWN_LATENCY) {
+	    s->latency = rtt;
+	  }
+	  else {
+	    s->latency = 0.75 * s->latency + 0.25 * rtt;
+	  }
+	  s->probe_sent_at = 0;
+
+	  if (s_debug >= 1) {
+	    text_color_set(DW_COLOR_DEBUG);
+	    dw_printf ("IGate server %s round trip %.0f ms, average %.0f ms.\n", s->ipaddr_str, rtt * 1000, s->latency * 1000);
+	  }
+	}
+	dw_mutex_unlock (&ul_mutex);
+}
+
+
 
 /*-------------------------------------------------------------------
  *
@@ -1004,6 +1337,11 @@ static void * connnect_thread_cwop (void *arg)
 	  if (is_server[my_server_index].igate_sock == -1) {
 
 	    struct addrinfo *ai = NULL;
+
+	    while (is_server[my_server_index].sock_closing != -1) {
+	      SLEEP_MS (100);
+	    }
+
 	    err = getaddrinfo(is_server[my_server_index].ipaddr_str, server_port_str, &hints, &ai);
 	    if (err != 0) {
 	      // This should not fail - we are supplying ip addr not hostname.
@@ -1097,7 +1435,7 @@ static void * connnect_thread_cwop (void *arg)
  * But make the Rx -> Internet messages wait until after login.
  */
 	    is_server[my_server_index].ok_to_send = 0;
-	    is_server[my_server_index].igate_sock = is;
+	    server_sock_set (my_server_index, is);
 
 	    if (is_server[my_server_index].igate_sock != -1) {
 	      char stemp[256];
@@ -1189,7 +1527,6 @@ dw_printf ("%s\n", stemp);
 
 void igate_send_rec_packet (int chan, packet_t recv_pp)
 {
-	int my_server_index = 0;	// for regular APRS-IS.
 	int n;
 	unsigned char *pinfo;
 	int info_len;
@@ -1203,12 +1540,8 @@ void igate_send_rec_packet (int chan, packet_t recv_pp)
 	  return;
 	}
 
-	if (is_server[my_server_index].igate_sock == -1) {
-	  return;	/* Silently discard if not connected. */
-	}
-
-	if ( ! is_server[my_server_index].ok_to_send) {
-	  return;	/* Login not complete. */
+	if ( ! aprs_server_ready()) {
+	  return;	/* Silently discard if not connected or login not complete. */
 	}
 
 	/* Gather statistics. */
@@ -1403,7 +1736,6 @@ static void send_packet_to_server (packet_t pp, int chan)
 	unsigned char *pinfo;
 	int info_len;
 	char msg[IGATE_MAX_MSG];
-	int my_server_index =0;		// Single server for ham APRS-IS
 
 	// Do not allow for CWOP mode.
 	// Revisit someday.  Should there be a message?
@@ -1544,8 +1876,7 @@ static void send_packet_to_server (packet_t pp, int chan)
 	  msg_len += info_len;
 	}
 
-	send_msg_to_server (my_server_index, msg, msg_len);
-	stats_uplink_packets++;
+	uplink_queue_line (msg, msg_len, UL_PACKET);
 
 /*
  * Remember what was sent to avoid duplicates in near future.
@@ -1562,9 +1893,10 @@ static void send_packet_to_server (packet_t pp, int chan)
  *
  * Name:        send_msg_to_server
  *
- * Purpose:     Send something to the IGate server.
- *		This one function should be used for login, heartbeats,
- *		and packets.
+ * Purpose:     Send something to the IGate server immediately.
+ *		This is used for login and for CWOP mode.
+ *		Packets and heartbeats for ham APRS-IS go through
+ *		uplink_queue_line instead.
  *
  * Inputs:	my_server_index - Index into is_servers.
  *
@@ -1587,8 +1919,17 @@ static void send_msg_to_server (int my_server_index, const char *imsg, int imsg_
 	int err;
 	char stemp[IGATE_MAX_MSG+1];
 	int stemp_len;
+	int sock;
+	int lost = 0;
+
+	dw_mutex_lock (&ul_mutex);
+	sock = is_server[my_server_index].igate_sock;
+	if (sock != -1) {
+	  is_server[my_server_index].sock_users++;
+	}
+	dw_mutex_unlock (&ul_mutex);
 
-	if (is_server[my_server_index].igate_sock == -1) {
+	if (sock == -1) {
 	  return;	/* Silently discard if not connected. */
 	}
 
@@ -1612,150 +1953,816 @@ static void send_msg_to_server (int my_server_index, const char *imsg, int imsg_
 	stemp[stemp_len++] = '\n';
 	stemp[stemp_len] = '\0';
 
-	stats_uplink_bytes += stemp_len;
+        err = SOCK_SEND (sock, stemp, stemp_len);
+#if __WIN32__	
+	if (err == SOCKET_ERROR) {
+	  err = WSAGetLastError();
+	}
+	else {
+	  err = 0;
+	}
+#else
+	err = (err <= 0);
+#endif
 
+	dw_mutex_lock (&ul_mutex);
+	if (err == 0) {
+	  stats_uplink_bytes += stemp_len;
+	}
+	else {
+	  lost = server_sock_drop (my_server_index, sock);
+	}
+	server_sock_put (my_server_index);
+	dw_mutex_unlock (&ul_mutex);
 
-#if __WIN32__	
-        err = SOCK_SEND (is_server[my_server_index].igate_sock, stemp, stemp_len);
-	if (err == SOCKET_ERROR)
-	{
+	if (lost) {
 	  text_color_set(DW_COLOR_ERROR);
-	  dw_printf ("\nError %d sending to IGate server.  Closing connection.\n\n", WSAGetLastError());
-	  //dw_printf ("DEBUG: igate_sock=%d, line=%d\n", is_server[my_server_index].igate_sock, __LINE__);
-	  closesocket (is_server[my_server_index].igate_sock);
-	  is_server[my_server_index].igate_sock = -1;
+#if __WIN32__	
+	  dw_printf ("\nError %d sending to IGate server.  Closing connection.\n\n", err);
 	  WSACleanup();
-	}
 #else
-        err = SOCK_SEND (is_server[my_server_index].igate_sock, stemp, stemp_len);
-	if (err <= 0)
-	{
-	  text_color_set(DW_COLOR_ERROR);
 	  dw_printf ("\nError sending to IGate server.  Closing connection.\n\n");
-	  close (is_server[my_server_index].igate_sock);
-	  is_server[my_server_index].igate_sock = -1;    
-	}
 #endif
+	}
 	
 } /* end send_msg_to_server */
 
 
 /*-------------------------------------------------------------------
  *
- * Name:        get1ch
- *
- * Purpose:     Read one byte from socket.
+ * Name:        server_sock_set
  *
- * Inputs:	igate_sock	- file handle for socket.
+ * Purpose:     Make a new connection available to everyone else.
  *
- * Returns:	One byte from stream.
- *		Waits and tries again later if any error.
+ * Inputs:	my_server_index - Index into is_servers.
  *
+ *		sock	- Socket for the connection.
  *
  *--------------------------------------------------------------------*/
 
-static int get1ch (int my_server_index)
+static void server_sock_set (int my_server_index, int sock)
 {
-	unsigned char ch;
-	int n;
-
-	while (1) {
+	dw_mutex_lock (&ul_mutex);
+	is_server[my_server_index].igate_sock = sock;
+	is_server[my_server_index].conn_seq++;
+	is_server[my_server_index].connecting = 0;
+	is_server[my_server_index].latency = UNKNOWN_LATENCY;
+	is_server[my_server_index].probe_sent_at = 0;
+	dw_mutex_unlock (&ul_mutex);
+}
 
-	  while (is_server[my_server_index].igate_sock == -1) {
-	    SLEEP_SEC(5);			/* Not connected.  Try again later. */
-	  }
 
-	  /* Just get one byte at a time. */
-	  // TODO: Should read complete packets and unpack from own buffer
-	  // rather than using a system call for each byte.
+/*
+ * Remember the address we are about to connect to, or
+ * clear connecting if that didn't work, for other_server_busy.
+ */
 
-	  n = SOCK_RECV (is_server[my_server_index].igate_sock, (char*)(&ch), 1);
+static void set_connecting (int my_server_index, const char *ipaddr_str)
+{
+	dw_mutex_lock (&ul_mutex);
+	if (ipaddr_str != NULL) {
+	  strlcpy (is_server[my_server_index].ipaddr_str, ipaddr_str, sizeof(is_server[my_server_index].ipaddr_str));
+	  is_server[my_server_index].connecting = 1;
+	}
+	else {
+	  is_server[my_server_index].connecting = 0;
+	}
+	dw_mutex_unlock (&ul_mutex);
+}
 
-	  if (n == 1) {		// Success
-#if DEBUG9
-	    dw_printf (log_fp, "%02x %c %c", ch, 
-			isprint(ch) ? ch : '.' , 
-			(isupper(ch>>1) || isdigit(ch>>1) || (ch>>1) == ' ') ? (ch>>1) : '.');
-	    if (ch == '\r') fprintf (log_fp, "  CR");
-	    if (ch == '\n') fprintf (log_fp, "  LF");
-	    fprintf (log_fp, "\n");
-#endif
-	    return(ch);	
-	  }
 
-	  // Linux man page: "These calls return the number of bytes received, or -1 if an error occurred
-	  // The return value will be 0 when the peer has performed an orderly shutdown.
+/*
+ * Is the other ham APRS-IS connection connected, or trying to connect?
+ * If ipaddr_str is not NULL, only to that address.
+ */
 
-	  // I saw 0 when two different clients were logged in with same callsign-ssid.
+static int other_server_busy (int other, const char *ipaddr_str)
+{
+	int busy;
 
-          text_color_set(DW_COLOR_ERROR);
-	  if (n == 0) {
-	    dw_printf ("\nServer %s has closed connection.\n\n",
-			is_server[my_server_index].ipaddr_str);
-	  }
-	  else {
-	    dw_printf ("\nError reading from server %s.  Closing connection.\n\n", 										is_server[my_server_index].ipaddr_str);
-	  }
-#if __WIN32__
-	  closesocket (is_server[my_server_index].igate_sock);
-#else
-	  close (is_server[my_server_index].igate_sock);
-#endif
-	  is_server[my_server_index].igate_sock = -1;
+	dw_mutex_lock (&ul_mutex);
+	busy = is_server[other].igate_sock != -1 || is_server[other].connecting;
+	if (busy && ipaddr_str != NULL) {
+	  busy = strcmp(ipaddr_str, is_server[other].ipaddr_str) == 0;
 	}
-
-} /* end get1ch */
-
-
+	dw_mutex_unlock (&ul_mutex);
+	return (busy);
+}
 
 
 /*-------------------------------------------------------------------
  *
- * Name:        igate_recv_thread
+ * Name:        server_sock_drop
  *
- * Purpose:     Wait for messages from IGate Server.
+ * Purpose:     Disconnect after an error.
  *
- * Inputs:	arg		- Index into the server table for CWOP mode.
- *				  Should be zero for regular APRS-IS.
+ * Inputs:	my_server_index - Index into is_servers.
  *
- * Outputs:	igate_sock	- File descriptor for communicating with client app.
+ *		sock	- Socket where the error happened.
  *
- * Description:	Process messages from the IGate server.
+ * Returns:	1 if the connection was dropped.
+ *		0 if someone else had already done it.
+ *
+ * Description:	Caller must have ul_mutex locked.
+ *
+ *		Nothing happens if sock is no longer the current connection.
+ *		Otherwise it is shut down right away, which also wakes up
+ *		igate_recv_thread.  The socket is closed only when nobody
+ *		is writing to it.  If someone is, server_sock_put closes it
+ *		when they are done.
  *
  *--------------------------------------------------------------------*/
 
+static int server_sock_drop (int my_server_index, int sock)
+{
+	struct s_server *s = &is_server[my_server_index];
+
+	if (sock == -1 || s->igate_sock != sock) {
+	  return (0);
+	}
+	s->igate_sock = -1;
+
 #if __WIN32__
-static unsigned __stdcall igate_recv_thread (void *arg)
+	shutdown (sock, SD_BOTH);
+	if (s->sock_users > 0) {
+	  s->sock_closing = sock;
+	}
+	else {
+	  closesocket (sock);
+	}
 #else
-static void * igate_recv_thread (void *arg)
-#endif
-{
-	int my_server_index = (int)(ptrdiff_t)arg;
-	
-	unsigned char ch;
-	unsigned char message[1000];  // Spec says max 512.
-	int len;
-	
-			
-#if DEBUGx
-	text_color_set(DW_COLOR_DEBUG);
-	dw_printf ("igate_recv_thread ( socket = %d )\n", is_server[my_server_index].igate_sock);
+	shutdown (sock, SHUT_RDWR);
+	if (s->sock_users > 0) {
+	  s->sock_closing = sock;
+	}
+	else {
+	  close (sock);
+	}
 #endif
+	return (1);
+}
 
-	while (1) {
 
-	  len = 0;
+/*
+ * Done writing to the socket taken, along with incrementing sock_users,
+ * with ul_mutex held.  Caller must have ul_mutex locked.
+ */
 
-	  do
-	  {
-	    ch = get1ch(my_server_index);
-	    stats_downlink_bytes++;
+static void server_sock_put (int my_server_index)
+{
+	struct s_server *s = &is_server[my_server_index];
 
-	    // I never expected to see a nul character but it can happen.
-	    // If found, change it to <0x00> and ax25_from_text will change it back to a single byte.
-	    // Along the way we can use the normal C string handling.
+	s->sock_users--;
+	if (s->sock_users == 0 && s->sock_closing != -1) {
+#if __WIN32__
+	  closesocket (s->sock_closing);
+#else
+	  close (s->sock_closing);
+#endif
+	  s->sock_closing = -1;
+	}
+}
 
-	    if (ch == 0 && len < (int)(sizeof(message)) - 5) {
+
+
+/*-------------------------------------------------------------------
+ *
+ * Name:        uplink_queue_line
+ *
+ * Purpose:     Queue something to be sent to the ham APRS-IS server.
+ *
+ * Inputs:	imsg	- Message.  We will add CR/LF here.
+ *
+ *		imsg_len - Length of imsg in bytes.
+ *			  It could contain nul characters so we can't
+ *			  use the normal C string functions.
+ *
+ *		kind	- UL_PACKET for a packet from the radio,
+ *			  UL_HEARTBEAT or UL_PROBE from connnect_thread_aprs.
+ *
+ * Outputs:	Appended to ul_queue.  uplink_thread will send it.
+ *
+ * Description:	This returns right away, even if the connection is slow
+ *		or broken.  If the queue is full, the oldest line is
+ *		discarded to make room.
+ *
+ *--------------------------------------------------------------------*/
+
+static void uplink_queue_line (const char *imsg, int imsg_len, int kind)
+{
+	struct uplink_line_s *line;
+	int len;
+	int was_empty;
+
+	len = imsg_len;
+	if (len + 2 > IGATE_MAX_MSG) {
+	  text_color_set(DW_COLOR_ERROR);
+	  dw_printf ("Rx IGate: Too long. Truncating.\n");
+	  len = IGATE_MAX_MSG - 2;
+	}
+
+	line = malloc (sizeof(struct uplink_line_s) + len + 2);
+	if (line == NULL) {
+	  text_color_set(DW_COLOR_ERROR);
+	  dw_printf ("FATAL ERROR: Out of memory.\n");
+	  exit (EXIT_FAILURE);
+	}
+	line->next = NULL;
+	line->queued_at = dtime_now();
+	line->kind = kind;
+	memcpy (line->data, imsg, len);
+	line->data[len++] = '\r';
+	line->data[len++] = '\n';
+	line->len = len;
+
+	dw_mutex_lock (&ul_mutex);
+
+	while (ul_queue_depth >= UPLINK_MAX_QUEUE) {
+	  struct uplink_line_s *old = ul_queue_head;
+
+	  ul_queue_head = old->next;
+	  if (ul_queue_head == NULL) {
+	    ul_queue_tail = NULL;
+	  }
+	  ul_queue_depth--;
+	  ul_queue_bytes -= old->len;
+	  stats_uplink_dropped++;
+	  free (old);
+	}
+
+	was_empty = (ul_queue_head == NULL);
+	if (was_empty) {
+	  ul_queue_head = line;
+	}
+	else {
+	  ul_queue_tail->next = line;
+	}
+	ul_queue_tail = line;
+	ul_queue_depth++;
+	ul_queue_bytes += len;
+	stats_uplink_queued++;
+	if (kind == UL_PACKET) {
+	  stats_uplink_packets++;
+	}
+
+// Writer needs a nudge when the queue was empty, or enough
+// has built up that it should not wait for more.
+
+	if (was_empty || ul_queue_bytes >= UPLINK_BATCH_BYTES) {
+#if __WIN32__
+	  SetEvent (ul_wake_up_event);
+#else
+	  pthread_cond_signal (&ul_wake_up_cond);
+#endif
+	}
+
+	dw_mutex_unlock (&ul_mutex);
+
+} /* end uplink_queue_line */
+
+
+/*
+ * Is any ham APRS-IS connection ready for packets?
+ */
+
+static int aprs_server_ready (void)
+{
+	for (int j = 0; j < num_is_servers; j++) {
+	  if (is_server[j].igate_sock != -1 && is_server[j].ok_to_send) {
+	    return (1);
+	  }
+	}
+	return (0);
+}
+
+
+/*
+ * Pick the ham APRS-IS connection to use.  Caller must have ul_mutex locked.
+ *
+ * Keep using the current one while it is good.  Otherwise take the one
+ * that responds fastest, first to the login and later to rtt_probe.
+ * Also change if the standby responds in less than half the time.
+ * Returns -1 if none is ready.
+ */
+
+static int select_aprs_server (void)
+{
+	int a = active_server;
+	int best = -1;
+
+	for (int j = 0; j < num_is_servers; j++) {
+	  if (is_server[j].igate_sock != -1 && is_server[j].ok_to_send) {
+	    if (best < 0 || is_server[j].latency < is_server[best].latency) {
+	      best = j;
+	    }
+	  }
+	}
+
+	if (a >= 0 && is_server[a].igate_sock != -1 && is_server[a].ok_to_send) {
+	  if (best == a || is_server[best].latency * 2 >= is_server[a].latency) {
+	    return (a);
+	  }
+	}
+
+	if (best != a) {
+	  active_server = best;
+	  if (best >= 0 && num_is_servers > 1) {
+	    text_color_set(DW_COLOR_INFO);
+	    dw_printf ("\nNow using IGate server %s for packets.  Response time %.0f ms.\n\n",
+				is_server[best].ipaddr_str, is_server[best].latency * 1000);
+	  }
+	}
+	return (best);
+}
+
+
+/*
+ * Discard lines which have been waiting longer than max_age seconds.
+ * Caller must have ul_mutex locked.
+ */
+
+static void uplink_drop_old (double now, double max_age)
+{
+	while (ul_queue_head != NULL && now - ul_queue_head->queued_at > max_age) {
+	  struct uplink_line_s *old = ul_queue_head;
+
+	  ul_queue_head = old->next;
+	  if (ul_queue_head == NULL) {
+	    ul_queue_tail = NULL;
+	  }
+	  ul_queue_depth--;
+	  ul_queue_bytes -= old->len;
+	  stats_uplink_dropped++;
+	  free (old);
+	}
+}
+
+
+/*
+ * Wait for signal from uplink_queue_line or until the specified time.
+ * Caller must have ul_mutex locked.  0 means wait with no time limit.
+ */
+
+static void uplink_wait (double until)
+{
+#if __WIN32__
+	DWORD ms = INFINITE;
+
+	if (until > 0) {
+	  double now = dtime_now();
+	  ms = until > now ? (DWORD)((until - now) * 1000) + 1 : 0;
+	}
+	dw_mutex_unlock (&ul_mutex);
+	WaitForSingleObject (ul_wake_up_event, ms);
+	dw_mutex_lock (&ul_mutex);
+#else
+	if (until > 0) {
+	  struct timespec abstime;
+
+	  abstime.tv_sec = (time_t)(long)until;
+	  abstime.tv_nsec = (long)((until - (long)abstime.tv_sec) * 1000000000.0);
+	  pthread_cond_timedwait (&ul_wake_up_cond, &ul_mutex, &abstime);
+	}
+	else {
+	  pthread_cond_wait (&ul_wake_up_cond, &ul_mutex);
+	}
+#endif
+}
+
+
+/*-------------------------------------------------------------------
+ *
+ * Name:        uplink_thread
+ *
+ * Purpose:     Write queued lines to the ham APRS-IS server.
+ *
+ * Inputs:	ul_queue_head	- Queue of lines.
+ *
+ *		is_server[]	- Connections maintained by connnect_thread_aprs.
+ *				  One, or two with IGSTANDBY.
+ *
+ * Description:	Wait until there is something in the queue, we are
+ *		connected, and login is complete.
+ *
+ *		A line is not sent right away.  We wait a short time for
+ *		others to arrive, for example several digipeated copies
+ *		or a burst after a quiet channel, so they can all go in
+ *		one write.  This is like the Nagle algorithm but with a
+ *		fixed upper limit on the delay.
+ *
+ *		If the write fails, the connection is closed and
+ *		connnect_thread_aprs establishes a new one.  What we
+ *		were writing goes back to the front of the queue.
+ *		If there is a standby connection, it is sent there right
+ *		away.  Otherwise it goes out after the new login unless
+ *		it became too old while we waited.  Packets heard more
+ *		than a few seconds before are not worth sending after a
+ *		reconnect so the first write to any connection other
+ *		than the last one uses a much shorter age limit.
+ *
+ *--------------------------------------------------------------------*/
+
+#define UPLINK_BUF_SIZE 4096
+
+#if __WIN32__
+static unsigned __stdcall uplink_thread (void *arg)
+#else
+static void * uplink_thread (void *arg)
+#endif
+{
+	char buf[UPLINK_BUF_SIZE];
+	int last_server = -1;		/* Connection used for the previous write. */
+	int last_conn_seq = 0;
+
+	while (1) {
+	  int len = 0;
+	  int nlines = 0;
+	  struct uplink_line_s *batch = NULL;
+	  struct uplink_line_s *batch_tail = NULL;
+	  int my_server_index;
+	  int sock;
+	  int lost = 0;
+	  double now;
+
+	  dw_mutex_lock (&ul_mutex);
+
+	  if (ul_queue_head == NULL) {
+	    uplink_wait (0);
+	    dw_mutex_unlock (&ul_mutex);
+	    continue;
+	  }
+
+// Discard anything that waited too long.  Probably while reconnecting.
+
+	  now = dtime_now();
+	  uplink_drop_old (now, UPLINK_MAX_AGE);
+	  if (ul_queue_head == NULL) {
+	    dw_mutex_unlock (&ul_mutex);
+	    continue;
+	  }
+
+// Not connected or login not complete.  Check again soon.
+
+	  my_server_index = select_aprs_server ();
+	  if (my_server_index < 0) {
+	    uplink_wait (now + 1.0);
+	    dw_mutex_unlock (&ul_mutex);
+	    continue;
+	  }
+
+// New connection, or switched to the standby.  Anything that waited
+// through the reconnect is stale by now.
+
+	  if (my_server_index != last_server || is_server[my_server_index].conn_seq != last_conn_seq) {
+	    last_server = my_server_index;
+	    last_conn_seq = is_server[my_server_index].conn_seq;
+	    uplink_drop_old (now, UPLINK_MAX_AGE_RECONNECT);
+	    if (ul_queue_head == NULL) {
+	      dw_mutex_unlock (&ul_mutex);
+	      continue;
+	    }
+	  }
+
+// Give others a chance to join the first one.
+
+	  if (ul_queue_bytes < UPLINK_BATCH_BYTES && now < ul_queue_head->queued_at + UPLINK_COALESCE_DELAY) {
+	    uplink_wait (ul_queue_head->queued_at + UPLINK_COALESCE_DELAY);
+	    dw_mutex_unlock (&ul_mutex);
+	    continue;
+	  }
+
+// Take as much as fits in the buffer and write outside the critical section.
+// Keep the lines until we know the write was successful.
+
+	  while (ul_queue_head != NULL && len + ul_queue_head->len <= UPLINK_BUF_SIZE) {
+	    struct uplink_line_s *line = ul_queue_head;
+
+	    ul_queue_head = line->next;
+	    if (ul_queue_head == NULL) {
+	      ul_queue_tail = NULL;
+	    }
+	    ul_queue_depth--;
+	    ul_queue_bytes -= line->len;
+
+	    line->next = NULL;
+	    if (batch == NULL) {
+	      batch = line;
+	    }
+	    else {
+	      batch_tail->next = line;
+	    }
+	    batch_tail = line;
+
+	    memcpy (buf + len, line->data, line->len);
+	    len += line->len;
+	    nlines++;
+
+	    // Round trip time is measured from when it is written.
+
+	    if (line->kind == UL_PROBE) {
+	      is_server[my_server_index].probe_sent_at = dtime_now();
+	    }
+	  }
+
+	  sock = is_server[my_server_index].igate_sock;
+	  is_server[my_server_index].sock_users++;
+	  dw_mutex_unlock (&ul_mutex);
+
+	  if (s_debug >= 1) {
+	    int start = 0;
+
+	    for (int k = 0; k < len; k++) {
+	      if (buf[k] == '\n') {
+	        text_color_set(DW_COLOR_XMIT);
+	        dw_printf ("[rx>ig] ");
+	        ax25_safe_print (buf + start, k - 1 - start, 0);
+	        dw_printf ("\n");
+	        start = k + 1;
+	      }
+	    }
+	  }
+
+	  int sent = 0;
+	  while (sent < len) {
+	    int n = SOCK_SEND (sock, buf + sent, len - sent);
+	    if (n <= 0) break;
+	    sent += n;
+	  }
+
+	  dw_mutex_lock (&ul_mutex);
+
+	  if (sent == len) {
+	    stats_uplink_sent += nlines;
+	    stats_uplink_bytes += len;
+	  }
+	  else {
+
+	    // Put them back at the front of the queue for the standby connection or
+	    // the next one.  Some might have been sent already, but the servers
+	    // remove duplicates.
+
+	    batch_tail->next = ul_queue_head;
+	    if (ul_queue_head == NULL) {
+	      ul_queue_tail = batch_tail;
+	    }
+	    ul_queue_head = batch;
+	    ul_queue_depth += nlines;
+	    ul_queue_bytes += len;
+	    batch = NULL;
+
+	    // Someone else might have noticed the problem first.
+
+	    lost = server_sock_drop (my_server_index, sock);
+	  }
+	  server_sock_put (my_server_index);
+
+	  dw_mutex_unlock (&ul_mutex);
+
+	  while (batch != NULL) {
+	    struct uplink_line_s *line = batch;
+	    batch = line->next;
+	    free (line);
+	  }
+
+	  if (lost) {
+	    text_color_set(DW_COLOR_ERROR);
+#if __WIN32__
+	    dw_printf ("\nError %d sending to IGate server.  Closing connection.\n\n", WSAGetLastError());
+	    WSACleanup();
+#else
+	    dw_printf ("\nError sending to IGate server.  Closing connection.\n\n");
+#endif
+	  }
+	}  /* while (1) */
+	return (0);
+
+} /* end uplink_thread */
+
+
+/*-------------------------------------------------------------------
+ *
+ * Name:        get1ch
+ *
+ * Purpose:     Read one byte from socket.
+ *
+ * Inputs:	igate_sock	- file handle for socket.
+ *
+ * Returns:	One byte from stream.
+ *		Waits and tries again later if any error.
+ *
+ *
+ *--------------------------------------------------------------------*/
+
+static int get1ch (int my_server_index)
+{
+	unsigned char ch;
+	int n;
+	int sock;
+
+	while (1) {
+
+	  while ((sock = is_server[my_server_index].igate_sock) == -1) {
+	    SLEEP_MS(250);			/* Not connected.  Try again soon. */
+	  }
+
+	  /* Just get one byte at a time. */
+	  // TODO: Should read complete packets and unpack from own buffer
+	  // rather than using a system call for each byte.
+
+	  n = SOCK_RECV (sock, (char*)(&ch), 1);
+
+	  if (n == 1) {		// Success
+#if DEBUG9
+	    dw_printf (log_fp, "%02x %c %c", ch, 
+			isprint(ch) ? ch : '.' , 
+			(isupper(ch>>1) || isdigit(ch>>1) || (ch>>1) == ' ') ? (ch>>1) : '.');
+	    if (ch == '\r') fprintf (log_fp, "  CR");
+	    if (ch == '\n') fprintf (log_fp, "  LF");
+	    fprintf (log_fp, "\n");
+#endif
+	    return(ch);	
+	  }
+
+	  // Linux man page: "These calls return the number of bytes received, or -1 if an error occurred
+	  // The return value will be 0 when the peer has performed an orderly shutdown.
+
+	  // I saw 0 when two different clients were logged in with same callsign-ssid.
+
+	  // Nothing to report if someone else already dropped the connection.
+
+	  char ipaddr_str[46];
+
+	  dw_mutex_lock (&ul_mutex);
+	  int lost = server_sock_drop (my_server_index, sock);
+	  strlcpy (ipaddr_str, is_server[my_server_index].ipaddr_str, sizeof(ipaddr_str));
+	  dw_mutex_unlock (&ul_mutex);
+
+	  if (lost) {
+            text_color_set(DW_COLOR_ERROR);
+	    if (n == 0) {
+	      dw_printf ("\nServer %s has closed connection.\n\n", ipaddr_str);
+	    }
+	    else {
+	      dw_printf ("\nError reading from server %s.  Closing connection.\n\n", ipaddr_str);
+	    }
+	  }
+	}
+
+} /* end get1ch */
+
+
+
+
+/*-------------------------------------------------------------------
+ *
+ * Name:        split_is_line
+ *
+ * Purpose:     Find the parts of a line from the APRS-IS server that we
+ *		need to decide what to do with it.
+ *
+ * Inputs:	message	- Line from server, without CR/LF, nul terminated.
+ *
+ * Outputs:	line	- Pointers into message, and lengths.  Nothing is copied.
+ *
+ * Returns:	1 for success.
+ *		0 if we don't find "source>" before ":".
+ *
+ * Description:	Almost everything the server sends is discarded.
+ *		Building a packet object for each line, just to look at
+ *		the source address, via path, and data type, is a lot of
+ *		wasted effort.  We do that only for lines that might be
+ *		transmitted.
+ *
+ *--------------------------------------------------------------------*/
+
+struct is_line_s {
+	const char *src;		/* Source address, not terminated. */
+	int src_len;
+	const char *path;		/* Destination and via path, between ">" and ":". */
+	int path_len;
+	const char *info;		/* Information part, to end of message, so nul terminated. */
+	char dti;			/* Data type indicator.  First character of information part. */
+};
+
+static int split_is_line (const char *message, struct is_line_s *line)
+{
+	const char *gt = strchr(message, '>');
+	if (gt == NULL || gt == message) return (0);
+
+	const char *colon = strchr(gt, ':');
+	if (colon == NULL) return (0);
+
+	line->src = message;
+	line->src_len = (int)(gt - message);
+	line->path = gt + 1;
+	line->path_len = (int)(colon - line->path);
+	line->info = colon + 1;
+	line->dti = *(line->info);
+	return (1);
+}
+
+
+/*
+ * Does the via path contain something telling us not to transmit?
+ *	NOGATE or RFONLY - means IGate should not pass them.
+ *	TCPXX or qAX - means it came from somewhere that did not identify itself correctly.
+ * Return pointer to it, for debug message, or NULL.
+ */
+
+static const char *via_no_gate (const struct is_line_s *line, int *len)
+{
+	static const char *nogate[] = { "qAX", "TCPXX", "RFONLY", "NOGATE" };	// qAX and TCPXX deprecated. http://www.aprs-is.net/q.aspx
+	const char *p = line->path;
+	const char *end = line->path + line->path_len;
+
+	p = memchr (p, ',', end - p);			// Skip destination.
+	while (p != NULL && p < end) {
+	  const char *via = p + 1;
+	  const char *comma = memchr (via, ',', end - via);
+	  int n = (int)((comma != NULL ? comma : end) - via);
+
+	  if (n > 0 && via[n-1] == '*') n--;		// Used flag is not part of the address.
+
+	  for (int k = 0; k < (int)(sizeof(nogate) / sizeof(nogate[0])); k++) {
+	    if (n == (int)strlen(nogate[k]) && strncmp(via, nogate[k], n) == 0) {
+	      *len = n;
+	      return (via);
+	    }
+	  }
+	  p = comma;
+	}
+	return (NULL);
+}
+
+
+/*
+ * Should packets from this connection be used?
+ * Always for a single connection and for CWOP.
+ * With a standby, only for the one selected for use.
+ */
+
+static int is_active_server (int my_server_index)
+{
+	int a;
+
+	if (save_igate_config_p->cwop_mode || num_is_servers < 2) return (1);
+	if (my_server_index == active_server) return (1);
+
+	dw_mutex_lock (&ul_mutex);
+	a = select_aprs_server ();
+	dw_mutex_unlock (&ul_mutex);
+
+	return (a == my_server_index);
+}
+
+
+/*-------------------------------------------------------------------
+ *
+ * Name:        igate_recv_thread
+ *
+ * Purpose:     Wait for messages from IGate Server.
+ *
+ * Inputs:	arg		- Index into the server table for CWOP mode.
+ *				  Should be zero for regular APRS-IS.
+ *
+ * Outputs:	igate_sock	- File descriptor for communicating with client app.
+ *
+ * Description:	Process messages from the IGate server.
+ *
+ *--------------------------------------------------------------------*/
+
+#if __WIN32__
+static unsigned __stdcall igate_recv_thread (void *arg)
+#else
+static void * igate_recv_thread (void *arg)
+#endif
+{
+	int my_server_index = (int)(ptrdiff_t)arg;
+	
+	unsigned char ch;
+	unsigned char message[1000];  // Spec says max 512.
+	int len;
+	
+			
+#if DEBUGx
+	text_color_set(DW_COLOR_DEBUG);
+	dw_printf ("igate_recv_thread ( socket = %d )\n", is_server[my_server_index].igate_sock);
+#endif
+
+	while (1) {
+
+	  len = 0;
+
+	  do
+	  {
+	    ch = get1ch(my_server_index);
+	    stats_downlink_bytes++;
+
+	    // I never expected to see a nul character but it can happen.
+	    // If found, change it to <0x00> and ax25_from_text will change it back to a single byte.
+	    // Along the way we can use the normal C string handling.
+
+	    if (ch == 0 && len < (int)(sizeof(message)) - 5) {
 	      message[len++] = '<';
 	      message[len++] = '0';
 	      message[len++] = 'x';
@@ -1822,8 +2829,28 @@ static void * igate_recv_thread (void *arg)
 	      dw_printf ("[ig] ");
 	      ax25_safe_print ((char *)message, len, 0);
 	      dw_printf ("\n");
+
+/*
+ * Version 1.8:  Response to login.  We can start sending now rather than
+ * waiting a fixed time.  Remember how long it took to choose between
+ * the connection in use and the standby.
+ */
+	      if (strncmp((char *)message, "# logresp", 9) == 0 && is_server[my_server_index].login_sent_at > 0) {
+	        dw_mutex_lock (&ul_mutex);
+	        is_server[my_server_index].latency = dtime_now() - is_server[my_server_index].login_sent_at;
+	        dw_mutex_unlock (&ul_mutex);
+	        is_server[my_server_index].ok_to_send = 1;
+	      }
+	    }
+	    else if (strncmp((char *)message, "# filter", 8) == 0 && ! save_igate_config_p->cwop_mode) {
+	      rtt_response (my_server_index);
 	    }
 	  }
+	  else if ( ! is_active_server(my_server_index)) {
+/*
+ * Standby connection gets the same packets.  Use them only if it takes over.
+ */
+	  }
 	  else 
 	  {
 /*
@@ -1851,10 +2878,18 @@ static void * igate_recv_thread (void *arg)
 	      //}
 	    }
 
+/*
+ * Find the source address, via path, and data type without building a packet object.
+ */
+	    struct is_line_s line;
+	    int ok = split_is_line ((char *)message, &line);
+
 /*
  * Record that we heard from the source address.
  */
-	    mheard_save_is ((char *)message);
+	    if (ok) {
+	      mheard_save_is (line.src, line.src_len);
+	    }
 
 	    stats_downlink_packets++;
 
@@ -1864,7 +2899,14 @@ static void * igate_recv_thread (void *arg)
 	    int to_chan = save_igate_config_p->tx_chan;
 
 	    if (to_chan >= 0) {
-	      maybe_xmit_packet_from_igate ((char*)message, to_chan);
+	      if (ok) {
+	        maybe_xmit_packet_from_igate ((char*)message, &line, to_chan);
+	      }
+	      else {
+	        text_color_set(DW_COLOR_ERROR);
+	        dw_printf ("Tx IGate: Could not parse message from server.\n");
+	        dw_printf ("%s\n", message);
+	      }
 	    }
 
 
@@ -1971,32 +3013,45 @@ static void * igate_recv_thread (void *arg)
 
 static void satgate_delay_packet (packet_t pp, int chan)
 {
-	packet_t pnext, plast;
-
-
-	//if (s_debug >= 1) {
-	  text_color_set(DW_COLOR_INFO);
-	  dw_printf ("Rx IGate: SATgate mode, delay packet heard directly.\n");
-	//}
+	int was_empty;
 
 	ax25_set_release_time (pp, dtime_now() + save_igate_config_p->satgate_delay);
+	ax25_set_nextp (pp, NULL);
 //TODO: save channel too.
 
 	dw_mutex_lock (&dp_mutex);
 
-	if (dp_queue_head == NULL) {
+	was_empty = (dp_queue_head == NULL);
+	if (was_empty) {
 	  dp_queue_head = pp;
 	}
 	else {
-	  plast = dp_queue_head;
-	  while ((pnext = ax25_get_nextp(plast)) != NULL) {
-	    plast = pnext;
-	  }
-	  ax25_set_nextp (plast, pp);
+	  ax25_set_nextp (dp_queue_tail, pp);
+	}
+	dp_queue_tail = pp;
+	dp_queue_depth++;
+	if (dp_queue_depth > dp_queue_max_depth) {
+	  dp_queue_max_depth = dp_queue_depth;
+	}
+
+// The delay thread only needs a nudge when the queue was empty.
+// Otherwise it is already waiting for the head, which is due first.
+
+	if (was_empty) {
+#if __WIN32__
+	  SetEvent (dp_wake_up_event);
+#else
+	  pthread_cond_signal (&dp_wake_up_cond);
+#endif
 	}
 
 	dw_mutex_unlock (&dp_mutex);
 
+	//if (s_debug >= 1) {
+	  text_color_set(DW_COLOR_INFO);
+	  dw_printf ("Rx IGate: SATgate mode, delay packet heard directly.\n");
+	//}
+
 } /* end satgate_delay_packet */
 
 
@@ -2005,14 +3060,19 @@ static void satgate_delay_packet (packet_t pp, int chan)
  *
  * Name:        satgate_delay_thread
  *
- * Purpose:     Release packet when specified release time has arrived.
+ * Purpose:     Release packets when their release time has arrived.
  *
  * Inputs:	dp_queue_head	- Queue of packets.
  *
  * Outputs:	Sent to APRS IS.
  *
- * Description:	For simplicity we'll just poll each second.
- *		Release the packet when its time has arrived.
+ * Description:	Originally this polled once a second and released
+ *		at most one packet each time.  During a busy satellite
+ *		pass they backed up and went out later and later.
+ *
+ *		Now we sleep until the packet at the head of the queue
+ *		is due, or something is added to an empty queue, and
+ *		then release everything that is due.
  *
  *--------------------------------------------------------------------*/
 
@@ -2022,39 +3082,79 @@ static unsigned __stdcall satgate_delay_thread (void *arg)
 static void * satgate_delay_thread (void *arg)
 #endif
 {
-	double release_time;
 	int chan = 0;				// TODO:  get receive channel somehow.
 						// only matters if multi channel with different names.
-		
+
 	while (1) {
-	  SLEEP_SEC (1);
+	  packet_t due = NULL;
+	  packet_t due_tail = NULL;
 
-/* Don't need critical region just to peek */
+	  dw_mutex_lock (&dp_mutex);
 
-	  if (dp_queue_head != NULL) {
+	  while (dp_queue_head == NULL) {
+#if __WIN32__
+	    dw_mutex_unlock (&dp_mutex);
+	    WaitForSingleObject (dp_wake_up_event, INFINITE);
+	    dw_mutex_lock (&dp_mutex);
+#else
+	    pthread_cond_wait (&dp_wake_up_cond, &dp_mutex);
+#endif
+	  }
 
-	    double now = dtime_now();
+	  double release_time = ax25_get_release_time (dp_queue_head);
+	  double now = dtime_now();
 
-	    release_time = ax25_get_release_time (dp_queue_head);
+	  if (now < release_time) {
+#if __WIN32__
+	    DWORD ms = (DWORD)((release_time - now) * 1000) + 1;
+	    dw_mutex_unlock (&dp_mutex);
+	    WaitForSingleObject (dp_wake_up_event, ms);
+	    dw_mutex_lock (&dp_mutex);
+#else
+	    struct timespec abstime;
 
-#if 0
-	    text_color_set(DW_COLOR_DEBUG);
-	    dw_printf ("SATgate:  %.1f sec remaining\n", release_time - now);
+	    abstime.tv_sec = (time_t)(long)release_time;
+	    abstime.tv_nsec = (long)((release_time - (long)abstime.tv_sec) * 1000000000.0);
+	    pthread_cond_timedwait (&dp_wake_up_cond, &dp_mutex, &abstime);
 #endif
-	    if (now > release_time) {
-	      packet_t pp;
+	    now = dtime_now();
+	  }
 
-	      dw_mutex_lock (&dp_mutex);
+// Take everything that is due, in one piece, and send outside the critical section.
 
-	      pp = dp_queue_head;
-	      dp_queue_head = ax25_get_nextp(pp);
+	  while (dp_queue_head != NULL && ax25_get_release_time (dp_queue_head) <= now) {
+	    packet_t pp = dp_queue_head;
 
-	      dw_mutex_unlock (&dp_mutex);
-	      ax25_set_nextp (pp, NULL);
+	    dp_queue_head = ax25_get_nextp (pp);
+	    if (dp_queue_head == NULL) {
+	      dp_queue_tail = NULL;
+	    }
+	    dp_queue_depth--;
 
-	      send_packet_to_server (pp, chan);
+	    ax25_set_nextp (pp, NULL);
+	    if (due == NULL) {
+	      due = pp;
+	    }
+	    else {
+	      ax25_set_nextp (due_tail, pp);
 	    }
-	  }  /* if something in queue */
+	    due_tail = pp;
+	  }
+
+	  dw_mutex_unlock (&dp_mutex);
+
+	  while (due != NULL) {
+	    packet_t pp = due;
+
+	    due = ax25_get_nextp (pp);
+	    ax25_set_nextp (pp, NULL);
+
+#if 0
+	    text_color_set(DW_COLOR_DEBUG);
+	    dw_printf ("SATgate:  released %.3f sec late\n", now - ax25_get_release_time (pp));
+#endif
+	    send_packet_to_server (pp, chan);
+	  }
 	}  /* while (1) */
 	return (0);
 
@@ -2095,8 +3195,15 @@ static void * satgate_delay_thread (void *arg)
  *				  the packet to the server did not login properly as a ham radio
  *				  operator so we don't want to put this on to RF.
  *
+ *		line		- Parts of message found by split_is_line.
+ *
  *		to_chan		- Radio channel for transmitting.
  *
+ * Description:	Version 1.8:  Most lines are rejected by the via path or,
+ *		with the default i/ filter, because they are not "messages."
+ *		Check for those first, using only the text, and build a
+ *		packet object only for what remains.
+ *
  *--------------------------------------------------------------------*/
 
 
@@ -2127,12 +3234,50 @@ static int is_message_message (char *infop)
 }
 
 
-static void maybe_xmit_packet_from_igate (char *message, int to_chan)
+static void maybe_xmit_packet_from_igate (char *message, const struct is_line_s *line, int to_chan)
 {
-	int n;
-
 	assert (to_chan >= 0 && to_chan < MAX_TOTAL_CHANS);
 
+/*
+ * Drop if path contains:
+ *	NOGATE or RFONLY - means IGate should not pass them.
+ *	TCPXX or qAX - means it came from somewhere that did not identify itself correctly.
+ */
+	int via_len;
+	const char *via = via_no_gate (line, &via_len);
+
+	if (via != NULL) {
+	  if (s_debug >= 1) {
+	    text_color_set(DW_COLOR_DEBUG);
+	    dw_printf ("Tx IGate: Do not transmit with %.*s in path.\n", via_len, via);
+	  }
+	  return;
+	}
+
+// Issue 408: The source address might not be valid AX.25 because it
+// came from a non-RF station.  e.g.  some server responding to a message.
+// We need to take source address from original rather than extracting it
+// from the packet object.
+
+	char src[AX25_MAX_ADDR_LEN];		/* Source address. */
+	int src_len = line->src_len < (int)sizeof(src) - 1 ? line->src_len : (int)sizeof(src) - 1;
+	memcpy (src, line->src, src_len);
+	src[src_len] = '\0';
+
+/*
+ * If the filter passes only "messages," anything else can go now.
+ * Third party traffic might contain a message so leave that for the filter.
+ * Don't drop a position from a message sender.  See special case below.
+ */
+	char *filter = save_digi_config_p->filter_str[MAX_TOTAL_CHANS][to_chan];
+
+	if (filter != NULL && line->dti != ':' && line->dti != '}' && pfilter_messages_only(filter)) {
+
+	  if (line->dti == '\0' || strchr("!=/@'`", line->dti) == NULL || mheard_get_msp(src) <= 0) {
+	    return;
+	  }
+	}
+
 /*
  * Try to parse it into a packet object; we need this for the packet filtering.
  *
@@ -2161,44 +3306,6 @@ static void maybe_xmit_packet_from_igate (char *message, int to_chan)
 	  return;
 	}
 
-// Issue 408: The source address might not be valid AX.25 because it
-// came from a non-RF station.  e.g.  some server responding to a message.
-// We need to take source address from original rather than extracting it
-// from the packet object.
-
-	char src[AX25_MAX_ADDR_LEN];		/* Source address. */
-	memset (src, 0, sizeof(src));
-	memcpy (src, message, sizeof(src)-1);
-	char *gt = strchr(src, '>');
-	if (gt != NULL) {
-	    *gt = '\0';
-	}
-
-/*
- * Drop if path contains:
- *	NOGATE or RFONLY - means IGate should not pass them.
- *	TCPXX or qAX - means it came from somewhere that did not identify itself correctly.
- */
-	for (n = 0; n < ax25_get_num_repeaters(pp3); n++) {
-	  char via[AX25_MAX_ADDR_LEN];	/* includes ssid. Do we want to ignore it? */
-
-	  ax25_get_addr_with_ssid (pp3, n + AX25_REPEATER_1, via);
-
-	  if (strcmp(via, "qAX") == 0 ||		// qAX deprecated. http://www.aprs-is.net/q.aspx
-	      strcmp(via, "TCPXX") == 0 ||		// TCPXX deprecated.
-	      strcmp(via, "RFONLY") == 0 ||
-	      strcmp(via, "NOGATE") == 0) {
-
-	    if (s_debug >= 1) {
-	      text_color_set(DW_COLOR_DEBUG);
-	      dw_printf ("Tx IGate: Do not transmit with %s in path.\n", via);
-	    }
-
-	    ax25_delete (pp3);
-	    return;
-	  }
-	}
-
 /*
  * Apply our own packet filtering if configured.
  * Do we want to do this before or after removing the VIA path?
@@ -32,6 +32,14 @@ struct igate_config_s {
 
 	int cwop_mode;			/* Read from multiple servers rather than normal IGate. */
 
+	int t2_standby;			/* Keep a second connection logged in, ready to take over */
+					/* immediately if the one in use is lost. */
+
+	char t2_standby_name[40];	/* Server for the standby connection.  Empty means */
+					/* another address for t2_server_name. */
+
+	int t2_standby_port;
+
 	char t2_login[AX25_MAX_ADDR_LEN];/* e.g. WA9XYZ-15 */
 					/* Note that the ssid could be any two alphanumeric */
 					/* characters not just 1 thru 15. */
@@ -126,5 +134,23 @@ int igate_get_upl_cnt (void);
 int igate_get_dnl_cnt (void);
 
 
+/* SATgate delay queue, for network statistics. */
+
+int igate_get_satgate_depth (void);
+
+int igate_get_satgate_max_depth (void);
+
+
+/* Uplink queue to APRS-IS server, for network statistics. */
+
+int igate_get_uplink_depth (void);
+
+int igate_get_uplink_queued (void);
+
+int igate_get_uplink_sent (void);
+
+int igate_get_uplink_dropped (void);
+
+
 
 #endif
@@ -38,7 +38,7 @@ extern struct rs *il2p_find_rs(int nparity);	// Internal later?
 
 extern void il2p_encode_rs (unsigned char *tx_data, int data_size, int num_parity, unsigned char *parity_out);
 
-extern int il2p_decode_rs (unsigned char *rec_block, int data_size, int num_parity, unsigned char *out);
+extern int il2p_decode_rs (unsigned char *rec_block, int data_size, int num_parity, const unsigned char *conf, unsigned char *out);
 
 extern int il2p_get_debug(void);
 extern void il2p_set_debug(int debug);
@@ -52,7 +52,9 @@ extern void il2p_set_debug(int debug);
 
 // Receives a bit stream from demodulator.
 
-extern void il2p_rec_bit (int chan, int subchan, int slice, int dbit);
+struct rx_chain_s;
+
+extern void il2p_rec_bit (struct rx_chain_s *R, int subchan, int slice, int dbit, int quality);
 
 
 
@@ -83,7 +85,7 @@ extern int il2p_encode_frame (packet_t pp, int max_fec, unsigned char *iout);
 
 packet_t il2p_decode_frame (unsigned char *irec);
 
-packet_t il2p_decode_header_payload (unsigned char* uhdr, unsigned char *epayload, int *symbols_corrected);
+packet_t il2p_decode_header_payload (unsigned char* uhdr, unsigned char *epayload, const unsigned char *pconf, int *symbols_corrected);
 
 
 
@@ -138,7 +140,7 @@ extern int il2p_payload_compute (il2p_payload_properties_t *p, int payload_size,
 
 extern int il2p_encode_payload (unsigned char *payload, int payload_size, int max_fec, unsigned char *enc);
 
-extern int il2p_decode_payload (unsigned char *received, int payload_size, int max_fec, unsigned char *payload_out, int *symbols_corrected);
+extern int il2p_decode_payload (unsigned char *received, int payload_size, int max_fec, const unsigned char *conf, unsigned char *payload_out, int *symbols_corrected);
 
 extern int il2p_get_header_attributes (unsigned char *hdr, int *hdr_type, int *max_fec);
 
@@ -152,6 +152,7 @@ void il2p_encode_rs (unsigned char *tx_data, int data_size, int num_parity, unsi
  *				Total size is sum of following two parameters.
  *		data_size	Number of data bytes in above.
  *		num_parity	Number of parity symbols (bytes) in above.
+ *		conf		Confidence for each byte of rec_block, or NULL.
  *
  * Outputs:	out		Original with possible corrections applied.
  *				data_size bytes.
@@ -159,9 +160,22 @@ void il2p_encode_rs (unsigned char *tx_data, int data_size, int num_parity, unsi
  * Returns:	-1 for unrecoverable.
  *		>= 0 for success.  Number of symbols corrected.
  *
+ * Description:	If the block can't be fixed and the confidence is known,
+ *		try again with all but two of the parity symbols used for
+ *		erasures of the least reliable bytes.  An erasure costs one
+ *		parity symbol rather than two for an error so up to
+ *		num_parity-2 bad bytes can be fixed rather than num_parity/2.
+ *
+ *		Unlike FX.25, there is no CRC to catch a wrong result so the
+ *		two remaining parity symbols are used only for checking.
+ *		The result is rejected if anything other than an erased
+ *		byte had to be changed.
+ *
  *--------------------------------------------------------------*/
 
-int il2p_decode_rs (unsigned char *rec_block, int data_size, int num_parity, unsigned char *out)
+static int erasure_decode (unsigned char *rec_block, int n, int num_parity, const unsigned char *conf, unsigned char *rs_block, int *derrlocs);
+
+int il2p_decode_rs (unsigned char *rec_block, int data_size, int num_parity, const unsigned char *conf, unsigned char *out)
 {
 
 	//  Use zero padding in front if data size is too small.
@@ -186,7 +200,6 @@ int il2p_decode_rs (unsigned char *rec_block, int data_size, int num_parity, uns
 	int derrlocs[FX25_MAX_CHECK];	// Half would probably be OK.
 
 	int derrors = DECODE_RS(il2p_find_rs(num_parity), rs_block, derrlocs, 0);
-	memcpy (out, rs_block + sizeof(rs_block) - n, data_size);
 
 	if (il2p_get_debug() >= 3) {
 	    if (derrors == 0) {
@@ -216,6 +229,12 @@ int il2p_decode_rs (unsigned char *rec_block, int data_size, int num_parity, uns
 	    }
 	}
 
+	if (derrors < 0 && conf != NULL && num_parity >= 6) {
+	    derrors = erasure_decode (rec_block, n, num_parity, conf, rs_block, derrlocs);
+	}
+
+	memcpy (out, rs_block + sizeof(rs_block) - n, data_size);
+
 	if (il2p_get_debug() >= 3) {
             text_color_set(DW_COLOR_DEBUG);
 	    dw_printf ("==============================  il2p_decode_rs  returns %d  ==============================\n", derrors);
@@ -223,4 +242,43 @@ int il2p_decode_rs (unsigned char *rec_block, int data_size, int num_parity, uns
 	return (derrors);
 }
 
+
+static int erasure_decode (unsigned char *rec_block, int n, int num_parity, const unsigned char *conf, unsigned char *rs_block, int *derrlocs)
+{
+	int pad = FX25_BLOCK_SIZE - n;
+	int no_eras = num_parity - 2;
+	int eras_pos[FX25_MAX_CHECK];
+
+	// Start over from what was received.  A failed decode can leave partial changes.
+
+	memset (rs_block, 0, pad);
+	memcpy (rs_block + pad, rec_block, n);
+
+	fx25_pick_erasures (conf, n, no_eras, pad, eras_pos);
+	memcpy (derrlocs, eras_pos, no_eras * sizeof(int));
+
+	int derrors = DECODE_RS(il2p_find_rs(num_parity), rs_block, derrlocs, no_eras);
+	if (derrors < 0) {
+	    memcpy (rs_block + pad, rec_block, n);
+	    return (-1);
+	}
+
+	for (int i = 0; i < derrors; i++) {
+	    int erased = 0;
+	    for (int k = 0; k < no_eras; k++) {
+	        if (derrlocs[i] == eras_pos[k]) erased = 1;
+	    }
+	    if ( ! erased) {
+	        memcpy (rs_block + pad, rec_block, n);
+	        return (-1);
+	    }
+	}
+
+	if (il2p_get_debug() >= 3) {
+	    text_color_set(DW_COLOR_DEBUG);
+	    dw_printf ("RS block fixed with %d erasures.\n", no_eras);
+	}
+	return (derrors);
+}
+
 // end il2p_init.c
\ No newline at end of file
@@ -198,6 +198,9 @@ int il2p_encode_payload (unsigned char *payload, int payload_size, int max_fec,
  *		payload_size	0 to 1023.  (IL2P_MAX_PAYLOAD_SIZE)
  *				Expected result size based on header.
  *		max_fec		true for 16 parity symbols, false for automatic.
+ *		conf		Confidence for each received byte, or NULL.
+ *				Used to pick erasures for blocks that can't
+ *				be fixed otherwise.
  *
  * Outputs:	payload_out	Recovered payload.
  *
@@ -215,7 +218,7 @@ int il2p_encode_payload (unsigned char *payload, int payload_size, int max_fec,
  *
  *--------------------------------------------------------------------------------*/
 
-int il2p_decode_payload (unsigned char *received, int payload_size, int max_fec, unsigned char *payload_out, int *symbols_corrected)
+int il2p_decode_payload (unsigned char *received, int payload_size, int max_fec, const unsigned char *conf, unsigned char *payload_out, int *symbols_corrected)
 {
 // Determine number of blocks and sizes.
 
@@ -227,6 +230,7 @@ int il2p_decode_payload (unsigned char *received, int payload_size, int max_fec,
 	}
 
 	unsigned char *pin = received;
+	const unsigned char *pconf = conf;
 	unsigned char *pout = payload_out;
 	int decoded_length = 0;
 	int failed = 0;
@@ -235,7 +239,7 @@ int il2p_decode_payload (unsigned char *received, int payload_size, int max_fec,
 
 	for (int b = 0; b < ipp.large_block_count; b++) {
 	    unsigned char corrected_block[255];
-	    int e = il2p_decode_rs (pin, ipp.large_block_size, ipp.parity_symbols_per_block, corrected_block);
+	    int e = il2p_decode_rs (pin, ipp.large_block_size, ipp.parity_symbols_per_block, pconf, corrected_block);
 
 	    // dw_printf ("%s:%d: large block decode_rs returned status = %d\n", __FILE__, __LINE__, e);
 
@@ -251,6 +255,7 @@ int il2p_decode_payload (unsigned char *received, int payload_size, int max_fec,
 	    }
 
 	    pin += ipp.large_block_size + ipp.parity_symbols_per_block;
+	    if (pconf != NULL) pconf += ipp.large_block_size + ipp.parity_symbols_per_block;
 	    pout += ipp.large_block_size;
 	    decoded_length += ipp.large_block_size;
 	}
@@ -259,7 +264,7 @@ int il2p_decode_payload (unsigned char *received, int payload_size, int max_fec,
 
 	for (int b = 0; b < ipp.small_block_count; b++) {
 	    unsigned char corrected_block[255];
-	    int e = il2p_decode_rs (pin, ipp.small_block_size, ipp.parity_symbols_per_block, corrected_block);
+	    int e = il2p_decode_rs (pin, ipp.small_block_size, ipp.parity_symbols_per_block, pconf, corrected_block);
 
 	    // dw_printf ("%s:%d: small block decode_rs returned status = %d\n", __FILE__, __LINE__, e);
 
@@ -275,6 +280,7 @@ int il2p_decode_payload (unsigned char *received, int payload_size, int max_fec,
 	    }
 
 	    pin += ipp.small_block_size + ipp.parity_symbols_per_block;
+	    if (pconf != NULL) pconf += ipp.small_block_size + ipp.parity_symbols_per_block;
 	    pout += ipp.small_block_size;
 	    decoded_length += ipp.small_block_size;
 	}
@@ -39,6 +39,8 @@
 #include "il2p.h"
 #include "multi_modem.h"
 #include "demod.h"
+#include "rxprof.h"
+#include "rx_chain.h"
 
 
 struct il2p_context_s {
@@ -66,10 +68,14 @@ struct il2p_context_s {
 				// Scrambled and encoded payload as received over the radio.
 	int pc;			// Number of bytes placed in above.
 
+	unsigned char pconf[IL2P_MAX_ENCODED_PAYLOAD_SIZE];
+				// Confidence for each byte of spayload, worst of its bits.
+	int bq;			// Worst bit quality so far for byte being accumulated.
+
 	int corrected;		// Number of symbols corrected by RS FEC.
 };
 
-static struct il2p_context_s *il2p_context[MAX_RADIO_CHANS][MAX_SUBCHANS][MAX_SLICERS];
+// One for each subchannel and slicer is found in the rx_chain_s for the channel.
 
 
 
@@ -79,7 +85,7 @@ static struct il2p_context_s *il2p_context[MAX_RADIO_CHANS][MAX_SUBCHANS][MAX_SL
  *
  * Purpose:     Extract FX.25 packets from a stream of bits.
  *
- * Inputs:      chan    - Channel number.
+ * Inputs:      R       - Receive chain for the radio channel.
  *
  *              subchan - This allows multiple demodulators per channel.
  *
@@ -87,6 +93,9 @@ static struct il2p_context_s *il2p_context[MAX_RADIO_CHANS][MAX_SUBCHANS][MAX_SL
  *
  *              dbit	- One bit from the received data stream.
  *
+ *		quality	- Confidence in the bit, 0 to 100.
+ *			  Used to pick erasures for payload blocks that can't be fixed otherwise.
+ *
  * Description: This is called once for each received bit.
  *              For each valid packet, process_rec_frame() is called for further processing.
  *		It can gather multiple candidates from different parallel demodulators
@@ -94,19 +103,17 @@ static struct il2p_context_s *il2p_context[MAX_RADIO_CHANS][MAX_SUBCHANS][MAX_SL
  *
  ***********************************************************************************/
 
-void il2p_rec_bit (int chan, int subchan, int slice, int dbit)
+void il2p_rec_bit (struct rx_chain_s *R, int subchan, int slice, int dbit, int quality)
 {
+	int chan = R->chan;
 
 // Allocate context blocks only as needed.
 
-	struct il2p_context_s *F = il2p_context[chan][subchan][slice];
+	struct il2p_context_s *F = R->il2p[subchan][slice];
 	if (F == NULL) {
-          assert (chan >= 0 && chan < MAX_RADIO_CHANS);
           assert (subchan >= 0 && subchan < MAX_SUBCHANS);
           assert (slice >= 0 && slice < MAX_SLICERS);
-	  F = il2p_context[chan][subchan][slice] = (struct il2p_context_s *)malloc(sizeof (struct il2p_context_s));
-	  assert (F != NULL);
-	  memset (F, 0, sizeof(struct il2p_context_s));
+	  F = R->il2p[subchan][slice] = rx_chain_alloc (sizeof (struct il2p_context_s));
 	}
 
 // Accumulate most recent 24 bits received.  Most recent is LSB.
@@ -159,7 +166,9 @@ void il2p_rec_bit (int chan, int subchan, int slice, int dbit)
 	        }
 
 		// Fix any errors and descramble.
+	        RXPROF_FRAME_ENTER (&R->prof, RXPROF_FEC)
 	        F->corrected = il2p_clarify_header(F->shdr, F->uhdr);
+	        RXPROF_FRAME_LEAVE (&R->prof, RXPROF_FEC)
 
 	        if (F->corrected >= 0) {	// Good header.
 						// How much payload is expected?
@@ -182,6 +191,7 @@ void il2p_rec_bit (int chan, int subchan, int slice, int dbit)
 
 	           if (F->eplen >= 1) {		// Need to gather payload.
 	             F->pc = 0;
+	             F->bq = 100;
 	             F->state = IL2P_PAYLOAD;
 	           }
 	           else if (F->eplen == 0) {	// No payload.
@@ -207,9 +217,12 @@ void il2p_rec_bit (int chan, int subchan, int slice, int dbit)
 
 	  case IL2P_PAYLOAD:		// Gathering the payload, if any.
 
+	    if (quality < F->bq) F->bq = quality;
 	    F->bc++;
 	    if (F->bc == 8) {	// full byte has been collected.
 	      F->bc = 0;
+	      F->pconf[F->pc] = F->bq;
+	      F->bq = 100;
 	      if ( ! F->polarity) {
 	        F->spayload[F->pc++] = F->acc & 0xff;
 	      }
@@ -235,7 +248,10 @@ void il2p_rec_bit (int chan, int subchan, int slice, int dbit)
 	    // TODO?:  for symmetry, we might decode the payload here and later build the frame.
 
 	    {
-	      packet_t pp = il2p_decode_header_payload (F->uhdr, F->spayload, &(F->corrected));
+	      rx_chain_frame_end (R);
+	      RXPROF_FRAME_ENTER (&R->prof, RXPROF_FEC)
+	      packet_t pp = il2p_decode_header_payload (F->uhdr, F->spayload, F->pconf, &(F->corrected));
+	      RXPROF_FRAME_LEAVE (&R->prof, RXPROF_FEC)
 
 	      if (il2p_get_debug() >= 1) {
 	          if (pp != NULL) {
@@ -249,13 +265,13 @@ void il2p_rec_bit (int chan, int subchan, int slice, int dbit)
 	      }
 
 	      if (pp != NULL) {
-	          alevel_t alevel = demod_get_audio_level (chan, subchan);
+	          alevel_t alevel = demod_chain_audio_level (R, subchan);
 	          retry_t retries = F->corrected;
 	          fec_type_t fec_type = fec_type_il2p;
 
 	          // TODO: Could we put last 3 arguments in packet object rather than passing around separately?
 
-	          multi_modem_process_rec_packet (chan, subchan, slice, pp, alevel, retries, fec_type);
+	          multi_modem_process_rec_packet (R, subchan, slice, pp, alevel, retries, fec_type);
 	      }
 	    }   // end block for local variables.
 
@@ -29,6 +29,7 @@
 #include "ax25_pad.h"
 #include "ax25_pad2.h"
 #include "multi_modem.h"
+#include "rx_chain.h"
 
 
 static void test_scramble(void);
@@ -161,29 +162,66 @@ static void test_rs()
 	unsigned char corrected[15];
 	int e;
 
-	e = il2p_decode_rs (example_s, 13, 2, corrected);
+	e = il2p_decode_rs (example_s, 13, 2, NULL, corrected);
 	assert (e == 0);
 	assert (memcmp(example_s, corrected, 13) == 0);
 
 	memcpy (received, example_s, 15);
 	received[0] = '?';
-	e = il2p_decode_rs (received, 13, 2, corrected);
+	e = il2p_decode_rs (received, 13, 2, NULL, corrected);
 	assert (e == 1);
 	assert (memcmp(example_s, corrected, 13) == 0);
 
-	e = il2p_decode_rs (example_u, 13, 2, corrected);
+	e = il2p_decode_rs (example_u, 13, 2, NULL, corrected);
 	assert (e == 0);
 	assert (memcmp(example_u, corrected, 13) == 0);
 
 	memcpy (received, example_u, 15);
 	received[12] = '?';
-	e = il2p_decode_rs (received, 13, 2, corrected);
+	e = il2p_decode_rs (received, 13, 2, NULL, corrected);
 	assert (e == 1);
 	assert (memcmp(example_u, corrected, 13) == 0);
 
 	received[1] = '?';
 	received[2] = '?';
-	e = il2p_decode_rs (received, 13, 2, corrected);
+	e = il2p_decode_rs (received, 13, 2, NULL, corrected);
+	assert (e == -1);
+
+// Version 1.8:  Erasures.  With 16 parity symbols, 8 bad bytes can be
+// fixed without knowing where they are.  Make 12 bad and give them the
+// lowest confidence.  14 erasures leave 2 parity symbols for checking.
+
+	unsigned char block[200+16];
+	unsigned char conf[200+16];
+	unsigned char bad[200+16];
+
+	for (int i = 0; i < 200; i++) {
+	  block[i] = i * 7 + 3;
+	}
+	il2p_encode_rs (block, 200, 16, block + 200);
+
+	memcpy (bad, block, sizeof(block));
+	memset (conf, 100, sizeof(conf));
+	for (int i = 0; i < 12; i++) {
+	  bad[i*15+5] ^= 0xa5;
+	  conf[i*15+5] = 10;
+	}
+
+	unsigned char fixed[200];
+
+	e = il2p_decode_rs (bad, 200, 16, NULL, fixed);
+	assert (e == -1);
+
+	e = il2p_decode_rs (bad, 200, 16, conf, fixed);
+	assert (e == 14);		// Counts all erasures, including 2 which were right.
+	assert (memcmp(block, fixed, 200) == 0);
+
+// One more wrong byte with full confidence.  The decoder can "fix" it
+// with the last 2 parity symbols but nothing is left to check the result.
+// It must be rejected because a byte not erased was changed.
+
+	bad[150] ^= 0x3c;
+	e = il2p_decode_rs (bad, 200, 16, conf, fixed);
 	assert (e == -1);
 }
 
@@ -298,7 +336,7 @@ static void test_payload(void)
 
 	        unsigned char extracted[IL2P_MAX_PAYLOAD_SIZE];
 	        int symbols_corrected = 0;
-		int e = il2p_decode_payload (encoded, payload_length, max_fec, extracted, &symbols_corrected);
+		int e = il2p_decode_payload (encoded, payload_length, max_fec, NULL, extracted, &symbols_corrected);
 	        //dw_printf ("e = %d, payload_length = %d\n", e, payload_length);
 		assert (e == payload_length);
 
@@ -851,7 +889,7 @@ static void decode_bitstream(void)
 	while ( (ch = fgetc(fp)) != EOF) {
 
 	  if (ch == '0' || ch == '1') {
-	    il2p_rec_bit (0, 0, 0, ch - '0');
+	    il2p_rec_bit (rx_chain_get(0), 0, 0, ch - '0', 100);
 	  }
 	}
 	fclose(fp);
@@ -922,7 +960,7 @@ static void test_serdes (void)
 	            dw_printf ("%d bits sent.\n", num_bits_sent);
 
 	            // Need extra bit at end to flush out state machine.
-	            il2p_rec_bit (0, 0, 0, 0);
+	            il2p_rec_bit (rx_chain_get(0), 0, 0, 0, 100);
 	        }
 	    }
 	    ax25_delete(pp);
@@ -938,12 +976,12 @@ static void test_serdes (void)
 
 void tone_gen_put_bit (int chan, int data)
 {
-	il2p_rec_bit (chan, 0, 0, data);
+	il2p_rec_bit (rx_chain_get(chan), 0, 0, data, 100);
 }
 
 // This is called when a complete frame has been deserialized.
 
-void multi_modem_process_rec_packet (int chan, int subchan, int slice, packet_t pp, alevel_t alevel, retry_t retries, fec_type_t fec_type)
+void multi_modem_process_rec_packet (struct rx_chain_s *R, int subchan, int slice, packet_t pp, alevel_t alevel, retry_t retries, fec_type_t fec_type)
 {
 	if (rec_count < 0) return;	// Skip check before serdes test.
 
@@ -967,7 +1005,7 @@ void multi_modem_process_rec_packet (int chan, int subchan, int slice, packet_t
 	ax25_delete (pp);
 }
 
-alevel_t demod_get_audio_level (int chan, int subchan)
+alevel_t demod_chain_audio_level (struct rx_chain_s *R, int subchan)
 {
 	alevel_t alevel;
 	memset (&alevel, 0, sizeof(alevel));
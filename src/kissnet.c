@@ -678,7 +678,10 @@ void kissnet_send_rec_packet (int chan, int kiss_cmd, unsigned char *fbuf, int f
 			struct kissport_status_s *onlykps, int onlyclient)
 {
 	unsigned char kiss_buff[2 * AX25_MAX_PACKET_LEN];
-	int kiss_len;
+	int kiss_len = 0;
+	int kiss_buff_for = -1;		// First byte (channel/command) of what is
+					// already in kiss_buff.  It is the same for most
+					// clients so do the framing and escapes only once.
 	int err;
 
 // Something received over the radio would normally be sent to all attached clients.
@@ -716,6 +719,7 @@ void kissnet_send_rec_packet (int chan, int kiss_cmd, unsigned char *fbuf, int f
 	            }
 	            strlcpy ((char *)kiss_buff, (char *)fbuf, sizeof(kiss_buff));
 	            kiss_len = strlen((char *)kiss_buff);
+	            kiss_buff_for = -1;
 	          }
 	          else {
 	            unsigned char stemp[AX25_MAX_PACKET_LEN + 1];
@@ -740,17 +744,21 @@ void kissnet_send_rec_packet (int chan, int kiss_cmd, unsigned char *fbuf, int f
 	              continue;
 	            }
 
-	            memcpy (stemp+1, fbuf, flen);
+	            if (stemp[0] != kiss_buff_for) {
 
-	            if (kiss_debug >= 2) {
-	              /* AX.25 frame with the CRC removed. */
-	              text_color_set(DW_COLOR_DEBUG);
-	              dw_printf ("\n");
-	              dw_printf ("Packet content before adding KISS framing and any escapes:\n");
-	              hex_dump (fbuf, flen);
-	            }
+	              memcpy (stemp+1, fbuf, flen);
+
+	              if (kiss_debug >= 2) {
+	                /* AX.25 frame with the CRC removed. */
+	                text_color_set(DW_COLOR_DEBUG);
+	                dw_printf ("\n");
+	                dw_printf ("Packet content before adding KISS framing and any escapes:\n");
+	                hex_dump (fbuf, flen);
+	              }
 
-	            kiss_len = kiss_encapsulate (stemp, flen+1, kiss_buff);
+	              kiss_len = kiss_encapsulate (stemp, flen+1, kiss_buff);
+	              kiss_buff_for = stemp[0];
+	            }
 
 	            /* This has the escapes and the surrounding FENDs. */
 
@@ -59,6 +59,7 @@
 #include "textcolor.h"
 #include "decode_aprs.h"
 #include "log.h"
+#include "textasync.h"
 
 
 /*
@@ -286,7 +287,7 @@ void log_write (int chan, decode_aprs_t *A, packet_t pp, alevel_t alevel, retry_
 	    // only if this will be the first line.
 	
 	    if ( ! already_there) {
-	      fprintf (g_log_fp, "chan,utime,isotime,source,heard,level,error,dti,name,symbol,latitude,longitude,speed,course,altitude,frequency,offset,tone,system,status,telemetry,comment\n");
+	      dw_fprintf (g_log_fp, "chan,utime,isotime,source,heard,level,error,dti,name,symbol,latitude,longitude,speed,course,altitude,frequency,offset,tone,system,status,telemetry,comment\n");
 	    }
 	  }
 	}
@@ -322,7 +323,7 @@ void log_write (int chan, decode_aprs_t *A, packet_t pp, alevel_t alevel, retry_
 	    // only if this will be the first line.
 
 	    if ( ! already_there) {
-	      fprintf (g_log_fp, "chan,utime,isotime,source,heard,level,error,dti,name,symbol,latitude,longitude,speed,course,altitude,frequency,offset,tone,system,status,telemetry,comment\n");
+	      dw_fprintf (g_log_fp, "chan,utime,isotime,source,heard,level,error,dti,name,symbol,latitude,longitude,speed,course,altitude,frequency,offset,tone,system,status,telemetry,comment\n");
 	    }
 	  }
 	}
@@ -413,15 +414,13 @@ void log_write (int chan, decode_aprs_t *A, packet_t pp, alevel_t alevel, retry_
 	  strlcpy (stone, "", sizeof(stone));  if (A->g_tone   != G_UNKNOWN) snprintf (stone, sizeof(stone), "%.1f", A->g_tone);
 	                       if (A->g_dcs    != G_UNKNOWN) snprintf (stone, sizeof(stone), "D%03o", A->g_dcs);
 
-	  fprintf (g_log_fp, "%d,%d,%s,%s,%s,%s,%d,%s,%s,%s,%s,%s,%s,%s,%s,%s,%s,%s,%s,%s,%s,%s\n", 
+	  dw_fprintf (g_log_fp, "%d,%d,%s,%s,%s,%s,%d,%s,%s,%s,%s,%s,%s,%s,%s,%s,%s,%s,%s,%s,%s,%s\n", 
 			chan, (int)now, itime, 
 			A->g_src, heard, alevel_text, (int)retries, sdti,
 			sname, ssymbol,
 			slat, slon, sspd, scse, salt, 
 			sfreq, soffs, stone, 
 			smfr, sstatus, stelemetry, scomment);
-
-	  fflush (g_log_fp);
 	}
 
 } /* end log_write */
@@ -534,7 +533,7 @@ void log_term (void)
 	    dw_printf("Closing log file \"%s\".\n", g_log_path);
 	  }
 
-	  fclose (g_log_fp);
+	  text_async_close (g_log_fp);	// After anything still waiting to be written.
 
 	  g_log_fp = NULL;
 	  strlcpy (g_open_fname, "", sizeof(g_open_fname));
@@ -479,10 +479,9 @@ void mheard_save_rf (int chan, decode_aprs_t *A, packet_t pp, alevel_t alevel, r
  *
  * Purpose:	Save information about station heard via Internet Server.
  *
- * Inputs:	ptext	- Packet in monitoring text form as sent by the Internet server.
- *
- *				  Any trailing CRLF should have been removed.
- *				  Typical examples:
+ * Inputs:	src	- Source address from packet in monitoring text form
+ *			  as sent by the Internet server.  Not nul terminated.
+ *			  Typical examples of those lines:
  *
  *				KA1BTK-5>APDR13,TCPIP*,qAC,T2IRELAND:=4237.62N/07040.68W$/A=-00054 http://aprsdroid.org/
  *				N1HKO-10>APJI40,TCPIP*,qAC,N1HKO-JS:<IGATE,MSG_CNT=0,LOC_CNT=0
@@ -500,43 +499,27 @@ void mheard_save_rf (int chan, decode_aprs_t *A, packet_t pp, alevel_t alevel, r
  *				  All we should care about here is the the source address.
  *				  Note that the source address might not adhere to the AX.25 format.
  *
- * Description:
+ *		src_len	- Number of characters in src, i.e. up to the ">".
+ *
+ * Description:	Version 1.8:  The IGate finds the source address in the line,
+ *		along with the other parts it needs, and passes only that.
+ *		Previously we were given the whole line and had to search
+ *		for the ">" again.
  *
  *------------------------------------------------------------------*/
 
-void mheard_save_is (char *ptext)
+void mheard_save_is (const char *src, int src_len)
 {
 	time_t now = time(NULL);
 	char source[AX25_MAX_ADDR_LEN];
 
-#if 1
 // It is possible that source won't adhere to the AX.25 restrictions.
-// So we simply extract the source address, as text, from the beginning rather than
+// So we simply take the source address, as text, from the beginning rather than
 // using ax25_from_text() and ax25_get_addr_with_ssid().
 
-	memset (source, 0, sizeof(source));
-	memcpy (source, ptext, sizeof(source)-1);
-	char *g = strchr(source, '>');
-	if (g != NULL) *g = '\0';
-
-#else
-
-/*
- * Keep this here in case I want to revive it to get location.
- */
-	packet_t pp = ax25_from_text(ptext, 0);
-
-	if (pp == NULL) {
-	  if (mheard_debug) {
-	    text_color_set(DW_COLOR_ERROR);
-	    dw_printf ("mheard_save_is: Could not parse message from server.\n");
-	    dw_printf ("%s\n", ptext);
-	  }
-	  return;
-	}
-
-	//////ax25_get_addr_with_ssid (pp, AX25_SOURCE, source);
-#endif
+	if (src_len > (int)sizeof(source) - 1) src_len = sizeof(source) - 1;
+	memcpy (source, src, src_len);
+	source[src_len] = '\0';
 
 	mheard_t *mptr = mheard_ptr(source);
 	if (mptr == NULL) {
@@ -9,7 +9,7 @@ void mheard_init (int debug);
 
 void mheard_save_rf (int chan, decode_aprs_t *A, packet_t pp, alevel_t alevel, retry_t retries);
 
-void mheard_save_is (char *ptext);
+void mheard_save_is (const char *src, int src_len);
 
 int mheard_count (int max_hops, int time_limit);
 
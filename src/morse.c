@@ -272,7 +272,7 @@ int morse_send (int chan, char *str, int wpm, int txdelay, int txtail)
 		time_units, morse_units_str(str));
 	}
 
-	audio_flush(ACHAN2ADEV(chan));
+	audio_flush(save_audio_config_p->chan_adev[chan]);
 
 	return (txdelay +
 		(int) (TIME_UNITS_TO_MS(time_units, wpm) + 0.5) +
@@ -303,7 +303,7 @@ static void morse_tone (int chan, int tu, int wpm) {
 	}
 #else
 
-	int a = ACHAN2ADEV(chan);	/* device for channel. */
+	int a = save_audio_config_p->chan_adev[chan];	/* device for channel. */
 	int sam;
 	int nsamples;
 	int j;
@@ -360,7 +360,7 @@ static void morse_quiet (int chan, int tu, int wpm) {
 	  dw_printf (".");
 	}
 #else
-	int a = ACHAN2ADEV(chan);	/* device for channel. */
+	int a = save_audio_config_p->chan_adev[chan];	/* device for channel. */
 	int sam = 0;
 	int nsamples;
 	int j;
@@ -399,7 +399,7 @@ static void morse_quiet_ms (int chan, int ms) {
 
 #if MTEST1
 #else
-	int a = ACHAN2ADEV(chan);	/* device for channel. */
+	int a = save_audio_config_p->chan_adev[chan];	/* device for channel. */
 	int sam = 0;
 	int nsamples;
 	int j;
@@ -78,6 +78,14 @@
  *		With normal AX.25 a couple frames can come and go during that time.	
  *		We want to delay the duplicate removal while FX.25 block reception
  *		is going on.
+ *
+ * New in version 1.8:
+ *
+ *		Previously every candidate was aged on every audio sample which
+ *		meant looping over all subchannels and slicers, up to 81 of them,
+ *		even when nothing was waiting.  Now each channel counts its audio
+ *		samples and remembers the earliest time a candidate is due so
+ *		each sample costs a single comparison.
  *		
  *------------------------------------------------------------------*/
 
@@ -88,6 +96,7 @@
 #include "direwolf.h"
 
 #include <stdlib.h>
+#include <stdint.h>
 #include <string.h>
 #include <assert.h>
 #include <stdio.h>
@@ -103,17 +112,17 @@
 #include "fx25.h"
 #include "version.h"
 #include "ais.h"
+#include "rxprof.h"
+#include "rx_chain.h"
 
 
 
-// Properties of the radio channels.
-
-static struct audio_s          *save_audio_config_p;
-
-
 // Candidates for further processing.
+// Allocated in multi_modem_init for the number of subchannels and slicers
+// actually in use.  See CANDIDATE below to find the one for a given subchannel
+// and slicer.
 
-static struct {
+struct candidate_s {
 	packet_t packet_p;
 	alevel_t alevel;
 	float speed_error;
@@ -123,21 +132,41 @@ static struct {
 				// It would be 0 to something around 4.
 				// For FX.25, it is the number of corrected.
 				// This could be from 0 thru 32.
-	int age;
+	int64_t due;		// Sample count when it has waited long enough.
 	unsigned int crc;
 	int score;
-} candidate[MAX_RADIO_CHANS][MAX_SUBCHANS][MAX_SLICERS];
-
-
+};
 
 //#define PROCESS_AFTER_BITS 2		// version 1.4.  Was a little short for skew of PSK with different modem types, optional pre-filter
 
 #define PROCESS_AFTER_BITS 3
 
 
-static int process_age[MAX_RADIO_CHANS];
+// Everything for one channel.  Found in the rx_chain_s for the channel.
+
+struct multi_modem_chan_s {
+
+	struct candidate_s *candidate;
 
-static void pick_best_candidate (int chan);
+	int num_candidates;
+
+	int num_slicers;
+
+	int process_age;
+
+// Number of audio samples processed and the earliest
+// sample count when a candidate is due.  0 means none are waiting.
+
+	int64_t sample_count;
+	int64_t candidate_deadline;
+
+	float dc_average;
+};
+
+#define CANDIDATE(M,subchan,slice) (M)->candidate[(subchan) * (M)->num_slicers + (slice)]
+
+static void pick_best_candidate (struct rx_chain_s *R);
+static void update_deadline (struct multi_modem_chan_s *M);
 
 
 
@@ -156,38 +185,94 @@ static void pick_best_candidate (int chan);
  *
  *------------------------------------------------------------------------------*/
 
+static void candidates_init (struct rx_chain_s *R, struct audio_s *pa);
+
 void multi_modem_init (struct audio_s *pa) 
 {
 	int chan;
 
+	demod_init (pa);
+	hdlc_rec_init (pa);
+
+	for (chan=0; chan<MAX_RADIO_CHANS; chan++) {
+	  candidates_init (rx_chain_get (chan), pa);
+	}
+}
+
+
+/*------------------------------------------------------------------------------
+ *
+ * Name:	multi_modem_chain_init
+ * 
+ * Purpose:	Initialize the modems and HDLC decoders for one receive chain.
+ *
+ * Input:	R	- Receive chain, normally from rx_chain_create.
+ *			  R->chan selects the channel configuration.
+ *
+ *		pa	- Modem properties.  Some derived values are
+ *			  filled in, as for multi_modem_init.
+ *		
+ * Description:	The chain can then be given audio samples with
+ *		multi_modem_process_sample.  Nothing is shared with any
+ *		other chain, so different threads may run different chains.
+ *
+ *------------------------------------------------------------------------------*/
+
+void multi_modem_chain_init (struct rx_chain_s *R, struct audio_s *pa)
+{
+	demod_chain_init (R, pa);
+	hdlc_rec_chain_init (R, pa);
+	candidates_init (R, pa);
+}
+
 
 /*
- * Save audio configuration for later use.
+ * demod_init has now settled the number of subchannels and slicers.
+ * atest calls this for each file so discard anything from last time.
  */
 
-	save_audio_config_p = pa;
-
-	memset (candidate, 0, sizeof(candidate));
+static void candidates_init (struct rx_chain_s *R, struct audio_s *pa)
+{
+	int chan = R->chan;
+	struct multi_modem_chan_s *M = R->mm;
+	int n;
 
-	demod_init (save_audio_config_p);
-	hdlc_rec_init (save_audio_config_p);
+	if (M == NULL) {
+	  M = R->mm = rx_chain_alloc (sizeof(struct multi_modem_chan_s));
+	}
+	R->audio_config = pa;
 
-	for (chan=0; chan<MAX_RADIO_CHANS; chan++) {
-	  if (save_audio_config_p->chan_medium[chan] == MEDIUM_RADIO) {
-	    if (save_audio_config_p->achan[chan].baud <= 0) {
-	      text_color_set(DW_COLOR_ERROR);
-	      dw_printf("Internal error, chan=%d, %s, %d\n", chan, __FILE__, __LINE__);
-	      save_audio_config_p->achan[chan].baud = DEFAULT_BAUD;
+	if (M->candidate != NULL) {
+	  for (n = 0; n < M->num_candidates; n++) {
+	    if (M->candidate[n].packet_p != NULL) {
+	      ax25_delete (M->candidate[n].packet_p);
 	    }
-	    int real_baud = save_audio_config_p->achan[chan].baud;
-	    if (save_audio_config_p->achan[chan].modem_type == MODEM_QPSK) real_baud = save_audio_config_p->achan[chan].baud / 2;
-	    if (save_audio_config_p->achan[chan].modem_type == MODEM_8PSK) real_baud = save_audio_config_p->achan[chan].baud / 3;
-
-	    process_age[chan] = PROCESS_AFTER_BITS * save_audio_config_p->adev[ACHAN2ADEV(chan)].samples_per_sec / real_baud ;
-	    //crc_queue_of_last_to_app[chan] = NULL;
 	  }
+	  rx_chain_free (M->candidate);
+	  M->candidate = NULL;
+	  M->num_candidates = 0;
 	}
+	M->sample_count = 0;
+	M->candidate_deadline = 0;
+
+	if (pa->chan_medium[chan] == MEDIUM_RADIO) {
 
+	  M->num_slicers = pa->achan[chan].num_slicers;
+	  M->num_candidates = pa->achan[chan].num_subchan * M->num_slicers;
+	  M->candidate = rx_chain_alloc (M->num_candidates * sizeof(struct candidate_s));
+
+	  if (pa->achan[chan].baud <= 0) {
+	    text_color_set(DW_COLOR_ERROR);
+	    dw_printf("Internal error, chan=%d, %s, %d\n", chan, __FILE__, __LINE__);
+	    pa->achan[chan].baud = DEFAULT_BAUD;
+	  }
+	  int real_baud = pa->achan[chan].baud;
+	  if (pa->achan[chan].modem_type == MODEM_QPSK) real_baud = pa->achan[chan].baud / 2;
+	  if (pa->achan[chan].modem_type == MODEM_8PSK) real_baud = pa->achan[chan].baud / 3;
+
+	  M->process_age = PROCESS_AFTER_BITS * pa->adev[pa->chan_adev[chan]].samples_per_sec / real_baud ;
+	  //crc_queue_of_last_to_app[chan] = NULL;
+	}
 }
 
 
@@ -197,7 +282,7 @@ void multi_modem_init (struct audio_s *pa)
  * 
  * Purpose:	Feed the sample into the proper modem(s) for the channel.	
  *
- * Inputs:	chan	- Radio channel number
+ * Inputs:	R	- Receive chain for the radio channel.
  *
  *		audio_sample 
  *
@@ -222,40 +307,43 @@ void multi_modem_init (struct audio_s *pa)
  *
  *------------------------------------------------------------------------------*/
 
-static float dc_average[MAX_RADIO_CHANS];
-
 int multi_modem_get_dc_average (int chan)
 {
 	// Scale to +- 200 so it will like the deviation measurement.
+	// Samples are now float with 16384 from a 16 bit sound card as 1.0.
 
-	return ( (int) ((float)(dc_average[chan]) * (200.0f / 32767.0f) ) );
+	return ( (int) ((float)(rx_chain_get(chan)->mm->dc_average) * (200.0f * 16384.0f / 32767.0f) ) );
 }
 
 __attribute__((hot))
-void multi_modem_process_sample (int chan, int audio_sample) 
+void multi_modem_process_sample (struct rx_chain_s *R, float audio_sample) 
 {
 	int d;
-	int subchan;
+	int chan = R->chan;
+	struct audio_s *pa = R->audio_config;
+	struct multi_modem_chan_s *M = R->mm;
+
+	M->sample_count++;
 
 // Accumulate an average DC bias level.
 // Shouldn't happen with a soundcard but could with mistuned SDR.
 
-	dc_average[chan] = dc_average[chan] * 0.999f + (float)audio_sample * 0.001f;
+	M->dc_average = M->dc_average * 0.999f + audio_sample * 0.001f;
 
 
 // Issue 128.  Someone ran into this.
 
-	//assert (save_audio_config_p->achan[chan].num_subchan > 0 && save_audio_config_p->achan[chan].num_subchan <= MAX_SUBCHANS);
-	//assert (save_audio_config_p->achan[chan].num_slicers > 0 && save_audio_config_p->achan[chan].num_slicers <= MAX_SLICERS);
+	//assert (pa->achan[chan].num_subchan > 0 && pa->achan[chan].num_subchan <= MAX_SUBCHANS);
+	//assert (pa->achan[chan].num_slicers > 0 && pa->achan[chan].num_slicers <= MAX_SLICERS);
 
-	if (save_audio_config_p->achan[chan].num_subchan <= 0 || save_audio_config_p->achan[chan].num_subchan > MAX_SUBCHANS ||
-	    save_audio_config_p->achan[chan].num_slicers <= 0 || save_audio_config_p->achan[chan].num_slicers > MAX_SLICERS) {
+	if (pa->achan[chan].num_subchan <= 0 || pa->achan[chan].num_subchan > MAX_SUBCHANS ||
+	    pa->achan[chan].num_slicers <= 0 || pa->achan[chan].num_slicers > MAX_SLICERS) {
 
 	  text_color_set(DW_COLOR_ERROR);
 	  dw_printf ("ERROR!  Something is seriously wrong in %s %s.\n", __FILE__, __func__);
 	  dw_printf ("chan = %d, num_subchan = %d [max %d], num_slicers = %d [max %d]\n", chan,
-									save_audio_config_p->achan[chan].num_subchan, MAX_SUBCHANS,
-									save_audio_config_p->achan[chan].num_slicers, MAX_SLICERS);
+									pa->achan[chan].num_subchan, MAX_SUBCHANS,
+									pa->achan[chan].num_slicers, MAX_SLICERS);
 	  dw_printf ("Please report this message and include a copy of your configuration file.\n");
 	  exit (EXIT_FAILURE);
 	}
@@ -264,26 +352,48 @@ void multi_modem_process_sample (int chan, int audio_sample)
 	/* 1.2: We can feed one demodulator but end up with multiple outputs. */
 
 	/* Send same thing to all. */
-	for (d = 0; d < save_audio_config_p->achan[chan].num_subchan; d++) {
-	  demod_process_sample(chan, d, audio_sample);
+	RXPROF_SAMPLE_ENTER (&R->prof)
+	for (d = 0; d < pa->achan[chan].num_subchan; d++) {
+	  demod_process_sample(R, d, audio_sample);
 	}
+	RXPROF_SAMPLE_LEAVE (&R->prof)
 
-	for (subchan = 0; subchan < save_audio_config_p->achan[chan].num_subchan; subchan++) {
-	  int slice;
+	/* Has any candidate waited long enough? */
 
-	  for (slice = 0; slice < save_audio_config_p->achan[chan].num_slicers; slice++) {
+	if (M->candidate_deadline != 0 && M->sample_count >= M->candidate_deadline) {
 
-	    if (candidate[chan][subchan][slice].packet_p != NULL) {
-	      candidate[chan][subchan][slice].age++;
-	      if (candidate[chan][subchan][slice].age > process_age[chan]) {
-	        if (fx25_rec_busy(chan)) {
-		  candidate[chan][subchan][slice].age = 0;
-	        }
-	        else {
-	          pick_best_candidate (chan);
-	        }
+	  if (fx25_rec_busy(R)) {
+
+	    // Wait some more for the FX.25 frame to complete.
+	    // Those due now start waiting again as if they just arrived.
+
+	    for (int n = 0; n < M->num_candidates; n++) {
+	      if (M->candidate[n].packet_p != NULL && M->candidate[n].due <= M->sample_count) {
+	        M->candidate[n].due = M->sample_count + 1 + M->process_age;
 	      }
 	    }
+	    update_deadline (M);
+	  }
+	  else {
+	    pick_best_candidate (R);
+	  }
+	}
+}
+
+
+/*
+ * Find the earliest time that a candidate is due.
+ * Needed only when one is replaced or postponed.
+ */
+
+static void update_deadline (struct multi_modem_chan_s *M)
+{
+	M->candidate_deadline = 0;
+
+	for (int n = 0; n < M->num_candidates; n++) {
+	  if (M->candidate[n].packet_p != NULL &&
+		(M->candidate_deadline == 0 || M->candidate[n].due < M->candidate_deadline)) {
+	    M->candidate_deadline = M->candidate[n].due;
 	  }
 	}
 }
@@ -297,7 +407,7 @@ void multi_modem_process_sample (int chan, int audio_sample)
  * Purpose:     This is called when we receive a frame with a valid 
  *		FCS and acceptable size.
  *
- * Inputs:	chan	- Audio channel number, 0 or 1.
+ * Inputs:	R	- Receive chain for the radio channel.
  *		subchan	- Which modem found it.
  *		slice	- Which slice found it.
  *		fbuf	- Pointer to first byte in HDLC frame.
@@ -314,18 +424,18 @@ void multi_modem_process_sample (int chan, int audio_sample)
  *--------------------------------------------------------------------*/
 
 
-void multi_modem_process_rec_frame (int chan, int subchan, int slice, unsigned char *fbuf, int flen, alevel_t alevel, retry_t retries, fec_type_t fec_type)
+void multi_modem_process_rec_frame (struct rx_chain_s *R, int subchan, int slice, unsigned char *fbuf, int flen, alevel_t alevel, retry_t retries, fec_type_t fec_type)
 {
 	packet_t pp;
+	struct audio_s *pa = R->audio_config;
 
 
-	assert (chan >= 0 && chan < MAX_RADIO_CHANS);
 	assert (subchan >= 0 && subchan < MAX_SUBCHANS);
 	assert (slice >= 0 && slice < MAX_SLICERS);
 
 // Special encapsulation for AIS & EAS so they can be treated normally pretty much everywhere else.
 
-	if (save_audio_config_p->achan[chan].modem_type == MODEM_AIS) {
+	if (pa->achan[R->chan].modem_type == MODEM_AIS) {
 	  char nmea[256];
 	  ais_to_nmea (fbuf, flen, nmea, sizeof(nmea));
 
@@ -342,7 +452,7 @@ void multi_modem_process_rec_frame (int chan, int subchan, int slice, unsigned c
 
 	  // alevel gets in there somehow making me question why it is passed thru here.
 	}
-	else if (save_audio_config_p->achan[chan].modem_type == MODEM_EAS) {
+	else if (pa->achan[R->chan].modem_type == MODEM_EAS) {
 	  char monfmt[300];	// EAS SAME message max length is 268
 
 	  snprintf (monfmt, sizeof(monfmt), "EAS>%s%1d%1d,NOGATE:{%c%c%s", APP_TOCALL, MAJOR_VERSION, MINOR_VERSION, USER_DEF_USER_ID, USER_DEF_TYPE_EAS, fbuf);
@@ -354,39 +464,50 @@ void multi_modem_process_rec_frame (int chan, int subchan, int slice, unsigned c
 	  pp = ax25_from_frame (fbuf, flen, alevel);
 	}
 
-	multi_modem_process_rec_packet (chan, subchan, slice, pp, alevel, retries, fec_type);
+	multi_modem_process_rec_packet (R, subchan, slice, pp, alevel, retries, fec_type);
 }
 
 // TODO: Eliminate function above and move code elsewhere?
 
-void multi_modem_process_rec_packet (int chan, int subchan, int slice, packet_t pp, alevel_t alevel, retry_t retries, fec_type_t fec_type)
+void multi_modem_process_rec_packet (struct rx_chain_s *R, int subchan, int slice, packet_t pp, alevel_t alevel, retry_t retries, fec_type_t fec_type)
 {
+	int chan = R->chan;
+	struct audio_s *pa = R->audio_config;
+
 	if (pp == NULL) {
 	  text_color_set(DW_COLOR_ERROR);
 	  dw_printf ("Unexpected internal problem, %s %d\n", __FILE__, __LINE__);
 	  return;	/* oops!  why would it fail? */
 	}
 
+	// For latency statistics.
+
+	double now = dtime_monotonic();
+
+	ax25_set_rx_time (pp, RX_TIME_AUDIO, R->frame_audio_time);
+	ax25_set_rx_time (pp, RX_TIME_FLAG, R->frame_end_time);
+	ax25_set_rx_time (pp, RX_TIME_DECODED, now);
+
 /*
  * If only one demodulator/slicer, and no FX.25 in progress,
  * push it thru and forget about all this foolishness.
  */
-	if (save_audio_config_p->achan[chan].num_subchan == 1 &&
-	    save_audio_config_p->achan[chan].num_slicers == 1 &&
-	    ! fx25_rec_busy(chan)) {
+	if (pa->achan[chan].num_subchan == 1 &&
+	    pa->achan[chan].num_slicers == 1 &&
+	    ! fx25_rec_busy(R)) {
 
 
 	  int drop_it = 0;
-	  if (save_audio_config_p->recv_error_rate != 0) {
+	  if (pa->recv_error_rate != 0) {
 	    float r = (float)(rand()) / (float)RAND_MAX;		// Random, 0.0 to 1.0
 
 	    //text_color_set(DW_COLOR_INFO);
-	    //dw_printf ("TEMP DEBUG.  recv error rate = %d\n", save_audio_config_p->recv_error_rate);
+	    //dw_printf ("TEMP DEBUG.  recv error rate = %d\n", pa->recv_error_rate);
 
-	    if (save_audio_config_p->recv_error_rate / 100.0 > r) {
+	    if (pa->recv_error_rate / 100.0 > r) {
 	      drop_it = 1;
 	      text_color_set(DW_COLOR_INFO);
-	      dw_printf ("Intentionally dropping incoming frame.  Recv Error rate = %d per cent.\n", save_audio_config_p->recv_error_rate);
+	      dw_printf ("Intentionally dropping incoming frame.  Recv Error rate = %d per cent.\n", pa->recv_error_rate);
 	    }
 	  }
 
@@ -394,6 +515,7 @@ void multi_modem_process_rec_packet (int chan, int subchan, int slice, packet_t
 	    ax25_delete (pp);
 	  }
 	  else {
+	    ax25_set_rx_time (pp, RX_TIME_PICKED, now);
 	    dlq_rec_frame (chan, subchan, slice, pp, alevel, fec_type, retries, "");
 	  }
 	  return;
@@ -403,21 +525,32 @@ void multi_modem_process_rec_packet (int chan, int subchan, int slice, packet_t
 /*
  * Otherwise, save them up for a few bit times so we can pick the best.
  */
-	if (candidate[chan][subchan][slice].packet_p != NULL) {
+	struct multi_modem_chan_s *M = R->mm;
+	int replaced = 0;
+
+	if (CANDIDATE(M,subchan,slice).packet_p != NULL) {
 	  /* Plain old AX.25: Oops!  Didn't expect it to be there. */
 	  /* FX.25: Quietly replace anything already there.  It will have priority. */
-	  ax25_delete (candidate[chan][subchan][slice].packet_p);
-	  candidate[chan][subchan][slice].packet_p = NULL;
+	  ax25_delete (CANDIDATE(M,subchan,slice).packet_p);
+	  CANDIDATE(M,subchan,slice).packet_p = NULL;
+	  replaced = 1;
 	}
 
 	assert (pp != NULL);
 
-	candidate[chan][subchan][slice].packet_p = pp;
-	candidate[chan][subchan][slice].alevel = alevel;
-	candidate[chan][subchan][slice].fec_type = fec_type;
-	candidate[chan][subchan][slice].retries = retries;
-	candidate[chan][subchan][slice].age = 0;
-	candidate[chan][subchan][slice].crc = ax25_m_m_crc(pp);
+	CANDIDATE(M,subchan,slice).packet_p = pp;
+	CANDIDATE(M,subchan,slice).alevel = alevel;
+	CANDIDATE(M,subchan,slice).fec_type = fec_type;
+	CANDIDATE(M,subchan,slice).retries = retries;
+	CANDIDATE(M,subchan,slice).due = M->sample_count + M->process_age;
+	CANDIDATE(M,subchan,slice).crc = ax25_m_m_crc(pp);
+
+	if (replaced) {
+	  update_deadline (M);
+	}
+	else if (M->candidate_deadline == 0 || CANDIDATE(M,subchan,slice).due < M->candidate_deadline) {
+	  M->candidate_deadline = CANDIDATE(M,subchan,slice).due;
+	}
 }
 
 
@@ -442,19 +575,22 @@ void multi_modem_process_rec_packet (int chan, int subchan, int slice, packet_t
 /* Opposite order would be suitable for multi-frequency although */
 /* multiple slicers are of questionable value for HF SSB. */
 
-#define subchan_from_n(x) ((x) % save_audio_config_p->achan[chan].num_subchan)
-#define slice_from_n(x)   ((x) / save_audio_config_p->achan[chan].num_subchan)
+#define subchan_from_n(x) ((x) % pa->achan[chan].num_subchan)
+#define slice_from_n(x)   ((x) / pa->achan[chan].num_subchan)
 
 
-static void pick_best_candidate (int chan) 
+static void pick_best_candidate (struct rx_chain_s *R) 
 {
+	int chan = R->chan;
+	struct audio_s *pa = R->audio_config;
+	struct multi_modem_chan_s *M = R->mm;
 	int best_n, best_score;
 	char spectrum[MAX_SUBCHANS*MAX_SLICERS+1];
 	int n, j, k;
-	if (save_audio_config_p->achan[chan].num_slicers < 1) {
-	  save_audio_config_p->achan[chan].num_slicers = 1;
+	if (pa->achan[chan].num_slicers < 1) {
+	  pa->achan[chan].num_slicers = 1;
 	}
-	int num_bars = save_audio_config_p->achan[chan].num_slicers * save_audio_config_p->achan[chan].num_subchan;
+	int num_bars = pa->achan[chan].num_slicers * pa->achan[chan].num_subchan;
 
 	memset (spectrum, 0, sizeof(spectrum));
 
@@ -464,22 +600,22 @@ static void pick_best_candidate (int chan)
 
 	  /* Build the spectrum display. */
 
-	  if (candidate[chan][j][k].packet_p == NULL) {
+	  if (CANDIDATE(M,j,k).packet_p == NULL) {
 	    spectrum[n] = '_';
 	  }
-	  else if (candidate[chan][j][k].fec_type != fec_type_none) {		// FX.25 or IL2P
+	  else if (CANDIDATE(M,j,k).fec_type != fec_type_none) {		// FX.25 or IL2P
 	    // FIXME: using retries both as an enum and later int too.
-	    if ((int)(candidate[chan][j][k].retries) <= 9) {
-	      spectrum[n] = '0' + candidate[chan][j][k].retries;
+	    if ((int)(CANDIDATE(M,j,k).retries) <= 9) {
+	      spectrum[n] = '0' + CANDIDATE(M,j,k).retries;
 	    }
 	    else {
 	      spectrum[n] = '+';
 	    }
 	  }									// AX.25 below
-	  else if (candidate[chan][j][k].retries == RETRY_NONE) {
+	  else if (CANDIDATE(M,j,k).retries == RETRY_NONE) {
 	    spectrum[n] = '|';
 	  }
-	  else if (candidate[chan][j][k].retries == RETRY_INVERT_SINGLE) {
+	  else if (CANDIDATE(M,j,k).retries == RETRY_INVERT_SINGLE) {
 	    spectrum[n] = ':';
 	  }
 	  else  {
@@ -488,12 +624,12 @@ static void pick_best_candidate (int chan)
 
 	  /* Beginning score depends on effort to get a valid frame CRC. */
 
-	  if (candidate[chan][j][k].packet_p == NULL) {
-	    candidate[chan][j][k].score = 0;
+	  if (CANDIDATE(M,j,k).packet_p == NULL) {
+	    CANDIDATE(M,j,k).score = 0;
 	  }
 	  else {
-	    if (candidate[chan][j][k].fec_type != fec_type_none) {
-	      candidate[chan][j][k].score = 9000 - 100 * candidate[chan][j][k].retries;		// has FEC
+	    if (CANDIDATE(M,j,k).fec_type != fec_type_none) {
+	      CANDIDATE(M,j,k).score = 9000 - 100 * CANDIDATE(M,j,k).retries;		// has FEC
 	    }
 	    else {
 	      /* Originally, this produced 0 for the PASSALL case. */
@@ -501,7 +637,7 @@ static void pick_best_candidate (int chan)
 	      /* Around 1.3 dev H, we add an extra 1 in here so the minimum */
 	      /* score should now be 1 for anything received.  */
 
-	      candidate[chan][j][k].score = RETRY_MAX * 1000 - ((int)candidate[chan][j][k].retries * 1000) + 1;
+	      CANDIDATE(M,j,k).score = RETRY_MAX * 1000 - ((int)CANDIDATE(M,j,k).retries * 1000) + 1;
 	    }
 	  }
 	}
@@ -517,16 +653,16 @@ static void pick_best_candidate (int chan)
 	  j = subchan_from_n(n);
 	  k = slice_from_n(n);
 
-	  if (candidate[chan][j][k].packet_p != NULL) {
+	  if (CANDIDATE(M,j,k).packet_p != NULL) {
 
 	    for (m = 0; m < num_bars; m++) {
 
 	      int mj = subchan_from_n(m);
 	      int mk = slice_from_n(m);
 
-	      if (m != n && candidate[chan][mj][mk].packet_p != NULL) {
-	        if (candidate[chan][j][k].crc == candidate[chan][mj][mk].crc) {
-	          candidate[chan][j][k].score += (num_bars+1) - abs(m-n);
+	      if (m != n && CANDIDATE(M,mj,mk).packet_p != NULL) {
+	        if (CANDIDATE(M,j,k).crc == CANDIDATE(M,mj,mk).crc) {
+	          CANDIDATE(M,j,k).score += (num_bars+1) - abs(m-n);
 	        }
 	      }
 	    }
@@ -540,9 +676,9 @@ static void pick_best_candidate (int chan)
 	  j = subchan_from_n(n);
 	  k = slice_from_n(n);
 
-	  if (candidate[chan][j][k].packet_p != NULL) {
-	    if (candidate[chan][j][k].score > best_score) {
-	       best_score = candidate[chan][j][k].score;
+	  if (CANDIDATE(M,j,k).packet_p != NULL) {
+	    if (CANDIDATE(M,j,k).score > best_score) {
+	       best_score = CANDIDATE(M,j,k).score;
 	       best_n = n;
 	    }
 	  }
@@ -556,18 +692,18 @@ static void pick_best_candidate (int chan)
 	  j = subchan_from_n(n);
 	  k = slice_from_n(n);
 
-	  if (candidate[chan][j][k].packet_p == NULL) {
+	  if (CANDIDATE(M,j,k).packet_p == NULL) {
 	    dw_printf ("%d.%d.%d: ptr=%p\n", chan, j, k,
-		candidate[chan][j][k].packet_p);
+		CANDIDATE(M,j,k).packet_p);
 	  }
 	  else {
 	    dw_printf ("%d.%d.%d: ptr=%p, fec_type=%d, retry=%d, age=%3d, crc=%04x, score=%d  %s\n", chan, j, k,
-		candidate[chan][j][k].packet_p,
-		(int)(candidate[chan][j][k].fec_type),
-		(int)(candidate[chan][j][k].retries),
-		candidate[chan][j][k].age,
-		candidate[chan][j][k].crc,
-		candidate[chan][j][k].score,
+		CANDIDATE(M,j,k).packet_p,
+		(int)(CANDIDATE(M,j,k).fec_type),
+		(int)(CANDIDATE(M,j,k).retries),
+		(int)(M->sample_count - CANDIDATE(M,j,k).due + M->process_age),
+		CANDIDATE(M,j,k).crc,
+		CANDIDATE(M,j,k).score,
 		(n == best_n) ? "***" : "");
 	  }
 	}
@@ -587,9 +723,9 @@ static void pick_best_candidate (int chan)
 	for (n = 0; n < num_bars; n++) {
 	  j = subchan_from_n(n);
 	  k = slice_from_n(n);
-	  if (n != best_n && candidate[chan][j][k].packet_p != NULL) {
-	    ax25_delete (candidate[chan][j][k].packet_p);
-	    candidate[chan][j][k].packet_p = NULL;
+	  if (n != best_n && CANDIDATE(M,j,k).packet_p != NULL) {
+	    ax25_delete (CANDIDATE(M,j,k).packet_p);
+	    CANDIDATE(M,j,k).packet_p = NULL;
 	  }
 	}
 
@@ -600,39 +736,41 @@ static void pick_best_candidate (int chan)
 	k = slice_from_n(best_n);
 
 	int drop_it = 0;
-	if (save_audio_config_p->recv_error_rate != 0) {
+	if (pa->recv_error_rate != 0) {
 	  float r = (float)(rand()) / (float)RAND_MAX;		// Random, 0.0 to 1.0
 
 	  //text_color_set(DW_COLOR_INFO);
-	  //dw_printf ("TEMP DEBUG.  recv error rate = %d\n", save_audio_config_p->recv_error_rate);
+	  //dw_printf ("TEMP DEBUG.  recv error rate = %d\n", pa->recv_error_rate);
 
-	  if (save_audio_config_p->recv_error_rate / 100.0 > r) {
+	  if (pa->recv_error_rate / 100.0 > r) {
 	    drop_it = 1;
 	    text_color_set(DW_COLOR_INFO);
-	    dw_printf ("Intentionally dropping incoming frame.  Recv Error rate = %d per cent.\n", save_audio_config_p->recv_error_rate);
+	    dw_printf ("Intentionally dropping incoming frame.  Recv Error rate = %d per cent.\n", pa->recv_error_rate);
 	  }
 	}
 
 	if ( drop_it ) {
-	  ax25_delete (candidate[chan][j][k].packet_p);
-	  candidate[chan][j][k].packet_p = NULL;
+	  ax25_delete (CANDIDATE(M,j,k).packet_p);
+	  CANDIDATE(M,j,k).packet_p = NULL;
 	}
 	else {
-	  assert (candidate[chan][j][k].packet_p != NULL);
+	  assert (CANDIDATE(M,j,k).packet_p != NULL);
+	  ax25_set_rx_time (CANDIDATE(M,j,k).packet_p, RX_TIME_PICKED, dtime_monotonic());
 	  dlq_rec_frame (chan, j, k,
-		candidate[chan][j][k].packet_p,
-		candidate[chan][j][k].alevel,
-		candidate[chan][j][k].fec_type,
-		(int)(candidate[chan][j][k].retries),
+		CANDIDATE(M,j,k).packet_p,
+		CANDIDATE(M,j,k).alevel,
+		CANDIDATE(M,j,k).fec_type,
+		(int)(CANDIDATE(M,j,k).retries),
 		spectrum);
 
 	  /* Someone else owns it now and will delete it later. */
-	  candidate[chan][j][k].packet_p = NULL;
+	  CANDIDATE(M,j,k).packet_p = NULL;
 	}
 
 	/* Clear in preparation for next time. */
 
-	memset (candidate[chan], 0, sizeof(candidate[chan]));
+	memset (M->candidate, 0, M->num_candidates * sizeof(struct candidate_s));
+	M->candidate_deadline = 0;
 
 } /* end pick_best_candidate */
 
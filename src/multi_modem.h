@@ -9,16 +9,21 @@
 /* Needed for struct audio_s */
 #include "audio.h"
 
+/* Needed for struct rx_chain_s */
+#include "rx_chain.h"
+
 
 void multi_modem_init (struct audio_s *pmodem); 
 
-void multi_modem_process_sample (int c, int audio_sample);
+void multi_modem_chain_init (struct rx_chain_s *R, struct audio_s *pa);
+
+void multi_modem_process_sample (struct rx_chain_s *R, float audio_sample);
 
 int multi_modem_get_dc_average (int chan);
 
 // Deprecated.  Replace with ...packet
-void multi_modem_process_rec_frame (int chan, int subchan, int slice, unsigned char *fbuf, int flen, alevel_t alevel, retry_t retries, fec_type_t fec_type);
+void multi_modem_process_rec_frame (struct rx_chain_s *R, int subchan, int slice, unsigned char *fbuf, int flen, alevel_t alevel, retry_t retries, fec_type_t fec_type);
 
-void multi_modem_process_rec_packet (int chan, int subchan, int slice, packet_t pp, alevel_t alevel, retry_t retries, fec_type_t fec_type);
+void multi_modem_process_rec_packet (struct rx_chain_s *R, int subchan, int slice, packet_t pp, alevel_t alevel, retry_t retries, fec_type_t fec_type);
 
 #endif
@@ -278,6 +278,56 @@ int pfilter (int from_chan, int to_chan, char *filter, packet_t pp, int is_aprs)
 
 
 
+/*-------------------------------------------------------------------
+ *
+ * Name:        pfilter_messages_only
+ *
+ * Purpose:     Determine whether a filter can only pass APRS "messages."
+ *
+ * Inputs:	filter	- String of filter specs and logical operators.
+ *
+ * Returns:	1 if the filter is nothing but IGate messaging (i/...)
+ *		specifications, optionally combined with |.
+ *		0 for anything else, including an empty filter.
+ *
+ * Description:	The default IS>RF filter is i/180.  The server can send
+ *		thousands of lines a minute and this rejects almost all
+ *		of them.  When we know that only a "message" can get thru,
+ *		the caller can discard everything else without building
+ *		a packet object and decoding it.
+ *
+ *		This is a conservative check.  Anything more complicated
+ *		goes through pfilter.  The same if debug output is enabled
+ *		so the details are still available.
+ *
+ *--------------------------------------------------------------------*/
+
+int pfilter_messages_only (char *filter)
+{
+	char *p = filter;
+	int n = 0;
+
+	if (s_debug >= 1) return (0);
+
+	while (*p != '\0') {
+	  if (*p == ' ' || iscntrl(*p) || *p == '|') {
+	    p++;
+	    continue;
+	  }
+	  if (p[0] != 'i' || ! ispunct(p[1])) {
+	    return (0);
+	  }
+	  while (*p != '\0' && *p != ' ' && ! iscntrl(*p)) {
+	    p++;
+	  }
+	  n++;
+	}
+	return (n > 0);
+
+} /* end pfilter_messages_only */
+
+
+
 /*-------------------------------------------------------------------
  *
  * Name:   	next_token     
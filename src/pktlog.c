@@ -0,0 +1,413 @@
+//
+//    This file is part of Dire Wolf, an amateur radio packet TNC.
+//
+//    Copyright (C) 2026  Dire Wolf contributors
+//
+//    This program is free software: you can redistribute it and/or modify
+//    it under the terms of the GNU General Public License as published by
+//    the Free Software Foundation, either version 2 of the License, or
+//    (at your option) any later version.
+//
+//    This program is distributed in the hope that it will be useful,
+//    but WITHOUT ANY WARRANTY; without even the implied warranty of
+//    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//    GNU General Public License for more details.
+//
+//    You should have received a copy of the GNU General Public License
+//    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+
+
+/*------------------------------------------------------------------
+ *
+ * File:	pktlog.c
+ *
+ * Purpose:	Save received frames to a binary log with an index.
+ *
+ * Description: log.c writes a line of CSV for each APRS packet.  That is
+ *		easy to read, but after months of logs, finding a station
+ *		means reading and parsing every line, and the original
+ *		frame can't be recovered to feed into another application.
+ *
+ *		This saves every received frame, APRS or not, exactly as
+ *		it was sent to client applications, along with when and where
+ *		it was heard.  A small fixed size index entry is written for
+ *		each frame so pktlogq can find a time range with a binary
+ *		search and pick out stations without looking at the frames.
+ *		See pktlog.h for the file formats.
+ *
+ *		PKTLOGDIR directory	in the configuration file enables it.
+ *
+ *		Daily files, named by UTC date, are used like log.c.
+ *
+ *------------------------------------------------------------------*/
+
+#include "direwolf.h"
+
+#include <stdio.h>
+#include <time.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <errno.h>
+#include <math.h>
+
+#if __WIN32__
+#include <direct.h> 	// for _mkdir()
+#include <io.h>		// for _chsize()
+#endif
+
+#include "ax25_pad.h"
+#include "textcolor.h"
+#include "decode_aprs.h"
+#include "dtime_now.h"
+#include "pktlog.h"
+
+
+static char g_pktlog_path[80];		/* Directory.  Empty if not enabled. */
+
+static FILE *g_data_fp;
+static FILE *g_index_fp;
+static uint32_t g_data_offset;		/* Where the next record will go. */
+static char g_open_date[16];		/* yyyy-mm-dd of open files. */
+
+
+/*------------------------------------------------------------------
+ *
+ * Function:	pktlog_init
+ *
+ * Purpose:	Initialization at start of application.
+ *
+ * Inputs:	path	- Directory for the log files.
+ *			  Empty string disables the binary log.
+ *
+ *------------------------------------------------------------------*/
+
+void pktlog_init (char *path)
+{
+	struct stat st;
+
+	strlcpy (g_pktlog_path, "", sizeof(g_pktlog_path));
+	g_data_fp = NULL;
+	g_index_fp = NULL;
+	strlcpy (g_open_date, "", sizeof(g_open_date));
+
+	if (strlen(path) == 0) {
+	  return;
+	}
+
+	if (stat(path,&st) == 0) {
+	  if ( ! S_ISDIR(st.st_mode)) {
+	    text_color_set(DW_COLOR_ERROR);
+	    dw_printf ("Binary packet log location \"%s\" is not a directory.\n", path);
+	    return;
+	  }
+	}
+	else {
+#if __WIN32__
+	  if (_mkdir (path) != 0) {
+#else
+	  if (mkdir (path, 0777) != 0) {
+#endif
+	    text_color_set(DW_COLOR_ERROR);
+	    dw_printf ("Failed to create binary packet log location \"%s\".\n", path);
+	    dw_printf ("%s\n", strerror(errno));
+	    return;
+	  }
+	  text_color_set(DW_COLOR_INFO);
+	  dw_printf ("Binary packet log location \"%s\" has been created.\n", path);
+	}
+
+	strlcpy (g_pktlog_path, path, sizeof(g_pktlog_path));
+
+} /* end pktlog_init */
+
+
+
+static void truncate_file (FILE *fp, long size)
+{
+	fflush (fp);
+#if __WIN32__
+	if (_chsize (_fileno(fp), size) != 0) {
+#else
+	if (ftruncate (fileno(fp), size) != 0) {
+#endif
+	  text_color_set(DW_COLOR_ERROR);
+	  dw_printf ("Could not remove incomplete end of binary packet log.\n");
+	}
+}
+
+
+/*------------------------------------------------------------------
+ *
+ * Function:	open_one
+ *
+ * Purpose:	Open one of the daily files for append.
+ *
+ * Inputs:	date		- yyyy-mm-dd
+ *		ext		- ".pkt" or ".idx"
+ *		magic		- For file header.
+ *		entry_len	- Size of each entry after the header, or 0 if they vary.
+ *
+ * Outputs:	size		- File size, after the header.
+ *
+ * Returns:	File pointer or NULL for failure.
+ *
+ * Description:	If the previous run was interrupted in the middle of writing
+ *		an index entry, the partial entry is removed so later entries
+ *		stay at the expected positions.
+ *
+ *------------------------------------------------------------------*/
+
+static FILE *open_one (char *date, char *ext, char *magic, int entry_len, uint32_t *size)
+{
+	char full_path[120];
+	struct stat st;
+	FILE *fp;
+	long have = 0;
+
+	strlcpy (full_path, g_pktlog_path, sizeof(full_path));
+#if __WIN32__
+	strlcat (full_path, "\\", sizeof(full_path));
+#else
+	strlcat (full_path, "/", sizeof(full_path));
+#endif
+	strlcat (full_path, date, sizeof(full_path));
+	strlcat (full_path, ext, sizeof(full_path));
+
+	if (stat(full_path,&st) == 0) {
+	  have = st.st_size;
+	}
+
+	fp = fopen (full_path, "ab");
+	if (fp == NULL) {
+	  text_color_set(DW_COLOR_ERROR);
+	  dw_printf ("Can't open binary packet log \"%s\" for write.\n", full_path);
+	  dw_printf ("%s\n", strerror(errno));
+	  return (NULL);
+	}
+
+	if (have < PKTLOG_FILE_HDR_LEN) {
+	  unsigned char hdr[PKTLOG_FILE_HDR_LEN];
+
+	  memset (hdr, 0, sizeof(hdr));
+	  memcpy (hdr, magic, 8);
+	  pktlog_put32 (hdr + 8, PKTLOG_VERSION);
+
+	  truncate_file (fp, 0);
+	  fwrite (hdr, sizeof(hdr), 1, fp);
+	  have = PKTLOG_FILE_HDR_LEN;
+	}
+	else if (entry_len > 0 && (have - PKTLOG_FILE_HDR_LEN) % entry_len != 0) {
+	  have -= (have - PKTLOG_FILE_HDR_LEN) % entry_len;
+	  truncate_file (fp, have);
+	}
+
+	*size = have;
+	return (fp);
+}
+
+
+/*------------------------------------------------------------------
+ *
+ * Function:	pktlog_write
+ *
+ * Purpose:	Save a received frame.
+ *
+ * Inputs:	chan	- Radio channel where heard.
+ *
+ *		pp	- Received packet object.
+ *
+ * 		alevel	- Audio level.
+ *
+ *		fec_type - none, FX.25, or IL2P.
+ *
+ *		retries	- Amount of effort to get a good CRC.
+ *
+ *		lat, lon - Position decoded from APRS packet or G_UNKNOWN.
+ *
+ *------------------------------------------------------------------*/
+
+void pktlog_write (int chan, packet_t pp, alevel_t alevel, fec_type_t fec_type, retry_t retries, double lat, double lon)
+{
+	double now;
+	time_t tnow;
+	struct tm tm;
+	char date[16];
+
+	if (strlen(g_pktlog_path) == 0) return;
+
+	now = dtime_realtime();
+	tnow = (time_t)now;
+	(void)gmtime_r (&tnow, &tm);
+	strftime (date, sizeof(date), "%Y-%m-%d", &tm);
+
+	if (g_data_fp != NULL && strcmp(date, g_open_date) != 0) {
+	  pktlog_term ();
+	}
+
+	if (g_data_fp == NULL) {
+	  uint32_t index_size;
+
+	  g_data_fp = open_one (date, ".pkt", PKTLOG_DATA_MAGIC, 0, &g_data_offset);
+	  if (g_data_fp == NULL) {
+	    return;
+	  }
+	  g_index_fp = open_one (date, ".idx", PKTLOG_INDEX_MAGIC, PKTLOG_INDEX_LEN, &index_size);
+	  if (g_index_fp == NULL) {
+	    fclose (g_data_fp);
+	    g_data_fp = NULL;
+	    return;
+	  }
+	  strlcpy (g_open_date, date, sizeof(g_open_date));
+	}
+
+	int flen = ax25_get_frame_len (pp);
+	unsigned char *fbuf = ax25_get_frame_data_ptr (pp);
+	int rec_len = (PKTLOG_REC_HDR_LEN + flen + 3) & ~3;
+	unsigned char rec[PKTLOG_REC_HDR_LEN + AX25_MAX_PACKET_LEN + 3];
+	int64_t usec = (int64_t)(now * 1000000.0);
+
+	memset (rec, 0, rec_len);
+	pktlog_put32 (rec + 0, rec_len);
+	rec[4] = chan;
+	rec[5] = fec_type;
+	rec[6] = retries;
+	pktlog_put64 (rec + 8, (uint64_t)usec);
+	pktlog_put16 (rec + 16, (uint16_t)alevel.rec);
+	pktlog_put16 (rec + 18, (uint16_t)alevel.mark);
+	pktlog_put16 (rec + 20, (uint16_t)alevel.space);
+	pktlog_put16 (rec + 22, flen);
+	if (lat != G_UNKNOWN && lon != G_UNKNOWN) {
+	  rec[7] |= PKTLOG_F_POSITION;
+	  pktlog_put32 (rec + 24, (uint32_t)(int32_t)lround(lat * 1.0e7));
+	  pktlog_put32 (rec + 28, (uint32_t)(int32_t)lround(lon * 1.0e7));
+	}
+	memcpy (rec + PKTLOG_REC_HDR_LEN, fbuf, flen);
+
+	unsigned char entry[PKTLOG_INDEX_LEN];
+	char src[AX25_MAX_ADDR_LEN];
+
+	memset (entry, 0, sizeof(entry));
+	pktlog_put64 (entry + 0, (uint64_t)usec);
+	pktlog_put32 (entry + 8, g_data_offset);
+	entry[12] = chan;
+	ax25_get_addr_with_ssid (pp, AX25_SOURCE, src);
+	strncpy ((char *)entry + 16, src, PKTLOG_INDEX_SRC_LEN - 1);
+
+	// Record first so the index never points beyond the data.
+
+	if (fwrite (rec, rec_len, 1, g_data_fp) != 1) {
+	  text_color_set(DW_COLOR_ERROR);
+	  dw_printf ("Error writing binary packet log.  Closing it.\n");
+	  pktlog_term ();
+	  return;
+	}
+	fflush (g_data_fp);
+	g_data_offset += rec_len;
+
+	fwrite (entry, sizeof(entry), 1, g_index_fp);
+	fflush (g_index_fp);
+
+} /* end pktlog_write */
+
+
+
+/*------------------------------------------------------------------
+ *
+ * Function:	pktlog_term
+ *
+ * Purpose:	Close the files.
+ *		Called when the date changes or at exit.
+ *
+ *------------------------------------------------------------------*/
+
+void pktlog_term (void)
+{
+	if (g_data_fp != NULL) {
+	  fclose (g_data_fp);
+	  g_data_fp = NULL;
+	}
+	if (g_index_fp != NULL) {
+	  fclose (g_index_fp);
+	  g_index_fp = NULL;
+	}
+	strlcpy (g_open_date, "", sizeof(g_open_date));
+
+} /* end pktlog_term */
+
+
+
+/*
+ * Unit test.  Write a few frames, with known times, for check-pktlog
+ * which then searches for them with pktlogq.
+ * dtime_realtime is replaced here so we can pick the times.
+ */
+
+#if PKTLOG_TEST
+
+static double test_now;
+
+double dtime_realtime (void)
+{
+	return (test_now);
+}
+
+int main (int argc, char *argv[])
+{
+	static const struct {
+	  double sec;			// After 2026-03-15 00:00:00 UTC.
+	  int chan;
+	  char *monitor;
+	} test[] = {
+	  { 14*3600 + 29*60 + 59,	0,	"WB2OSZ-1>APDW18:>one" },
+	  { 14*3600 + 30*60,		1,	"N0CALL>APDW18:>two" },
+	  { 14*3600 + 30*60 + 30,	0,	"WB2OSZ>APDW18:>three" },
+	  { 14*3600 + 30*60 + 59.5,	1,	"WB2OSZ-15>APDW18:>four" },
+	  { 14*3600 + 31*60,		0,	"W1AW>APDW18:>five" },
+	  { 23*3600 + 59*60 + 59,	0,	"WB2OSZ-7>APDW18:>six" } };
+
+	alevel_t alevel;
+
+	text_color_init (0);
+	memset (&alevel, 0, sizeof(alevel));
+
+	// Start over if run before.
+
+	(void)remove ("testpktlog/2026-03-15.pkt");
+	(void)remove ("testpktlog/2026-03-15.idx");
+
+	pktlog_init ("testpktlog");
+
+	for (int n = 0; n < sizeof(test) / sizeof(test[0]); n++) {
+	  packet_t pp = ax25_from_text (test[n].monitor, 1);
+
+	  if (pp == NULL) {
+	    text_color_set(DW_COLOR_ERROR);
+	    dw_printf ("Could not make packet from \"%s\".\n", test[n].monitor);
+	    exit (EXIT_FAILURE);
+	  }
+	  test_now = 1773532800.0 + test[n].sec;
+	  pktlog_write (test[n].chan, pp, alevel, fec_type_none, RETRY_NONE, G_UNKNOWN, G_UNKNOWN);
+	  ax25_delete (pp);
+	}
+	pktlog_term ();
+
+	FILE *fp = fopen ("testpktlog/2026-03-15.idx", "rb");
+	if (fp == NULL) {
+	  text_color_set(DW_COLOR_ERROR);
+	  dw_printf ("Binary packet log was not written.\n");
+	  exit (EXIT_FAILURE);
+	}
+	fclose (fp);
+
+	text_color_set(DW_COLOR_INFO);
+	dw_printf ("Wrote %d frames to testpktlog/2026-03-15.\n", (int)(sizeof(test) / sizeof(test[0])));
+	exit (EXIT_SUCCESS);
+}
+
+#endif  /* PKTLOG_TEST */
+
+/* end pktlog.c */
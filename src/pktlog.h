@@ -0,0 +1,119 @@
+
+/* pktlog.h - Binary log of received frames, with an index for fast searching. */
+
+#ifndef PKTLOG_H
+#define PKTLOG_H 1
+
+#include <stdint.h>
+
+#include "ax25_pad.h"		/* for packet_t, alevel_t */
+#include "audio.h"		/* for retry_t */
+#include "dlq.h"		/* for fec_type_t */
+
+
+/*
+ * Each day, UTC, gets a pair of files in the PKTLOGDIR directory:
+ *
+ *	yyyy-mm-dd.pkt		Data.  A file header and then one record for each frame.
+ *	yyyy-mm-dd.idx		Index.  A file header and then one fixed size entry
+ *				for each record, in the order received.
+ *
+ * Both files are only appended to.  The data record is written before its
+ * index entry so every complete index entry refers to a complete record.
+ * An incomplete last index entry, from a crash, is ignored by readers.
+ *
+ * All numbers are little endian regardless of the machine writing them
+ * so files can be moved between computers.
+ */
+
+#define PKTLOG_FILE_HDR_LEN	16		/* 8 character magic, 32 bit version, 32 bits reserved. */
+
+#define PKTLOG_DATA_MAGIC	"DWPKTDAT"
+#define PKTLOG_INDEX_MAGIC	"DWPKTIDX"
+#define PKTLOG_VERSION		1
+
+
+/*
+ * Data record.  Offsets in bytes.
+ *
+ *	 0	u32	Length of whole record, including this header, multiple of 4.
+ *	 4	u8	Radio channel.
+ *	 5	u8	FEC type: 0 = none, 1 = FX.25, 2 = IL2P.
+ *	 6	u8	Retries, i.e. bits fixed to get a good CRC.
+ *	 7	u8	Flags.  See below.
+ *	 8	i64	Time received, microseconds since 1970, UTC.
+ *	16	i16	Audio level.
+ *	18	i16	Mark tone level.
+ *	20	i16	Space tone level.
+ *	22	u16	Frame length.
+ *	24	i32	Latitude, units of 1e-7 degree.  Only if PKTLOG_F_POSITION.
+ *	28	i32	Longitude, same units.
+ *	32		Frame, as sent to KISS clients, without FCS.
+ */
+
+#define PKTLOG_REC_HDR_LEN	32
+
+#define PKTLOG_F_POSITION	0x01		/* Latitude and longitude were decoded from APRS packet. */
+
+
+/*
+ * Index entry.
+ *
+ *	 0	i64	Time received, same as data record.
+ *	 8	u32	Offset of data record in the .pkt file.
+ *	12	u8	Radio channel.
+ *	13		Reserved, 3 bytes.
+ *	16	char	Source address with SSID, e.g. "WB2OSZ-15", nul padded.
+ */
+
+#define PKTLOG_INDEX_LEN	32
+
+#define PKTLOG_INDEX_SRC_LEN	16
+
+
+/*
+ * Get and put little endian numbers.
+ */
+
+static inline void pktlog_put16 (unsigned char *p, uint16_t x)
+{
+	p[0] = x & 0xff;
+	p[1] = (x >> 8) & 0xff;
+}
+
+static inline void pktlog_put32 (unsigned char *p, uint32_t x)
+{
+	pktlog_put16 (p, x & 0xffff);
+	pktlog_put16 (p + 2, x >> 16);
+}
+
+static inline void pktlog_put64 (unsigned char *p, uint64_t x)
+{
+	pktlog_put32 (p, x & 0xffffffff);
+	pktlog_put32 (p + 4, x >> 32);
+}
+
+static inline uint16_t pktlog_get16 (const unsigned char *p)
+{
+	return (p[0] | (p[1] << 8));
+}
+
+static inline uint32_t pktlog_get32 (const unsigned char *p)
+{
+	return (pktlog_get16(p) | ((uint32_t)pktlog_get16(p + 2) << 16));
+}
+
+static inline uint64_t pktlog_get64 (const unsigned char *p)
+{
+	return (pktlog_get32(p) | ((uint64_t)pktlog_get32(p + 4) << 32));
+}
+
+
+void pktlog_init (char *path);
+
+void pktlog_write (int chan, packet_t pp, alevel_t alevel, fec_type_t fec_type, retry_t retries, double lat, double lon);
+
+void pktlog_term (void);
+
+
+#endif  /* PKTLOG_H */
@@ -0,0 +1,525 @@
+//
+//    This file is part of Dire Wolf, an amateur radio packet TNC.
+//
+//    Copyright (C) 2026  Dire Wolf contributors
+//
+//    This program is free software: you can redistribute it and/or modify
+//    it under the terms of the GNU General Public License as published by
+//    the Free Software Foundation, either version 2 of the License, or
+//    (at your option) any later version.
+//
+//    This program is distributed in the hope that it will be useful,
+//    but WITHOUT ANY WARRANTY; without even the implied warranty of
+//    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//    GNU General Public License for more details.
+//
+//    You should have received a copy of the GNU General Public License
+//    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+
+
+/*------------------------------------------------------------------
+ *
+ * File:	pktlogq.c
+ *
+ * Purpose:	Search binary packet logs and optionally send the
+ *		frames found to a KISS TNC.
+ *
+ * Description:	The binary logs are written by direwolf when PKTLOGDIR
+ *		is in the configuration file.  See pktlog.h for the format.
+ *
+ *		The index file is mapped into memory.  The first entry in
+ *		the time window is found with a binary search, then entries
+ *		are checked for the station and channel wanted.  The data file
+ *		is only looked at for matching entries.
+ *
+ *		Matching frames are listed in monitor format.  With -h, they
+ *		are also sent to a KISS TNC over TCP.  Another instance of
+ *		direwolf will transmit them on the channel given, so point it
+ *		at a channel or instance used for testing.
+ *
+ * Usage:	pktlogq [ options ] file ...
+ *
+ *		Files can be either the .idx or .pkt of the pair.
+ *
+ *------------------------------------------------------------------*/
+
+#include "direwolf.h"
+
+#if __WIN32__
+#include <winsock2.h>
+#else
+#include <sys/types.h>
+#include <sys/socket.h>
+#include <sys/mman.h>
+#include <fcntl.h>
+#endif
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+#include <assert.h>
+#include <getopt.h>
+#include <unistd.h>
+#include <time.h>
+#include <sys/stat.h>
+
+#include "ax25_pad.h"
+#include "textcolor.h"
+#include "kiss_frame.h"
+#include "dwsock.h"
+#include "pktlog.h"
+
+
+static char station[AX25_MAX_ADDR_LEN] = "";	/* -s option. */
+static int64_t begin_us = INT64_MIN;		/* -b option. */
+static int64_t end_us = INT64_MAX;		/* -e option. */
+static int only_chan = -1;			/* -c option. */
+static char hostname[50] = "";			/* -h option. */
+static char port[30] = "8001";			/* -p option. */
+static int kiss_chan = -1;			/* -C option. */
+static int delay_ms = 100;			/* -d option. */
+static int quiet = 0;				/* -q option. */
+
+static int server_sock = -1;
+
+
+/*
+ * A file mapped into memory, or read into memory where mmap is not available.
+ */
+
+struct map_s {
+	unsigned char *p;
+	size_t len;
+};
+
+static int map_file (char *fname, struct map_s *m)
+{
+	struct stat st;
+
+	m->p = NULL;
+	m->len = 0;
+
+	if (stat(fname, &st) != 0) {
+	  text_color_set(DW_COLOR_ERROR);
+	  dw_printf ("Can't open %s.\n", fname);
+	  return (-1);
+	}
+	if (st.st_size < PKTLOG_FILE_HDR_LEN) {
+	  text_color_set(DW_COLOR_ERROR);
+	  dw_printf ("%s is too short.\n", fname);
+	  return (-1);
+	}
+	m->len = st.st_size;
+
+#if __WIN32__
+	FILE *fp = fopen (fname, "rb");
+	if (fp == NULL) {
+	  text_color_set(DW_COLOR_ERROR);
+	  dw_printf ("Can't open %s.\n", fname);
+	  return (-1);
+	}
+	m->p = malloc (m->len);
+	if (m->p == NULL) {
+	  text_color_set(DW_COLOR_ERROR);
+	  dw_printf ("FATAL ERROR: Out of memory.\n");
+	  exit (EXIT_FAILURE);
+	}
+	m->len = fread (m->p, 1, m->len, fp);
+	fclose (fp);
+#else
+	int fd = open (fname, O_RDONLY);
+	if (fd < 0) {
+	  text_color_set(DW_COLOR_ERROR);
+	  dw_printf ("Can't open %s.\n", fname);
+	  return (-1);
+	}
+	void *p = mmap (NULL, m->len, PROT_READ, MAP_SHARED, fd, 0);
+	close (fd);
+	if (p == MAP_FAILED) {
+	  text_color_set(DW_COLOR_ERROR);
+	  dw_printf ("Can't map %s into memory.\n", fname);
+	  return (-1);
+	}
+	m->p = p;
+#endif
+	return (0);
+}
+
+static void unmap_file (struct map_s *m)
+{
+	if (m->p != NULL) {
+#if __WIN32__
+	  free (m->p);
+#else
+	  munmap (m->p, m->len);
+#endif
+	  m->p = NULL;
+	}
+}
+
+
+/*
+ * Seconds since 1970 for a UTC date and time.
+ * timegm isn't available everywhere.
+ */
+
+static int64_t utc_seconds (int y, int mon, int d, int h, int min, int s)
+{
+	// Days since 1970-01-01, from a well known algorithm for the proleptic Gregorian calendar.
+
+	y -= mon <= 2;
+	int64_t era = (y >= 0 ? y : y - 399) / 400;
+	int64_t yoe = y - era * 400;
+	int64_t doy = (153 * (mon + (mon > 2 ? -3 : 9)) + 2) / 5 + d - 1;
+	int64_t doe = yoe * 365 + yoe / 4 - yoe / 100 + doy;
+	int64_t days = era * 146097 + doe - 719468;
+
+	return (days * 86400 + h * 3600 + min * 60 + s);
+}
+
+
+/*
+ * Parse yyyy-mm-dd[Thh:mm[:ss]], UTC, into microseconds.
+ * Also get the length of the day, minute, or second named,
+ * so the end of a time window can include all of it.
+ */
+
+static int64_t parse_time (char *str, int64_t *extent_us)
+{
+	int y, mon, d, h = 0, min = 0, s = 0;
+
+	int n = sscanf (str, "%d-%d-%d%*1[T ]%d:%d:%d", &y, &mon, &d, &h, &min, &s);
+	if (n < 3 || n == 4 || mon < 1 || mon > 12 || d < 1 || d > 31) {
+	  text_color_set(DW_COLOR_ERROR);
+	  dw_printf ("Time \"%s\" should be like 2026-03-15 or 2026-03-15T14:30:00.\n", str);
+	  exit (EXIT_FAILURE);
+	}
+	*extent_us = (n == 3 ? 86400LL : n == 5 ? 60LL : 1LL) * 1000000;
+	return (utc_seconds (y, mon, d, h, min, s) * 1000000);
+}
+
+
+/*
+ * Does source address from index match the -s option?
+ * Without an SSID, any SSID matches.  A trailing * matches any ending.
+ */
+
+static int station_match (const char *src)
+{
+	int n = strlen(station);
+
+	if (n == 0) {
+	  return (1);
+	}
+	if (station[n-1] == '*') {
+	  return (strncasecmp(src, station, n-1) == 0);
+	}
+	if (strncasecmp(src, station, n) != 0) {
+	  return (0);
+	}
+	return (src[n] == '\0' || (src[n] == '-' && strchr(station, '-') == NULL));
+}
+
+
+/*
+ * Print and/or send one frame.
+ */
+
+static void process_record (const unsigned char *rec, int64_t usec)
+{
+	static const char *fec_name[3] = { "", " FX.25", " IL2P" };
+
+	int chan = rec[4];
+	int fec = rec[5];
+	int retries = rec[6];
+	int flags = rec[7];
+	int level = (int16_t)pktlog_get16 (rec + 16);
+	int flen = pktlog_get16 (rec + 22);
+	const unsigned char *fbuf = rec + PKTLOG_REC_HDR_LEN;
+
+	assert (flen <= AX25_MAX_PACKET_LEN);		// Checked by caller.
+
+	if ( ! quiet) {
+	  time_t t = (time_t)(usec / 1000000);
+	  struct tm tm;
+	  char stime[32];
+	  alevel_t alevel;
+
+	  memset (&alevel, 0xff, sizeof(alevel));
+	  packet_t pp = ax25_from_frame ((unsigned char *)fbuf, flen, alevel);
+
+	  (void)gmtime_r (&t, &tm);
+	  strftime (stime, sizeof(stime), "%Y-%m-%dT%H:%M:%S", &tm);
+
+	  text_color_set(DW_COLOR_REC);
+	  dw_printf ("%s.%03dZ [%d] audio level %d%s%s", stime, (int)((usec / 1000) % 1000), chan,
+			level, fec >= 1 && fec <= 2 ? fec_name[fec] : "", retries ? " (fixed bits)" : "");
+	  if (flags & PKTLOG_F_POSITION) {
+	    dw_printf (" %.6f %.6f", (int32_t)pktlog_get32(rec + 24) * 1.0e-7, (int32_t)pktlog_get32(rec + 28) * 1.0e-7);
+	  }
+	  dw_printf ("\n");
+
+	  if (pp != NULL) {
+	    char addrs[AX25_MAX_ADDRS*AX25_MAX_ADDR_LEN];
+	    unsigned char *pinfo;
+	    int info_len;
+
+	    ax25_format_addrs (pp, addrs);
+	    info_len = ax25_get_info (pp, &pinfo);
+	    text_color_set(DW_COLOR_DECODED);
+	    dw_printf ("%s", addrs);
+	    ax25_safe_print ((char *)pinfo, info_len, 0);
+	    dw_printf ("\n");
+	    ax25_delete (pp);
+	  }
+	  else {
+	    text_color_set(DW_COLOR_ERROR);
+	    dw_printf ("Frame is not valid AX.25.\n");
+	  }
+	}
+
+	if (server_sock >= 0) {
+	  unsigned char temp[AX25_MAX_PACKET_LEN + 1];
+	  unsigned char kissed[AX25_MAX_PACKET_LEN * 2 + 4];
+
+	  temp[0] = ((kiss_chan >= 0 ? kiss_chan : chan) << 4) | KISS_CMD_DATA_FRAME;
+	  memcpy (temp + 1, fbuf, flen);
+	  int klen = kiss_encapsulate (temp, flen + 1, kissed);
+
+	  if (SOCK_SEND(server_sock, (char *)kissed, klen) != klen) {
+	    text_color_set(DW_COLOR_ERROR);
+	    dw_printf ("ERROR writing KISS frame to socket.\n");
+	    exit (EXIT_FAILURE);
+	  }
+	  if (delay_ms > 0) {
+	    SLEEP_MS (delay_ms);
+	  }
+	}
+}
+
+
+/*
+ * Search one pair of files.  Returns number of frames found.
+ */
+
+static int search_file (char *fname)
+{
+	char idx_name[300];
+	char pkt_name[300];
+	struct map_s idx, pkt;
+	int found = 0;
+
+	strlcpy (idx_name, fname, sizeof(idx_name));
+	char *dot = strrchr (idx_name, '.');
+	if (dot == NULL || (strcmp(dot, ".idx") != 0 && strcmp(dot, ".pkt") != 0)) {
+	  text_color_set(DW_COLOR_ERROR);
+	  dw_printf ("%s should be a binary packet log with .idx or .pkt file name extension.\n", fname);
+	  return (0);
+	}
+	strlcpy (dot, ".idx", sizeof(idx_name) - (dot - idx_name));
+	strlcpy (pkt_name, idx_name, sizeof(pkt_name));
+	strlcpy (pkt_name + (dot - idx_name), ".pkt", sizeof(pkt_name) - (dot - idx_name));
+
+	if (map_file (idx_name, &idx) != 0) {
+	  return (0);
+	}
+	if (map_file (pkt_name, &pkt) != 0) {
+	  unmap_file (&idx);
+	  return (0);
+	}
+
+	if (memcmp(idx.p, PKTLOG_INDEX_MAGIC, 8) != 0 || memcmp(pkt.p, PKTLOG_DATA_MAGIC, 8) != 0 ||
+		pktlog_get32(idx.p + 8) != PKTLOG_VERSION || pktlog_get32(pkt.p + 8) != PKTLOG_VERSION) {
+	  text_color_set(DW_COLOR_ERROR);
+	  dw_printf ("%s is not a binary packet log of version %d.\n", fname, PKTLOG_VERSION);
+	  unmap_file (&idx);
+	  unmap_file (&pkt);
+	  return (0);
+	}
+
+	const unsigned char *entries = idx.p + PKTLOG_FILE_HDR_LEN;
+	size_t num = (idx.len - PKTLOG_FILE_HDR_LEN) / PKTLOG_INDEX_LEN;
+
+// Find first entry at or after the beginning time.
+
+	size_t lo = 0, hi = num;
+	while (lo < hi) {
+	  size_t mid = lo + (hi - lo) / 2;
+	  if ((int64_t)pktlog_get64(entries + mid * PKTLOG_INDEX_LEN) < begin_us) {
+	    lo = mid + 1;
+	  }
+	  else {
+	    hi = mid;
+	  }
+	}
+
+	size_t n;
+	for (n = lo; n < num; n++) {
+	  const unsigned char *e = entries + n * PKTLOG_INDEX_LEN;
+	  int64_t usec = (int64_t)pktlog_get64(e);
+	  char src[PKTLOG_INDEX_SRC_LEN + 1];
+
+	  if (usec > end_us) {
+	    break;
+	  }
+	  if (only_chan >= 0 && e[12] != only_chan) {
+	    continue;
+	  }
+	  memcpy (src, e + 16, PKTLOG_INDEX_SRC_LEN);
+	  src[PKTLOG_INDEX_SRC_LEN] = '\0';
+	  if ( ! station_match(src)) {
+	    continue;
+	  }
+
+// Don't trust anything from the file.  It could be damaged, or the last
+// record could have been cut short when direwolf stopped.  Sizes are
+// compared by subtraction so nothing can wrap around.
+
+	  size_t offset = pktlog_get32(e + 8);
+	  if (offset < PKTLOG_FILE_HDR_LEN || offset > pkt.len ||
+		pkt.len - offset < PKTLOG_REC_HDR_LEN) {
+	    text_color_set(DW_COLOR_ERROR);
+	    dw_printf ("%s: Index entry %d points past the end of the data file.  Record is incomplete.\n", fname, (int)n);
+	    continue;
+	  }
+
+	  size_t reclen = pktlog_get32(pkt.p + offset);
+	  size_t flen = pktlog_get16(pkt.p + offset + 22);
+	  if (reclen > pkt.len - offset) {
+	    text_color_set(DW_COLOR_ERROR);
+	    dw_printf ("%s: Record for index entry %d is incomplete.\n", fname, (int)n);
+	    continue;
+	  }
+	  if (reclen < PKTLOG_REC_HDR_LEN || flen > reclen - PKTLOG_REC_HDR_LEN || flen > AX25_MAX_PACKET_LEN) {
+	    text_color_set(DW_COLOR_ERROR);
+	    dw_printf ("%s: Index entry %d points to an invalid record.\n", fname, (int)n);
+	    continue;
+	  }
+
+	  process_record (pkt.p + offset, usec);
+	  found++;
+	}
+
+	unmap_file (&idx);
+	unmap_file (&pkt);
+	return (found);
+}
+
+
+/*
+ * kiss_frame.c calls this for frames received from the TNC.
+ * We don't read anything from the TNC so it is never used.
+ */
+
+void kiss_process_msg (unsigned char *kiss_msg, int kiss_len, int debug, struct kissport_status_s *kps, int client,
+			void (*sendfun)(int chan, int kiss_cmd, unsigned char *fbuf, int flen, struct kissport_status_s *kps, int client))
+{
+}
+
+
+static void usage (void)
+{
+	text_color_set(DW_COLOR_INFO);
+	dw_printf ("\n");
+	dw_printf ("pktlogq - Search binary packet logs written by direwolf with PKTLOGDIR.\n");
+	dw_printf ("\n");
+	dw_printf ("Usage: pktlogq [options] file ...\n");
+	dw_printf ("\n");
+	dw_printf ("    -s station   Source address.  Any SSID if none given.  Trailing * matches anything.\n");
+	dw_printf ("    -b time      Beginning of time window, UTC, e.g. 2026-03-15T14:30.\n");
+	dw_printf ("    -e time      End of time window, including all of the day, minute, or second.\n");
+	dw_printf ("    -c chan      Only this radio channel.\n");
+	dw_printf ("    -h host      Send frames found to KISS TNC on this host.\n");
+	dw_printf ("    -p port      TCP port for KISS TNC.  Default 8001.\n");
+	dw_printf ("    -C chan      Channel for sending to KISS TNC.  Default is channel where heard.\n");
+	dw_printf ("    -d msec      Delay between frames sent to KISS TNC.  Default 100.\n");
+	dw_printf ("    -q           Quiet.  Don't list the frames.\n");
+	dw_printf ("\n");
+	dw_printf ("Files can be .idx or .pkt; the other of the pair is found automatically.\n");
+	exit (EXIT_FAILURE);
+}
+
+
+int main (int argc, char *argv[])
+{
+	int c;
+	int total = 0;
+	int64_t extent_us;
+
+	text_color_init (0);	// Turn off text color.
+
+	while ((c = getopt(argc, argv, "s:b:e:c:h:p:C:d:q")) != -1) {
+	  switch (c) {
+	    case 's':
+	      strlcpy (station, optarg, sizeof(station));
+	      break;
+	    case 'b':
+	      begin_us = parse_time (optarg, &extent_us);
+	      break;
+	    case 'e':
+	      end_us = parse_time (optarg, &extent_us);
+	      end_us += extent_us - 1;		// All of the day, minute, or second.
+	      break;
+	    case 'c':
+	      only_chan = atoi(optarg);
+	      break;
+	    case 'h':
+	      strlcpy (hostname, optarg, sizeof(hostname));
+	      break;
+	    case 'p':
+	      strlcpy (port, optarg, sizeof(port));
+	      break;
+	    case 'C':
+	      kiss_chan = atoi(optarg);
+	      if (kiss_chan < 0 || kiss_chan > 15) {
+	        text_color_set(DW_COLOR_ERROR);
+	        dw_printf ("KISS channel must be in range 0 to 15.\n");
+	        exit (EXIT_FAILURE);
+	      }
+	      break;
+	    case 'd':
+	      delay_ms = atoi(optarg);
+	      break;
+	    case 'q':
+	      quiet = 1;
+	      break;
+	    default:
+	      usage ();
+	  }
+	}
+
+	if (optind >= argc) {
+	  usage ();
+	}
+
+	if (strlen(hostname) > 0) {
+	  char ipaddr_str[DWSOCK_IPADDR_LEN];
+
+	  if (dwsock_init() < 0) {
+	    exit (EXIT_FAILURE);
+	  }
+	  server_sock = dwsock_connect (hostname, port, "TCP KISS TNC", 0, 0, ipaddr_str);
+	  if (server_sock < 0) {
+	    text_color_set(DW_COLOR_ERROR);
+	    dw_printf ("Unable to connect to KISS TNC at %s:%s.\n", hostname, port);
+	    exit (EXIT_FAILURE);
+	  }
+	}
+
+	for ( ; optind < argc; optind++) {
+	  total += search_file (argv[optind]);
+	}
+
+	text_color_set(DW_COLOR_INFO);
+	dw_printf ("%d frame%s found.\n", total, total == 1 ? "" : "s");
+
+	if (server_sock >= 0) {
+	  SLEEP_MS (500);		// Give the TNC a chance to read everything before we close.
+	  dwsock_close (server_sock);
+	}
+	exit (EXIT_SUCCESS);
+}
+
+/* end pktlogq.c */
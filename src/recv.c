@@ -38,7 +38,7 @@
  *			various other *_init()
  *
  *			loop forever:
- *				s = demod_get_sample.
+ *				demod_get_sample (&s)
  *				multi_modem_process_sample(s)
  *				
  *
@@ -207,10 +207,10 @@ static void * recv_adev_thread (void *arg)
 	int a = (int)(ptrdiff_t)arg;	// audio device number.
 	int eof;
 	
-	/* This audio device can have one (mono) or two (stereo) channels. */
-	/* Find number of the first channel and number of channels. */
+	/* This audio device can have one (mono) or two (stereo) channels, */
+	/* or more for IQ input.  Find number of the first channel and number of channels. */
 
-	int first_chan =  ADEVFIRSTCHAN(a); 
+	int first_chan = save_pa->adev[a].first_chan;
 	int num_chan = save_pa->adev[a].num_channels;
 
 #if DEBUG
@@ -224,20 +224,18 @@ static void * recv_adev_thread (void *arg)
 	while ( ! eof) 
 	{
 
-	  int audio_sample;
+	  float audio_sample = 0;
 	  int c;
 	  char tt;
 
 	  for (c=0; c<num_chan; c++)
 	  {
-	    audio_sample = demod_get_sample (a);
-	  
- 	    if (audio_sample >= 256 * 256) 
+	    if (demod_get_sample (a, &audio_sample) < 0) 
 	      eof = 1;
 
 	    // Future?  provide more flexible mapping.
 	    // i.e. for each valid channel where audio_source[] is first_chan+c.
-	    multi_modem_process_sample(first_chan + c, audio_sample);
+	    multi_modem_process_sample(rx_chain_get(first_chan + c), audio_sample);
 
 
 	    /* Originally, the DTMF decoder was always active. */
@@ -260,7 +258,7 @@ static void * recv_adev_thread (void *arg)
 	    /* sequences arriving at the same instant. */
 
 	    if (save_pa->achan[first_chan + c].dtmf_decode != DTMF_DECODE_OFF) {
-	      tt = dtmf_sample (first_chan + c, audio_sample/16384.);
+	      tt = dtmf_sample (first_chan + c, audio_sample);
 	      if (tt != ' ') {
 	        aprs_tt_button (first_chan + c, tt);
 	      }
@@ -31,6 +31,9 @@
  *
  * Version 1.3:	Store as bytes rather than packing 8 bits per byte.
  *
+ * Version 1.8:	Recycle deleted blocks rather than going back to
+ *		malloc / free for every frame.  Each one is over 20 KB.
+ *
  *******************************************************************************/
 
 #define RRBB_C
@@ -45,14 +48,25 @@
 #include "textcolor.h"
 #include "ax25_pad.h"
 #include "rrbb.h"
+#include "rx_chain.h"
 
 
 #define MAGIC1 0x12344321
 #define MAGIC2 0x56788765
 
 
-volatile static int new_count = 0;
-volatile static int delete_count = 0;
+/*
+ * Deleted blocks are kept on a free list in the receive chain.
+ *
+ * A block is created by hdlc_rec.c and deleted by hdlc_rec2.c, both
+ * in the thread which runs that receive chain, so no locking is
+ * needed when the lists are kept per chain.
+ *
+ * Normally there is one block per slicer being filled and one being
+ * decoded so only a couple need to be kept around.
+ */
+
+#define RRBB_FREE_MAX 4
 
 
 /***********************************************************************************
@@ -61,7 +75,7 @@ volatile static int delete_count = 0;
  *
  * Purpose:	Allocate space for an array of samples.
  *
- * Inputs:	chan	- Radio channel from whence it came.
+ * Inputs:	R	- Receive chain for the radio channel from whence it came.
  *
  *		subchan	- Which demodulator of the channel.
  *
@@ -79,31 +93,40 @@ volatile static int delete_count = 0;
  *
  ***********************************************************************************/
 
-rrbb_t rrbb_new (int chan, int subchan, int slice, int is_scrambled, int descram_state, int prev_descram)
+rrbb_t rrbb_new (struct rx_chain_s *R, int subchan, int slice, int is_scrambled, int descram_state, int prev_descram)
 {
 	rrbb_t result;
+	int chan = R->chan;
 
 	assert (chan >= 0 && chan < MAX_RADIO_CHANS);
 	assert (subchan >= 0 && subchan < MAX_SUBCHANS);
 	assert (slice >= 0 && slice < MAX_SLICERS);
 
-	result = malloc(sizeof(struct rrbb_s));
-	if (result == NULL) {
-	  text_color_set(DW_COLOR_ERROR);
-	  dw_printf ("FATAL ERROR: Out of memory.\n");
-	  exit (EXIT_FAILURE);
+	if (R->rrbb_free != NULL) {
+	  result = R->rrbb_free;
+	  R->rrbb_free = result->nextp;
+	  R->rrbb_free_len--;
+	}
+	else {
+	  result = malloc(sizeof(struct rrbb_s));
+	  if (result == NULL) {
+	    text_color_set(DW_COLOR_ERROR);
+	    dw_printf ("FATAL ERROR: Out of memory.\n");
+	    exit (EXIT_FAILURE);
+	  }
 	}
 	result->magic1 = MAGIC1;
+	result->chain = R;
 	result->chan = chan;
 	result->subchan = subchan;
 	result->slice = slice;
 	result->magic2 = MAGIC2;
 
-	new_count++;
+	R->rrbb_in_use++;
 
-	if (new_count > delete_count + 100) {
+	if (R->rrbb_in_use > 100) {
 	  text_color_set(DW_COLOR_ERROR);
-	  dw_printf ("MEMORY LEAK, rrbb_new, new_count=%d, delete_count=%d\n", new_count, delete_count);
+	  dw_printf ("MEMORY LEAK, rrbb_new, chan=%d, %d in use\n", chan, R->rrbb_in_use);
 	}
 
 	rrbb_clear (result, is_scrambled, descram_state, prev_descram);
@@ -158,6 +181,7 @@ void rrbb_clear (rrbb_t b, int is_scrambled, int descram_state, int prev_descram
  *
  * Inputs:	Handle for sample array.
  *		Value for the sample.
+ *		Confidence in the value, 0 to 100.
  *
  ***********************************************************************************/
 
@@ -259,21 +283,38 @@ int rrbb_get_len (rrbb_t b)
  * Purpose:	Free the storage associated with the bit array.
  *
  * Inputs:	Handle for bit array.
+ *
+ * Description:	It goes on the free list for the receive chain, to be used
+ *		again by rrbb_new, unless there are already enough there.
+ *		The magic numbers are cleared either way so any further
+ *		use by the caller will be caught.
  *		
  ***********************************************************************************/
 
 void rrbb_delete (rrbb_t b)
 {
+	struct rx_chain_s *R;
+
 	assert (b != NULL);
 	assert (b->magic1 == MAGIC1);
 	assert (b->magic2 == MAGIC2);
 
 	b->magic1 = 0;
 	b->magic2 = 0;
-	
-	free (b);
 
-	delete_count++;
+	R = b->chain;
+	assert (R != NULL);
+
+	if (R->rrbb_free_len < RRBB_FREE_MAX) {
+	  b->nextp = R->rrbb_free;
+	  R->rrbb_free = b;
+	  R->rrbb_free_len++;
+	}
+	else {
+	  free (b);
+	}
+
+	R->rrbb_in_use--;
 }
 
 
@@ -339,6 +380,26 @@ int rrbb_get_chan (rrbb_t b)
 }
 
 
+/***********************************************************************************
+ *
+ * Name:	rrbb_get_chain
+ *
+ * Purpose:	Get receive chain which collected the bit buffer.
+ *
+ * Inputs:	b	Handle for bit array.
+ *		
+ ***********************************************************************************/
+
+struct rx_chain_s *rrbb_get_chain (rrbb_t b)
+{
+	assert (b != NULL);
+	assert (b->magic1 == MAGIC1);
+	assert (b->magic2 == MAGIC2);
+
+	return (b->chain);
+}
+
+
 /***********************************************************************************
  *
  * Name:	rrbb_get_subchan	
@@ -24,10 +24,13 @@
 
 #define MAX_NUM_BITS (MAX_FRAME_LEN * 8 * 6 / 5)
 
+struct rx_chain_s;
+
 typedef struct rrbb_s {
 	int magic1;
 	struct rrbb_s* nextp;	/* Next pointer to maintain a queue. */
 
+	struct rx_chain_s *chain; /* Receive chain which collected it. */
 	int chan;		/* Radio channel from which it was received. */
 	int subchan;		/* Which modem when more than one per channel. */
 	int slice;		/* Which slicer. */
@@ -42,22 +45,26 @@ typedef struct rrbb_s {
 
 	unsigned char fdata[MAX_NUM_BITS];
 
+	unsigned char fqual[MAX_NUM_BITS];	/* Confidence in each bit, 0 to 100, from the demodulator. */
+						/* Used to decide which bits to try changing first. */
+
 	int magic2;
 } *rrbb_t;
 
 
 
-rrbb_t rrbb_new (int chan, int subchan, int slice, int is_scrambled, int descram_state, int prev_descram);
+rrbb_t rrbb_new (struct rx_chain_s *R, int subchan, int slice, int is_scrambled, int descram_state, int prev_descram);
 
 void rrbb_clear (rrbb_t b, int is_scrambled, int descram_state, int prev_descram);
 
 
-static inline /*__attribute__((always_inline))*/ void rrbb_append_bit (rrbb_t b, const unsigned char val)
+static inline /*__attribute__((always_inline))*/ void rrbb_append_bit (rrbb_t b, const unsigned char val, const unsigned char quality)
 {
 	if (b->len >= MAX_NUM_BITS) {
 	  return;	/* Silently discard if full. */
 	}
 	b->fdata[b->len] = val;
+	b->fqual[b->len] = quality;
 	b->len++;
 }
 
@@ -66,6 +73,11 @@ static inline /*__attribute__((always_inline))*/ unsigned char rrbb_get_bit (con
 	return (b->fdata[ind]);
 }
 
+static inline /*__attribute__((always_inline))*/ unsigned char rrbb_get_quality (const rrbb_t b, const int ind)
+{
+	return (b->fqual[ind]);
+}
+
 
 void rrbb_chop8 (rrbb_t b);
 
@@ -79,6 +91,7 @@ void rrbb_set_nextp (rrbb_t b, rrbb_t np);
 rrbb_t rrbb_get_nextp (rrbb_t b);
 
 int rrbb_get_chan (rrbb_t b);
+struct rx_chain_s *rrbb_get_chain (rrbb_t b);
 int rrbb_get_subchan (rrbb_t b);
 int rrbb_get_slice (rrbb_t b);
 
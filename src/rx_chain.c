@@ -0,0 +1,151 @@
+//
+//    This file is part of Dire Wolf, an amateur radio packet TNC.
+//
+//    Copyright (C) 2026  Dire Wolf contributors
+//
+//    This program is free software: you can redistribute it and/or modify
+//    it under the terms of the GNU General Public License as published by
+//    the Free Software Foundation, either version 2 of the License, or
+//    (at your option) any later version.
+//
+//    This program is distributed in the hope that it will be useful,
+//    but WITHOUT ANY WARRANTY; without even the implied warranty of
+//    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//    GNU General Public License for more details.
+//
+//    You should have received a copy of the GNU General Public License
+//    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+
+
+/********************************************************************************
+ *
+ * File:	rx_chain.c
+ *
+ * Purpose:	Keep the receive state for each radio channel together.
+ *
+ * Description:	Previously demod.c, hdlc_rec.c, multi_modem.c, fx25_rec.c,
+ *		and il2p_rec.c each had their own static arrays indexed by
+ *		channel, subchannel, and slicer.  State for different channels,
+ *		often processed by different threads, was packed together
+ *		so they ended up sharing cache lines.
+ *
+ *		Now each module keeps its state for a channel in a part of
+ *		the rx_chain_s structure for that channel.  See rx_chain.h.
+ *
+ *******************************************************************************/
+
+#include "direwolf.h"
+
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <assert.h>
+
+#include "textcolor.h"
+#include "rx_chain.h"
+
+
+struct rx_chain_s *rx_chain[MAX_RADIO_CHANS];
+
+
+#define CACHE_LINE 64
+
+
+/*-------------------------------------------------------------------
+ *
+ * Name:        rx_chain_new
+ *
+ * Purpose:     Create the receive state for a channel.
+ *
+ * Inputs:	chan	- Radio channel number.
+ *
+ * Returns:	Pointer to new structure with all parts empty.
+ *
+ * Description:	Normally called by rx_chain_get the first time a channel is used.
+ *		Each module fills in its own part when initialized.
+ *
+ *--------------------------------------------------------------------*/
+
+struct rx_chain_s *rx_chain_new (int chan)
+{
+	assert (chan >= 0 && chan < MAX_RADIO_CHANS);
+
+	if (rx_chain[chan] == NULL) {
+	  rx_chain[chan] = rx_chain_create (chan);
+	}
+	return (rx_chain[chan]);
+}
+
+
+/*-------------------------------------------------------------------
+ *
+ * Name:        rx_chain_create
+ *
+ * Purpose:     Create receive state which is not the one for the channel.
+ *
+ * Inputs:	chan	- Radio channel number, for the configuration to
+ *			  use and for reporting frames heard.
+ *
+ * Returns:	Pointer to new structure with all parts empty.
+ *		Set it up with multi_modem_chain_init.
+ *
+ * Description:	Nothing else knows about it.  It can be run by a separate
+ *		thread alongside the one in rx_chain[chan], e.g. to try
+ *		different settings on the same audio.
+ *
+ *--------------------------------------------------------------------*/
+
+struct rx_chain_s *rx_chain_create (int chan)
+{
+	assert (chan >= 0 && chan < MAX_RADIO_CHANS);
+
+	struct rx_chain_s *R = rx_chain_alloc (sizeof(struct rx_chain_s));
+	R->chan = chan;
+	return (R);
+}
+
+
+/*-------------------------------------------------------------------
+ *
+ * Name:        rx_chain_alloc
+ *
+ * Purpose:     Allocate zeroed memory for a channel's receive state.
+ *
+ * Inputs:	size	- Number of bytes.
+ *
+ * Returns:	Pointer to memory which starts on a cache line and
+ *		doesn't share its last cache line with anything else.
+ *		Exits if out of memory.
+ *
+ * Description:	malloc alignment is only 8 or 16 bytes and aligned_alloc
+ *		is not available everywhere so we round up ourselves.
+ *		The original pointer is kept just before the result
+ *		for rx_chain_free.
+ *
+ *--------------------------------------------------------------------*/
+
+void *rx_chain_alloc (size_t size)
+{
+	size_t rounded = (size + CACHE_LINE - 1) & ~(size_t)(CACHE_LINE - 1);
+
+	char *p = calloc (1, rounded + CACHE_LINE + sizeof(void *));
+	if (p == NULL) {
+	  text_color_set(DW_COLOR_ERROR);
+	  dw_printf ("FATAL ERROR: Out of memory.\n");
+	  exit (EXIT_FAILURE);
+	}
+
+	uintptr_t a = ((uintptr_t)(p + sizeof(void *)) + CACHE_LINE - 1) & ~(uintptr_t)(CACHE_LINE - 1);
+	((void **)a)[-1] = p;
+	return ((void *)a);
+}
+
+void rx_chain_free (void *p)
+{
+	if (p != NULL) {
+	  free (((void **)p)[-1]);
+	}
+}
+
+/* end rx_chain.c */
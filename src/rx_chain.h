@@ -0,0 +1,126 @@
+
+/* rx_chain.h - Receive state for one radio channel. */
+
+#ifndef RX_CHAIN_H
+#define RX_CHAIN_H 1
+
+#include <stddef.h>
+
+#include "direwolf.h"		// for MAX_RADIO_CHANS, MAX_SUBCHANS, MAX_SLICERS
+#include "dtime_now.h"
+#include "rxprof.h"
+
+
+/*
+ * Everything the receive chain remembers about a channel, from the
+ * demodulators through HDLC, FX.25, IL2P, and picking the best of
+ * multiple candidates, is reached from here.
+ *
+ * Each part belongs to the module named and its contents are private
+ * to that module.  Each part is allocated on its own cache line so
+ * channels processed by different threads don't slow each other down
+ * by writing to the same cache line.
+ *
+ * A channel is processed by only one thread so there is no locking.
+ *
+ * The receive path, from multi_modem_process_sample through the
+ * demodulators, HDLC, FX.25, IL2P, hdlc_rec2, and back to
+ * multi_modem_process_rec_frame, is handed a pointer to one of these
+ * and doesn't look anything up by channel number.  That includes
+ * DCD, muting, the rrbb free list, and the processor time measurements.
+ *
+ * The rx_chain table below has the chain used for each radio channel.
+ * DCD for transmitting, muting during transmit, and the statistics
+ * come from there.
+ *
+ * A chain can also be created with rx_chain_create, outside of the
+ * table, and set up with multi_modem_chain_init from any audio
+ * configuration.  Such a chain shares nothing with any other so
+ * several, even for the same channel number, can be run at the same
+ * time by different threads.  It does not drive the DCD output or
+ * hold off transmitting.  Frames found still go to dlq_rec_frame
+ * with only the channel number.
+ *
+ * Shared and read only after initialization:  the audio configuration
+ * and the demod_afsk.c cosine table, filled in by the first
+ * multi_modem_chain_init, so do those one at a time.  Audio devices are
+ * read by demod_get_sample, by audio device number, or with
+ * demod_chain_get_sample for the chain's own configuration.
+ */
+
+struct audio_s;
+struct rrbb_s;
+
+
+struct rx_chain_s {
+
+	int chan;				// Radio channel number.  Used for reporting what
+						// was heard, not to find any state.
+
+	struct audio_s *audio_config;		// Configuration this chain was initialized from.
+
+	volatile int mute_input;		// Set by demod_mute_input while transmitting half duplex.
+
+	struct rrbb_s *rrbb_free;		// rrbb.c - Recycled raw bit buffers
+	int rrbb_free_len;			// and how many.
+	int rrbb_in_use;			// Not deleted yet, to catch leaks.
+
+	struct rxprof_chan_s prof;		// rxprof.c
+
+	double audio_time;			// When the audio buffer now being processed was read.
+						// Set by audio_stats.c.  0 if not known, e.g. atest.
+
+	double frame_audio_time;		// audio_time and dtime_monotonic() when the end
+	double frame_end_time;			// of the most recent frame was found.
+						// See rx_chain_frame_end.
+
+	struct demod_chan_s *demod;		// demod.c
+
+	struct hdlc_chan_s *hdlc;		// hdlc_rec.c
+
+	struct multi_modem_chan_s *mm;		// multi_modem.c
+
+	struct fx_context_s *fx25[MAX_SUBCHANS][MAX_SLICERS];
+						// fx25_rec.c, allocated when first needed.
+
+	struct il2p_context_s *il2p[MAX_SUBCHANS][MAX_SLICERS];
+						// il2p_rec.c, allocated when first needed.
+};
+
+
+extern struct rx_chain_s *rx_chain[MAX_RADIO_CHANS];
+
+struct rx_chain_s *rx_chain_new (int chan);
+
+struct rx_chain_s *rx_chain_create (int chan);
+
+void *rx_chain_alloc (size_t size);
+
+void rx_chain_free (void *p);
+
+
+/*
+ * Get the receive state for a channel, creating it the first time.
+ */
+
+static inline struct rx_chain_s *rx_chain_get (int chan)
+{
+	struct rx_chain_s *R = rx_chain[chan];
+
+	return (R != NULL ? R : rx_chain_new (chan));
+}
+
+
+/*
+ * Remember when the end of a frame was found, for latency statistics.
+ * Called at the closing flag and end of FX.25 or IL2P blocks.
+ */
+
+static inline void rx_chain_frame_end (struct rx_chain_s *R)
+{
+	R->frame_audio_time = R->audio_time;
+	R->frame_end_time = dtime_monotonic();
+}
+
+
+#endif  /* RX_CHAIN_H */
@@ -0,0 +1,246 @@
+//
+//    This file is part of Dire Wolf, an amateur radio packet TNC.
+//
+//    Copyright (C) 2026  Dire Wolf contributors
+//
+//    This program is free software: you can redistribute it and/or modify
+//    it under the terms of the GNU General Public License as published by
+//    the Free Software Foundation, either version 2 of the License, or
+//    (at your option) any later version.
+//
+//    This program is distributed in the hope that it will be useful,
+//    but WITHOUT ANY WARRANTY; without even the implied warranty of
+//    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//    GNU General Public License for more details.
+//
+//    You should have received a copy of the GNU General Public License
+//    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+
+
+/********************************************************************************
+ *
+ * File:	rxprof.c
+ *
+ * Purpose:	Measure how much processor time is used by the different
+ *		stages of the receive chain.
+ *
+ * Description:	atest has always told us the overall speed, e.g. "150 x realtime",
+ *		but not where the time goes.  With multiple subchannels,
+ *		slicers, FX.25, IL2P, and "fix bits" all in play it is hard
+ *		to tell which part got slower after a change.
+ *
+ *		Reading the clock for every audio sample would cost nearly as much
+ *		as the processing we are trying to measure so the per sample and
+ *		per bit stages are timed for only one out of every RXPROF_SAMPLE_EVERY
+ *		audio samples.  Over a few seconds of audio that gives a good
+ *		estimate.  The per frame stages are infrequent and always timed.
+ *
+ *		The measurements are kept in the rx_chain_s for the channel,
+ *		which is processed by only one thread, so there is no locking.
+ *		statsnet.c reads the totals while they are being updated so
+ *		those are atomic.  Times are kept in nanoseconds for that.
+ *
+ *******************************************************************************/
+
+#include "direwolf.h"
+
+#include <stdio.h>
+#include <string.h>
+#include <math.h>
+#include <assert.h>
+#include <time.h>
+
+#ifdef __APPLE__
+#include <sys/time.h>
+#endif
+
+#include "rxprof.h"
+#include "rx_chain.h"
+
+
+int rxprof_enabled = 0;
+
+
+static double clock_cost;		// Time for reading the clock once.  Reading it
+					// for a short stage would otherwise make it
+					// look much slower than it really is.
+
+static const char *stage_name[RXPROF_NUM_STAGES] = { "demod", "hdlc", "fec", "fix_bits" };
+
+
+/*
+ * The usual dtime_monotonic has very coarse resolution on Windows
+ * and we need better than a microsecond here.
+ */
+
+static double now (void)
+{
+#if __WIN32__
+	static double scale = 0;
+	LARGE_INTEGER c;
+
+	if (scale == 0) {
+	  LARGE_INTEGER f;
+	  QueryPerformanceFrequency (&f);
+	  scale = 1.0 / (double)(f.QuadPart);
+	}
+	QueryPerformanceCounter (&c);
+	return ((double)(c.QuadPart) * scale);
+#elif __APPLE__
+	struct timeval tp;
+	gettimeofday (&tp, NULL);
+	return ((double)(tp.tv_sec) + (double)(tp.tv_usec) * 0.000001);
+#else
+	struct timespec ts;
+	clock_gettime (CLOCK_MONOTONIC, &ts);
+	return ((double)(ts.tv_sec) + (double)(ts.tv_nsec) * 0.000000001);
+#endif
+}
+
+
+/*-------------------------------------------------------------------
+ *
+ * Name:        rxprof_init
+ *
+ * Purpose:     Turn profiling on or off and clear the accumulated times.
+ *
+ * Inputs:	enable	- True to start collecting.
+ *
+ * Description:	Clears the times for the receive chain of each channel.
+ *		A chain created later starts out clear.
+ *
+ *--------------------------------------------------------------------*/
+
+void rxprof_init (int enable)
+{
+	for (int chan = 0; chan < MAX_RADIO_CHANS; chan++) {
+	  if (rx_chain[chan] != NULL) {
+	    rxprof_reset (&rx_chain[chan]->prof);
+	  }
+	}
+	rxprof_enabled = enable;
+
+	if (enable) {
+	  double start = now();
+	  for (int n = 0; n < 1000; n++) {
+	    (void) now();
+	  }
+	  clock_cost = (now() - start) / 1001;
+	}
+}
+
+void rxprof_reset (struct rxprof_chan_s *P)
+{
+	memset (P, 0, sizeof(struct rxprof_chan_s));
+}
+
+
+/*-------------------------------------------------------------------
+ *
+ * Name:        rxprof_begin_sample
+ *
+ * Purpose:     Count an audio sample and decide whether it should be timed.
+ *
+ * Returns:	True for one of every RXPROF_SAMPLE_EVERY samples.
+ *
+ *--------------------------------------------------------------------*/
+
+int rxprof_begin_sample (struct rxprof_chan_s *P)
+{
+	int64_t n = __atomic_add_fetch (&(P->sample_count), 1, __ATOMIC_RELAXED);
+	P->timed = (n % RXPROF_SAMPLE_EVERY) == 0;
+	return (P->timed);
+}
+
+
+/*-------------------------------------------------------------------
+ *
+ * Name:        rxprof_enter
+ *		rxprof_leave
+ *
+ * Purpose:     Mark the start and end of a stage.
+ *
+ * Description:	Time in a nested stage is subtracted from the one
+ *		that called it so the results add up to the total.
+ *
+ *--------------------------------------------------------------------*/
+
+void rxprof_enter (struct rxprof_chan_s *P, enum rxprof_stage_e stage)
+{
+	if (P->depth >= RXPROF_STACK_SIZE) {
+	  P->depth++;		// Still need to match up with leave.
+	  return;
+	}
+	P->stack[P->depth].stage = stage;
+	P->stack[P->depth].children = 0;
+	P->stack[P->depth].start = now();
+	P->depth++;
+}
+
+void rxprof_leave (struct rxprof_chan_s *P, enum rxprof_stage_e stage)
+{
+	if (P->depth <= 0) return;
+	P->depth--;
+	if (P->depth >= RXPROF_STACK_SIZE) return;
+
+	assert (P->stack[P->depth].stage == stage);
+
+	double elapsed = now() - P->stack[P->depth].start;
+
+	// The caller also pays for reading the clock on the way in and out.
+
+	__atomic_fetch_add (&(P->exclusive_ns[stage]), (int64_t)llround((elapsed - clock_cost - P->stack[P->depth].children) * 1e9), __ATOMIC_RELAXED);
+	if (P->depth > 0) {
+	  P->stack[P->depth - 1].children += elapsed + clock_cost;
+	}
+}
+
+
+/*-------------------------------------------------------------------
+ *
+ * Name:        rxprof_get_seconds
+ *
+ * Purpose:     Get estimated time spent in a stage for a channel.
+ *
+ * Returns:	Seconds.  Sampled stages are scaled up to estimate the total.
+ *
+ * Description:	This is for the receive chain registered for the channel.
+ *
+ *--------------------------------------------------------------------*/
+
+double rxprof_get_seconds (int chan, enum rxprof_stage_e stage)
+{
+	assert (chan >= 0 && chan < MAX_RADIO_CHANS);
+	assert (stage >= 0 && stage < RXPROF_NUM_STAGES);
+
+	if (rx_chain[chan] == NULL) {
+	  return (0);
+	}
+
+	double t = (double)__atomic_load_n (&(rx_chain[chan]->prof.exclusive_ns[stage]), __ATOMIC_RELAXED) * 1e-9;
+
+	if (stage == RXPROF_DEMOD || stage == RXPROF_HDLC) {
+	  t *= RXPROF_SAMPLE_EVERY;
+	}
+	return (t < 0 ? 0 : t);
+}
+
+int64_t rxprof_get_samples (int chan)
+{
+	assert (chan >= 0 && chan < MAX_RADIO_CHANS);
+
+	if (rx_chain[chan] == NULL) {
+	  return (0);
+	}
+	return (__atomic_load_n (&(rx_chain[chan]->prof.sample_count), __ATOMIC_RELAXED));
+}
+
+const char *rxprof_stage_name (enum rxprof_stage_e stage)
+{
+	assert (stage >= 0 && stage < RXPROF_NUM_STAGES);
+
+	return (stage_name[stage]);
+}
+
+/* end rxprof.c */
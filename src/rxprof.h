@@ -0,0 +1,112 @@
+
+/* rxprof.h - Measure where the time goes in the receive chain. */
+
+#ifndef RXPROF_H
+#define RXPROF_H 1
+
+#include <stdint.h>
+
+
+/*
+ * Stages of the receive chain that we keep track of.
+ *
+ * DEMOD and HDLC run for every audio sample or received bit which is
+ * far too often to read the clock each time.  They are timed for only
+ * one out of every RXPROF_SAMPLE_EVERY audio samples and scaled up.
+ *
+ * FEC and FIX_BITS happen once per frame so they are always timed.
+ *
+ * Times are exclusive.  HDLC time is taken out of DEMOD, which calls it,
+ * and FEC and FIX_BITS are taken out of whatever they were called from.
+ */
+
+enum rxprof_stage_e {
+	RXPROF_DEMOD = 0,	// Filters, mixers, AGC, slicers, PLL.
+	RXPROF_HDLC,		// Bit level framing: HDLC, FX.25 & IL2P bit collection.
+	RXPROF_FEC,		// FX.25 Reed-Solomon, IL2P header and payload decoding.
+	RXPROF_FIX_BITS,	// Frame CRC check and "fix bits" attempts.
+	RXPROF_NUM_STAGES
+};
+
+#define RXPROF_SAMPLE_EVERY 16
+
+#define RXPROF_STACK_SIZE 8		// Deepest nesting is DEMOD, HDLC, FEC or FIX_BITS.
+
+
+/*
+ * Measurements for one receive chain.  Part of rx_chain_s.
+ * Contents are private to rxprof.c except for timed.
+ * sample_count and exclusive_ns are read by the statistics thread
+ * so use only atomic operations for those.
+ */
+
+struct rxprof_chan_s {
+
+	int timed;			// Set while the current audio sample is being timed.
+
+	int64_t sample_count;		// Audio samples processed.
+
+	int64_t exclusive_ns[RXPROF_NUM_STAGES];	// Measured time, not yet scaled.
+
+	int depth;
+	struct {
+	  enum rxprof_stage_e stage;
+	  double start;
+	  double children;		// Time spent in nested stages.
+	} stack[RXPROF_STACK_SIZE];
+};
+
+
+extern int rxprof_enabled;
+
+
+void rxprof_init (int enable);
+
+void rxprof_reset (struct rxprof_chan_s *P);
+
+void rxprof_enter (struct rxprof_chan_s *P, enum rxprof_stage_e stage);
+
+void rxprof_leave (struct rxprof_chan_s *P, enum rxprof_stage_e stage);
+
+int rxprof_begin_sample (struct rxprof_chan_s *P);
+
+double rxprof_get_seconds (int chan, enum rxprof_stage_e stage);
+
+int64_t rxprof_get_samples (int chan);
+
+const char *rxprof_stage_name (enum rxprof_stage_e stage);
+
+
+/*
+ * Use these around the stages in the receive chain.
+ * P is the rxprof_chan_s in the rx_chain_s being processed.
+ *
+ * RXPROF_SAMPLE_ENTER/LEAVE go around the processing of one audio sample.
+ * RXPROF_BIT_ENTER/LEAVE are for per bit stages which are timed only
+ *	when the enclosing sample is.
+ * RXPROF_FRAME_ENTER/LEAVE are for per frame stages which are always timed.
+ *
+ * These cost no more than a test of a flag when not enabled.
+ */
+
+#define RXPROF_SAMPLE_ENTER(P) \
+	int rxprof_this_sample = rxprof_enabled && rxprof_begin_sample(P); \
+	if (rxprof_this_sample) rxprof_enter (P, RXPROF_DEMOD);
+
+#define RXPROF_SAMPLE_LEAVE(P) \
+	if (rxprof_this_sample) { rxprof_leave (P, RXPROF_DEMOD); (P)->timed = 0; }
+
+#define RXPROF_BIT_ENTER(P,stage) \
+	if ((P)->timed) rxprof_enter (P, stage);
+
+#define RXPROF_BIT_LEAVE(P,stage) \
+	if ((P)->timed) rxprof_leave (P, stage);
+
+#define RXPROF_FRAME_ENTER(P,stage) \
+	if (rxprof_enabled) rxprof_enter (P, stage);
+
+#define RXPROF_FRAME_LEAVE(P,stage) \
+	if (rxprof_enabled) rxprof_leave (P, stage);
+
+
+#endif  /* RXPROF_H */
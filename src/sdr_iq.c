@@ -0,0 +1,685 @@
+//
+//    This file is part of Dire Wolf, an amateur radio packet TNC.
+//
+//    Copyright (C) 2026  Dire Wolf contributors
+//
+//    This program is free software: you can redistribute it and/or modify
+//    it under the terms of the GNU General Public License as published by
+//    the Free Software Foundation, either version 2 of the License, or
+//    (at your option) any later version.
+//
+//    This program is distributed in the hope that it will be useful,
+//    but WITHOUT ANY WARRANTY; without even the implied warranty of
+//    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//    GNU General Public License for more details.
+//
+//    You should have received a copy of the GNU General Public License
+//    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+
+
+/********************************************************************************
+ *
+ * File:	sdr_iq.c
+ *
+ * Purpose:	Take complex IQ samples from a software defined radio,
+ *		covering a wide part of a band, and produce FM demodulated
+ *		audio for several radio channels within it.
+ *
+ * Description:	Previously, listening to several frequencies with an SDR
+ *		meant running a separate copy of rtl_fm, or similar, for
+ *		each one and feeding the audio in by UDP or stdin.
+ *
+ *		Here we use a polyphase filter bank.  The IQ input, sampled
+ *		at R per second, is divided into M = R / spacing equally spaced
+ *		frequency bins.  Every D = M/2 input samples, we produce one
+ *		complex sample for the bins we care about, for an output rate
+ *		of twice the channel spacing.  e.g. 50 kHz for 25 kHz spacing.
+ *
+ *		The expensive part, applying the lowpass filter, is done once
+ *		and shared by all channels.  After that, each channel costs only
+ *		M multiplies for each output sample.
+ *
+ *		Output for bin k, at input sample n, is
+ *
+ *			y[n] = sum h[i] x[n-i] exp(-j 2 pi k (n-i) / M)
+ *
+ *		i.e. shift bin k down to 0 Hz then apply lowpass filter h.
+ *		Pulling exp(-j 2 pi k n / M) out of the sum leaves a sum over i
+ *		that can be folded into M partial sums, u[m], shared by all bins,
+ *		then a Discrete Fourier Transform for each bin.
+ *
+ *		The exp(-j 2 pi k n / M) factor, and any remaining offset when
+ *		a channel is not exactly on a bin, turn into a constant change
+ *		in phase between output samples.  The FM discriminator looks at
+ *		the phase change between samples so we simply subtract it there.
+ *
+ *		The demodulated audio is then handed over, as 16 bit samples,
+ *		as if it came from a sound card with one audio channel for
+ *		each radio channel.
+ *
+ *		The filter bank always covers every channel slot in the IQ
+ *		input, e.g. 48 for 1.2 MHz at 25 kHz spacing.  Only the slots
+ *		with a radio channel assigned are demodulated.  Each one needs
+ *		its own channel number, so there can be at most MAX_TOTAL_CHANS
+ *		(16) for all devices together.  See direwolf.h.
+ *
+ * Configuration:
+ *
+ *		ADEVICE  udp:7355  null			IQ from UDP, stdin, or a file.
+ *		IQINPUT  1200000  CU8  144.700		Sample rate, format, center MHz.
+ *		ACHANNELS 2
+ *		CHANNEL 0
+ *		IQFREQ 144.390				Radio frequency for each channel.
+ *
+ *******************************************************************************/
+
+#include "direwolf.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <assert.h>
+
+#include "audio.h"
+#include "fsk_demod_state.h"		// for bp_window_t
+#include "dsp.h"
+#include "textcolor.h"
+#include "sdr_iq.h"
+
+
+// Taps in the lowpass filter for each bin.
+// The whole filter is TAPS_PER_BIN * M long.
+
+#define TAPS_PER_BIN 24
+
+
+struct iq_chan_s {
+
+	float *cos_k;		// Discrete Fourier Transform coefficients for bin k.
+	float *sin_k;		// Stored in the same order as the folded partial sums.
+
+	float step;		// Phase change, in radians, between output samples
+				// caused by the bin position and fine tuning.
+
+	float prev_re;		// Previous output, for the FM discriminator.
+	float prev_im;
+};
+
+
+static struct sdr_iq_s {
+
+	enum iq_format_e format;
+
+	int bytes_per_sample;	// For one complex sample.
+
+	int M;			// Number of bins.
+	int D;			// Decimation factor, M/2.
+	int L;			// Number of filter taps, TAPS_PER_BIN * M.
+
+	float *hr;		// Lowpass filter, reversed.
+
+	float *hist_re;		// Most recent L input samples.  Kept twice,
+	float *hist_im;		// at i and i+L, so they are always contiguous.
+	int hist_next;		// Where the next one goes.
+
+	int count;		// Input samples since last output.
+
+	float *v_re;		// Folded partial sums.
+	float *v_im;
+
+	float scale;		// Discriminator output to 16 bit audio.
+
+	int num_chan;
+	struct iq_chan_s *chan;	// Same as audio channels of the device.
+
+	unsigned char partial[8];	// Left over part of a complex sample
+	int partial_len;		// from the previous read.
+
+} *iq[MAX_ADEVS];
+
+
+static void *zalloc (size_t size)
+{
+	void *p = calloc (1, size);
+	if (p == NULL) {
+	  text_color_set(DW_COLOR_ERROR);
+	  dw_printf ("FATAL ERROR: Out of memory.\n");
+	  exit (EXIT_FAILURE);
+	}
+	return (p);
+}
+
+
+const char *sdr_iq_format_name (enum iq_format_e format)
+{
+	switch (format) {
+	  case IQ_FORMAT_CU8:	return ("CU8");
+	  case IQ_FORMAT_CS8:	return ("CS8");
+	  case IQ_FORMAT_CS16:	return ("CS16");
+	  case IQ_FORMAT_CF32:	return ("CF32");
+	}
+	return ("?");
+}
+
+
+/*-------------------------------------------------------------------
+ *
+ * Name:        sdr_iq_init
+ *
+ * Purpose:     Set up the channelizer for an audio device with IQ input.
+ *
+ * Inputs:	a	- Audio device number.
+ *		pa	- Audio configuration.  iq_rate, iq_format, iq_center,
+ *			  and iq_spacing for the device, and iq_freq for
+ *			  each of its channels.
+ *
+ * Outputs:	pa	- samples_per_sec and bits_per_sample are changed
+ *			  to describe the demodulated audio.
+ *
+ * Returns:	0 for success, -1 for error.
+ *
+ *--------------------------------------------------------------------*/
+
+int sdr_iq_init (int a, struct audio_s *pa)
+{
+	struct sdr_iq_s *S;
+	int M, L;
+	int i, c;
+
+	assert (a >= 0 && a < MAX_ADEVS);
+	assert (pa->adev[a].iq_rate > 0);
+
+	if (pa->adev[a].iq_spacing <= 0) {
+	  pa->adev[a].iq_spacing = DEFAULT_IQ_SPACING;
+	}
+
+	M = pa->adev[a].iq_rate / pa->adev[a].iq_spacing;
+
+	if (pa->adev[a].iq_rate % pa->adev[a].iq_spacing != 0 || M < 4 || M % 2 != 0) {
+	  text_color_set(DW_COLOR_ERROR);
+	  dw_printf ("Audio device %d: IQ sample rate %d must be an even multiple, at least 4, of the channel spacing %d.\n",
+			a, pa->adev[a].iq_rate, pa->adev[a].iq_spacing);
+	  return (-1);
+	}
+
+	assert (pa->adev[a].num_channels >= 1);
+
+	if (iq[a] == NULL) {
+	  iq[a] = zalloc (sizeof(struct sdr_iq_s));
+	}
+	S = iq[a];
+
+// Could be here again for the same device.  Sizes might be different this time.
+
+	free (S->hr);
+	free (S->hist_re);
+	free (S->hist_im);
+	free (S->v_re);
+	free (S->v_im);
+	for (c = 0; c < S->num_chan; c++) {
+	  free (S->chan[c].cos_k);
+	  free (S->chan[c].sin_k);
+	}
+	free (S->chan);
+	memset (S, 0, sizeof(struct sdr_iq_s));
+
+	S->format = pa->adev[a].iq_format;
+	switch (S->format) {
+	  case IQ_FORMAT_CU8:
+	  case IQ_FORMAT_CS8:	S->bytes_per_sample = 2;  break;
+	  case IQ_FORMAT_CS16:	S->bytes_per_sample = 4;  break;
+	  case IQ_FORMAT_CF32:	S->bytes_per_sample = 8;  break;
+	}
+
+	S->M = M;
+	S->D = M / 2;
+	S->L = L = TAPS_PER_BIN * M;
+
+/*
+ * Lowpass filter with cutoff half way to the next bin.
+ * Store it reversed so the folding loop runs forward thru memory.
+ */
+	S->hr = zalloc (L * sizeof(float));
+	{
+	  float G = 0;
+	  float fc = 0.5f / M;
+	  float center = 0.5f * (L - 1);
+
+	  for (i = 0; i < L; i++) {
+	    float sinc;
+	    if (i - center == 0) {
+	      sinc = 2 * fc;
+	    }
+	    else {
+	      sinc = sinf(2 * M_PI * fc * (i - center)) / (M_PI * (i - center));
+	    }
+	    S->hr[L - 1 - i] = sinc * window (BP_WINDOW_BLACKMAN, L, i);
+	    G += S->hr[L - 1 - i];
+	  }
+	  for (i = 0; i < L; i++) {
+	    S->hr[i] /= G;
+	  }
+	}
+
+	S->hist_re = zalloc (2 * L * sizeof(float));
+	S->hist_im = zalloc (2 * L * sizeof(float));
+	S->hist_next = 0;
+	S->count = 0;
+	S->partial_len = 0;
+
+	S->v_re = zalloc (M * sizeof(float));
+	S->v_im = zalloc (M * sizeof(float));
+
+	int out_rate = 2 * pa->adev[a].iq_spacing;
+
+// Full scale audio for deviation of half the channel spacing.
+
+	S->scale = 32767.0f / (2.0f * (float)M_PI * 0.5f * pa->adev[a].iq_spacing / out_rate);
+
+/*
+ * Find the nearest bin for each channel and what is left over.
+ */
+	S->num_chan = pa->adev[a].num_channels;
+	S->chan = zalloc (S->num_chan * sizeof(struct iq_chan_s));
+
+	for (c = 0; c < S->num_chan; c++) {
+	  int chan = pa->adev[a].first_chan + c;
+	  struct iq_chan_s *C = &S->chan[c];
+
+	  double freq = pa->achan[chan].iq_freq;
+	  if (freq == 0) freq = pa->adev[a].iq_center;
+
+	  double offset = (freq - pa->adev[a].iq_center) * 1000000.0;	// Hz
+
+	  if (fabs(offset) > 0.5 * pa->adev[a].iq_rate - 0.5 * pa->adev[a].iq_spacing) {
+	    text_color_set(DW_COLOR_ERROR);
+	    dw_printf ("Channel %d: Frequency %.4f MHz is outside of the IQ input, %.4f MHz +- %.1f kHz.\n",
+			chan, freq, pa->adev[a].iq_center, 0.0005 * (pa->adev[a].iq_rate - pa->adev[a].iq_spacing));
+	    return (-1);
+	  }
+
+	  int k = (int) lround(offset / pa->adev[a].iq_spacing);
+	  double residual = offset - (double)k * pa->adev[a].iq_spacing;
+
+	  if (fabs(residual) > 0.25 * pa->adev[a].iq_spacing) {
+	    text_color_set(DW_COLOR_ERROR);
+	    dw_printf ("Channel %d: Frequency %.4f MHz is %.1f kHz away from the nearest %d Hz step from the center frequency.\n",
+			chan, freq, residual * 0.001, pa->adev[a].iq_spacing);
+	    dw_printf ("Part of the signal will be lost.  Move the center frequency to line up better.\n");
+	  }
+
+	  if (k < 0) k += M;
+
+	  C->cos_k = zalloc (M * sizeof(float));
+	  C->sin_k = zalloc (M * sizeof(float));
+
+	  // Partial sum v[j] holds what goes with exp(+j 2 pi k m / M) where m = M-1-j.
+
+	  for (i = 0; i < M; i++) {
+	    int m = M - 1 - i;
+	    double theta = 2 * M_PI * (double)((k * m) % M) / M;
+	    C->cos_k[i] = cos(theta);
+	    C->sin_k[i] = sin(theta);
+	  }
+
+	  double step = M_PI * k + 2 * M_PI * residual / out_rate;
+	  step = fmod(step, 2 * M_PI);
+	  if (step > M_PI) step -= 2 * M_PI;
+	  C->step = step;
+
+	  C->prev_re = 0;
+	  C->prev_im = 0;
+
+	  text_color_set(DW_COLOR_INFO);
+	  dw_printf ("Channel %d: %.4f MHz from IQ input, %d samples per second, %s, centered on %.4f MHz.\n",
+			chan, freq, pa->adev[a].iq_rate, sdr_iq_format_name(S->format), pa->adev[a].iq_center);
+	}
+
+	pa->adev[a].samples_per_sec = out_rate;
+	pa->adev[a].bits_per_sample = 16;	// Also used for the output device so
+	pa->adev[a].float_samples = 0;		// stay with what every sound card can do.
+
+	return (0);
+
+} /* end sdr_iq_init */
+
+
+/*-------------------------------------------------------------------
+ *
+ * Name:        sdr_iq_audio_size
+ *
+ * Purpose:     Find the largest amount of audio produced from one read.
+ *
+ * Inputs:	a		- Audio device number.
+ *		raw_size	- Most bytes of IQ input for one read.
+ *
+ * Returns:	Number of bytes.
+ *
+ *--------------------------------------------------------------------*/
+
+int sdr_iq_audio_size (int a, int raw_size)
+{
+	struct sdr_iq_s *S = iq[a];
+
+	int frames = (raw_size / S->bytes_per_sample + 1) / S->D + 1;
+	int size = frames * S->num_chan * 2;
+
+	return (size < 256 ? 256 : size);
+}
+
+
+/*
+ * Produce one output sample for each channel.
+ */
+
+__attribute__((hot))
+static void channelize (struct sdr_iq_s *S, unsigned char *out)
+{
+	int M = S->M;
+	int j, p, c;
+
+/*
+ * Fold the filter.  The oldest sample is at hist_next and newest at hist_next + L - 1.
+ */
+	const float *xr = S->hist_re + S->hist_next;
+	const float *xi = S->hist_im + S->hist_next;
+
+	for (j = 0; j < M; j++) {
+	  S->v_re[j] = 0;
+	  S->v_im[j] = 0;
+	}
+	for (p = 0; p < TAPS_PER_BIN; p++) {
+	  const float *h = S->hr + p * M;
+	  const float *pr = xr + p * M;
+	  const float *pi = xi + p * M;
+	  for (j = 0; j < M; j++) {
+	    S->v_re[j] += h[j] * pr[j];
+	    S->v_im[j] += h[j] * pi[j];
+	  }
+	}
+
+/*
+ * For each channel, the DFT for its bin then FM discriminator.
+ */
+	for (c = 0; c < S->num_chan; c++) {
+	  struct iq_chan_s *C = &S->chan[c];
+	  float yr = 0, yi = 0;
+
+	  for (j = 0; j < M; j++) {
+	    yr += S->v_re[j] * C->cos_k[j] - S->v_im[j] * C->sin_k[j];
+	    yi += S->v_re[j] * C->sin_k[j] + S->v_im[j] * C->cos_k[j];
+	  }
+
+	  // Phase change since the previous sample.
+
+	  float dr = yr * C->prev_re + yi * C->prev_im;
+	  float di = yi * C->prev_re - yr * C->prev_im;
+	  C->prev_re = yr;
+	  C->prev_im = yi;
+
+	  float d = atan2f(di, dr) - C->step;
+	  if (d > (float)M_PI) d -= 2 * (float)M_PI;
+	  else if (d < -(float)M_PI) d += 2 * (float)M_PI;
+
+	  int sam = (int) lrintf(d * S->scale);
+	  if (sam > 32767) sam = 32767;
+	  else if (sam < -32768) sam = -32768;
+
+	  *out++ = sam & 0xff;		// Little endian like sound card.
+	  *out++ = (sam >> 8) & 0xff;
+	}
+}
+
+
+/*-------------------------------------------------------------------
+ *
+ * Name:        sdr_iq_process
+ *
+ * Purpose:     Turn IQ input into audio for each channel.
+ *
+ * Inputs:	a	- Audio device number.
+ *		raw	- IQ samples as read from the source.
+ *			  Need not end on a sample boundary.
+ *		raw_len	- Number of bytes.
+ *
+ * Outputs:	audio	- 16 bit little endian samples, interleaved for
+ *			  the channels of the device, like a sound card.
+ *			  Must have room for sdr_iq_audio_size bytes.
+ *
+ * Returns:	Number of bytes of audio.  Could be 0.
+ *
+ *--------------------------------------------------------------------*/
+
+__attribute__((hot))
+int sdr_iq_process (int a, const unsigned char *raw, int raw_len, unsigned char *audio)
+{
+	struct sdr_iq_s *S = iq[a];
+	int n = 0;
+	int out_len = 0;
+	unsigned char b[8];
+
+	assert (S != NULL);
+
+	while (1) {
+	  const unsigned char *s;
+	  float re = 0, im = 0;
+
+/*
+ * Get the next complex sample, possibly with the first part from last time.
+ */
+	  if (S->partial_len > 0) {
+	    int need = S->bytes_per_sample - S->partial_len;
+	    if (raw_len - n < need) {
+	      memcpy (S->partial + S->partial_len, raw + n, raw_len - n);
+	      S->partial_len += raw_len - n;
+	      break;
+	    }
+	    memcpy (b, S->partial, S->partial_len);
+	    memcpy (b + S->partial_len, raw + n, need);
+	    n += need;
+	    S->partial_len = 0;
+	    s = b;
+	  }
+	  else if (raw_len - n >= S->bytes_per_sample) {
+	    s = raw + n;
+	    n += S->bytes_per_sample;
+	  }
+	  else {
+	    memcpy (S->partial, raw + n, raw_len - n);
+	    S->partial_len = raw_len - n;
+	    break;
+	  }
+
+	  switch (S->format) {
+	    case IQ_FORMAT_CU8:
+	      re = ((int)s[0] - 127.5f) * (1.0f / 128);
+	      im = ((int)s[1] - 127.5f) * (1.0f / 128);
+	      break;
+	    case IQ_FORMAT_CS8:
+	      re = (signed char)s[0] * (1.0f / 128);
+	      im = (signed char)s[1] * (1.0f / 128);
+	      break;
+	    case IQ_FORMAT_CS16:
+	      re = (short)(s[0] | (s[1] << 8)) * (1.0f / 32768);
+	      im = (short)(s[2] | (s[3] << 8)) * (1.0f / 32768);
+	      break;
+	    case IQ_FORMAT_CF32:
+	      memcpy (&re, s, 4);
+	      memcpy (&im, s + 4, 4);
+	      break;
+	  }
+
+	  S->hist_re[S->hist_next] = S->hist_re[S->hist_next + S->L] = re;
+	  S->hist_im[S->hist_next] = S->hist_im[S->hist_next + S->L] = im;
+	  if (++S->hist_next >= S->L) S->hist_next = 0;
+
+	  if (++S->count >= S->D) {
+	    S->count = 0;
+	    channelize (S, audio + out_len);
+	    out_len += S->num_chan * 2;
+	  }
+	}
+
+	return (out_len);
+
+} /* end sdr_iq_process */
+
+
+/*-------------------------------------------------------------------
+ *
+ * Name:        main
+ *
+ * Purpose:     Unit test for the channelizer.
+ *
+ * Usage:	gcc -DSDR_IQ_TEST sdr_iq.c dsp.c textcolor.c -lm ; ./a.out
+ *		or
+ *		make sdriqtest
+ *
+ * Description:	Make IQ samples with an FM modulated tone on one channel
+ *		and an unmodulated carrier on each of the others.
+ *		The tone should come out of only the intended channel,
+ *		at the level expected for its deviation, and the others
+ *		should be quiet.
+ *
+ *		The channels are not all on bin centers so the fine
+ *		tuning gets checked too.  Do it again with the tone
+ *		on a different channel, which also exercises starting over.
+ *
+ *--------------------------------------------------------------------*/
+
+#if SDR_IQ_TEST
+
+#define T_RATE 400000		// 16 bins of 25 kHz.
+#define T_CENTER 144.700
+#define T_NCHAN 3
+#define T_TONE 1000		// Audio tone, Hz.
+#define T_DEV 3000		// Deviation, Hz.
+#define T_SECONDS 1
+
+static struct audio_s my_audio_config;
+
+static const double t_freq[T_NCHAN] = { 144.650, 144.775, 144.8005 };
+
+static int errors = 0;
+
+
+static void try_channel (int tone_chan)
+{
+	int a = 0;
+	int c, n;
+	double phase[T_NCHAN];
+
+	memset (&my_audio_config, 0, sizeof(my_audio_config));
+	my_audio_config.adev[a].defined = 1;
+	my_audio_config.adev[a].num_channels = T_NCHAN;
+	my_audio_config.adev[a].first_chan = 0;
+	my_audio_config.adev[a].iq_rate = T_RATE;
+	my_audio_config.adev[a].iq_format = IQ_FORMAT_CU8;
+	my_audio_config.adev[a].iq_center = T_CENTER;
+	for (c = 0; c < T_NCHAN; c++) {
+	  my_audio_config.achan[c].iq_freq = t_freq[c];
+	  phase[c] = 0;
+	}
+
+	if (sdr_iq_init (a, &my_audio_config) != 0) {
+	  text_color_set(DW_COLOR_ERROR);
+	  dw_printf ("sdr_iq_init failed.\n");
+	  exit (EXIT_FAILURE);
+	}
+	assert (my_audio_config.adev[a].samples_per_sec == 2 * DEFAULT_IQ_SPACING);
+
+	int out_rate = my_audio_config.adev[a].samples_per_sec;
+	int total_in = T_RATE * T_SECONDS;
+	int total_out = total_in / (T_RATE / DEFAULT_IQ_SPACING / 2);
+
+	unsigned char *raw = zalloc (2 * total_in);
+	short *audio = zalloc (sdr_iq_audio_size(a, 2 * total_in) + total_out * T_NCHAN * 2);
+
+	for (n = 0; n < total_in; n++) {
+	  double re = 0, im = 0;
+
+	  for (c = 0; c < T_NCHAN; c++) {
+	    double f = (t_freq[c] - T_CENTER) * 1000000.0;
+	    double amp = 0.2;
+	    if (c == tone_chan) {
+	      f += T_DEV * sin (2 * M_PI * T_TONE * (double)n / T_RATE);
+	      amp = 0.3;
+	    }
+	    phase[c] = fmod (phase[c] + 2 * M_PI * f / T_RATE, 2 * M_PI);
+	    re += amp * cos(phase[c]);
+	    im += amp * sin(phase[c]);
+	  }
+	  raw[2*n] = (unsigned char) lrint(127.5 + 128 * re);
+	  raw[2*n+1] = (unsigned char) lrint(127.5 + 128 * im);
+	}
+
+// Odd sized pieces so complex samples get split across calls.
+
+	int len = 0;
+	for (n = 0; n < 2 * total_in; n += 1001) {
+	  int k = 2 * total_in - n < 1001 ? 2 * total_in - n : 1001;
+	  len += sdr_iq_process (a, raw + n, k, (unsigned char *)audio + len);
+	}
+	assert (len == total_out * T_NCHAN * 2);
+
+// Skip the filter startup then look at a whole number of tone cycles.
+
+	int skip = out_rate / 10;
+	int count = (total_out - skip) / (out_rate / T_TONE) * (out_rate / T_TONE);
+	float expect = 32767.0f * T_DEV / (0.5f * DEFAULT_IQ_SPACING);
+
+	for (c = 0; c < T_NCHAN; c++) {
+	  double si = 0, co = 0, sq = 0;
+
+	  for (n = skip; n < skip + count; n++) {
+	    double x = audio[n * T_NCHAN + c];
+	    si += x * sin (2 * M_PI * T_TONE * (double)n / out_rate);
+	    co += x * cos (2 * M_PI * T_TONE * (double)n / out_rate);
+	    sq += x * x;
+	  }
+	  float level = 2 * sqrt(si * si + co * co) / count;
+	  float rms = sqrt(sq / count);
+
+	  int ok;
+	  if (c == tone_chan) {
+	    ok = fabsf(level - expect) < 0.03f * expect;
+	  }
+	  else {
+	    ok = rms < 0.01f * expect;
+	  }
+
+	  text_color_set(ok ? DW_COLOR_INFO : DW_COLOR_ERROR);
+	  dw_printf ("Tone on %d:  channel %d, %d Hz level %.0f, rms %.0f, expected %s %.0f  %s\n",
+			tone_chan, c, T_TONE, level, rms,
+			c == tone_chan ? "level" : "rms below", c == tone_chan ? expect : 0.01f * expect,
+			ok ? "ok" : "FAILED");
+	  if ( ! ok) errors++;
+	}
+
+	free (raw);
+	free (audio);
+}
+
+
+int main ()
+{
+	try_channel (1);
+	try_channel (2);
+	try_channel (0);
+
+	if (errors != 0) {
+	  text_color_set(DW_COLOR_ERROR);
+	  dw_printf ("\nsdr_iq test FAILED.\n");
+	  exit (EXIT_FAILURE);
+	}
+
+	text_color_set(DW_COLOR_INFO);
+	dw_printf ("\nsdr_iq test passed.\n");
+	exit (EXIT_SUCCESS);
+}
+
+#endif
+
+/* end sdr_iq.c */
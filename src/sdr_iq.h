@@ -0,0 +1,19 @@
+
+/* sdr_iq.h - Split wideband IQ from a software defined radio into audio channels. */
+
+#ifndef SDR_IQ_H
+#define SDR_IQ_H 1
+
+#include "audio.h"
+
+
+int sdr_iq_init (int a, struct audio_s *pa);
+
+int sdr_iq_audio_size (int a, int raw_size);
+
+int sdr_iq_process (int a, const unsigned char *raw, int raw_len, unsigned char *audio);
+
+const char *sdr_iq_format_name (enum iq_format_e format);
+
+
+#endif  /* SDR_IQ_H */
@@ -1583,16 +1583,29 @@ static THREAD_F cmd_listen_thread (void *arg)
 	              {
 	                // Misleading if using stdin or udp.
 		        char stemp[100];
-		        int a = ACHAN2ADEV(j);
+		        int a = save_audio_config_p->chan_adev[j];
+		        int n = j - save_audio_config_p->adev[a].first_chan;	// within device.
 		        // If I was really ambitious, some description could be provided.
 		        static const char *names[8] = { "first", "second", "third", "fourth", "fifth", "sixth", "seventh", "eighth" };
+		        char which[16];
+
+		        if (a < 8) {
+		          strlcpy (which, names[a], sizeof(which));
+		        }
+		        else {
+		          snprintf (which, sizeof(which), "#%d", a + 1);
+		        }
 
 		        if (save_audio_config_p->adev[a].num_channels == 1) {
-		          snprintf (stemp, sizeof(stemp), "Port%d %s soundcard mono;", j+1, names[a]);
+		          snprintf (stemp, sizeof(stemp), "Port%d %s soundcard mono;", j+1, which);
+		          strlcat (reply.info, stemp, sizeof(reply.info));
+		        }
+		        else if (save_audio_config_p->adev[a].num_channels == 2) {
+		          snprintf (stemp, sizeof(stemp), "Port%d %s soundcard %s;", j+1, which, n ? "right" : "left");
 		          strlcat (reply.info, stemp, sizeof(reply.info));
 		        }
 		        else {
-		          snprintf (stemp, sizeof(stemp), "Port%d %s soundcard %s;", j+1, names[a], j&1 ? "right" : "left");
+		          snprintf (stemp, sizeof(stemp), "Port%d %s soundcard channel %d;", j+1, which, n + 1);
 		          strlcat (reply.info, stemp, sizeof(reply.info));
 		        }
 	              }
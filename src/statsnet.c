@@ -0,0 +1,973 @@
+//
+//    This file is part of Dire Wolf, an amateur radio packet TNC.
+//
+//    Copyright (C) 2026  Dire Wolf contributors
+//
+//    This program is free software: you can redistribute it and/or modify
+//    it under the terms of the GNU General Public License as published by
+//    the Free Software Foundation, either version 2 of the License, or
+//    (at your option) any later version.
+//
+//    This program is distributed in the hope that it will be useful,
+//    but WITHOUT ANY WARRANTY; without even the implied warranty of
+//    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//    GNU General Public License for more details.
+//
+//    You should have received a copy of the GNU General Public License
+//    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+
+
+/********************************************************************************
+ *
+ * File:	statsnet.c
+ *
+ * Purpose:	Report receive performance statistics over a TCP port while running.
+ *
+ * Description:	audio_stats.c prints the audio sample rate once in a while but
+ *		that doesn't tell us how close we are to running out of
+ *		processor time.  To decide how many channels or decoders
+ *		a given computer can handle, we want to see:
+ *
+ *		  - Processor time used by each stage of the receive chain,
+ *		    per channel, from rxprof.c.
+ *		  - How many times faster than real time each channel is running.
+ *		  - Depth of the received frame queue and the transmit queues.
+ *		  - Frames received, by FEC type, and how many needed fixing.
+ *		  - Time taken by each step from reading the audio to sending
+ *		    a received frame to client applications.
+ *
+ *		The receive thread for a channel updates its rxprof counters.
+ *		The thread that delivers received frames, app_process_rec_packet,
+ *		updates the frame counts here.  The statistics thread reads
+ *		them while that is going on.  Like the packet counts in
+ *		ax25_pad.c, they are updated and read with atomic operations
+ *		so a 64 bit count can't be seen half updated on a 32 bit
+ *		processor.  Nothing is locked.  A report might be slightly
+ *		out of step but the next one will be fine.
+ *
+ *		The report is in the Prometheus text exposition format and
+ *		is sent in response to any connection, so it can be used with
+ *		a web browser, curl, or a Prometheus server.
+ *
+ *		    STATSPORT 8002
+ *
+ *		    curl http://localhost:8002/metrics
+ *
+ *		This shows a lot about the inside of the decoders so, by default,
+ *		we listen only on the loopback interface.  Add a local address,
+ *		or 0.0.0.0 for all, to get it from other computers.
+ *
+ *		    STATSPORT 8002 0.0.0.0
+ *
+ *		Counters accumulate from start up.  Use rate() to get
+ *		values for an interval.
+ *
+ *******************************************************************************/
+
+#include "direwolf.h"		// Sets _WIN32_WINNT for XP API level needed by ws2tcpip.h
+
+#if __WIN32__
+#include <winsock2.h>
+#include <ws2tcpip.h>  		// _WIN32_WINNT must be set to 0x0501 before including this
+#else
+#include <stdlib.h>
+#include <sys/types.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+#include <errno.h>
+#ifndef MSG_NOSIGNAL
+#define MSG_NOSIGNAL 0		// Not on Mac OSX.
+#endif
+#endif
+
+#include <unistd.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdarg.h>
+#include <string.h>
+#include <math.h>
+#include <assert.h>
+
+#include "textcolor.h"
+#include "audio.h"
+#include "config.h"
+#include "statsnet.h"
+#include "rxprof.h"
+#include "dlq.h"
+#include "tq.h"
+#include "dtime_now.h"
+#include "textasync.h"
+#include "igate.h"
+
+
+static struct audio_s *save_audio_config_p;
+
+static int stats_port;
+
+static char stats_addr[48];	// Local IPv4 address to listen on.
+
+
+/*
+ * Upper bounds of the latency histogram buckets, in seconds.
+ * There is always one more for everything larger.
+ */
+
+static const double latency_bucket[] = { 0.001, 0.002, 0.005, 0.01, 0.02, 0.05, 0.1, 0.2, 0.5, 1.0, 2.0, 5.0 };
+
+#define NUM_LATENCY_BUCKETS (sizeof(latency_bucket) / sizeof(latency_bucket[0]))
+
+
+/*
+ * Intervals between the times recorded in a received packet.  See enum rx_time_e.
+ * The last one is the whole trip, from the audio if known.
+ */
+
+static const struct {
+	const char *name;
+	enum rx_time_e from;
+	enum rx_time_e to;
+} interval[] = {
+	{ "demod",	RX_TIME_AUDIO,		RX_TIME_FLAG },		// Audio buffer read to end of frame found.
+	{ "decode",	RX_TIME_FLAG,		RX_TIME_DECODED },	// Fix bits, FX.25 or IL2P FEC.
+	{ "pick",	RX_TIME_DECODED,	RX_TIME_PICKED },	// Waiting for other decoders, FX.25 busy.
+	{ "queue",	RX_TIME_PICKED,		RX_TIME_DLQ },		// Waiting in the received frame queue.
+	{ "deliver",	RX_TIME_DLQ,		RX_TIME_SENT },		// Printing, logging, sending to clients.
+	{ "total",	RX_TIME_AUDIO,		RX_TIME_SENT }
+};
+
+#define NUM_INTERVALS ((int)(sizeof(interval) / sizeof(interval[0])))
+
+struct histogram_s {
+	int64_t count;
+	int64_t sum_ns;			// Nanoseconds so it can be atomic.
+	int64_t bucket[NUM_LATENCY_BUCKETS + 1];
+};
+
+
+/*
+ * Updated by the thread which delivers received frames.
+ * Use only atomic operations.
+ */
+
+static struct {
+
+	int64_t frames[3];		// Index is fec_type: none, fx25, il2p.
+
+	int64_t fix_bits;		// Plain AX.25 where bits had to be changed for good CRC.
+
+	int64_t fec_corrected;		// FX.25 or IL2P where at least one byte was corrected.
+
+	struct histogram_s latency[NUM_INTERVALS];
+
+} rec[MAX_TOTAL_CHANS];
+
+
+#if __WIN32__
+#define THREAD_F unsigned __stdcall
+#else
+#define THREAD_F void *
+#endif
+
+static THREAD_F stats_listen_thread (void *arg);
+
+
+/*-------------------------------------------------------------------
+ *
+ * Name:        statsnet_init
+ *
+ * Purpose:     Start listening for statistics requests if enabled.
+ *
+ * Inputs:	pa		- Audio configuration, for channels and sample rates.
+ *
+ *		misc_config	- stats_port is the TCP port.  0 to disable.
+ *				  stats_addr is the local address to listen on.
+ *
+ * Description:	Also turns on the receive stage timing in rxprof.c
+ *		which normally costs only the test of a flag.
+ *
+ *--------------------------------------------------------------------*/
+
+void statsnet_init (struct audio_s *pa, struct misc_config_s *misc_config)
+{
+	save_audio_config_p = pa;
+	stats_port = misc_config->stats_port;
+	strlcpy (stats_addr, misc_config->stats_addr, sizeof(stats_addr));
+
+	memset (rec, 0, sizeof(rec));
+
+	if (stats_port == 0) {
+	  return;
+	}
+
+	rxprof_init (1);
+
+#if __WIN32__
+	HANDLE listen_th = (HANDLE)_beginthreadex (NULL, 0, stats_listen_thread, NULL, 0, NULL);
+	if (listen_th == NULL) {
+	  text_color_set(DW_COLOR_ERROR);
+	  dw_printf ("Could not create statistics listening thread for tcp port %d\n", stats_port);
+	  return;
+	}
+#else
+	pthread_t listen_tid;
+	int e = pthread_create (&listen_tid, NULL, stats_listen_thread, NULL);
+	if (e != 0) {
+	  text_color_set(DW_COLOR_ERROR);
+	  perror("Could not create statistics listening thread");
+	  dw_printf ("for tcp port %d\n", stats_port);
+	  return;
+	}
+#endif
+}
+
+
+/*-------------------------------------------------------------------
+ *
+ * Name:        statsnet_rec_frame
+ *
+ * Purpose:     Count a received frame as it is sent to client applications.
+ *
+ * Inputs:	chan		- Channel, including virtual channels.
+ *
+ *		fec_type	- none, fx25, or il2p.
+ *
+ *		retries		- Bits changed for plain AX.25 or bytes corrected by FEC.
+ *
+ *		pp		- Packet object with times along the way.
+ *
+ * Description:	Each interval goes into its own histogram so we can
+ *		tell which step is responsible for any delay.
+ *		Frames without the times, e.g. from the IGate or
+ *		network TNC, are only counted.
+ *
+ *--------------------------------------------------------------------*/
+
+void statsnet_rec_frame (int chan, fec_type_t fec_type, retry_t retries, packet_t pp)
+{
+	if (stats_port == 0 || chan < 0 || chan >= MAX_TOTAL_CHANS) {
+	  return;
+	}
+
+	int f = (fec_type == fec_type_fx25 || fec_type == fec_type_il2p) ? (int)fec_type : 0;
+
+	__atomic_fetch_add (&rec[chan].frames[f], 1, __ATOMIC_RELAXED);
+
+	if (retries != RETRY_NONE) {
+	  if (f == 0) {
+	    __atomic_fetch_add (&rec[chan].fix_bits, 1, __ATOMIC_RELAXED);
+	  }
+	  else {
+	    __atomic_fetch_add (&rec[chan].fec_corrected, 1, __ATOMIC_RELAXED);
+	  }
+	}
+
+	ax25_set_rx_time (pp, RX_TIME_SENT, dtime_monotonic());
+
+	for (int i = 0; i < NUM_INTERVALS; i++) {
+	  double from = ax25_get_rx_time (pp, interval[i].from);
+	  double to = ax25_get_rx_time (pp, interval[i].to);
+
+	  if (from == 0 && interval[i].from == RX_TIME_AUDIO) {
+	    from = ax25_get_rx_time (pp, RX_TIME_FLAG);		// Audio time not available.
+	  }
+	  if (from > 0 && to >= from) {
+	    struct histogram_s *h = &(rec[chan].latency[i]);
+	    double latency = to - from;
+	    int b = 0;
+
+	    while (b < (int)NUM_LATENCY_BUCKETS && latency > latency_bucket[b]) {
+	      b++;
+	    }
+	    __atomic_fetch_add (&(h->bucket[b]), 1, __ATOMIC_RELAXED);
+	    __atomic_fetch_add (&(h->sum_ns), (int64_t)llround(latency * 1e9), __ATOMIC_RELAXED);
+	    __atomic_fetch_add (&(h->count), 1, __ATOMIC_RELAXED);
+	  }
+	}
+}
+
+
+/*
+ * Build up the report in a growing buffer.
+ */
+
+struct report_s {
+	char *buf;
+	int len;
+	int size;
+};
+
+static void report (struct report_s *r, const char *fmt, ...)
+{
+	va_list ap;
+
+	while (1) {
+	  va_start (ap, fmt);
+	  int n = vsnprintf (r->buf + r->len, r->size - r->len, fmt, ap);
+	  va_end (ap);
+
+	  if (n >= 0 && n < r->size - r->len) {
+	    r->len += n;
+	    return;
+	  }
+
+	  r->size = r->size * 2 + (n > 0 ? n : 0);
+	  r->buf = realloc (r->buf, r->size);
+	  if (r->buf == NULL) {
+	    text_color_set(DW_COLOR_ERROR);
+	    dw_printf ("FATAL ERROR: Out of memory.\n");
+	    exit (EXIT_FAILURE);
+	  }
+	}
+}
+
+
+/*-------------------------------------------------------------------
+ *
+ * Name:        statsnet_report
+ *
+ * Purpose:     Format the current statistics.
+ *
+ * Inputs:	len	- Number of bytes is returned here.
+ *
+ * Returns:	Prometheus text format.  Caller must free it.
+ *
+ *--------------------------------------------------------------------*/
+
+char *statsnet_report (int *len)
+{
+	struct report_s r;
+	int chan;
+
+	r.size = 8192;
+	r.len = 0;
+	r.buf = malloc (r.size);
+	if (r.buf == NULL) {
+	  text_color_set(DW_COLOR_ERROR);
+	  dw_printf ("FATAL ERROR: Out of memory.\n");
+	  exit (EXIT_FAILURE);
+	}
+	r.buf[0] = '\0';
+
+	report (&r, "# HELP direwolf_rx_samples_total Audio samples processed by the receive chain.\n");
+	report (&r, "# TYPE direwolf_rx_samples_total counter\n");
+	for (chan = 0; chan < MAX_RADIO_CHANS; chan++) {
+	  if (save_audio_config_p->chan_medium[chan] == MEDIUM_RADIO) {
+	    report (&r, "direwolf_rx_samples_total{chan=\"%d\"} %lld\n", chan, (long long)rxprof_get_samples(chan));
+	  }
+	}
+
+	report (&r, "# HELP direwolf_rx_stage_seconds_total Estimated processor time for each receive stage.\n");
+	report (&r, "# TYPE direwolf_rx_stage_seconds_total counter\n");
+	for (chan = 0; chan < MAX_RADIO_CHANS; chan++) {
+	  if (save_audio_config_p->chan_medium[chan] == MEDIUM_RADIO) {
+	    for (int s = 0; s < RXPROF_NUM_STAGES; s++) {
+	      report (&r, "direwolf_rx_stage_seconds_total{chan=\"%d\",stage=\"%s\"} %.6f\n",
+			chan, rxprof_stage_name(s), rxprof_get_seconds(chan, s));
+	    }
+	  }
+	}
+
+	report (&r, "# HELP direwolf_rx_realtime_ratio Audio time divided by processor time.  Below 1 means falling behind.\n");
+	report (&r, "# TYPE direwolf_rx_realtime_ratio gauge\n");
+	for (chan = 0; chan < MAX_RADIO_CHANS; chan++) {
+	  if (save_audio_config_p->chan_medium[chan] == MEDIUM_RADIO) {
+	    double cpu = 0;
+	    for (int s = 0; s < RXPROF_NUM_STAGES; s++) {
+	      cpu += rxprof_get_seconds(chan, s);
+	    }
+	    int a = save_audio_config_p->chan_adev[chan];
+	    double audio = (double)rxprof_get_samples(chan) / save_audio_config_p->adev[a].samples_per_sec;
+	    if (cpu > 0) {
+	      report (&r, "direwolf_rx_realtime_ratio{chan=\"%d\"} %.1f\n", chan, audio / cpu);
+	    }
+	  }
+	}
+
+	static const char *fec_name[3] = { "none", "fx25", "il2p" };
+
+	report (&r, "# HELP direwolf_rx_frames_total Received frames sent to client applications.\n");
+	report (&r, "# TYPE direwolf_rx_frames_total counter\n");
+	for (chan = 0; chan < MAX_TOTAL_CHANS; chan++) {
+	  if (save_audio_config_p->chan_medium[chan] != MEDIUM_NONE) {
+	    for (int f = 0; f < 3; f++) {
+	      report (&r, "direwolf_rx_frames_total{chan=\"%d\",fec=\"%s\"} %lld\n", chan, fec_name[f], (long long)__atomic_load_n (&rec[chan].frames[f], __ATOMIC_RELAXED));
+	    }
+	  }
+	}
+
+	report (&r, "# HELP direwolf_rx_fix_bits_total Frames without FEC which needed bits changed to get a good CRC.\n");
+	report (&r, "# TYPE direwolf_rx_fix_bits_total counter\n");
+	for (chan = 0; chan < MAX_TOTAL_CHANS; chan++) {
+	  if (save_audio_config_p->chan_medium[chan] != MEDIUM_NONE) {
+	    report (&r, "direwolf_rx_fix_bits_total{chan=\"%d\"} %lld\n", chan, (long long)__atomic_load_n (&rec[chan].fix_bits, __ATOMIC_RELAXED));
+	  }
+	}
+
+	report (&r, "# HELP direwolf_rx_fec_corrected_total FX.25 or IL2P frames with errors corrected.\n");
+	report (&r, "# TYPE direwolf_rx_fec_corrected_total counter\n");
+	for (chan = 0; chan < MAX_TOTAL_CHANS; chan++) {
+	  if (save_audio_config_p->chan_medium[chan] != MEDIUM_NONE) {
+	    report (&r, "direwolf_rx_fec_corrected_total{chan=\"%d\"} %lld\n", chan, (long long)__atomic_load_n (&rec[chan].fec_corrected, __ATOMIC_RELAXED));
+	  }
+	}
+
+	report (&r, "# HELP direwolf_rx_latency_seconds Time for each step from reading audio to sending received frame to client applications.\n");
+	report (&r, "# TYPE direwolf_rx_latency_seconds histogram\n");
+	for (chan = 0; chan < MAX_TOTAL_CHANS; chan++) {
+	  if (save_audio_config_p->chan_medium[chan] != MEDIUM_NONE) {
+	    for (int i = 0; i < NUM_INTERVALS; i++) {
+	      struct histogram_s *h = &(rec[chan].latency[i]);
+	      int64_t cumulative = 0;
+	      for (int b = 0; b < (int)NUM_LATENCY_BUCKETS; b++) {
+	        cumulative += __atomic_load_n (&(h->bucket[b]), __ATOMIC_RELAXED);
+	        report (&r, "direwolf_rx_latency_seconds_bucket{chan=\"%d\",step=\"%s\",le=\"%g\"} %lld\n",
+			chan, interval[i].name, latency_bucket[b], (long long)cumulative);
+	      }
+	      cumulative += __atomic_load_n (&(h->bucket[NUM_LATENCY_BUCKETS]), __ATOMIC_RELAXED);
+	      report (&r, "direwolf_rx_latency_seconds_bucket{chan=\"%d\",step=\"%s\",le=\"+Inf\"} %lld\n", chan, interval[i].name, (long long)cumulative);
+	      report (&r, "direwolf_rx_latency_seconds_sum{chan=\"%d\",step=\"%s\"} %.6f\n", chan, interval[i].name,
+			(double)__atomic_load_n (&(h->sum_ns), __ATOMIC_RELAXED) * 1e-9);
+	      report (&r, "direwolf_rx_latency_seconds_count{chan=\"%d\",step=\"%s\"} %lld\n", chan, interval[i].name,
+			(long long)__atomic_load_n (&(h->count), __ATOMIC_RELAXED));
+	    }
+	  }
+	}
+
+	report (&r, "# HELP direwolf_console_dropped_total Console messages discarded because output could not keep up.\n");
+	report (&r, "# TYPE direwolf_console_dropped_total counter\n");
+	report (&r, "direwolf_console_dropped_total %d\n", text_async_dropped());
+
+	report (&r, "# HELP direwolf_dlq_length Items waiting in the received frame queue.\n");
+	report (&r, "# TYPE direwolf_dlq_length gauge\n");
+	report (&r, "direwolf_dlq_length %d\n", dlq_get_length());
+
+	report (&r, "# HELP direwolf_satgate_queue_length Packets held for the SATgate delay.\n");
+	report (&r, "# TYPE direwolf_satgate_queue_length gauge\n");
+	report (&r, "direwolf_satgate_queue_length %d\n", igate_get_satgate_depth());
+
+	report (&r, "# HELP direwolf_satgate_queue_max_length Most packets ever held for the SATgate delay at the same time.\n");
+	report (&r, "# TYPE direwolf_satgate_queue_max_length gauge\n");
+	report (&r, "direwolf_satgate_queue_max_length %d\n", igate_get_satgate_max_depth());
+
+	report (&r, "# HELP direwolf_igate_uplink_queue_length Lines waiting to be sent to the APRS-IS server.\n");
+	report (&r, "# TYPE direwolf_igate_uplink_queue_length gauge\n");
+	report (&r, "direwolf_igate_uplink_queue_length %d\n", igate_get_uplink_depth());
+
+	report (&r, "# HELP direwolf_igate_uplink_lines_total Lines for the APRS-IS server by what happened to them.\n");
+	report (&r, "# TYPE direwolf_igate_uplink_lines_total counter\n");
+	report (&r, "direwolf_igate_uplink_lines_total{state=\"queued\"} %d\n", igate_get_uplink_queued());
+	report (&r, "direwolf_igate_uplink_lines_total{state=\"sent\"} %d\n", igate_get_uplink_sent());
+	report (&r, "direwolf_igate_uplink_lines_total{state=\"dropped\"} %d\n", igate_get_uplink_dropped());
+
+	report (&r, "# HELP direwolf_tq_length Frames waiting in the transmit queue.\n");
+	report (&r, "# TYPE direwolf_tq_length gauge\n");
+	for (chan = 0; chan < MAX_RADIO_CHANS; chan++) {
+	  if (save_audio_config_p->chan_medium[chan] == MEDIUM_RADIO) {
+	    report (&r, "direwolf_tq_length{chan=\"%d\",prio=\"hi\"} %d\n", chan, tq_count(chan, TQ_PRIO_0_HI, "", "", 0));
+	    report (&r, "direwolf_tq_length{chan=\"%d\",prio=\"lo\"} %d\n", chan, tq_count(chan, TQ_PRIO_1_LO, "", "", 0));
+	  }
+	}
+
+	*len = r.len;
+	return (r.buf);
+}
+
+
+/*-------------------------------------------------------------------
+ *
+ * Name:        stats_listen_thread
+ *
+ * Purpose:     Send the report to anyone who connects.
+ *
+ * Description:	Clients are handled one at a time.  Generating the report
+ *		takes very little time so there is no need for more.
+ *		We read whatever request was sent, with a short timeout,
+ *		so HTTP clients don't see the connection reset.
+ *
+ *--------------------------------------------------------------------*/
+
+static const char http_header[] = "HTTP/1.0 200 OK\r\n"
+				"Content-Type: text/plain; version=0.0.4\r\n"
+				"Connection: close\r\n"
+				"\r\n";
+
+static THREAD_F stats_listen_thread (void *arg)
+{
+#if __WIN32__
+
+	struct addrinfo hints;
+	struct addrinfo *ai = NULL;
+	char tcp_port_str[12];
+	SOCKET listen_sock;
+	WSADATA wsadata;
+	int err;
+
+	snprintf (tcp_port_str, sizeof(tcp_port_str), "%d", stats_port);
+
+	err = WSAStartup (MAKEWORD(2,2), &wsadata);
+	if (err != 0) {
+	  text_color_set(DW_COLOR_ERROR);
+	  dw_printf("WSAStartup failed: %d\n", err);
+	  return (0);
+	}
+
+	memset (&hints, 0, sizeof(hints));
+	hints.ai_family = AF_INET;
+	hints.ai_socktype = SOCK_STREAM;
+	hints.ai_protocol = IPPROTO_TCP;
+	hints.ai_flags = AI_PASSIVE | AI_NUMERICHOST;
+
+	err = getaddrinfo(stats_addr, tcp_port_str, &hints, &ai);
+	if (err != 0) {
+	  text_color_set(DW_COLOR_ERROR);
+	  dw_printf("Invalid address %s for STATSPORT, getaddrinfo failed: %d\n", stats_addr, err);
+	  WSACleanup();
+	  return (0);
+	}
+
+	listen_sock = socket(ai->ai_family, ai->ai_socktype, ai->ai_protocol);
+	if (listen_sock == INVALID_SOCKET) {
+	  text_color_set(DW_COLOR_ERROR);
+	  dw_printf ("stats_listen_thread: Socket creation failed, err=%d", WSAGetLastError());
+	  return (0);
+	}
+
+	err = bind (listen_sock, ai->ai_addr, (int)ai->ai_addrlen);
+	if (err == SOCKET_ERROR) {
+	  text_color_set(DW_COLOR_ERROR);
+	  dw_printf("Bind failed with error: %d\n", WSAGetLastError());
+	  dw_printf("Some other application is probably already using port %s.\n", tcp_port_str);
+	  dw_printf("Try using a different port number with STATSPORT in the configuration file.\n");
+	  freeaddrinfo(ai);
+	  closesocket(listen_sock);
+	  WSACleanup();
+	  return (0);
+	}
+	freeaddrinfo(ai);
+
+	if (listen(listen_sock, 4) == SOCKET_ERROR) {
+	  text_color_set(DW_COLOR_ERROR);
+	  dw_printf("Listen failed with error: %d\n", WSAGetLastError());
+	  return (0);
+	}
+
+	text_color_set(DW_COLOR_INFO);
+	dw_printf("Ready to report statistics on %s port %s ...\n", stats_addr, tcp_port_str);
+
+	while (1) {
+	  SOCKET client = accept(listen_sock, NULL, NULL);
+	  if (client == INVALID_SOCKET) {
+	    SLEEP_SEC(1);
+	    continue;
+	  }
+
+	  DWORD timeout_ms = 1000;
+	  setsockopt (client, SOL_SOCKET, SO_RCVTIMEO, (const char *)&timeout_ms, sizeof(timeout_ms));
+
+	  char request[1024];
+	  (void) recv (client, request, sizeof(request), 0);
+
+	  int len;
+	  char *body = statsnet_report (&len);
+	  send (client, http_header, strlen(http_header), 0);
+	  send (client, body, len, 0);
+	  free (body);
+
+	  shutdown (client, SD_BOTH);
+	  closesocket (client);
+	}
+
+#else		/* End of Windows case, now Linux / Unix / Mac OSX. */
+
+	struct sockaddr_in sockaddr;
+	int listen_sock;
+	int bcopt = 1;
+
+	listen_sock = socket(AF_INET, SOCK_STREAM, 0);
+	if (listen_sock == -1) {
+	  text_color_set(DW_COLOR_ERROR);
+	  perror ("stats_listen_thread: Socket creation failed");
+	  return (NULL);
+	}
+
+	setsockopt (listen_sock, SOL_SOCKET, SO_REUSEADDR, (const char *)&bcopt, 4);
+
+	memset (&sockaddr, 0, sizeof(sockaddr));
+	if (inet_pton(AF_INET, stats_addr, &sockaddr.sin_addr) != 1) {
+	  text_color_set(DW_COLOR_ERROR);
+	  dw_printf("Invalid address %s for STATSPORT.  It must be a local IPv4 address like 127.0.0.1.\n", stats_addr);
+	  close (listen_sock);
+	  return (NULL);
+	}
+	sockaddr.sin_port = htons(stats_port);
+	sockaddr.sin_family = AF_INET;
+
+	if (bind(listen_sock, (struct sockaddr*)&sockaddr, sizeof(sockaddr)) == -1) {
+	  text_color_set(DW_COLOR_ERROR);
+	  dw_printf("Bind failed with error: %d\n", errno);
+	  dw_printf("%s\n", strerror(errno));
+	  dw_printf("Some other application is probably already using port %d.\n", stats_port);
+	  dw_printf("Try using a different port number with STATSPORT in the configuration file.\n");
+	  close (listen_sock);
+	  return (NULL);
+	}
+
+	if (listen(listen_sock, 4) == -1) {
+	  text_color_set(DW_COLOR_ERROR);
+	  perror ("stats_listen_thread: Listen failed");
+	  close (listen_sock);
+	  return (NULL);
+	}
+
+	text_color_set(DW_COLOR_INFO);
+	dw_printf("Ready to report statistics on %s port %d ...\n", stats_addr, stats_port);
+
+	while (1) {
+	  int client = accept(listen_sock, NULL, NULL);
+	  if (client < 0) {
+	    SLEEP_SEC(1);
+	    continue;
+	  }
+
+	  struct timeval tv;
+	  tv.tv_sec = 1;
+	  tv.tv_usec = 0;
+	  setsockopt (client, SOL_SOCKET, SO_RCVTIMEO, (const char *)&tv, sizeof(tv));
+
+	  char request[1024];
+	  if (recv (client, request, sizeof(request), 0) < 0) {
+	    // Timeout.  Probably not HTTP.  Send the report anyhow.
+	  }
+
+	  int len;
+	  char *body = statsnet_report (&len);
+	  if (send (client, http_header, strlen(http_header), MSG_NOSIGNAL) > 0) {
+	    int sent = 0;
+	    while (sent < len) {
+	      int n = send (client, body + sent, len - sent, MSG_NOSIGNAL);
+	      if (n <= 0) break;
+	      sent += n;
+	    }
+	  }
+	  free (body);
+
+	  shutdown (client, SHUT_RDWR);
+	  close (client);
+	}
+#endif
+
+	return (0);
+}
+
+
+/*-------------------------------------------------------------------
+ *
+ * Unit test for the report.
+ *
+ * Checks the counts and that the output follows the Prometheus text
+ * exposition format:  every sample belongs to a metric family given
+ * by # HELP and # TYPE before it, and the histogram buckets add up.
+ * Then one thread counts frames while reports are made by another,
+ * to be sure the counts never go backwards.
+ *
+ * Usage:	gcc -DSTATSNET_TEST statsnet.c rxprof.c rx_chain.c ax25_pad.c fcs_calc.c dtime_now.c textcolor.c -lm -lpthread ; ./a.out
+ *
+ *--------------------------------------------------------------------*/
+
+#if STATSNET_TEST
+
+#include "rx_chain.h"
+
+
+/* Stand ins for the modules reported on. */
+
+int dlq_get_length (void) { return (2); }
+int tq_count (int chan, int prio, char *source, char *dest, int bytes) { return (prio + 5); }
+int text_async_dropped (void) { return (7); }
+int igate_get_satgate_depth (void) { return (0); }
+int igate_get_satgate_max_depth (void) { return (0); }
+int igate_get_uplink_depth (void) { return (0); }
+int igate_get_uplink_queued (void) { return (0); }
+int igate_get_uplink_sent (void) { return (0); }
+int igate_get_uplink_dropped (void) { return (0); }
+
+
+static int errors = 0;
+
+static void expect (char *text, const char *line)
+{
+	if (strstr(text, line) == NULL) {
+	  text_color_set(DW_COLOR_ERROR);
+	  dw_printf ("Missing from report: %s", line);
+	  errors++;
+	}
+}
+
+static void format_error (const char *what, const char *line)
+{
+	text_color_set(DW_COLOR_ERROR);
+	dw_printf ("%s: %s\n", what, line);
+	errors++;
+}
+
+
+static void check_format (char *text)
+{
+	char family[80] = "";
+	char type[20] = "";
+	long long last_bucket = -1;
+	long long inf_bucket = -1;
+	char *copy = strdup (text);
+	char *line, *save;
+
+	for (line = strtok_r(copy, "\n", &save); line != NULL; line = strtok_r(NULL, "\n", &save)) {
+
+	  if (strncmp(line, "# HELP ", 7) == 0) {
+	    if (sscanf (line + 7, "%79s", family) != 1) format_error ("Bad HELP", line);
+	    strlcpy (type, "", sizeof(type));
+	    continue;
+	  }
+
+	  if (strncmp(line, "# TYPE ", 7) == 0) {
+	    char name[80];
+	    if (sscanf (line + 7, "%79s %19s", name, type) != 2 || strcmp(name, family) != 0) {
+	      format_error ("TYPE doesn't match HELP", line);
+	    }
+	    if (strcmp(type, "counter") != 0 && strcmp(type, "gauge") != 0 && strcmp(type, "histogram") != 0) {
+	      format_error ("Unknown TYPE", line);
+	    }
+	    continue;
+	  }
+
+	  if (line[0] == '#' || strlen(type) == 0) {
+	    format_error ("Sample without HELP and TYPE", line);
+	    continue;
+	  }
+
+	  // name{label="value",...} number
+
+	  char name[80];
+	  int n = strcspn (line, "{ ");
+	  if (n >= (int)sizeof(name)) n = sizeof(name) - 1;
+	  memcpy (name, line, n);
+	  name[n] = '\0';
+
+	  char *value = strrchr (line, ' ');
+	  char *end;
+	  if (value == NULL) {
+	    format_error ("No value", line);
+	    continue;
+	  }
+	  double v = strtod (value + 1, &end);
+	  if (*end != '\0') {
+	    format_error ("Value is not a number", line);
+	  }
+	  if (line[n] == '{' && value[-1] != '}') {
+	    format_error ("Labels not closed", line);
+	  }
+
+	  if (strcmp(type, "histogram") == 0) {
+	    int flen = strlen(family);
+	    if (strncmp(name, family, flen) != 0) {
+	      format_error ("Sample not in family", line);
+	    }
+	    else if (strcmp(name + flen, "_bucket") == 0) {
+	      if (v < last_bucket) format_error ("Buckets not cumulative", line);
+	      last_bucket = v;
+	      if (strstr(line, "le=\"+Inf\"") != NULL) {
+	        inf_bucket = v;
+	        last_bucket = -1;
+	      }
+	    }
+	    else if (strcmp(name + flen, "_count") == 0) {
+	      if (v != inf_bucket) format_error ("Count is not the same as +Inf bucket", line);
+	    }
+	    else if (strcmp(name + flen, "_sum") != 0) {
+	      format_error ("Sample not in family", line);
+	    }
+	  }
+	  else if (strcmp(name, family) != 0) {
+	    format_error ("Sample not in family", line);
+	  }
+	}
+
+	free (copy);
+}
+
+
+static packet_t timed_frame (void)
+{
+	packet_t pp = ax25_from_text ("W1ABC>APDW18:test", 1);
+	double now = dtime_monotonic();
+
+	ax25_set_rx_time (pp, RX_TIME_AUDIO, now - 0.0040);
+	ax25_set_rx_time (pp, RX_TIME_FLAG, now - 0.0010);	// demod 3 ms.
+	ax25_set_rx_time (pp, RX_TIME_DECODED, now - 0.0009);
+	ax25_set_rx_time (pp, RX_TIME_PICKED, now - 0.0008);
+	ax25_set_rx_time (pp, RX_TIME_DLQ, now - 0.0007);
+	return (pp);
+}
+
+
+#define COUNT_FRAMES 200000
+
+static int counting_done = 0;
+
+static THREAD_F count_thread (void *arg)
+{
+	packet_t pp = ax25_from_text ("W1ABC>APDW18:test", 1);
+
+	for (int n = 0; n < COUNT_FRAMES; n++) {
+	  statsnet_rec_frame (1, fec_type_none, RETRY_NONE, pp);
+	}
+	ax25_delete (pp);
+	__atomic_store_n (&counting_done, 1, __ATOMIC_RELEASE);
+	return (0);
+}
+
+static long long chan1_frames (char *text)
+{
+	char *p = strstr (text, "direwolf_rx_frames_total{chan=\"1\",fec=\"none\"} ");
+	return (p != NULL ? atoll(strchr(p, ' ') + 1) : -1);
+}
+
+
+int main (int argc, char *argv[])
+{
+	struct audio_s audio;
+	packet_t pp;
+	char *text;
+	int len;
+
+	text_color_init (1);
+
+	memset (&audio, 0, sizeof(audio));
+	audio.chan_medium[0] = MEDIUM_RADIO;
+	audio.chan_medium[1] = MEDIUM_RADIO;
+	audio.adev[0].samples_per_sec = 48000;
+
+	// Not statsnet_init because we don't want the listening thread.
+
+	save_audio_config_p = &audio;
+	stats_port = 1;
+	memset (rec, 0, sizeof(rec));
+	rxprof_init (1);
+
+	struct rx_chain_s *R = rx_chain_get (0);
+	(void) rx_chain_get (1);
+
+	for (int n = 0; n < 48000; n++) {
+	  RXPROF_SAMPLE_ENTER (&R->prof)
+	  RXPROF_SAMPLE_LEAVE (&R->prof)
+	}
+
+	pp = timed_frame ();
+	statsnet_rec_frame (0, fec_type_none, RETRY_NONE, pp);
+	ax25_delete (pp);
+
+	pp = timed_frame ();
+	statsnet_rec_frame (0, fec_type_none, RETRY_INVERT_SINGLE, pp);
+	ax25_delete (pp);
+
+	pp = timed_frame ();
+	statsnet_rec_frame (0, fec_type_fx25, (retry_t)2, pp);
+	ax25_delete (pp);
+
+	// e.g. from IGate.  No times so only counted.
+	pp = ax25_from_text ("W1ABC>APDW18:test", 1);
+	statsnet_rec_frame (0, fec_type_none, RETRY_NONE, pp);
+	ax25_delete (pp);
+
+	text = statsnet_report (&len);
+	if (len != (int)strlen(text)) {
+	  format_error ("Wrong length", "");
+	}
+
+	expect (text, "direwolf_rx_samples_total{chan=\"0\"} 48000\n");
+	expect (text, "direwolf_rx_stage_seconds_total{chan=\"0\",stage=\"demod\"} ");
+	expect (text, "direwolf_rx_frames_total{chan=\"0\",fec=\"none\"} 3\n");
+	expect (text, "direwolf_rx_frames_total{chan=\"0\",fec=\"fx25\"} 1\n");
+	expect (text, "direwolf_rx_frames_total{chan=\"0\",fec=\"il2p\"} 0\n");
+	expect (text, "direwolf_rx_fix_bits_total{chan=\"0\"} 1\n");
+	expect (text, "direwolf_rx_fec_corrected_total{chan=\"0\"} 1\n");
+	expect (text, "direwolf_rx_latency_seconds_bucket{chan=\"0\",step=\"demod\",le=\"0.002\"} 0\n");
+	expect (text, "direwolf_rx_latency_seconds_bucket{chan=\"0\",step=\"demod\",le=\"0.005\"} 3\n");
+	expect (text, "direwolf_rx_latency_seconds_bucket{chan=\"0\",step=\"demod\",le=\"+Inf\"} 3\n");
+	expect (text, "direwolf_rx_latency_seconds_sum{chan=\"0\",step=\"demod\"} 0.009000\n");
+	expect (text, "direwolf_rx_latency_seconds_count{chan=\"0\",step=\"total\"} 3\n");
+	expect (text, "direwolf_console_dropped_total 7\n");
+	expect (text, "direwolf_dlq_length 2\n");
+	expect (text, "direwolf_tq_length{chan=\"0\",prio=\"hi\"} 5\n");
+	expect (text, "direwolf_tq_length{chan=\"0\",prio=\"lo\"} 6\n");
+	check_format (text);
+
+	text_color_set(DW_COLOR_INFO);
+	fputs (text, stdout);		// Too long for dw_printf.
+	free (text);
+
+/*
+ * Count in one thread while reporting in another.
+ */
+#if __WIN32__
+	HANDLE count_th = (HANDLE)_beginthreadex (NULL, 0, count_thread, NULL, 0, NULL);
+	if (count_th == NULL) {
+#else
+	pthread_t count_tid;
+	if (pthread_create (&count_tid, NULL, count_thread, NULL) != 0) {
+#endif
+	  text_color_set(DW_COLOR_ERROR);
+	  dw_printf ("Could not create thread.\n");
+	  exit (EXIT_FAILURE);
+	}
+
+	long long prev = 0;
+	int reports = 0;
+	while ( ! __atomic_load_n (&counting_done, __ATOMIC_ACQUIRE)) {
+	  text = statsnet_report (&len);
+	  long long now = chan1_frames (text);
+	  if (now < prev || now > COUNT_FRAMES) {
+	    text_color_set(DW_COLOR_ERROR);
+	    dw_printf ("Frame count went from %lld to %lld.\n", prev, now);
+	    errors++;
+	  }
+	  prev = now;
+	  reports++;
+	  free (text);
+	}
+
+#if __WIN32__
+	WaitForSingleObject (count_th, INFINITE);
+#else
+	pthread_join (count_tid, NULL);
+#endif
+
+	text = statsnet_report (&len);
+	if (chan1_frames (text) != COUNT_FRAMES) {
+	  text_color_set(DW_COLOR_ERROR);
+	  dw_printf ("Expected %d frames on channel 1, got %lld.\n", COUNT_FRAMES, chan1_frames (text));
+	  errors++;
+	}
+	check_format (text);
+	free (text);
+
+	text_color_set(DW_COLOR_INFO);
+	dw_printf ("\n%d reports while counting.\n", reports);
+
+	if (errors != 0) {
+	  text_color_set(DW_COLOR_ERROR);
+	  dw_printf ("\n%d errors.\n", errors);
+	  exit (EXIT_FAILURE);
+	}
+
+	text_color_set(DW_COLOR_REC);
+	dw_printf ("\nSuccess!\n");
+	exit (EXIT_SUCCESS);
+
+}  /* end main */
+
+#endif
+
+/* end statsnet.c */
@@ -0,0 +1,20 @@
+
+/* statsnet.h - Report receive performance statistics over a TCP port. */
+
+#ifndef STATSNET_H
+#define STATSNET_H 1
+
+#include "audio.h"
+#include "config.h"
+#include "ax25_pad.h"
+#include "dlq.h"		// for fec_type_t
+
+
+void statsnet_init (struct audio_s *pa, struct misc_config_s *misc_config);
+
+void statsnet_rec_frame (int chan, fec_type_t fec_type, retry_t retries, packet_t pp);
+
+char *statsnet_report (int *len);
+
+
+#endif  /* STATSNET_H */
@@ -0,0 +1,473 @@
+//
+//    This file is part of Dire Wolf, an amateur radio packet TNC.
+//
+//    Copyright (C) 2026  Dire Wolf contributors
+//
+//    This program is free software: you can redistribute it and/or modify
+//    it under the terms of the GNU General Public License as published by
+//    the Free Software Foundation, either version 2 of the License, or
+//    (at your option) any later version.
+//
+//    This program is distributed in the hope that it will be useful,
+//    but WITHOUT ANY WARRANTY; without even the implied warranty of
+//    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//    GNU General Public License for more details.
+//
+//    You should have received a copy of the GNU General Public License
+//    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+
+
+/********************************************************************************
+ *
+ * File:	textasync.c
+ *
+ * Purpose:	Write console and log output from a separate thread.
+ *
+ * Description:	Everything printed goes through dw_printf, text_color_set,
+ *		and dw_fprintf (for log files).  Normally these write to
+ *		stdout or the file right away.  A slow terminal, a serial
+ *		console, or a pipe to another program that isn't keeping
+ *		up can stall the thread doing the printing.  Much of the
+ *		printing is done by the threads which process received frames
+ *		so a busy channel, printing a lot, could fall behind.
+ *
+ *		After text_async_init, the text is copied into a ring buffer
+ *		and another thread does the actual writing.  The ring lock is
+ *		held only long enough to copy the text in or out, never while
+ *		writing, so printing never waits for the terminal or disk.
+ *		The writer takes everything available at once and writes it
+ *		with one fwrite for each file, then flushes.
+ *
+ *		If the ring is more than half full, console text is discarded
+ *		and counted rather than making the caller wait.  A message is
+ *		kept or discarded as a whole, never split.  The count is
+ *		reported on the console when there is room again.
+ *
+ *		Log files are different.  They are a record of what was heard
+ *		so text for them is never discarded.  If the ring is full, the
+ *		caller waits for the writer to make room.  Keeping console text
+ *		out of the top half of the ring leaves room for it.
+ *
+ *		text_color_set doesn't send the same color again if it is
+ *		already in effect.  That is decided here, under the ring lock,
+ *		so it matches the order of the text in the ring.  After any text
+ *		is discarded we no longer know which color the terminal has
+ *		so the next one is always sent.
+ *
+ *		A log file is closed with text_async_close so the writer can
+ *		close it after writing what is waiting for it, rather than
+ *		the caller waiting for that.
+ *
+ *		Text from one thread comes out in the same order it was printed.
+ *		Anything using printf directly, rather than dw_printf, bypasses
+ *		this and could appear out of order.
+ *
+ *		Not used for Windows, where console color is set with a
+ *		function call rather than escape sequences in the text.
+ *
+ *******************************************************************************/
+
+#include "direwolf.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#if ! __WIN32__
+#include <pthread.h>
+#include <signal.h>
+#endif
+
+#include "textcolor.h"
+#include "textasync.h"
+
+
+#define RING_SIZE (256 * 1024)		/* Text waiting to be written. */
+
+#define BATCH_SIZE (64 * 1024)		/* Most taken by the writer at once. */
+
+#define MAX_RECORD (8 * 1024)		/* Longer text is split. */
+
+
+#define CLOSE_RESERVE 1024		/* Room kept for close requests when text fills the ring. */
+
+#define CONSOLE_LIMIT (RING_SIZE / 2)	/* Console text is discarded beyond this. */
+
+
+/*
+ * Each piece of text is stored as a header followed by the text.
+ * A len of REC_CLOSE, with no text, means close the file.
+ */
+
+struct rec_s {
+	FILE *fp;
+	int len;
+};
+
+#define REC_CLOSE (-1)
+
+#define REC_SIZE(r) ((int)sizeof(r) + ((r).len > 0 ? (r).len : 0))
+
+
+static volatile int s_dropped = 0;	/* Console messages discarded because output could not keep up. */
+
+
+#if ! __WIN32__
+
+static char s_ring[RING_SIZE];
+static int s_head = 0;			/* Next position to write. */
+static int s_tail = 0;			/* Next position to read. */
+static int s_used = 0;			/* Bytes in ring. */
+
+static int s_writing = 0;		/* Writer has taken text but not finished writing it. */
+
+static pthread_mutex_t s_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t s_wake = PTHREAD_COND_INITIALIZER;	/* Ring no longer empty. */
+static pthread_cond_t s_idle = PTHREAD_COND_INITIALIZER;	/* Everything written. */
+static pthread_cond_t s_room = PTHREAD_COND_INITIALIZER;	/* Writer took text out of the ring. */
+
+static int s_last_color = -1;		/* Color escape most recently put in the ring. */
+					/* -1 for unknown.  Protected by s_lock. */
+
+static int s_started = 0;
+
+
+static void ring_put (const void *src, int n)
+{
+	int first = RING_SIZE - s_head;
+
+	if (first > n) first = n;
+	memcpy (s_ring + s_head, src, first);
+	memcpy (s_ring, (const char *)src + first, n - first);
+	s_head = (s_head + n) % RING_SIZE;
+	s_used += n;
+}
+
+static void ring_get (void *dst, int n)
+{
+	int first = RING_SIZE - s_tail;
+
+	if (first > n) first = n;
+	memcpy (dst, s_ring + s_tail, first);
+	memcpy ((char *)dst + first, s_ring, n - first);
+	s_tail = (s_tail + n) % RING_SIZE;
+	s_used -= n;
+}
+
+
+/*-------------------------------------------------------------------
+ *
+ * Name:        async_output
+ *
+ * Purpose:     Put text in the ring for the writer thread.
+ *
+ * Inputs:	fp	- stdout or an open file.
+ *		buf	- Text.
+ *		len	- Number of bytes.
+ *		color	- >= 0 if buf is the escape sequence for this color.
+ *
+ * Description:	Called by textcolor.c in place of writing directly.
+ *		Console text is discarded, as a whole, if there is not
+ *		enough room.  Log file text waits for room.
+ *
+ *--------------------------------------------------------------------*/
+
+static void async_output (FILE *fp, const char *buf, int len, int color)
+{
+	int pieces = (len + MAX_RECORD - 1) / MAX_RECORD;
+
+	pthread_mutex_lock (&s_lock);
+
+	if (fp == stdout) {
+	  if (color >= 0 && color == s_last_color) {
+	    pthread_mutex_unlock (&s_lock);
+	    return;
+	  }
+	  if (s_used + pieces * (int)sizeof(struct rec_s) + len > CONSOLE_LIMIT) {
+	    s_dropped++;
+	    s_last_color = -1;
+	    pthread_mutex_unlock (&s_lock);
+	    return;
+	  }
+	  if (color >= 0) {
+	    s_last_color = color;
+	  }
+	}
+
+	while (len > 0) {
+	  struct rec_s r;
+
+	  r.fp = fp;
+	  r.len = len > MAX_RECORD ? MAX_RECORD : len;
+
+	  // Only for a log file.  Console text was checked above.
+
+	  while (s_used + (int)sizeof(r) + r.len > RING_SIZE - CLOSE_RESERVE) {
+	    pthread_cond_signal (&s_wake);
+	    pthread_cond_wait (&s_room, &s_lock);
+	  }
+
+	  int was_empty = (s_used == 0);
+
+	  ring_put (&r, sizeof(r));
+	  ring_put (buf, r.len);
+
+	  if (was_empty) {
+	    pthread_cond_signal (&s_wake);
+	  }
+
+	  buf += r.len;
+	  len -= r.len;
+	}
+
+	pthread_mutex_unlock (&s_lock);
+}
+
+
+/*-------------------------------------------------------------------
+ *
+ * Name:        writer_thread
+ *
+ * Purpose:     Take text from the ring and write it.
+ *
+ * Description:	Takes as many complete pieces as will fit in the batch.
+ *		Consecutive pieces for the same file are written together
+ *		and each file is flushed once at the end of the batch.
+ *
+ *		All signals are blocked here so a signal handler never
+ *		runs in this thread while it is in the middle of writing.
+ *
+ *--------------------------------------------------------------------*/
+
+static void *writer_thread (void *arg)
+{
+	static char batch[BATCH_SIZE];
+	int reported = 0;
+	sigset_t all;
+
+	sigfillset (&all);
+	pthread_sigmask (SIG_BLOCK, &all, NULL);
+
+	while (1) {
+	  int n = 0;
+
+	  pthread_mutex_lock (&s_lock);
+
+	  s_writing = 0;
+	  while (s_used == 0) {
+	    pthread_cond_broadcast (&s_idle);
+	    pthread_cond_wait (&s_wake, &s_lock);
+	  }
+
+	  while (s_used > 0) {
+	    struct rec_s r;
+	    int first = RING_SIZE - s_tail;
+
+	    if (first >= (int)sizeof(r)) {
+	      memcpy (&r, s_ring + s_tail, sizeof(r));
+	    }
+	    else {
+	      memcpy (&r, s_ring + s_tail, first);
+	      memcpy ((char *)(&r) + first, s_ring, sizeof(r) - first);
+	    }
+	    if (n + REC_SIZE(r) > BATCH_SIZE) {
+	      break;
+	    }
+	    ring_get (batch + n, REC_SIZE(r));
+	    n += REC_SIZE(r);
+	  }
+	  s_writing = 1;
+	  pthread_cond_broadcast (&s_room);
+
+	  int dropped = s_dropped;
+
+	  pthread_mutex_unlock (&s_lock);
+
+	  FILE *flush_list[8];
+	  int num_flush = 0;
+	  int k = 0;
+
+	  while (k < n) {
+	    struct rec_s r;
+	    memcpy (&r, batch + k, sizeof(r));
+	    FILE *fp = r.fp;
+	    int start = k + sizeof(r);
+	    int end;
+	    int j;
+
+	    if (r.len == REC_CLOSE) {
+
+	      // Everything before it for this file has been written.
+
+	      k = start;
+	      for (j = 0; j < num_flush && flush_list[j] != fp; j++) ;
+	      if (j < num_flush) {
+	        flush_list[j] = flush_list[--num_flush];
+	      }
+	      fclose (fp);
+	      continue;
+	    }
+
+	    end = start + r.len;
+	    k = end;
+
+	    // Join up following pieces for the same file.  Their headers are
+	    // in the way so move the text down over them.
+
+	    while (k < n) {
+	      memcpy (&r, batch + k, sizeof(r));
+	      if (r.fp != fp || r.len == REC_CLOSE) break;
+	      memmove (batch + end, batch + k + sizeof(r), r.len);
+	      end += r.len;
+	      k += sizeof(r) + r.len;
+	    }
+
+	    fwrite (batch + start, 1, end - start, fp);
+
+	    for (j = 0; j < num_flush && flush_list[j] != fp; j++) ;
+	    if (j == num_flush) {
+	      if (num_flush < (int)(sizeof(flush_list) / sizeof(flush_list[0]))) {
+	        flush_list[num_flush++] = fp;
+	      }
+	      else {
+	        fflush (fp);
+	      }
+	    }
+	  }
+
+	  if (dropped != reported) {
+	    fprintf (stdout, "\n[%d console messages were discarded because output could not keep up.]\n", dropped - reported);
+	    reported = dropped;
+	    if (num_flush == 0) flush_list[num_flush++] = stdout;
+	  }
+
+	  for (k = 0; k < num_flush; k++) {
+	    fflush (flush_list[k]);
+	  }
+	}
+
+	return (NULL);
+}
+
+#endif	/* ! __WIN32__ */
+
+
+/*-------------------------------------------------------------------
+ *
+ * Name:        text_async_init
+ *
+ * Purpose:     Start writing console and log output from a separate thread.
+ *
+ * Description:	Call once, early, after text_color_init.
+ *		Anything still waiting is written when the program exits.
+ *
+ *--------------------------------------------------------------------*/
+
+void text_async_init (void)
+{
+#if ! __WIN32__
+	pthread_t tid;
+
+	if (s_started) {
+	  return;
+	}
+
+	if (pthread_create (&tid, NULL, writer_thread, NULL) != 0) {
+	  text_color_set(DW_COLOR_ERROR);
+	  dw_printf ("Could not create thread for console output.  Continuing without it.\n");
+	  return;
+	}
+	pthread_detach (tid);
+
+	s_started = 1;
+	text_output_set (async_output);
+	atexit (text_async_flush);
+#endif
+}
+
+
+/*-------------------------------------------------------------------
+ *
+ * Name:        text_async_flush
+ *
+ * Purpose:     Wait until everything printed so far has been written.
+ *
+ * Description:	Used at exit.
+ *
+ *--------------------------------------------------------------------*/
+
+void text_async_flush (void)
+{
+#if ! __WIN32__
+	if ( ! s_started) {
+	  return;
+	}
+
+	pthread_mutex_lock (&s_lock);
+	while (s_used > 0 || s_writing) {
+	  pthread_cond_wait (&s_idle, &s_lock);
+	}
+	pthread_mutex_unlock (&s_lock);
+#endif
+}
+
+
+/*-------------------------------------------------------------------
+ *
+ * Name:        text_async_close
+ *
+ * Purpose:     Close a file after any text waiting for it has been written.
+ *
+ * Inputs:	fp	- File previously used with dw_fprintf.
+ *
+ * Description:	The writer thread closes it when it gets to it so the
+ *		caller doesn't wait for the disk.  Used when the log file
+ *		changes each day.  Room is kept in the ring for this so
+ *		it is not dropped when text is.
+ *
+ *--------------------------------------------------------------------*/
+
+void text_async_close (FILE *fp)
+{
+#if ! __WIN32__
+	if (s_started) {
+	  struct rec_s r;
+
+	  r.fp = fp;
+	  r.len = REC_CLOSE;
+
+	  pthread_mutex_lock (&s_lock);
+	  if (s_used + (int)sizeof(r) <= RING_SIZE) {
+	    int was_empty = (s_used == 0);
+
+	    ring_put (&r, sizeof(r));
+	    if (was_empty) {
+	      pthread_cond_signal (&s_wake);
+	    }
+	    pthread_mutex_unlock (&s_lock);
+	    return;
+	  }
+	  pthread_mutex_unlock (&s_lock);
+
+	  text_async_flush ();		// Should never happen.  Do it the slow way.
+	}
+#endif
+	fclose (fp);
+}
+
+
+/*-------------------------------------------------------------------
+ *
+ * Name:        text_async_dropped
+ *
+ * Returns:	Number of console messages discarded because output could not keep up.
+ *
+ *--------------------------------------------------------------------*/
+
+int text_async_dropped (void)
+{
+	return (s_dropped);
+}
+
+/* end textasync.c */
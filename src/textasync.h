@@ -0,0 +1,19 @@
+
+/* textasync.h - Write console and log output from a separate thread. */
+
+#ifndef TEXTASYNC_H
+#define TEXTASYNC_H 1
+
+#include <stdio.h>
+
+
+void text_async_init (void);
+
+void text_async_flush (void);
+
+void text_async_close (FILE *fp);
+
+int text_async_dropped (void);
+
+
+#endif  /* TEXTASYNC_H */
@@ -85,6 +85,7 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <stdarg.h>
+#include <string.h>
 
 
 #if __WIN32__
@@ -173,6 +174,34 @@ static const char clear_eos[]	= "\e[0J";
 static int g_enable_color = 1;
 
 
+/*
+ * Where the text finally goes.  NULL means write it here, right away.
+ * textasync.c supplies a function which hands it off to another thread.
+ */
+
+static text_output_t s_output = NULL;
+
+static void put_text (FILE *fp, const char *buf, int len, int color)
+{
+	if (len <= 0) {
+	  return;
+	}
+	if (s_output != NULL) {
+	  (*s_output) (fp, buf, len, color);
+	  return;
+	}
+	fwrite (buf, 1, len, fp);
+	if (fp != stdout) {
+	  fflush (fp);
+	}
+}
+
+void text_output_set (text_output_t fn)
+{
+	s_output = fn;
+}
+
+
 void text_color_init (int enable_color)
 {
 
@@ -296,6 +325,7 @@ void text_color_set ( enum dw_color_e c )
 
 void text_color_set ( enum dw_color_e c )
 {
+	const char *esc;
 
 	if (g_enable_color == 0) {
 	  return;
@@ -310,32 +340,34 @@ void text_color_set ( enum dw_color_e c )
 
 	  default:
 	  case DW_COLOR_INFO:
-	    printf ("%s", t_black[t]);
+	    esc = t_black[t];
 	    break;
 
 	  case DW_COLOR_ERROR:
-	    printf ("%s", t_red[t]);
+	    esc = t_red[t];
 	    break;
 
 	  case DW_COLOR_REC:
 	    // Bright green is very difficult to read against a while background.
 	    // Let's use dark green instead.   release 1.6.
-	    //printf ("%s", t_green[t]);
-	    printf ("%s", t_dark_green[t]);
+	    //esc = t_green[t];
+	    esc = t_dark_green[t];
 	    break;
 
 	  case DW_COLOR_DECODED:
-	    printf ("%s", t_blue[t]);
+	    esc = t_blue[t];
 	    break;
 
 	  case DW_COLOR_XMIT:
-	    printf ("%s", t_magenta[t]);
+	    esc = t_magenta[t];
 	    break;
 
 	  case DW_COLOR_DEBUG:
-	    printf ("%s", t_dark_green[t]);
+	    esc = t_dark_green[t];
 	    break;
 	}
+
+	put_text (stdout, esc, strlen(esc), (int)c);
 }
 
 #endif
@@ -377,7 +409,55 @@ int dw_printf (const char *fmt, ...)
 
 // TODO: other possible destinations...
 
-	fputs (buffer, stdout);
+	put_text (stdout, buffer, len < BSIZE ? len : BSIZE - 1, -1);
+	return (len);
+}
+
+
+/*-------------------------------------------------------------------
+ *
+ * Name:        dw_fprintf 
+ *
+ * Purpose:     fprintf replacement for log files so they can be
+ *		written by the same thread as the console output.
+ *
+ * Inputs:	fp	- Open file.
+ *		fmt	- C language format.
+ *		...	- Additional arguments, just like printf.
+ *
+ * Returns:	Number of characters in result.
+ *
+ * Description:	Unlike dw_printf, the result is never truncated.
+ *		Files other than stdout are flushed after each write.
+ *
+ *--------------------------------------------------------------------*/
+
+int dw_fprintf (FILE *fp, const char *fmt, ...) 
+{
+	va_list args;
+	char buffer[BSIZE];
+	char *p = buffer;
+	int len;
+	
+	va_start (args, fmt);
+	len = vsnprintf (buffer, BSIZE, fmt, args);
+	va_end (args);
+
+	if (len >= BSIZE) {
+	  p = malloc (len + 1);
+	  if (p == NULL) {
+	    return (-1);
+	  }
+	  va_start (args, fmt);
+	  vsnprintf (p, len + 1, fmt, args);
+	  va_end (args);
+	}
+
+	put_text (fp, p, len, -1);
+
+	if (p != buffer) {
+	  free (p);
+	}
 	return (len);
 }
 
@@ -11,6 +11,8 @@
 #ifndef TEXTCOLOR_H
 #define TEXTCOLOR_H 1
 
+#include <stdio.h>
+
 enum dw_color_e { 	DW_COLOR_INFO,		/* black */
 			DW_COLOR_ERROR,		/* red */
 			DW_COLOR_REC,		/* green */
@@ -55,4 +57,19 @@ int dw_printf (const char *fmt, ...)
 				__attribute__((format(printf,1,2)));		/* gnu C lib. */
 #endif
 
+int dw_fprintf (FILE *fp, const char *fmt, ...)
+#if __WIN32__
+				__attribute__((format(ms_printf,2,3)));
+#else
+				__attribute__((format(printf,2,3)));
+#endif
+
+
+/* Replace the final write to stdout or a file.  See textasync.c. */
+/* color is >= 0 when buf is only the escape sequence to select that color. */
+
+typedef void (*text_output_t) (FILE *fp, const char *buf, int len, int color);
+
+void text_output_set (text_output_t fn);
+
 #endif
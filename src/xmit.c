@@ -72,6 +72,7 @@
 #include "hdlc_rec.h"
 #include "ptt.h"
 #include "dtime_now.h"
+#include "csma.h"
 #include "morse.h"
 #include "dtmf.h"
 #include "xid.h"
@@ -167,8 +168,23 @@ static void * xmit_thread (void *arg);
  * different channels that want to transmit at the same time.
  * We are not clever enough to multiplex them so use this
  * so only one is activte at the same time.
+ *
+ * Version 1.8:  The mutex was held for the whole transmission and the
+ * other channel polled with try_lock every 10 ms.  Now the mutex only
+ * protects the busy flag and the other channel waits to be told when
+ * the device is released.
  */
 static dw_mutex_t audio_out_dev_mutex[MAX_ADEVS];
+static int audio_out_dev_busy[MAX_ADEVS];
+
+#if __WIN32__
+static HANDLE audio_out_dev_event[MAX_ADEVS];
+#else
+static pthread_cond_t audio_out_dev_cond[MAX_ADEVS];	/* Used with audio_out_dev_mutex. */
+#endif
+
+static int audio_out_dev_acquire (int chan, double until);
+static void audio_out_dev_release (int chan);
 
 
 
@@ -265,6 +281,17 @@ void xmit_init (struct audio_s *p_modem, int debug_xmit_packet)
 
 	for (ad = 0; ad < MAX_ADEVS; ad++) {
 	  dw_mutex_init (&(audio_out_dev_mutex[ad]));
+	  audio_out_dev_busy[ad] = 0;
+#if __WIN32__
+	  audio_out_dev_event[ad] = CreateEvent (NULL, 0, 0, NULL);
+	  if (audio_out_dev_event[ad] == NULL) {
+	    text_color_set(DW_COLOR_ERROR);
+	    dw_printf ("xmit_init: CreateEvent: can't create audio device wake up event, a=%d", ad);
+	    exit (1);
+	  }
+#else
+	  dtime_cond_init (&(audio_out_dev_cond[ad]));
+#endif
 	}
  
 #if DEBUG
@@ -611,9 +638,9 @@ static void * xmit_thread (void *arg)
 	            break;
 	        }
 
-	        // Corresponding lock is in wait_for_clear_channel.
+	        // Corresponding acquire is in wait_for_clear_channel.
 
-	        dw_mutex_unlock (&(audio_out_dev_mutex[ACHAN2ADEV(chan)]));
+	        audio_out_dev_release (chan);
 	      }
 	      else {
 /*
@@ -882,7 +909,7 @@ static void xmit_ax25_frames (int chan, int prio, packet_t pp, int max_bundle)
  * about 40 mS of elapsed real time.
  */
 
-	audio_wait(ACHAN2ADEV(chan));		
+	audio_wait(save_audio_config_p->chan_adev[chan]);		
 
 /* 
  * Ideally we should be here just about the time when the audio is ending.
@@ -1386,30 +1413,8 @@ static void xmit_dtmf (int c, packet_t pp, int speed)
  *		This would only be appropriate when transmit and receive are
  *		using different radio frequencies.  e.g.  VHF up, UHF down satellite.
  *
- * Transmit delay algorithm:
- *
- *		Wait for channel to be clear.
- *		If anything in high priority queue, bail out of the following.
- *
- *		Wait slottime * 10 milliseconds.
- *		Generate an 8 bit random number in range of 0 - 255.
- *		If random number <= persist value, return.
- *		Otherwise repeat.
- *
- * Example:
- *
- *		For typical values of slottime=10 and persist=63,
- *
- *		Delay		Probability
- *		-----		-----------
- *		100		.25					= 25%
- *		200		.75 * .25				= 19%
- *		300		.75 * .75 * .25				= 14%
- *		400		.75 * .75 * .75 * .25			= 11%
- *		500		.75 * .75 * .75 * .75 * .25		= 8%
- *		600		.75 * .75 * .75 * .75 * .75 * .25	= 6%
- *		700		.75 * .75 * .75 * .75 * .75 * .75 * .25	= 4%
- *		etc.		...
+ *		New in version 1.8: The transmit delay algorithm is now
+ *		csma_wait, in csma.c.  Times are from dtime_monotonic.
  *
  *--------------------------------------------------------------------*/
 
@@ -1418,11 +1423,10 @@ static void xmit_dtmf (int c, packet_t pp, int speed)
 /* Might need to revisit some day for connected mode file transfers. */
 
 #define WAIT_TIMEOUT_MS (60 * 1000)	
-#define WAIT_CHECK_EVERY_MS 10
 
 static int wait_for_clear_channel (int chan, int slottime, int persist, int fulldup)
 {
-	int n = 0;
+	double give_up = dtime_monotonic() + WAIT_TIMEOUT_MS * 0.001;
 
 /*
  * For dull duplex we skip the channel busy check and random wait.
@@ -1430,74 +1434,93 @@ static int wait_for_clear_channel (int chan, int slottime, int persist, int full
  * half is busy.
  */
 	if ( ! fulldup) {
-
-start_over_again:
-
-	while (hdlc_rec_data_detect_any(chan)) {
-	  SLEEP_MS(WAIT_CHECK_EVERY_MS);
-	  n++;
-	  if (n > (WAIT_TIMEOUT_MS / WAIT_CHECK_EVERY_MS)) {
+	  if ( ! csma_wait (chan, slottime, persist, save_audio_config_p->achan[chan].dwait, give_up)) {
 	    return 0;
 	  }
 	}
 
-//TODO:  rethink dwait.
-
 /*
- * Added in version 1.2 - for transceivers that can't
- * turn around fast enough when using squelch and VOX.
+ * This is to prevent two channels from transmitting at the same time
+ * thru a stereo audio device.
+ * We are not clever enough to combine two audio streams.
+ * They must go out one at a time.
+ * Documentation recommends using separate audio device for each channel rather than stereo.
+ * That also allows better use of multiple cores for receiving.
  */
 
-	if (save_audio_config_p->achan[chan].dwait > 0) {
-	  SLEEP_MS (save_audio_config_p->achan[chan].dwait * 10);
-	}
+// TODO: review this.
 
-	if (hdlc_rec_data_detect_any(chan)) {
-	  goto start_over_again;
-	}
+	return (audio_out_dev_acquire (chan, give_up));
 
-/*
- * Wait random time.
- * Proceed to transmit sooner if anything shows up in high priority queue.
- */
-	while (tq_peek(chan, TQ_PRIO_0_HI) == NULL) {
-	  int r;
+} /* end wait_for_clear_channel */
 
-	  SLEEP_MS (slottime * 10);
 
-	  if (hdlc_rec_data_detect_any(chan)) {
-	    goto start_over_again;
-	  }
+/*-------------------------------------------------------------------
+ *
+ * Name:        audio_out_dev_acquire
+ *
+ * Purpose:     Get exclusive use of the audio output device for a channel.
+ *
+ * Inputs:	chan	- Radio channel number.
+ *
+ *		until	- Give up at this time, from dtime_monotonic().
+ *
+ * Returns:	1 for OK.  0 for timeout.
+ *
+ * Description:	Only one channel of a stereo device can be transmitting.
+ *		Wait for the other to call audio_out_dev_release.
+ *
+ *--------------------------------------------------------------------*/
+
+static int audio_out_dev_acquire (int chan, double until)
+{
+	int a = save_audio_config_p->chan_adev[chan];
+	int ok;
 
-	  r = rand() & 0xff;
-	  if (r <= persist) {
+	dw_mutex_lock (&(audio_out_dev_mutex[a]));
+
+	while (audio_out_dev_busy[a]) {
+	  double now = dtime_monotonic();
+
+	  if (now >= until) {
 	    break;
- 	  }	
+	  }
+#if __WIN32__
+	  dw_mutex_unlock (&(audio_out_dev_mutex[a]));
+	  WaitForSingleObject (audio_out_dev_event[a], (DWORD)((until - now) * 1000) + 1);
+	  dw_mutex_lock (&(audio_out_dev_mutex[a]));
+#else
+	  dtime_cond_timedwait (&(audio_out_dev_cond[a]), &(audio_out_dev_mutex[a]), until);
+#endif
 	}
+
+	ok = ! audio_out_dev_busy[a];
+	if (ok) {
+	  audio_out_dev_busy[a] = 1;
 	}
 
-/*
- * This is to prevent two channels from transmitting at the same time
- * thru a stereo audio device.
- * We are not clever enough to combine two audio streams.
- * They must go out one at a time.
- * Documentation recommends using separate audio device for each channel rather than stereo.
- * That also allows better use of multiple cores for receiving.
- */
+	dw_mutex_unlock (&(audio_out_dev_mutex[a]));
 
-// TODO: review this.
+	return (ok);
 
-	while ( ! dw_mutex_try_lock(&(audio_out_dev_mutex[ACHAN2ADEV(chan)]))) {
-	  SLEEP_MS(WAIT_CHECK_EVERY_MS);
-	  n++;
-	  if (n > (WAIT_TIMEOUT_MS / WAIT_CHECK_EVERY_MS)) {
-	    return 0;
-	  }
-	}
+} /* end audio_out_dev_acquire */
 
-	return 1;
 
-} /* end wait_for_clear_channel */
+static void audio_out_dev_release (int chan)
+{
+	int a = save_audio_config_p->chan_adev[chan];
+
+	dw_mutex_lock (&(audio_out_dev_mutex[a]));
+	audio_out_dev_busy[a] = 0;
+#if __WIN32__
+	dw_mutex_unlock (&(audio_out_dev_mutex[a]));
+	SetEvent (audio_out_dev_event[a]);
+#else
+	pthread_cond_broadcast (&(audio_out_dev_cond[a]));
+	dw_mutex_unlock (&(audio_out_dev_mutex[a]));
+#endif
+
+} /* end audio_out_dev_release */
 
 
 /* end xmit.c */